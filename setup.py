@@ -17,6 +17,7 @@ macros = dict(
     STARRY_MN_MAX_ITER=100,
     STARRY_IJ_MAX_ITER=200,
     STARRY_REFINE_J_AT=25,
+    STARRY_NTHREADS=0,
 )
 
 # Override with user values
@@ -131,6 +132,9 @@ class BuildExt(build_ext):
             opts.append(cpp_flag(self.compiler))
             if has_flag(self.compiler, "-fvisibility=hidden"):
                 opts.append("-fvisibility=hidden")
+            if has_flag(self.compiler, "-pthread"):
+                opts.append("-pthread")
+                link_opts.append("-pthread")
         elif ct == "msvc":
             opts.append(
                 '/DVERSION_INFO=\\"%s\\"' % self.distribution.get_version()
@@ -1,5 +1,6 @@
 # -*- coding: utf-8 -*-
 import logging
+import os
 
 rootLogger = logging.getLogger("starry")
 rootLogger.addHandler(logging.StreamHandler())
@@ -42,6 +43,55 @@ class ConfigType(type):
         """Enable function profiling in lazy mode."""
         return cls._profile
 
+    @property
+    def cache_dir(cls):
+        """Directory in which to cache the change of basis matrices.
+
+        Computing these matrices is expensive at high degree. If this is
+        set, they are saved to disk the first time they are computed and
+        loaded from there by every subsequent process. Defaults to the
+        value of the ``STARRY_CACHE_DIR`` environment variable; if neither
+        is set, the matrices are cached in memory only.
+        """
+        return os.environ.get("STARRY_CACHE_DIR", None)
+
+    @cache_dir.setter
+    def cache_dir(cls, value):
+        if value is None:
+            os.environ.pop("STARRY_CACHE_DIR", None)
+        else:
+            value = os.path.abspath(os.path.expanduser(str(value)))
+            os.makedirs(value, exist_ok=True)
+            os.environ["STARRY_CACHE_DIR"] = value
+
+    @property
+    def sT_tol(cls):
+        """Tolerance of the tabulated occultation solution.
+
+        If nonzero, batched occultation calls at a fixed occultor radius
+        evaluate the solution vector and its derivatives from a piecewise
+        Chebyshev table in the impact parameter instead of solving for each
+        point exactly. This is much faster for long light curves. Each
+        component is accurate to this tolerance times the larger of unity
+        and its magnitude on the piece of the table, i.e., the tolerance is
+        absolute for small components and relative for large ones. Defaults
+        to ``0`` (exact solution).
+        """
+        return cls._sT_tol
+
+    @sT_tol.setter
+    def sT_tol(cls, value):
+        value = float(value)
+        if value < 0:
+            raise ValueError("The tolerance must be non-negative.")
+        if (cls._allow_changes) or (cls._sT_tol == value):
+            cls._sT_tol = value
+        else:
+            raise Exception(
+                "Cannot change the `starry` config at this time. "
+                "Config options should be set before instantiating any `starry` maps."
+            )
+
     @quiet.setter
     def quiet(cls, value):
         cls._quiet = value
@@ -79,3 +129,4 @@ class config(metaclass=ConfigType):
     _lazy = True
     _quiet = False
     _profile = False
+    _sT_tol = 0.0
@@ -11,3 +11,6 @@ STARRY_COVARIANCE_CHOLESKY = 3
 
 # Gravitational constant in internal units
 G_grav = constants.G.to(units.R_sun ** 3 / units.M_sun / units.day ** 2).value
+
+# Speed of light in internal units
+c_light = constants.c.to(units.R_sun / units.day).value
@@ -3,23 +3,28 @@ from .. import config
 from .._constants import *
 from .. import _c_ops
 from .ops import (
+    XOp,
     sTOp,
     rTReflectedOp,
+    sTReflectedOp,
     dotROp,
     tensordotRzOp,
+    dotProjectionOp,
     FOp,
     tensordotDOp,
     spotYlmOp,
     pTOp,
+    RenderOp,
     minimizeOp,
     LDPhysicalOp,
-    LimbDarkOp,
-    GetClOp,
+    LimbDarkFluxOp,
+    LimbDarkExposureOp,
     RaiseValueErrorOp,
-    RaiseValueErrorIfOp,
+    KeplerOp,
 )
 from .utils import logger, autocompile
-from .math import math
+from .math import math, _to_matrix
+from scipy.linalg import block_diag as scipy_block_diag
 import theano
 import theano.tensor as tt
 import theano.sparse as ts
@@ -38,7 +43,14 @@ except ModuleNotFoundError:  # pragma: no cover
     exoplanet = None
 
 
-__all__ = ["OpsYlm", "OpsLD", "OpsReflected", "OpsRV", "OpsSystem"]
+__all__ = [
+    "OpsYlm",
+    "OpsLD",
+    "OpsReflected",
+    "OpsRV",
+    "OpsSystem",
+    "SystemDesignMatrix",
+]
 
 
 class OpsYlm(object):
@@ -62,6 +74,7 @@ class OpsYlm(object):
         config.rootHandler.terminator = ""
         logger.info("Pre-computing some matrices... ")
         self._c_ops = _c_ops.Ops(ydeg, udeg, fdeg, drorder)
+        self._c_ops.sT_tol = config.sT_tol
         config.rootHandler.terminator = "\n"
         logger.info("Done.")
 
@@ -78,6 +91,8 @@ class OpsYlm(object):
         # Rotation operations
         self._tensordotRz = tensordotRzOp(self._c_ops.tensordotRz)
         self._dotR = dotROp(self._c_ops.dotR)
+        self._dotProjection = dotProjectionOp(self._c_ops.dotProjection)
+        self._dotProjectionT = dotProjectionOp(self._c_ops.dotProjectionT)
 
         # Filter
         # TODO: Make the filter operator sparse
@@ -86,9 +101,14 @@ class OpsYlm(object):
         # Differential rotation
         self._tensordotD = tensordotDOp(self._c_ops.tensordotD)
 
+        # Fused design matrix
+        self._X = XOp(self._c_ops.X, self._c_ops.Ny)
+
         # Misc
         self._spotYlm = spotYlmOp(self._c_ops.spotYlm, self.ydeg, self.nw)
+        self._spotYlms = spotYlmOp(self._c_ops.spotYlms, self.ydeg, self.nw)
         self._pT = pTOp(self._c_ops.pT, self.deg)
+        self._render = RenderOp(self._c_ops.render)
         if self.nw is None:
             if self._reflected:
                 self._minimize = minimizeOp(
@@ -105,7 +125,7 @@ class OpsYlm(object):
         else:
             # TODO: Implement minimization for spectral maps?
             self._minimize = None
-        self._LimbDarkIsPhysical = LDPhysicalOp(_c_ops.nroots)
+        self._LimbDarkIsPhysical = LDPhysicalOp(_c_ops.nrootsBatch)
 
     @property
     def rT(self):
@@ -151,6 +171,10 @@ class OpsYlm(object):
     def spotYlm(self, amp, sigma, lat, lon):
         return self._spotYlm(amp, sigma, lat, lon)
 
+    @autocompile
+    def spotYlms(self, amp, sigma, lat, lon):
+        return self._spotYlms(amp, sigma, lat, lon)
+
     @autocompile
     def pT(self, x, y, z):
         return self._pT(x, y, z)
@@ -168,6 +192,11 @@ class OpsYlm(object):
     @autocompile
     def X(self, theta, xo, yo, zo, ro, inc, obl, u, f, alpha):
         """Compute the light curve design matrix."""
+        # Without differential rotation, the whole
+        # thing is computed in a single C++ call
+        if not self.diffrot:
+            return self._X(theta, xo, yo, zo, ro, inc, obl, u, f)
+
         # Determine shapes
         rows = theta.shape[0]
         cols = self.rTA1.shape[1]
@@ -207,6 +236,37 @@ class OpsYlm(object):
 
         return X
 
+    @property
+    def streaming(self):
+        """Whether :py:meth:`solve` is available for this map."""
+        return not (self.diffrot or self._reflected)
+
+    def solve(
+        self, theta, xo, yo, zo, ro, inc, obl, u, f, flux, CInv, mu, LInv
+    ):
+        """
+        Solve the linear problem for the posterior over maps. The design
+        matrix is computed in blocks of rows and reduced on the fly, so it
+        is never stored in memory. Requires numerical inputs and a scalar
+        or diagonal data covariance.
+
+        """
+        return self._c_ops.solve(
+            theta,
+            xo,
+            yo,
+            zo,
+            ro,
+            inc,
+            obl,
+            u,
+            f,
+            flux,
+            np.atleast_1d(CInv),
+            mu,
+            _to_matrix(LInv, self._c_ops.Ny),
+        )
+
     @autocompile
     def flux(self, theta, xo, yo, zo, ro, inc, obl, y, u, f, alpha):
         """Compute the light curve."""
@@ -264,16 +324,6 @@ class OpsYlm(object):
     @autocompile
     def render(self, res, projection, theta, inc, obl, y, u, f, alpha):
         """Render the map on a Cartesian grid."""
-        # Compute the Cartesian grid
-        xyz = ifelse(
-            tt.eq(projection, STARRY_RECTANGULAR_PROJECTION),
-            self.compute_rect_grid(res),
-            self.compute_ortho_grid(res),
-        )
-
-        # Compute the polynomial basis
-        pT = self.pT(xyz[0], xyz[1], xyz[2])
-
         # If orthographic, rotate the map to the correct frame
         if self.nw is None:
             Ry = ifelse(
@@ -317,8 +367,8 @@ class OpsYlm(object):
                 tt.dot(self.F(u0, f0), A1Ry),
             )
 
-        # Dot the polynomial into the basis
-        res = tt.reshape(tt.dot(pT, A1Ry), [res, res, -1])
+        # Evaluate the polynomial on the grid, one tile of pixels at a time
+        res = tt.reshape(self._render(res, projection, A1Ry), [res, res, -1])
 
         # We need the shape to be (nframes, npix, npix)
         return res.dimshuffle(2, 0, 1)
@@ -328,6 +378,13 @@ class OpsYlm(object):
         """Return the spherical harmonic expansion of a Gaussian spot."""
         return self.spotYlm(amp, sigma, lat, lon)
 
+    @autocompile
+    def expand_spots(self, amp, sigma, lat, lon):
+        """Return the summed spherical harmonic expansion of several
+        Gaussian spots. The amplitude has one row per spot (and one
+        column per wavelength bin, if any)."""
+        return self.spotYlms(amp, sigma, lat, lon)
+
     @autocompile
     def compute_ortho_grid(self, res):
         """Compute the polynomial basis on the plane of the sky."""
@@ -364,48 +421,9 @@ class OpsYlm(object):
         if self.ydeg == 0:
             return M
 
-        # Rotate to the sky frame
-        # TODO: Do this in a single compound rotation
-        M = self.dotR(
-            self.dotR(
-                self.dotR(
-                    M,
-                    -tt.cos(obl),
-                    -tt.sin(obl),
-                    math.to_tensor(0.0),
-                    -(0.5 * np.pi - inc),
-                ),
-                math.to_tensor(0.0),
-                math.to_tensor(0.0),
-                math.to_tensor(1.0),
-                obl,
-            ),
-            math.to_tensor(1.0),
-            math.to_tensor(0.0),
-            math.to_tensor(0.0),
-            -0.5 * np.pi,
-        )
-
-        # Rotate to the correct phase
-        if theta.ndim > 0:
-            M = self.tensordotRz(M, theta)
-        else:
-            M = self.dotR(
-                M,
-                math.to_tensor(0.0),
-                math.to_tensor(0.0),
-                math.to_tensor(1.0),
-                theta,
-            )
-
-        # Rotate to the polar frame
-        M = self.dotR(
-            M,
-            math.to_tensor(1.0),
-            math.to_tensor(0.0),
-            math.to_tensor(0.0),
-            0.5 * np.pi,
-        )
+        # Rotate to the sky frame, then to the correct
+        # phase, and finally to the polar frame
+        M = self._dotProjection(M, inc, obl, tt.reshape(theta, (-1,)))
 
         # Apply the differential rotation
         if self.diffrot:
@@ -444,48 +462,9 @@ class OpsYlm(object):
                     "Code this branch up if needed.", MT.shape
                 )
 
-        # Rotate to the polar frame
-        MT = self.dotR(
-            MT,
-            math.to_tensor(1.0),
-            math.to_tensor(0.0),
-            math.to_tensor(0.0),
-            -0.5 * np.pi,
-        )
-
-        # Rotate to the correct phase
-        if theta.ndim > 0:
-            MT = self.tensordotRz(MT, -theta)
-        else:
-            MT = self.dotR(
-                MT,
-                math.to_tensor(0.0),
-                math.to_tensor(0.0),
-                math.to_tensor(1.0),
-                -theta,
-            )
-
-        # Rotate to the sky frame
-        # TODO: Do this in a single compound rotation
-        MT = self.dotR(
-            self.dotR(
-                self.dotR(
-                    MT,
-                    math.to_tensor(1.0),
-                    math.to_tensor(0.0),
-                    math.to_tensor(0.0),
-                    0.5 * np.pi,
-                ),
-                math.to_tensor(0.0),
-                math.to_tensor(0.0),
-                math.to_tensor(1.0),
-                -obl,
-            ),
-            -tt.cos(obl),
-            -tt.sin(obl),
-            math.to_tensor(0.0),
-            (0.5 * np.pi - inc),
-        )
+        # Rotate to the polar frame, then to the correct
+        # phase, and finally to the sky frame
+        MT = self._dotProjectionT(MT, inc, obl, tt.reshape(theta, (-1,)))
 
         return tt.transpose(MT)
 
@@ -559,9 +538,8 @@ class OpsLD(object):
         self.nw = nw
 
         # Set up the ops
-        self._get_cl = GetClOp()
-        self._limbdark = LimbDarkOp()
-        self._LimbDarkIsPhysical = LDPhysicalOp(_c_ops.nroots)
+        self._limbdark_flux = LimbDarkFluxOp()
+        self._LimbDarkIsPhysical = LDPhysicalOp(_c_ops.nrootsBatch)
 
     @autocompile
     def limbdark_is_physical(self, u):
@@ -585,18 +563,13 @@ class OpsLD(object):
         b_occ = tt.invert(tt.ge(b, 1.0 + ro) | tt.le(zo, 0.0) | tt.eq(ro, 0.0))
         i_occ = tt.arange(b.size)[b_occ]
 
-        # Get the Agol `c` coefficients
-        c = self._get_cl(u)
-        if self.udeg == 0:
-            c_norm = c / (np.pi * c[0])
-        else:
-            c_norm = c / (np.pi * (c[0] + 2 * c[1] / 3))
-
-        # Compute the occultation flux
+        # Compute the occultation flux. The op computes the Agol `c`
+        # coefficients and normalizes them internally.
         los = zo[i_occ]
         r = ro * tt.ones_like(los)
+        u = tt.reshape(u, (1, -1))
         flux = tt.set_subtensor(
-            flux[i_occ], self._limbdark(c_norm, b[i_occ], r, los)[0]
+            flux[i_occ], self._limbdark_flux(u, b[i_occ], r, los)[:, 0]
         )
         return flux
 
@@ -745,6 +718,9 @@ class OpsReflected(OpsYlm):
     def __init__(self, *args, **kwargs):
         super(OpsReflected, self).__init__(*args, reflected=True, **kwargs)
         self._rT = rTReflectedOp(self._c_ops.rTReflected, self._c_ops.N)
+        self._sTReflected = sTReflectedOp(
+            self._c_ops.sTReflected, self._c_ops.N
+        )
         self._A1Big = ts.as_sparse_variable(self._c_ops.A1Big)
 
     @property
@@ -755,6 +731,10 @@ class OpsReflected(OpsYlm):
     def rT(self, b):
         return self._rT(b)
 
+    @autocompile
+    def sTReflected(self, b, xo, yo, zo, ro):
+        return self._sTReflected(b, xo, yo, zo, ro)
+
     @autocompile
     def intensity(self, lat, lon, y, u, f, xs, ys, zs, wta, ld):
         """Compute the intensity at a series of lat-lon points on the surface."""
@@ -832,59 +812,39 @@ class OpsReflected(OpsYlm):
     @autocompile
     def X(self, theta, xs, ys, zs, xo, yo, zo, ro, inc, obl, u, f, alpha):
         """Compute the light curve design matrix."""
-        # Determine shapes
-        rows = theta.shape[0]
-        cols = (self.ydeg + 1) ** 2
-        X = tt.zeros((rows, cols))
-
-        # Compute the occultation mask
-        b = tt.sqrt(xo ** 2 + yo ** 2)
-        b_rot = tt.ge(b, 1.0 + ro) | tt.le(zo, 0.0) | tt.eq(ro, 0.0)
-        b_occ = tt.invert(b_rot)
-        i_rot = tt.arange(b.size)[b_rot]
-        i_occ = tt.arange(b.size)[b_occ]
+        # Compute the semi-minor axis of the terminator
+        r2 = xs ** 2 + ys ** 2 + zs ** 2
+        bterm = -zs / tt.sqrt(r2)
 
-        # Rotation operator
-        # -----------------
+        # Rotate the occultor into the frame in which the
+        # source lies along the +y axis
+        theta_z = tt.arctan2(xs, ys)
+        cos_z = tt.cos(theta_z)
+        sin_z = tt.sin(theta_z)
+        xo_z = xo * cos_z - yo * sin_z
+        yo_z = xo * sin_z + yo * cos_z
 
-        # Compute the semi-minor axis of the terminator
-        # and the reflectance integrals
-        r2 = xs[i_rot] ** 2 + ys[i_rot] ** 2 + zs[i_rot] ** 2
-        bterm = -zs[i_rot] / tt.sqrt(r2)
-        rT = self.rT(bterm)
+        # Compute the reflectance integrals over the visible part
+        # of the day side (these are just `rT` for points that
+        # are not occulted)
+        sT = self.sTReflected(bterm, xo_z, yo_z, zo, ro)
 
         # Transform to Ylms and rotate on the sky plane
-        rTA1 = ts.dot(rT, self.A1Big)
-        theta_z = tt.arctan2(xs[i_rot], ys[i_rot])
-        rTA1Rz = self.tensordotRz(rTA1, theta_z)
+        sTA1 = ts.dot(sT, self.A1Big)
+        sTA1Rz = self.tensordotRz(sTA1, theta_z)
 
         # Apply limb darkening?
         F = self.F(u, f)
         A1InvFA1 = ts.dot(ts.dot(self.A1Inv, F), self.A1)
-        rTA1Rz = tt.dot(rTA1Rz, A1InvFA1)
+        sTA1Rz = tt.dot(sTA1Rz, A1InvFA1)
 
         # Rotate to the correct phase and weight by the distance to the source
         # The factor of 2/3 ensures that the flux from a uniform map
         # with unit amplitude seen at noon is unity.
-        X = tt.set_subtensor(
-            X[i_rot],
-            self.right_project(rTA1Rz, inc, obl, theta[i_rot], alpha)
-            / (2.0 / 3.0 * tt.shape_padright(r2)),
-        )
-
-        # Occultation operator
-        # --------------------
-
-        X = tt.set_subtensor(
-            X[i_occ],
-            RaiseValueErrorIfOp(
-                "Occultations in reflected light not yet implemented."
-            )(b_occ.any()),
+        return self.right_project(sTA1Rz, inc, obl, theta, alpha) / (
+            2.0 / 3.0 * tt.shape_padright(r2)
         )
 
-        # We're done
-        return X
-
     @autocompile
     def flux(
         self, theta, xs, ys, zs, xo, yo, zo, ro, inc, obl, y, u, f, alpha
@@ -919,9 +879,6 @@ class OpsReflected(OpsYlm):
             self.compute_ortho_grid(res),
         )
 
-        # Compute the polynomial basis
-        pT = self.pT(xyz[0], xyz[1], xyz[2])
-
         # If orthographic, rotate the map to the correct frame
         if self.nw is None:
             Ry = ifelse(
@@ -964,8 +921,8 @@ class OpsReflected(OpsYlm):
             tt.dot(self.F(u0, f0), A1Ry),
         )
 
-        # Dot the polynomial into the basis
-        image = tt.dot(pT, A1Ry)
+        # Evaluate the polynomial on the grid, one tile of pixels at a time
+        image = self._render(res, projection, A1Ry)
 
         # Compute the illumination profile
         I = self.compute_illumination(xyz, xs, ys, zs)
@@ -1016,6 +973,109 @@ class OpsReflected(OpsYlm):
         return I
 
 
+class SystemDesignMatrix(object):
+    """
+    A structured representation of the flux design matrix of a system.
+
+    Away from occultations, the columns of each body are its rotational
+    phase curve, i.e., the vector ``rTA1`` rotated by the body's phase
+    ``theta``. Since a rotation about a fixed axis acts on a spherical
+    harmonic of degree ``l`` through ``cos(m theta)`` and
+    ``sin(m theta)`` for ``m <= l``, each block of the design matrix is
+    exactly ``F(theta) B``, where ``F`` holds the ``2 ydeg + 1`` Fourier
+    modes of the phase and ``B`` is a small ``(2 ydeg + 1) x Ny`` matrix.
+    Only the rows of the cadences during which some body is occulted are
+    stored densely.
+
+    Args:
+        theta (list): The rotational phase of each body at each cadence.
+        B (list): The phase curve factor ``B`` of each body.
+        occ (vector): The indices of the occulted cadences.
+        X_occ (matrix): The rows of the design matrix at those cadences.
+    """
+
+    def __init__(self, theta, B, occ, X_occ):
+        self.theta = theta
+        self.B = B
+        self.occ = occ
+        self.X_occ = X_occ
+        npts = len(theta[0])
+        self.shape = (npts, sum([Bk.shape[1] for Bk in B]))
+        self._phase = np.ones(npts, dtype=bool)
+        self._phase[occ] = False
+
+    @staticmethod
+    def fourier(theta, K):
+        """Return the first ``K`` Fourier modes of the angle ``theta``."""
+        m = np.arange(1, (K - 1) // 2 + 1)
+        F = np.empty((len(theta), K))
+        F[:, 0] = 1.0
+        F[:, 1::2] = np.cos(np.outer(theta, m))
+        F[:, 2::2] = np.sin(np.outer(theta, m))
+        return F
+
+    def _F(self, rows):
+        """The Fourier modes of all bodies at the cadences ``rows``."""
+        return np.hstack(
+            [
+                self.fourier(theta[rows], Bk.shape[0])
+                for theta, Bk in zip(self.theta, self.B)
+            ]
+        )
+
+    def toarray(self):
+        """Return the dense design matrix."""
+        X = np.hstack(
+            [
+                self.fourier(theta, Bk.shape[0]).dot(Bk)
+                for theta, Bk in zip(self.theta, self.B)
+            ]
+        )
+        X[self.occ] = self.X_occ
+        return X
+
+    def dot(self, y):
+        """Return the product of the design matrix and ``y``."""
+        y = np.array(y, dtype="float64")
+        Fy = np.zeros((self.shape[0],) + y.shape[1:])
+        n = 0
+        for theta, Bk in zip(self.theta, self.B):
+            Ny = Bk.shape[1]
+            Fy += self.fourier(theta, Bk.shape[0]).dot(Bk.dot(y[n : n + Ny]))
+            n += Ny
+        Fy[self.occ] = self.X_occ.dot(y)
+        return Fy
+
+    def normal_equations(self, flux, CInv):
+        """
+        Return the normal equations ``W = X^T C^-1 X`` and
+        ``b = X^T C^-1 f`` and ``f^T C^-1 f`` for a diagonal data
+        covariance ``C``. The phase curve rows only contribute
+        through the ``O(npts (2 ydeg + 1)^2)`` Gram matrix of their
+        Fourier modes.
+
+        Args:
+            flux (vector): The data vector ``f``.
+            CInv (scalar or vector): The inverse data covariance.
+        """
+        flux = np.array(flux, dtype="float64")
+        w = np.array(CInv, dtype="float64") * np.ones(self.shape[0])
+
+        # Phase curve rows
+        F = self._F(self._phase)
+        wF = F * w[self._phase].reshape(-1, 1)
+        B = scipy_block_diag(*self.B)
+        W = B.T.dot(F.T.dot(wF)).dot(B)
+        b = B.T.dot(wF.T.dot(flux[self._phase]))
+
+        # Occultation rows
+        wX = self.X_occ * w[self.occ].reshape(-1, 1)
+        W += self.X_occ.T.dot(wX)
+        b += wX.T.dot(flux[self.occ])
+
+        return W, b, np.dot(w * flux, flux)
+
+
 class OpsSystem(object):
     """Class housing ops for modeling Keplerian systems."""
 
@@ -1041,8 +1101,29 @@ class OpsSystem(object):
         self.oversample = oversample
         self.order = order
 
-        # Require exoplanet
-        assert exoplanet is not None, "This class requires exoplanet >= 0.2.0."
+        # If all bodies are purely limb-darkened, the exposure time
+        # integration is done adaptively by the limb darkening op,
+        # so we don't need to oversample the light curve
+        self._exposure_ld = (self.texp != 0.0) and all(
+            [
+                body._map.__props__["limbdarkened"]
+                for body in [primary] + list(secondaries)
+            ]
+        )
+        if self._exposure_ld:
+            self._limbdark_exposure = LimbDarkExposureOp()
+
+        # Keplerian orbits of the secondaries
+        self._kepler = KeplerOp(
+            _c_ops.kepler, G_grav, c_light if self.light_delay else 0.0
+        )
+
+        # The primary's reflex motion is not delayed, so with light
+        # delay we also need the instantaneous relative positions
+        if self.light_delay:
+            self._kepler_instant = KeplerOp(_c_ops.kepler, G_grav, 0.0)
+        else:
+            self._kepler_instant = self._kepler
 
     @autocompile
     def position(
@@ -1059,34 +1140,36 @@ class OpsSystem(object):
         sec_iorb,
     ):
         """Compute the Cartesian positions of all bodies."""
-        orbit = exoplanet.orbits.KeplerianOrbit(
-            period=sec_porb,
-            t0=sec_t0,
-            incl=sec_iorb,
-            ecc=sec_ecc,
-            omega=sec_w,
-            Omega=sec_Omega,
-            m_planet=sec_m,
-            m_star=pri_m,
-            r_star=1.0,  # doesn't matter
+        args = (
+            t,
+            pri_m,
+            sec_m,
+            sec_t0,
+            sec_porb,
+            sec_ecc,
+            sec_w,
+            sec_Omega,
+            sec_iorb,
         )
-        # Position of the primary
-        if len(self.secondaries) > 1:
-            x_pri, y_pri, z_pri = tt.sum(orbit.get_star_position(t), axis=-1)
-        else:
-            x_pri, y_pri, z_pri = orbit.get_star_position(t)
 
-        # Positions of the secondaries
-        try:
-            x_sec, y_sec, z_sec = orbit.get_planet_position(
-                t, light_delay=self.light_delay
-            )
-        except TypeError:
-            if self.light_delay:
-                logger.warn(
-                    "This version of `exoplanet` does not model light delays."
-                )
-            x_sec, y_sec, z_sec = orbit.get_planet_position(t)
+        # Relative positions of the secondaries
+        x, y, z, _, _, _ = self._kepler(*args)
+
+        # Move to the barycentric frame. The primary's offset is
+        # computed from the instantaneous (not retarded) positions
+        if self.light_delay:
+            x0, y0, z0, _, _, _ = self._kepler_instant(*args)
+        else:
+            x0, y0, z0 = x, y, z
+        m_tot = tt.shape_padleft(pri_m + sec_m)
+        fac = tt.shape_padleft(sec_m) / m_tot
+        x_pri = -tt.sum(fac * x0, axis=-1, keepdims=True)
+        y_pri = -tt.sum(fac * y0, axis=-1, keepdims=True)
+        z_pri = -tt.sum(fac * z0, axis=-1, keepdims=True)
+        fac = pri_m / m_tot
+        x_sec = fac * x
+        y_sec = fac * y
+        z_sec = fac * z
 
         # Concatenate them
         x = tt.transpose(tt.concatenate((x_pri, x_sec), axis=-1))
@@ -1128,6 +1211,26 @@ class OpsSystem(object):
         sec_alpha,
     ):
         """Compute the system light curve design matrix."""
+        # Exposure time integration in the limb darkening op?
+        if self._exposure_ld:
+            return self._X_exposure_ld(
+                t,
+                pri_r,
+                pri_m,
+                pri_L,
+                pri_u,
+                sec_r,
+                sec_m,
+                sec_t0,
+                sec_porb,
+                sec_ecc,
+                sec_w,
+                sec_Omega,
+                sec_iorb,
+                sec_L,
+                sec_u,
+            )
+
         # Exposure time integration?
         if self.texp != 0.0:
 
@@ -1158,27 +1261,17 @@ class OpsSystem(object):
             t = tt.reshape(t, (-1,))
 
         # Compute the relative positions of all bodies
-        orbit = exoplanet.orbits.KeplerianOrbit(
-            period=sec_porb,
-            t0=sec_t0,
-            incl=sec_iorb,
-            ecc=sec_ecc,
-            omega=sec_w,
-            Omega=sec_Omega,
-            m_planet=sec_m,
-            m_star=pri_m,
-            r_star=pri_r,
+        x, y, z, _, _, _ = self._kepler(
+            t,
+            pri_m,
+            sec_m,
+            sec_t0,
+            sec_porb,
+            sec_ecc,
+            sec_w,
+            sec_Omega,
+            sec_iorb,
         )
-        try:
-            x, y, z = orbit.get_relative_position(
-                t, light_delay=self.light_delay
-            )
-        except TypeError:
-            if self.light_delay:
-                logger.warn(
-                    "This version of `exoplanet` does not model light delays."
-                )
-            x, y, z = orbit.get_relative_position(t)
 
         # Get all rotational phases
         pri_prot = ifelse(
@@ -1418,6 +1511,315 @@ class OpsSystem(object):
                 axis=1,
             )
 
+    def X_structured(
+        self,
+        t,
+        pri_r,
+        pri_m,
+        pri_prot,
+        pri_t0,
+        pri_theta0,
+        pri_L,
+        pri_inc,
+        pri_obl,
+        pri_u,
+        pri_f,
+        pri_alpha,
+        sec_r,
+        sec_m,
+        sec_prot,
+        sec_t0,
+        sec_theta0,
+        sec_porb,
+        sec_ecc,
+        sec_w,
+        sec_Omega,
+        sec_iorb,
+        sec_L,
+        sec_inc,
+        sec_obl,
+        sec_u,
+        sec_f,
+        sec_alpha,
+    ):
+        """
+        Compute the system light curve design matrix as a
+        :py:class:`SystemDesignMatrix`. This works with numerical
+        values only, and only for bodies in emitted light with no
+        differential rotation and no exposure time integration.
+
+        """
+        if self._reflected or self.texp != 0.0 or self.nw is not None:
+            raise NotImplementedError(
+                "Structured design matrices are only implemented for "
+                "monochromatic maps in emitted light and zero exposure time."
+            )
+        if np.any(pri_alpha != 0.0) or np.any(sec_alpha != 0.0):
+            raise NotImplementedError(
+                "Structured design matrices are not implemented for maps "
+                "with differential rotation."
+            )
+
+        # Compute the relative positions of all bodies
+        x, y, z, _, _, _ = self._kepler.func(
+            t,
+            pri_m,
+            sec_m,
+            sec_t0,
+            sec_porb,
+            sec_ecc,
+            sec_w,
+            sec_Omega,
+            sec_iorb,
+            self._kepler.G,
+            self._kepler.clight,
+        )
+
+        # Get all rotational phases
+        with np.errstate(divide="ignore"):
+            pri_freq = np.where(pri_prot == 0.0, 0.0, 2 * np.pi / pri_prot)
+            sec_freq = np.where(sec_prot == 0.0, 0.0, 2 * np.pi / sec_prot)
+        theta = [pri_freq * (t - pri_t0) + pri_theta0] + [
+            sec_freq[i] * (t - sec_t0[i]) + sec_theta0[i]
+            for i in range(len(self.secondaries))
+        ]
+
+        # Find the cadences during which any body is occulted,
+        # using the same criteria as in :py:meth:`X`
+        def occulted(xo, yo, zo, ro):
+            b = np.sqrt(xo ** 2 + yo ** 2)
+            return ~((b >= 1.0 + ro) | (zo <= 0.0) | (ro == 0.0))
+
+        occ = np.zeros(len(t), dtype=bool)
+        with np.errstate(divide="ignore", invalid="ignore"):
+            for i, _ in enumerate(self.secondaries):
+                occ |= occulted(
+                    x[:, i] / pri_r,
+                    y[:, i] / pri_r,
+                    z[:, i] / pri_r,
+                    sec_r[i] / pri_r,
+                )
+                occ |= occulted(
+                    -x[:, i] / sec_r[i],
+                    -y[:, i] / sec_r[i],
+                    -z[:, i] / sec_r[i],
+                    pri_r / sec_r[i],
+                )
+                for j, _ in enumerate(self.secondaries):
+                    if i != j:
+                        occ |= occulted(
+                            (-x[:, i] + x[:, j]) / sec_r[i],
+                            (-y[:, i] + y[:, j]) / sec_r[i],
+                            (-z[:, i] + z[:, j]) / sec_r[i],
+                            sec_r[j] / sec_r[i],
+                        )
+        occ = np.flatnonzero(occ)
+
+        # Factor the phase curve of each body by sampling it at
+        # `2 ydeg + 1` equally spaced phases
+        def factor(ops, Ny, L, inc, obl, u, f, alpha):
+            K = 2 * int(np.round(np.sqrt(Ny))) - 1
+            nodes = np.linspace(0, 2 * np.pi, K, endpoint=False)
+            zeros = np.zeros(K)
+            P = L * ops.X(
+                nodes,
+                zeros,
+                zeros,
+                zeros,
+                np.array(0.0),
+                inc,
+                obl,
+                u,
+                f,
+                alpha,
+            )
+            return np.linalg.solve(SystemDesignMatrix.fourier(nodes, K), P)
+
+        B = [
+            factor(
+                self.primary.map.ops,
+                self.primary.map.Ny,
+                pri_L,
+                pri_inc,
+                pri_obl,
+                pri_u,
+                pri_f,
+                pri_alpha,
+            )
+        ] + [
+            factor(
+                sec.map.ops,
+                sec.map.Ny,
+                sec_L[i],
+                sec_inc[i],
+                sec_obl[i],
+                sec_u[i],
+                sec_f[i],
+                sec_alpha[i],
+            )
+            for i, sec in enumerate(self.secondaries)
+        ]
+
+        # Compute the dense rows of the occulted cadences
+        if len(occ):
+            X_occ = self.X(
+                t[occ],
+                pri_r,
+                pri_m,
+                pri_prot,
+                pri_t0,
+                pri_theta0,
+                pri_L,
+                pri_inc,
+                pri_obl,
+                pri_u,
+                pri_f,
+                pri_alpha,
+                sec_r,
+                sec_m,
+                sec_prot,
+                sec_t0,
+                sec_theta0,
+                sec_porb,
+                sec_ecc,
+                sec_w,
+                sec_Omega,
+                sec_iorb,
+                sec_L,
+                sec_inc,
+                sec_obl,
+                sec_u,
+                sec_f,
+                sec_alpha,
+            )
+        else:
+            X_occ = np.zeros((0, sum([Bk.shape[1] for Bk in B])))
+
+        return SystemDesignMatrix(theta, B, occ, X_occ)
+
+    def _X_exposure_ld(
+        self,
+        t,
+        pri_r,
+        pri_m,
+        pri_L,
+        pri_u,
+        sec_r,
+        sec_m,
+        sec_t0,
+        sec_porb,
+        sec_ecc,
+        sec_w,
+        sec_Omega,
+        sec_iorb,
+        sec_L,
+        sec_u,
+    ):
+        """
+        Compute the exposure-averaged design matrix of a system of
+        purely limb-darkened bodies. The motion of each occultor is
+        expanded to second order in time over each exposure, and the flux
+        is integrated adaptively in the limb darkening op, so we only need
+        the positions, velocities and accelerations at the middle of each
+        exposure.
+
+        """
+        # Compute the relative positions & velocities of all bodies
+        x, y, z, vx, vy, vz = self._kepler(
+            t,
+            pri_m,
+            sec_m,
+            sec_t0,
+            sec_porb,
+            sec_ecc,
+            sec_w,
+            sec_Omega,
+            sec_iorb,
+        )
+        texp = tt.as_tensor_variable(self.texp) * tt.ones_like(t)
+
+        # With light delay, the positions and velocities are both those
+        # at the retarded time `t_e`, and the apparent positions move
+        # across the sky at `v dt_e / dt = v / (1 - v_z / c)`. The same
+        # correction to the accelerations is of order `v / c` over an
+        # exposure, so we neglect it
+        if self.light_delay:
+            fac = 1.0 / (1.0 - vz / c_light)
+            vx = vx * fac
+            vy = vy * fac
+
+        # Keplerian accelerations relative to the primary
+        fac = (
+            -G_grav
+            * tt.shape_padleft(pri_m + sec_m)
+            / (x ** 2 + y ** 2 + z ** 2) ** 1.5
+        )
+        ax = fac * x
+        ay = fac * y
+
+        def occultation(xo, yo, zo, vxo, vyo, axo, ayo, ro, u):
+            """The exposure-averaged change in flux due to an occultation."""
+            flux = self._limbdark_exposure(
+                tt.reshape(u, (1, -1)),
+                xo,
+                yo,
+                vxo,
+                vyo,
+                axo,
+                ayo,
+                ro * tt.ones_like(xo),
+                texp,
+                zo,
+            )[:, 0]
+            return flux - 1.0
+
+        # Compute transits across the primary
+        X_pri = tt.ones_like(t)
+        for i, _ in enumerate(self.secondaries):
+            X_pri += occultation(
+                x[:, i] / pri_r,
+                y[:, i] / pri_r,
+                z[:, i] / pri_r,
+                vx[:, i] / pri_r,
+                vy[:, i] / pri_r,
+                ax[:, i] / pri_r,
+                ay[:, i] / pri_r,
+                sec_r[i] / pri_r,
+                pri_u,
+            )
+        X = [pri_L * X_pri]
+
+        # Compute occultations of the secondaries
+        for i, _ in enumerate(self.secondaries):
+            X_sec = tt.ones_like(t) + occultation(
+                -x[:, i] / sec_r[i],
+                -y[:, i] / sec_r[i],
+                -z[:, i] / sec_r[i],
+                -vx[:, i] / sec_r[i],
+                -vy[:, i] / sec_r[i],
+                -ax[:, i] / sec_r[i],
+                -ay[:, i] / sec_r[i],
+                pri_r / sec_r[i],
+                sec_u[i],
+            )
+            for j, _ in enumerate(self.secondaries):
+                if i == j:
+                    continue
+                X_sec += occultation(
+                    (-x[:, i] + x[:, j]) / sec_r[i],
+                    (-y[:, i] + y[:, j]) / sec_r[i],
+                    (-z[:, i] + z[:, j]) / sec_r[i],
+                    (-vx[:, i] + vx[:, j]) / sec_r[i],
+                    (-vy[:, i] + vy[:, j]) / sec_r[i],
+                    (-ax[:, i] + ax[:, j]) / sec_r[i],
+                    (-ay[:, i] + ay[:, j]) / sec_r[i],
+                    sec_r[j] / sec_r[i],
+                    sec_u[i],
+                )
+            X.append(sec_L[i] * X_sec)
+
+        return tt.stack(X, axis=1)
+
     @autocompile
     def rv(
         self,
@@ -1571,6 +1973,9 @@ class OpsSystem(object):
         rv = Iv * invI
 
         # Compute the Keplerian RV
+        assert (
+            exoplanet is not None
+        ), "This method requires exoplanet >= 0.2.0."
         orbit = exoplanet.orbits.KeplerianOrbit(
             period=sec_porb,
             t0=sec_t0,
@@ -1633,27 +2038,17 @@ class OpsSystem(object):
     ):
         """Render all of the bodies in the system."""
         # Compute the relative positions of all bodies
-        orbit = exoplanet.orbits.KeplerianOrbit(
-            period=sec_porb,
-            t0=sec_t0,
-            incl=sec_iorb,
-            ecc=sec_ecc,
-            omega=sec_w,
-            Omega=sec_Omega,
-            m_planet=sec_m,
-            m_star=pri_m,
-            r_star=pri_r,
+        x, y, z, _, _, _ = self._kepler(
+            t,
+            pri_m,
+            sec_m,
+            sec_t0,
+            sec_porb,
+            sec_ecc,
+            sec_w,
+            sec_Omega,
+            sec_iorb,
         )
-        try:
-            x, y, z = orbit.get_relative_position(
-                t, light_delay=self.light_delay
-            )
-        except TypeError:
-            if self.light_delay:
-                logger.warn(
-                    "This version of `exoplanet` does not model light delays."
-                )
-            x, y, z = orbit.get_relative_position(t)
 
         # Get all rotational phases
         pri_prot = ifelse(
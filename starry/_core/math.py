@@ -1,6 +1,9 @@
 # -*- coding: utf-8 -*-
 from .. import config
+from .. import _c_ops
 from .utils import *
+from .utils import is_theano
+from .ops import BandedOp, SemiseparableOp
 from .._constants import *
 import theano
 import theano.tensor as tt
@@ -132,6 +135,116 @@ def _cho_solve(cho_A, b):
     return _solve_upper(tt.transpose(cho_A), _solve_lower(cho_A, b))
 
 
+# Linear solve with a semiseparable matrix
+_semiseparable = SemiseparableOp(_c_ops.semiseparable)
+
+
+def _semiseparable_solve(t, diag, a, c, Y):
+    """
+    Return `C^-1 Y` and `log |C|` for the semiseparable covariance
+    with elements `diag_n delta_nm + sum_j a_j exp(-c_j |t_n - t_m|)`.
+
+    """
+    a = a * tt.ones((1, 1))
+    c = c * tt.ones((1, 1))
+    U = tt.ones_like(tt.shape_padright(t)) * a
+    V = tt.ones_like(U)
+    A = diag * tt.ones_like(t) + tt.sum(a)
+    P = tt.exp(-tt.shape_padright(t[1:] - t[:-1]) * c)
+    return _semiseparable(A, U, V, P, Y)
+
+
+# Linear solve with a banded matrix
+_banded = BandedOp(_c_ops.banded)
+
+
+def _map_solution(X, flux, C_solve, mu, LInv):
+    """
+    Return the MAP coefficients and the Cholesky factorization of their
+    covariance, given a function `C_solve(Y)` returning `C^-1 Y` and
+    `log |C|` for the data covariance `C`.
+
+    """
+    # Compute C^-1 . f and C^-1 . X
+    Y = tt.concatenate((tt.reshape(flux, (-1, 1)), X), axis=1)
+    Z, _ = C_solve(Y)
+    CInvf = Z[:, 0]
+    CInvX = Z[:, 1:]
+
+    # Compute W = X^T . C^-1 . X + L^-1
+    W = _add_prior(tt.dot(tt.transpose(X), CInvX), LInv)
+    if LInv.ndim == 0 or LInv.ndim == 1:
+        LInvmu = mu * LInv
+    else:
+        LInvmu = tt.dot(LInv, mu)
+
+    # Compute the max like y and its covariance matrix
+    cho_W = sla.cholesky(W)
+    yhat = _cho_solve(cho_W, tt.dot(tt.transpose(X), CInvf) + LInvmu)
+    ycov = _cho_solve(cho_W, tt.eye(cho_W.shape[0]))
+    cho_ycov = sla.cholesky(ycov)
+
+    return yhat, cho_ycov
+
+
+def _map_lnlike(X, flux, C_solve, mu, LInv, lndetL):
+    """
+    Return the log marginal likelihood of the data, given a function
+    `C_solve(Y)` returning `C^-1 Y` and `log |C|` for the data
+    covariance `C`. This uses the Woodbury identity and the matrix
+    determinant lemma, so no ``N x N`` matrices are formed.
+
+    """
+    # Residual vector
+    r = tt.reshape(flux - tt.dot(X, mu), (-1, 1))
+
+    # Compute C^-1 . r and C^-1 . X
+    Y = tt.concatenate((r, X), axis=1)
+    Z, lndetC = C_solve(Y)
+    CInvr = Z[:, :1]
+    CInvX = Z[:, 1:]
+
+    # Compute W = X^T . C^-1 . X + L^-1
+    W = _add_prior(tt.dot(tt.transpose(X), CInvX), LInv)
+    cho_W = sla.cholesky(W)
+
+    # Inverse of GP covariance via Woodbury identity
+    XTCInvr = tt.dot(tt.transpose(X), CInvr)
+    rSInvr = tt.dot(tt.transpose(r), CInvr) - tt.dot(
+        tt.transpose(XTCInvr), _cho_solve(cho_W, XTCInvr)
+    )
+
+    # Determinant of GP covariance
+    lndetW = 2 * tt.sum(tt.log(tt.diag(cho_W)))
+    lndetS = lndetW + lndetC + tt.sum(lndetL)
+
+    # Compute the marginal likelihood
+    N = X.shape[0]
+    lnlike = -0.5 * rSInvr
+    lnlike -= 0.5 * lndetS
+    lnlike -= 0.5 * N * tt.log(2 * np.pi)
+
+    return lnlike[0, 0]
+
+
+def _add_prior(W, LInv):
+    """Add the scalar, vector or matrix `LInv` to the matrix `W`."""
+    if LInv.ndim == 0 or LInv.ndim == 1:
+        return tt.inc_subtensor(
+            W[tuple((tt.arange(W.shape[0]), tt.arange(W.shape[0])))], LInv
+        )
+    else:
+        return W + LInv
+
+
+def _to_matrix(A, N):
+    """Return the scalar, vector or matrix `A` as a dense `N x N` matrix."""
+    A = np.array(A, dtype="float64")
+    if A.ndim < 2:
+        A = np.diag(A * np.ones(N))
+    return A
+
+
 class LinAlgType(type):
     """Linear algebra operations."""
 
@@ -139,12 +252,16 @@ class LinAlgType(type):
     def cho_solve(self, cho_A, b):
         return _cho_solve(cho_A, b)
 
-    @autocompile
     def solve(self, X, flux, cho_C, mu, LInv):
         """
         Compute the maximum a posteriori (MAP) prediction for the
         spherical harmonic coefficients of a map given a flux timeseries.
 
+        For numerical inputs and a scalar or diagonal data covariance,
+        the normal equations are accumulated in C++ a block of rows
+        at a time, so none of the large ``npts x Ny`` intermediates
+        are formed. Otherwise, this calls the Theano implementation.
+
         Args:
             X (matrix): The flux design matrix.
             flux (array): The flux timeseries.
@@ -160,11 +277,25 @@ class LinAlgType(type):
             covariance matrix.
 
         """
+        if not is_theano(X, flux, cho_C, mu, LInv) and np.ndim(cho_C) < 2:
+            mu = np.array(mu, dtype="float64")
+            return _c_ops.solve(
+                np.ascontiguousarray(X, dtype="float64"),
+                np.ascontiguousarray(flux, dtype="float64"),
+                np.atleast_1d(1.0 / np.array(cho_C, dtype="float64") ** 2),
+                mu,
+                _to_matrix(LInv, mu.shape[0]),
+            )
+        return self._solve(X, flux, cho_C, mu, LInv)
+
+    @autocompile
+    def _solve(self, X, flux, cho_C, mu, LInv):
+        """Theano implementation of :py:meth:`solve`."""
         # Compute C^-1 . X
         if cho_C.ndim == 0:
             CInvX = X / cho_C ** 2
         elif cho_C.ndim == 1:
-            CInvX = tt.dot(tt.diag(1 / cho_C ** 2), X)
+            CInvX = X / tt.reshape(cho_C ** 2, (-1, 1))
         else:
             CInvX = _cho_solve(cho_C, X)
 
@@ -270,13 +401,17 @@ class LinAlgType(type):
         # Residual vector
         r = tt.reshape(flux - gp_mu, (-1, 1))
 
-        # Inverse of GP covariance via Woodbury identity
+        # Apply the inverse data covariance. If it's a scalar or
+        # a vector, we never form an `N x N` matrix
         if CInv.ndim == 0:
             U = X * CInv
+            CInvr = r * CInv
         elif CInv.ndim == 1:
-            U = tt.dot(tt.diag(CInv), X)
+            U = X * tt.reshape(CInv, (-1, 1))
+            CInvr = r * tt.reshape(CInv, (-1, 1))
         else:
             U = tt.dot(CInv, X)
+            CInvr = tt.dot(CInv, r)
 
         if LInv.ndim == 0:
             W = tt.dot(tt.transpose(X), U) + LInv * tt.eye(U.shape[1])
@@ -286,33 +421,265 @@ class LinAlgType(type):
             W = tt.dot(tt.transpose(X), U) + LInv
         cho_W = sla.cholesky(W)
 
-        if CInv.ndim == 0:
-            SInv = CInv * tt.eye(U.shape[0]) - tt.dot(
-                U, _cho_solve(cho_W, tt.transpose(U))
-            )
-        elif CInv.ndim == 1:
-            SInv = tt.diag(CInv) - tt.dot(
-                U, _cho_solve(cho_W, tt.transpose(U))
-            )
-        else:
-            SInv = CInv - tt.dot(U, _cho_solve(cho_W, tt.transpose(U)))
+        # Inverse of GP covariance via Woodbury identity, applied
+        # directly to the residual vector
+        UTr = tt.dot(tt.transpose(U), r)
+        rSInvr = tt.dot(tt.transpose(r), CInvr) - tt.dot(
+            tt.transpose(UTr), _cho_solve(cho_W, UTr)
+        )
 
         # Determinant of GP covariance
         lndetW = 2 * tt.sum(tt.log(tt.diag(cho_W)))
-        lndetS = lndetW + lndetC + lndetL
+        lndetS = lndetW + lndetC + tt.sum(lndetL)
 
         # Compute the marginal likelihood
         N = X.shape[0]
-        lnlike = -0.5 * tt.dot(tt.transpose(r), tt.dot(SInv, r))
+        lnlike = -0.5 * rSInvr
         lnlike -= 0.5 * lndetS
         lnlike -= 0.5 * N * tt.log(2 * np.pi)
 
         return lnlike[0, 0]
 
+    @autocompile
+    def solve_semiseparable(self, X, flux, t, diag, a, c, mu, LInv):
+        """
+        Compute the maximum a posteriori (MAP) prediction for the
+        spherical harmonic coefficients of a map given a flux timeseries
+        with a semiseparable data covariance. The cost scales linearly
+        with the number of data points.
+
+        Args:
+            X (matrix): The flux design matrix.
+            flux (array): The flux timeseries.
+            t, diag, a, c: The parameters of the data covariance; see
+                :py:class:`linalg.Semiseparable`.
+            mu (array): The prior mean of the spherical harmonic coefficients.
+            LInv (scalar/vector/matrix): The inverse prior covariance of the
+                spherical harmonic coefficients.
+
+        Returns:
+            The vector of spherical harmonic coefficients corresponding to the
+            MAP solution and the Cholesky factorization of the corresponding
+            covariance matrix.
+
+        """
+        return _map_solution(
+            X,
+            flux,
+            lambda Y: _semiseparable_solve(t, diag, a, c, Y),
+            mu,
+            LInv,
+        )
+
+    @autocompile
+    def lnlike_semiseparable(self, X, flux, t, diag, a, c, mu, LInv, lndetL):
+        """
+        Compute the log marginal likelihood of the data given a design matrix
+        and a semiseparable data covariance. This uses the Woodbury identity
+        and the matrix determinant lemma, so the cost scales linearly with
+        the number of data points and no ``N x N`` matrices are formed.
+
+        Args:
+            X (matrix): The flux design matrix.
+            flux (array): The flux timeseries.
+            t, diag, a, c: The parameters of the data covariance; see
+                :py:class:`linalg.Semiseparable`.
+            mu (array): The prior mean of the spherical harmonic coefficients.
+            LInv (scalar/vector/matrix): The inverse prior covariance of the
+                spherical harmonic coefficients.
+            lndetL (scalar): The log determinant of the prior covariance.
+
+        Returns:
+            The log marginal likelihood of the `flux` vector conditioned on
+            the design matrix `X`.
+
+        """
+        return _map_lnlike(
+            X,
+            flux,
+            lambda Y: _semiseparable_solve(t, diag, a, c, Y),
+            mu,
+            LInv,
+            lndetL,
+        )
+
+    @autocompile
+    def solve_banded(self, X, flux, bands, mu, LInv):
+        """
+        Compute the maximum a posteriori (MAP) prediction for the
+        spherical harmonic coefficients of a map given a flux timeseries
+        with a banded data covariance. The cost scales as ``O(N p^2)``
+        for ``N`` data points and ``p`` subdiagonals.
+
+        Args:
+            X (matrix): The flux design matrix.
+            flux (array): The flux timeseries.
+            bands (matrix): The lower band storage of the data covariance;
+                see :py:class:`linalg.Banded`.
+            mu (array): The prior mean of the spherical harmonic coefficients.
+            LInv (scalar/vector/matrix): The inverse prior covariance of the
+                spherical harmonic coefficients.
+
+        Returns:
+            The vector of spherical harmonic coefficients corresponding to the
+            MAP solution and the Cholesky factorization of the corresponding
+            covariance matrix.
+
+        """
+        return _map_solution(X, flux, lambda Y: _banded(bands, Y), mu, LInv)
+
+    @autocompile
+    def lnlike_banded(self, X, flux, bands, mu, LInv, lndetL):
+        """
+        Compute the log marginal likelihood of the data given a design matrix
+        and a banded data covariance. This uses the Woodbury identity and
+        the matrix determinant lemma, so the cost scales as ``O(N p^2)``
+        and no ``N x N`` matrices are formed.
+
+        Args:
+            X (matrix): The flux design matrix.
+            flux (array): The flux timeseries.
+            bands (matrix): The lower band storage of the data covariance;
+                see :py:class:`linalg.Banded`.
+            mu (array): The prior mean of the spherical harmonic coefficients.
+            LInv (scalar/vector/matrix): The inverse prior covariance of the
+                spherical harmonic coefficients.
+            lndetL (scalar): The log determinant of the prior covariance.
+
+        Returns:
+            The log marginal likelihood of the `flux` vector conditioned on
+            the design matrix `X`.
+
+        """
+        return _map_lnlike(
+            X, flux, lambda Y: _banded(bands, Y), mu, LInv, lndetL
+        )
+
+    def solve_normal(self, W, b, mu, LInv):
+        """
+        Compute the maximum a posteriori (MAP) prediction for the
+        spherical harmonic coefficients of a map given the normal equations
+        ``W = X^T C^-1 X`` and ``b = X^T C^-1 f`` of the least-squares
+        problem. This works with numerical values only.
+
+        Args:
+            W (matrix): The data precision projected onto the coefficients.
+            b (vector): The data vector projected onto the coefficients.
+            mu (array): The prior mean of the spherical harmonic coefficients.
+            LInv (scalar/vector/matrix): The inverse prior covariance of the
+                spherical harmonic coefficients.
+
+        Returns:
+            The vector of spherical harmonic coefficients corresponding to the
+            MAP solution and the Cholesky factorization of the corresponding
+            covariance matrix.
+
+        """
+        mu = np.array(mu, dtype="float64")
+        return _c_ops.solve(
+            np.ascontiguousarray(W, dtype="float64"),
+            np.ascontiguousarray(b, dtype="float64"),
+            mu,
+            _to_matrix(LInv, mu.shape[0]),
+        )
+
+    def lnlike_normal(self, W, b, fCInvf, N, mu, LInv, lndetC, lndetL):
+        """
+        Compute the log marginal likelihood of the data given the normal
+        equations ``W = X^T C^-1 X`` and ``b = X^T C^-1 f`` of the
+        least-squares problem and ``f^T C^-1 f``. This uses the Woodbury
+        identity and the matrix determinant lemma, and works with
+        numerical values only.
+
+        Args:
+            W (matrix): The data precision projected onto the coefficients.
+            b (vector): The data vector projected onto the coefficients.
+            fCInvf (scalar): The data precision-weighted norm of the data.
+            N (int): The number of data points.
+            mu (array): The prior mean of the spherical harmonic coefficients.
+            LInv (scalar/vector/matrix): The inverse prior covariance of the
+                spherical harmonic coefficients.
+            lndetC (scalar): The log determinant of the data covariance.
+            lndetL (scalar): The log determinant of the prior covariance.
+
+        Returns:
+            The log marginal likelihood of the data.
+
+        """
+        mu = np.array(mu, dtype="float64")
+        cho_W = np.linalg.cholesky(W + _to_matrix(LInv, mu.shape[0]))
+
+        # Apply the inverse GP covariance to the residual vector
+        # `r = f - X mu` via the Woodbury identity
+        Wmu = np.dot(W, mu)
+        rCInvr = fCInvf - 2 * np.dot(mu, b) + np.dot(mu, Wmu)
+        z = scipy.linalg.solve_triangular(cho_W, b - Wmu, lower=True)
+        rSInvr = rCInvr - np.dot(z, z)
+
+        # Determinant of GP covariance
+        lndetW = 2 * np.sum(np.log(np.diag(cho_W)))
+        lndetS = lndetW + lndetC + np.sum(lndetL)
+
+        # Compute the marginal likelihood
+        return -0.5 * (rSInvr + lndetS + N * np.log(2 * np.pi))
+
 
 class linalg(metaclass=LinAlgType):
     """Miscellaneous linear algebra operations."""
 
+    class Semiseparable(object):
+        r"""A semiseparable data covariance matrix.
+
+        This is the covariance of white noise plus a sum of exponential
+        (``celerite``-style) kernels,
+
+        .. math::
+
+            C_{nm} = \sigma_n^2 \delta_{nm} +
+                \sum_j a_j e^{-c_j |t_n - t_m|},
+
+        which can be passed as the covariance ``C`` to the ``set_data``
+        methods. Solves and likelihood evaluations with this covariance
+        scale linearly with the number of data points.
+
+        Args:
+            t (vector): The times of the observations, in increasing order.
+            diag (scalar or vector): The white noise variance
+                :math:`\sigma_n^2`.
+            a (scalar or vector): The amplitudes :math:`a_j` of the
+                exponential kernels.
+            c (scalar or vector): The inverse timescales :math:`c_j` of the
+                exponential kernels.
+        """
+
+        def __init__(self, t, diag, a, c):
+            self.t, self.diag, self.a, self.c = math.cast(t, diag, a, c)
+            self.a = self.a * math.ones(1)
+            self.c = self.c * math.ones(1)
+
+    class Banded(object):
+        r"""A banded data covariance matrix.
+
+        This is a symmetric covariance whose only nonzero elements are
+        within ``p`` places of the diagonal, such as white noise plus a
+        compactly supported kernel. It can be passed as the covariance
+        ``C`` to the ``set_data`` methods. Solves and likelihood
+        evaluations with this covariance use a banded Cholesky
+        factorization, whose cost scales as ``O(N p^2)`` for ``N`` data
+        points.
+
+        Args:
+            bands (matrix): The ``(p + 1) x N`` lower band storage of the
+                covariance, as in :py:func:`scipy.linalg.cholesky_banded`:
+                ``bands[k, n]`` is the element ``C[n + k, n]``. The last
+                ``k`` entries of row ``k`` are ignored.
+        """
+
+        def __init__(self, bands):
+            self.bands = math.cast(bands)
+            if self.bands.ndim != 2:
+                raise ValueError("The bands must be a two-dimensional array.")
+
     class Covariance(object):
         """A container for covariance matrices.
 
@@ -339,6 +706,26 @@ class linalg(metaclass=LinAlgType):
                 self.kind = "cholesky"
                 self.N = cho_C.shape[0]
 
+            # User provided a semiseparable covariance
+            elif isinstance(C, linalg.Semiseparable):
+
+                self.value = C
+                self.cholesky = None
+                self.inverse = None
+                self.lndet = None
+                self.kind = "semiseparable"
+                self.N = C.t.shape[0]
+
+            # User provided a banded covariance
+            elif isinstance(C, linalg.Banded):
+
+                self.value = C
+                self.cholesky = None
+                self.inverse = None
+                self.lndet = None
+                self.kind = "banded"
+                self.N = C.bands.shape[1]
+
             # User provided the covariance as a scalar, vector, or matrix
             elif C is not None:
 
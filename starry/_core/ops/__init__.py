@@ -1,10 +1,15 @@
 # -*- coding: utf-8 -*-
 from .exceptions import *
+from .banded import *
+from .design import *
 from .diffrot import *
 from .filter import *
 from .integration import *
+from .kepler import *
 from .limbdark import *
 from .minimize import *
 from .polybasis import *
+from .render import *
 from .rotation import *
+from .semiseparable import *
 from .spot import *
@@ -0,0 +1,15 @@
+# -*- coding: utf-8 -*-
+from .semiseparable import SemiseparableOp
+
+__all__ = ["BandedOp"]
+
+
+class BandedOp(SemiseparableOp):
+    """
+    Solve the linear system `C Z = Y` for a symmetric banded matrix `C`
+    and compute its log determinant. The inputs are the lower band
+    storage `B` of `C` (see `linalg.h`) and the right hand side `Y`;
+    the outputs are `Z` and `log |C|`. The gradient op is the same as
+    for :py:class:`SemiseparableOp`.
+
+    """
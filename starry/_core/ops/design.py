@@ -0,0 +1,65 @@
+# -*- coding: utf-8 -*-
+from __future__ import division, print_function
+import numpy as np
+from theano import gof
+import theano.tensor as tt
+from ..utils import output_storage
+
+
+__all__ = ["XOp"]
+
+
+class XOp(tt.Op):
+    def __init__(self, func, Ny):
+        self.func = func
+        self.Ny = Ny
+        self._grad_op = XGradientOp(self)
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [tt.TensorType(inputs[-1].dtype, (False, False))()]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return [shapes[0] + (tt.as_tensor(self.Ny),)]
+
+    def R_op(self, inputs, eval_points):
+        if eval_points[0] is None:
+            return eval_points
+        return self.grad(inputs, eval_points)
+
+    def perform(self, node, inputs, outputs):
+        out = output_storage(outputs[0], (np.shape(inputs[0])[0], self.Ny))
+        self.func(*inputs, out=out)
+        outputs[0][0] = out
+
+    def grad(self, inputs, gradients):
+        return self._grad_op(*(inputs + gradients))
+
+
+class XGradientOp(tt.Op):
+    def __init__(self, base_op):
+        self.base_op = base_op
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [i.type() for i in inputs[:-1]]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return shapes[:-1]
+
+    def perform(self, node, inputs, outputs):
+        theta, xo, yo, zo, ro, inc, obl, u, f, bX = inputs
+        btheta, bxo, byo, bro, binc, bobl, bu, bf = self.base_op.func(
+            theta, xo, yo, zo, ro, inc, obl, u, f, bX
+        )
+        outputs[0][0] = np.reshape(btheta, np.shape(theta))
+        outputs[1][0] = np.reshape(bxo, np.shape(xo))
+        outputs[2][0] = np.reshape(byo, np.shape(yo))
+        outputs[3][0] = np.zeros_like(zo)
+        outputs[4][0] = np.reshape(bro, np.shape(ro))
+        outputs[5][0] = np.reshape(binc, np.shape(inc))
+        outputs[6][0] = np.reshape(bobl, np.shape(obl))
+        outputs[7][0] = np.reshape(bu, np.shape(u))
+        outputs[8][0] = np.reshape(bf, np.shape(f))
@@ -3,6 +3,7 @@ from __future__ import division, print_function
 import numpy as np
 from theano import gof
 import theano.tensor as tt
+from ..utils import output_storage
 
 
 __all__ = ["tensordotDOp"]
@@ -27,7 +28,11 @@ class tensordotDOp(tt.Op):
         return self.grad(inputs, eval_points)
 
     def perform(self, node, inputs, outputs):
-        outputs[0][0] = self.func(*inputs)
+        M, wta = inputs
+        shape = (np.shape(wta)[0], np.shape(M)[-1])
+        out = output_storage(outputs[0], shape)
+        self.func(M, wta, out=out)
+        outputs[0][0] = out
 
     def grad(self, inputs, gradients):
         return self._grad_op(*(inputs + gradients))
@@ -3,6 +3,7 @@ from __future__ import division, print_function
 import numpy as np
 from theano import gof
 import theano.tensor as tt
+from ..utils import output_storage
 
 
 __all__ = ["FOp"]
@@ -29,7 +30,9 @@ class FOp(tt.Op):
         return self.grad(inputs, eval_points)
 
     def perform(self, node, inputs, outputs):
-        outputs[0][0] = self.func(*inputs)
+        out = output_storage(outputs[0], (self.N, self.Ny))
+        self.func(*inputs, out=out)
+        outputs[0][0] = out
 
     def grad(self, inputs, gradients):
         return self._grad_op(*(inputs + gradients))
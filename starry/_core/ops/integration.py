@@ -3,9 +3,10 @@ from __future__ import division, print_function
 import numpy as np
 from theano import gof
 import theano.tensor as tt
+from ..utils import output_storage
 
 
-__all__ = ["sTOp", "rTReflectedOp"]
+__all__ = ["sTOp", "rTReflectedOp", "sTReflectedOp"]
 
 
 class sTOp(tt.Op):
@@ -28,7 +29,9 @@ class sTOp(tt.Op):
         return self.grad(inputs, eval_points)
 
     def perform(self, node, inputs, outputs):
-        outputs[0][0] = self.func(*inputs)
+        out = output_storage(outputs[0], (np.shape(inputs[0])[0], self.N))
+        self.func(*inputs, out=out)
+        outputs[0][0] = out
 
     def grad(self, inputs, gradients):
         return self._grad_op(*(inputs + gradients))
@@ -72,7 +75,9 @@ class rTReflectedOp(tt.Op):
         return self.grad(inputs, eval_points)
 
     def perform(self, node, inputs, outputs):
-        outputs[0][0] = self.func(inputs[0])
+        out = output_storage(outputs[0], (np.shape(inputs[0])[0], self.N))
+        self.func(inputs[0], out=out)
+        outputs[0][0] = out
 
     def grad(self, inputs, gradients):
         # NOTE: There may be a bug in Theano for custom Ops
@@ -98,3 +103,53 @@ class rTReflectedGradientOp(tt.Op):
     def perform(self, node, inputs, outputs):
         bb = self.base_op.func(*inputs)
         outputs[0][0] = np.reshape(bb, np.shape(inputs[0]))
+
+
+class sTReflectedOp(tt.Op):
+    def __init__(self, func, N):
+        self.func = func
+        self.N = N
+        self._grad_op = sTReflectedGradientOp(self)
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [tt.TensorType(inputs[0].dtype, (False, False))()]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return [shapes[0] + (tt.as_tensor(self.N),)]
+
+    def R_op(self, inputs, eval_points):
+        if eval_points[0] is None:
+            return eval_points
+        return self.grad(inputs, eval_points)
+
+    def perform(self, node, inputs, outputs):
+        out = output_storage(outputs[0], (np.shape(inputs[0])[0], self.N))
+        self.func(*inputs, out=out)
+        outputs[0][0] = out
+
+    def grad(self, inputs, gradients):
+        return self._grad_op(*(inputs + gradients))
+
+
+class sTReflectedGradientOp(tt.Op):
+    def __init__(self, base_op):
+        self.base_op = base_op
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [i.type() for i in inputs[:-1]]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return shapes[:-1]
+
+    def perform(self, node, inputs, outputs):
+        bterm, xo, yo, zo, ro, bsT = inputs
+        bb, bxo, byo, bro = self.base_op.func(*inputs)
+        outputs[0][0] = np.reshape(bb, np.shape(bterm))
+        outputs[1][0] = np.reshape(bxo, np.shape(xo))
+        outputs[2][0] = np.reshape(byo, np.shape(yo))
+        outputs[3][0] = np.zeros_like(zo)
+        outputs[4][0] = np.reshape(bro, np.shape(ro))
@@ -0,0 +1,70 @@
+# -*- coding: utf-8 -*-
+import numpy as np
+import theano
+from theano import gof
+import theano.tensor as tt
+
+__all__ = ["KeplerOp"]
+
+
+class KeplerOp(tt.Op):
+    """
+    Relative positions and velocities of the secondaries in a Keplerian
+    system. The inputs are the times, the primary mass and the masses,
+    reference times, periods, eccentricities, arguments of pericenter,
+    longitudes of ascending node and inclinations of the secondaries.
+    If `clight` is nonzero, the positions account for the light travel
+    time across the system.
+
+    """
+
+    def __init__(self, func, G, clight=0.0):
+        self.func = func
+        self.G = float(G)
+        self.clight = float(clight)
+        self._grad_op = KeplerGradientOp(self)
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [
+            tt.TensorType(inputs[0].dtype, (False, False))() for i in range(6)
+        ]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return [(shapes[0][0], shapes[2][0]) for i in range(6)]
+
+    def perform(self, node, inputs, outputs):
+        res = self.func(*inputs, self.G, self.clight)
+        for i in range(6):
+            outputs[i][0] = res[i]
+
+    def grad(self, inputs, gradients):
+        results = self(*inputs)
+        gradients = [
+            tt.zeros_like(r)
+            if isinstance(g.type, theano.gradient.DisconnectedType)
+            else g
+            for r, g in zip(results, gradients)
+        ]
+        return self._grad_op(*(inputs + gradients))
+
+
+class KeplerGradientOp(tt.Op):
+    def __init__(self, base_op):
+        self.base_op = base_op
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [i.type() for i in inputs[:-6]]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return shapes[:-6]
+
+    def perform(self, node, inputs, outputs):
+        res = self.base_op.func(
+            *inputs[:-6], self.base_op.G, self.base_op.clight, *inputs[-6:]
+        )
+        for i in range(len(outputs)):
+            outputs[i][0] = np.reshape(res[i], np.shape(inputs[i]))
@@ -7,6 +7,14 @@
 #ifndef _STARRY_BASIS_H_
 #define _STARRY_BASIS_H_
 
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <type_traits>
 #include "utils.h"
 
 namespace starry {
@@ -459,6 +467,237 @@ void computeU(int lmax, const Eigen::SparseMatrix<T> &A1,
   U1 = A1 * XU0;
 }
 
+/**
+The full-size change of basis matrices for a given total degree and
+normalization. These depend only on `(deg, norm)`, are expensive to
+compute, and are never modified once built, so a single instance is
+shared by every `Basis` that needs them.
+
+*/
+template <typename T>
+struct BasisMatrices {
+  Eigen::SparseMatrix<T> A1;    /**< The polynomial change of basis matrix */
+  Eigen::SparseMatrix<T> A1Inv; /**< Its inverse */
+  Eigen::SparseMatrix<T> A2;    /**< The Green's change of basis matrix */
+  Eigen::SparseMatrix<T> A;     /**< The full change of basis matrix */
+  Eigen::SparseMatrix<T> U1;    /**< Limb darkening to polynomial matrix */
+  RowVector<T> rT;              /**< The rotation solution vector */
+  RowVector<T> rTA1;            /**< The rotation vector in Ylm space */
+
+  explicit BasisMatrices(int deg, const T &norm) {
+    computeA1(deg, A1, norm);
+    computeA1Inv(deg, A1, A1Inv);
+    computeA(deg, A1, A2, A);
+    computerT(deg, rT);
+    rTA1 = rT * A1;
+    computeU(deg, A1, A, U1, norm);
+  }
+
+  BasisMatrices() {}
+};
+
+namespace cache {
+
+/**
+On-disk layout of the basis matrix cache. Every file starts with this
+header, followed by the seven arrays of `BasisMatrices` in declaration
+order. Sparse matrices are stored as their raw compressed column
+arrays (`outer`, `inner`, `values`), so the payload is flat and can be
+read back (or memory-mapped) without any parsing. Bump `version`
+whenever the layout or the way the matrices are computed changes.
+
+*/
+struct Header {
+  char magic[8];
+  int32_t version;
+  int32_t deg;
+  int32_t ndigits;
+  int32_t scalar_size;
+  double norm;
+};
+
+static const char magic[8] = {'S', 'T', 'A', 'R', 'R', 'Y', 'B', '\0'};
+static const int32_t version = 1;
+
+/**
+Return the path of the cache file for a given `(deg, norm)`, or an
+empty string if the disk cache is disabled. The cache lives in the
+directory given by the `STARRY_CACHE_DIR` environment variable.
+
+*/
+inline std::string path(int deg, double norm) {
+  const char *dir = getenv("STARRY_CACHE_DIR");
+  if ((dir == nullptr) || (dir[0] == '\0')) return "";
+  uint64_t bits;
+  std::memcpy(&bits, &norm, sizeof(bits));
+  std::ostringstream os;
+  os << dir << "/basis_v" << version << "_d" << deg << "_n" << STARRY_NDIGITS
+     << "_" << std::hex << bits << ".bin";
+  return os.str();
+}
+
+template <typename T>
+inline void write(std::ostream &os, const Eigen::SparseMatrix<T> &M) {
+  int64_t dims[3] = {M.rows(), M.cols(), M.nonZeros()};
+  os.write((const char *)dims, sizeof(dims));
+  os.write((const char *)M.outerIndexPtr(), (dims[1] + 1) * sizeof(int));
+  os.write((const char *)M.innerIndexPtr(), dims[2] * sizeof(int));
+  os.write((const char *)M.valuePtr(), dims[2] * sizeof(T));
+}
+
+template <typename T>
+inline void write(std::ostream &os, const RowVector<T> &v) {
+  int64_t size = v.size();
+  os.write((const char *)&size, sizeof(size));
+  os.write((const char *)v.data(), size * sizeof(T));
+}
+
+template <typename T>
+inline bool read(std::istream &is, Eigen::SparseMatrix<T> &M) {
+  int64_t dims[3];
+  if (!is.read((char *)dims, sizeof(dims))) return false;
+  if ((dims[0] < 0) || (dims[1] < 0) || (dims[2] < 0)) return false;
+  M.resize(dims[0], dims[1]);
+  M.resizeNonZeros(dims[2]);
+  is.read((char *)M.outerIndexPtr(), (dims[1] + 1) * sizeof(int));
+  is.read((char *)M.innerIndexPtr(), dims[2] * sizeof(int));
+  is.read((char *)M.valuePtr(), dims[2] * sizeof(T));
+  return bool(is) && (M.outerIndexPtr()[dims[1]] == dims[2]);
+}
+
+template <typename T>
+inline bool read(std::istream &is, RowVector<T> &v) {
+  int64_t size;
+  if (!is.read((char *)&size, sizeof(size))) return false;
+  if (size < 0) return false;
+  v.resize(size);
+  return bool(is.read((char *)v.data(), size * sizeof(T)));
+}
+
+/**
+Attempt to load the matrices from disk. Returns `false` if the cache is
+disabled, the file is missing, or it was written by a different version
+or configuration of the code.
+
+The file is read with plain stream reads rather than memory-mapped:
+`BasisMatrices` owns ordinary `Eigen::SparseMatrix` storage, which
+`Basis` references directly, so a mapping would be copied out anyway.
+The files are also tiny compared to the sparse LU solves they replace.
+The flat layout would allow `Eigen::Map`s over an `mmap` if the
+matrices ever become views.
+
+*/
+template <typename T>
+inline bool load(int deg, double norm, BasisMatrices<T> &M) {
+  std::string fname = path(deg, norm);
+  if (fname.empty()) return false;
+  std::ifstream is(fname, std::ios::binary);
+  if (!is) return false;
+  Header h;
+  if (!is.read((char *)&h, sizeof(h))) return false;
+  if ((std::memcmp(h.magic, magic, sizeof(magic)) != 0) ||
+      (h.version != version) || (h.deg != deg) ||
+      (h.ndigits != STARRY_NDIGITS) || (h.scalar_size != int(sizeof(T))) ||
+      (h.norm != norm))
+    return false;
+  int N = (deg + 1) * (deg + 1);
+  if (!(read(is, M.A1) && read(is, M.A1Inv) && read(is, M.A2) &&
+        read(is, M.A) && read(is, M.U1) && read(is, M.rT) && read(is, M.rTA1)))
+    return false;
+  return (M.A1.rows() == N) && (M.A1.cols() == N) && (M.A1Inv.rows() == N) &&
+         (M.A1Inv.cols() == N) && (M.A2.rows() == N) && (M.A2.cols() == N) &&
+         (M.A.rows() == N) && (M.A.cols() == N) && (M.U1.rows() == N) &&
+         (M.U1.cols() == deg + 1) && (M.rT.size() == N) &&
+         (M.rTA1.size() == N);
+}
+
+/**
+Save the matrices to disk. The file is written under a temporary name
+and renamed into place, so concurrent processes never see a partially
+written cache. Failures are silently ignored: the cache is only an
+optimization.
+
+*/
+template <typename T>
+inline void save(int deg, double norm, const BasisMatrices<T> &M) {
+  std::string fname = path(deg, norm);
+  if (fname.empty()) return;
+  std::ostringstream tmp;
+  tmp << fname << ".tmp" << std::hex << std::this_thread::get_id() << "_"
+      << std::chrono::steady_clock::now().time_since_epoch().count();
+  {
+    std::ofstream os(tmp.str(), std::ios::binary | std::ios::trunc);
+    if (!os) return;
+    Header h;
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+    h.deg = deg;
+    h.ndigits = STARRY_NDIGITS;
+    h.scalar_size = sizeof(T);
+    h.norm = norm;
+    os.write((const char *)&h, sizeof(h));
+    write(os, M.A1);
+    write(os, M.A1Inv);
+    write(os, M.A2);
+    write(os, M.A);
+    write(os, M.U1);
+    write(os, M.rT);
+    write(os, M.rTA1);
+    if (!os) {
+      os.close();
+      std::remove(tmp.str().c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp.str().c_str(), fname.c_str()) != 0)
+    std::remove(tmp.str().c_str());
+}
+
+/**
+Build the matrices, going through the disk cache when the scalar type
+can be stored as raw bytes (i.e., not for multiprecision types).
+
+*/
+template <typename T>
+inline std::shared_ptr<const BasisMatrices<T>> build(int deg, const T &norm,
+                                                     std::true_type) {
+  auto M = std::make_shared<BasisMatrices<T>>();
+  if (load(deg, double(norm), *M)) return M;
+  M = std::make_shared<BasisMatrices<T>>(deg, norm);
+  save(deg, double(norm), *M);
+  return M;
+}
+
+template <typename T>
+inline std::shared_ptr<const BasisMatrices<T>> build(int deg, const T &norm,
+                                                     std::false_type) {
+  return std::make_shared<const BasisMatrices<T>>(deg, norm);
+}
+
+}  // namespace cache
+
+/**
+Return the (shared, immutable) change of basis matrices for a given
+degree and normalization. Matrices are computed at most once per
+process and reused by every `Basis` with the same `(deg, norm)`.
+
+*/
+template <typename T>
+inline std::shared_ptr<const BasisMatrices<T>> getBasisMatrices(int deg,
+                                                                const T &norm) {
+  static std::mutex mutex;
+  static std::map<std::pair<int, double>,
+                  std::shared_ptr<const BasisMatrices<T>>>
+      registry;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &M = registry[std::make_pair(deg, double(norm))];
+  if (!M)
+    M = cache::build<T>(
+        deg, norm,
+        std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+  return M;
+}
+
 // --
 
 /**
@@ -472,18 +711,23 @@ class Basis {
   const int udeg; /**< The highest degree of the limb darkening map */
   const int fdeg; /**< The highest degree of the filter map */
   const int deg;
-  const double norm;         /**< Map normalization constant */
+  const double norm; /**< Map normalization constant */
+
+ protected:
+  std::shared_ptr<const BasisMatrices<T>> matrices; /**< Shared matrices */
+
+ public:
   Eigen::SparseMatrix<T> A1; /**< The polynomial change of basis matrix */
-  Eigen::SparseMatrix<T>
-      A1_big; /**< The augmented polynomial change of basis matrix */
+  const Eigen::SparseMatrix<T>
+      &A1_big; /**< The augmented polynomial change of basis matrix */
   Eigen::SparseMatrix<T> A1_f; /**< The polynomial change of basis matrix for
                                   the filter operator */
-  Eigen::SparseMatrix<T>
-      A1Inv; /**< The inverse of the polynomial change of basis matrix */
-  Eigen::SparseMatrix<T> A2; /**< The Green's change of basis matrix */
-  Eigen::SparseMatrix<T> A;  /**< The full change of basis matrix */
-  RowVector<T> rT;           /**< The rotation solution vector */
-  RowVector<T> rTA1;         /**< The rotation vector in Ylm space */
+  const Eigen::SparseMatrix<T>
+      &A1Inv; /**< The inverse of the polynomial change of basis matrix */
+  Eigen::SparseMatrix<T> A2;        /**< The Green's change of basis matrix */
+  const Eigen::SparseMatrix<T> &A;  /**< The full change of basis matrix */
+  const RowVector<T> &rT;           /**< The rotation solution vector */
+  RowVector<T> rTA1;                /**< The rotation vector in Ylm space */
   Eigen::SparseMatrix<T>
       U1; /**< The limb darkening to polynomial change of basis matrix */
 
@@ -491,32 +735,20 @@ class Basis {
   RowVector<T> x_cache, y_cache, z_cache;
   Matrix<T, RowMajor> pT;
 
-  // Constructor: compute the matrices
+  // Constructor: fetch the shared augmented matrices
+  // and slice them to the shapes actually used in the code
   explicit Basis(int ydeg, int udeg, int fdeg, T norm = 2.0 / root_pi<T>()) :
       ydeg(ydeg), udeg(udeg), fdeg(fdeg), deg(ydeg + udeg + fdeg), norm(norm),
-      x_cache(0), y_cache(0), z_cache(0) {
-    // Compute the augmented matrices
-    Eigen::SparseMatrix<T> A1Inv_, A2_, A_, U1_;
-    RowVector<T> rT_, rTA1_;
-    computeA1(deg, A1_big, norm);
-    computeA1Inv(deg, A1_big, A1Inv_);
-    computeA(deg, A1_big, A2_, A_);
-    computerT(deg, rT_);
-    rTA1_ = rT_ * A1_big;
-    computeU(deg, A1_big, A_, U1_, norm);
-
-    // Resize to the shapes actually used
-    // in the code
+      matrices(getBasisMatrices<T>(deg, norm)), A1_big(matrices->A1),
+      A1Inv(matrices->A1Inv), A(matrices->A), rT(matrices->rT), x_cache(0),
+      y_cache(0), z_cache(0) {
     int Ny = (ydeg + 1) * (ydeg + 1);
     int Nf = (fdeg + 1) * (fdeg + 1);
     A1 = A1_big.block(0, 0, Ny, Ny);
     A1_f = A1_big.block(0, 0, Nf, Nf);
-    A1Inv = A1Inv_;
-    A2 = A2_.block(0, 0, Ny, Ny);
-    A = A_;
-    rT = rT_;
-    rTA1 = rTA1_.segment(0, Ny);
-    U1 = U1_.block(0, 0, (udeg + 1) * (udeg + 1), udeg + 1);
+    A2 = matrices->A2.block(0, 0, Ny, Ny);
+    rTA1 = matrices->rTA1.segment(0, Ny);
+    U1 = matrices->U1.block(0, 0, (udeg + 1) * (udeg + 1), udeg + 1);
   }
 
   /**
@@ -0,0 +1,510 @@
+/**
+\file design.h
+\brief Fused computation of the light curve design matrix.
+
+*/
+
+#ifndef _STARRY_DESIGN_H_
+#define _STARRY_DESIGN_H_
+
+#include "basis.h"
+#include "filter.h"
+#include "solver_emitted.h"
+#include "utils.h"
+#include "wigner.h"
+
+//! Number of rows of the design matrix computed at a time in each thread
+#ifndef STARRY_DESIGN_BLOCK
+#define STARRY_DESIGN_BLOCK 64
+#endif
+
+namespace starry {
+namespace design {
+
+using namespace utils;
+
+/**
+Compute `cos(m theta)` and `sin(m theta)` for `m = 0, ..., lmax`.
+
+*/
+template <class Scalar>
+inline void computeCosSin(int lmax, const Scalar &theta, RowVector<Scalar> &c,
+                          RowVector<Scalar> &s) {
+  c.resize(lmax + 1);
+  s.resize(lmax + 1);
+  c(0) = 1.0;
+  s(0) = 0.0;
+  if (lmax == 0) return;
+  c(1) = cos(theta);
+  s(1) = sin(theta);
+  for (int m = 2; m < lmax + 1; ++m) {
+    c(m) = c(m - 1) * c(1) - s(m - 1) * s(1);
+    s(m) = s(m - 1) * c(1) + c(m - 1) * s(1);
+  }
+}
+
+/**
+Rotate row `i` of the spherical harmonic matrix `M` about the z
+axis given the cosines and sines `c` and `s` of `m theta`,
+
+    out_{l,m} = M_{l,m} cos(m theta) + M_{l,-m} sin(m theta),
+
+and store it in row `i` of `out`. This is a single row of
+`Wigner::tensordotRz`.
+
+*/
+template <class Scalar>
+inline void rotateZ(int lmax, const RowVector<Scalar> &c,
+                    const RowVector<Scalar> &s,
+                    const Matrix<Scalar, RowMajor> &M, int i,
+                    Matrix<Scalar, RowMajor> &out) {
+  for (int l = 0; l < lmax + 1; ++l) {
+    int n0 = l * l + l;
+    out(i, n0) = M(i, n0);
+    for (int m = 1; m < l + 1; ++m) {
+      out(i, n0 + m) = M(i, n0 + m) * c(m) + M(i, n0 - m) * s(m);
+      out(i, n0 - m) = M(i, n0 - m) * c(m) - M(i, n0 + m) * s(m);
+    }
+  }
+}
+
+/**
+Backpropagate the gradient `bout` of row `i` of the output of
+`rotateZ` to row `i` of the input `M` (stored in row `i` of `bM`)
+and to the rotation angle (returned).
+
+*/
+template <class Scalar>
+inline Scalar rotateZ(int lmax, const RowVector<Scalar> &c,
+                      const RowVector<Scalar> &s,
+                      const Matrix<Scalar, RowMajor> &M, int i,
+                      const Matrix<Scalar, RowMajor> &bout,
+                      Matrix<Scalar, RowMajor> &bM) {
+  Scalar btheta = 0.0;
+  for (int l = 0; l < lmax + 1; ++l) {
+    int n0 = l * l + l;
+    bM(i, n0) = bout(i, n0);
+    for (int m = 1; m < l + 1; ++m) {
+      bM(i, n0 + m) = bout(i, n0 + m) * c(m) - bout(i, n0 - m) * s(m);
+      bM(i, n0 - m) = bout(i, n0 - m) * c(m) + bout(i, n0 + m) * s(m);
+      btheta += m * (bout(i, n0 + m) *
+                         (M(i, n0 - m) * c(m) - M(i, n0 + m) * s(m)) -
+                     bout(i, n0 - m) *
+                         (M(i, n0 + m) * c(m) + M(i, n0 - m) * s(m)));
+    }
+  }
+  return btheta;
+}
+
+/**
+Compute the product `M . R` of a matrix with a block-diagonal
+Wigner matrix `R` (or its transpose), one degree at a time.
+
+*/
+template <bool TRANSPOSE = false, class Scalar>
+inline void dotBlockDiagonal(int lmax, const Matrix<Scalar, RowMajor> &M,
+                             const Matrix<Scalar> &R,
+                             Matrix<Scalar, RowMajor> &MR) {
+  MR.resize(M.rows(), M.cols());
+  for (int l = 0; l < lmax + 1; ++l) {
+    if (TRANSPOSE)
+      MR.middleCols(l * l, 2 * l + 1).noalias() =
+          M.middleCols(l * l, 2 * l + 1) *
+          R.block(l * l, l * l, 2 * l + 1, 2 * l + 1).transpose();
+    else
+      MR.middleCols(l * l, 2 * l + 1).noalias() =
+          M.middleCols(l * l, 2 * l + 1) *
+          R.block(l * l, l * l, 2 * l + 1, 2 * l + 1);
+  }
+}
+
+/**
+The light curve design matrix for a spherical harmonic map.
+
+Each row is the occultation (or, for points not occulted, the
+rotation) solution vector transformed to the Ylm basis, filtered,
+and rotated into the observer's frame; this is the same sequence
+of operations as `OpsYlm.X` on the Python side, except that the
+rows are computed a block at a time so that the intermediates
+stay in cache. The rotation into the sky frame is block-diagonal
+and the same for every row, so it is computed once per call.
+Differential rotation is not supported.
+
+*/
+template <class Scalar>
+class DesignMatrix {
+ protected:
+  basis::Basis<Scalar> &B;
+  wigner::Wigner<Scalar> &W;
+  filter::Filter<Scalar> &F;
+  std::vector<std::unique_ptr<solver::GreensEmitted<Scalar>>> &Gs;
+  const int ydeg;
+  const int Ny;
+  const int deg;
+  const int N;
+  const bool filter;
+
+  // Operators shared by all rows
+  Matrix<Scalar> Rinc;      /**< Rotation about the inclination axis */
+  Matrix<Scalar> Rincobl;   /**< ... followed by rotation by `obl` */
+  Matrix<Scalar> Rsky;      /**< ... followed by rotation to the polar frame */
+  Matrix<Scalar> Rpolar;    /**< Rotation from the polar frame */
+  Matrix<Scalar> A1InvFA1;  /**< The filter operator in Ylm space */
+  RowVector<Scalar> rTA1F;  /**< The filtered rotation solution */
+  RowVector<Scalar> rTA1FR; /**< ... rotated to the polar frame */
+
+  /**
+  Compute the operators shared by all rows.
+
+  */
+  inline void computeOperators(const Scalar &inc, const Scalar &obl,
+                               const Vector<Scalar> &u,
+                               const Vector<Scalar> &f) {
+    Matrix<Scalar> I = Matrix<Scalar>::Identity(Ny, Ny);
+    W.dotR(I, -cos(obl), -sin(obl), Scalar(0.0), inc - 0.5 * pi<Scalar>());
+    Rinc = W.dotR_result;
+    W.dotR(Rinc, Scalar(0.0), Scalar(0.0), Scalar(1.0), obl);
+    Rincobl = W.dotR_result;
+    W.dotR(Rincobl, Scalar(1.0), Scalar(0.0), Scalar(0.0),
+           -0.5 * pi<Scalar>());
+    Rsky = W.dotR_result;
+    W.dotR(I, Scalar(1.0), Scalar(0.0), Scalar(0.0), 0.5 * pi<Scalar>());
+    Rpolar = W.dotR_result;
+    if (filter) {
+      F.computeF(u, f);
+      A1InvFA1 = B.A1Inv * F.F * B.A1;
+      rTA1F = B.rT * F.F * B.A1;
+    } else {
+      rTA1F = B.rTA1;
+    }
+    rTA1FR = rTA1F * Rsky;
+  }
+
+  /**
+  Return the indices of the points in `[start, end)` that are
+  occulted.
+
+  */
+  inline std::vector<int> getOcculted(const Ref<const Vector<double>> &xo,
+                                      const Ref<const Vector<double>> &yo,
+                                      const Ref<const Vector<double>> &zo,
+                                      const double &ro, size_t start,
+                                      size_t end) {
+    std::vector<int> occ;
+    if (ro == 0) return occ;
+    for (size_t n = start; n < end; ++n) {
+      double b = sqrt(xo(n) * xo(n) + yo(n) * yo(n));
+      if ((b < 1.0 + ro) && (zo(n) > 0)) occ.push_back(n - start);
+    }
+    return occ;
+  }
+
+ public:
+  // Gradient of the design matrix
+  Vector<Scalar> bu;
+  Vector<Scalar> bf;
+  Scalar binc;
+  Scalar bobl;
+  Scalar bro;
+
+  DesignMatrix(
+      basis::Basis<Scalar> &B, wigner::Wigner<Scalar> &W,
+      filter::Filter<Scalar> &F,
+      std::vector<std::unique_ptr<solver::GreensEmitted<Scalar>>> &Gs) :
+      B(B), W(W), F(F), Gs(Gs), ydeg(B.ydeg), Ny((ydeg + 1) * (ydeg + 1)),
+      deg(B.deg), N((deg + 1) * (deg + 1)), filter(B.udeg + B.fdeg > 0) {}
+
+  /**
+  Compute the design matrix a block of rows at a time in `nt`
+  threads, calling `func(thread, n0, XR)` on each block `XR`
+  of rows starting at row `n0`. The full matrix is never
+  stored, so this can be used to reduce it on the fly.
+
+  */
+  template <typename Function>
+  inline void computeBlocks(const Ref<const Vector<double>> &theta,
+                            const Ref<const Vector<double>> &xo,
+                            const Ref<const Vector<double>> &yo,
+                            const Ref<const Vector<double>> &zo,
+                            const double &ro, const double &inc,
+                            const double &obl, const Vector<Scalar> &u,
+                            const Vector<Scalar> &f,
+                            const solver::GreensEmittedTable<Scalar> &table,
+                            int nt, Function &&func) {
+    size_t npts = size_t(theta.size());
+    if (((size_t)xo.size() != npts) || ((size_t)yo.size() != npts) ||
+        ((size_t)zo.size() != npts))
+      throw std::runtime_error("Incompatible shapes in the design matrix.");
+    computeOperators(static_cast<Scalar>(inc), static_cast<Scalar>(obl), u, f);
+    Scalar r = static_cast<Scalar>(ro);
+    while (int(Gs.size()) < nt)
+      Gs.emplace_back(new solver::GreensEmitted<Scalar>(deg));
+    parallelFor(npts, nt, [&](int t, size_t start, size_t end) {
+      solver::GreensEmitted<Scalar> &G = *Gs[t];
+      Matrix<Scalar, RowMajor> sT, sTA, sTAR, V, Y, Z, XR;
+      RowVector<Scalar> c, s;
+      for (size_t n0 = start; n0 < end; n0 += STARRY_DESIGN_BLOCK) {
+        size_t n1 = std::min(n0 + STARRY_DESIGN_BLOCK, end);
+        int nrows = n1 - n0;
+
+        // Points that are not occulted get the rotation solution
+        Y.resize(nrows, Ny);
+        Y.rowwise() = rTA1FR;
+
+        // Occultation solution for the rest
+        std::vector<int> occ = getOcculted(xo, yo, zo, ro, n0, n1);
+        int nocc = occ.size();
+        if (nocc) {
+          Vector<Scalar> b(nocc);
+          for (int k = 0; k < nocc; ++k)
+            b(k) = sqrt(Scalar(xo(n0 + occ[k])) * xo(n0 + occ[k]) +
+                        Scalar(yo(n0 + occ[k])) * yo(n0 + occ[k]));
+          sT.resize(nocc, N);
+          solver::computeBatch<false>(G, table, b, r,
+                                      [&](int k) { sT.row(k) = G.sT; });
+          sTA = sT * B.A;
+          sTAR.resize(nocc, N);
+          for (int k = 0; k < nocc; ++k) {
+            computeCosSin(deg, Scalar(atan2(xo(n0 + occ[k]), yo(n0 + occ[k]))),
+                          c, s);
+            rotateZ(deg, c, s, sTA, k, sTAR);
+          }
+          if (filter)
+            V = sTAR * A1InvFA1;
+          else
+            V = sTAR;
+          dotBlockDiagonal(ydeg, V, Rsky, Z);
+          for (int k = 0; k < nocc; ++k) Y.row(occ[k]) = Z.row(k);
+        }
+
+        // Rotate to the correct phase and to the sky frame
+        Z.resize(nrows, Ny);
+        for (int i = 0; i < nrows; ++i) {
+          computeCosSin(ydeg, static_cast<Scalar>(theta(n0 + i)), c, s);
+          rotateZ(ydeg, c, s, Y, i, Z);
+        }
+        dotBlockDiagonal(ydeg, Z, Rpolar, XR);
+        func(t, n0, XR);
+      }
+    });
+  }
+
+  /**
+  Compute the design matrix, writing it into `X`.
+
+  */
+  inline void compute(const Ref<const Vector<double>> &theta,
+                      const Ref<const Vector<double>> &xo,
+                      const Ref<const Vector<double>> &yo,
+                      const Ref<const Vector<double>> &zo, const double &ro,
+                      const double &inc, const double &obl,
+                      const Vector<Scalar> &u, const Vector<Scalar> &f,
+                      const solver::GreensEmittedTable<Scalar> &table,
+                      int nthreads, Ref<Matrix<double, RowMajor>> X) {
+    size_t npts = size_t(theta.size());
+    if (((size_t)X.rows() != npts) || (X.cols() != Ny))
+      throw std::runtime_error("Output array has the wrong shape.");
+    computeBlocks(theta, xo, yo, zo, ro, inc, obl, u, f, table,
+                  getNumThreads(npts, nthreads),
+                  [&](int, size_t n0, const Matrix<Scalar, RowMajor> &XR) {
+                    X.block(n0, 0, XR.rows(), Ny) =
+                        XR.template cast<double>();
+                  });
+  }
+
+  /**
+  Backpropagate the gradient `bX` of the design matrix. The
+  gradients with respect to the vector arguments are written
+  into `btheta`, `bxo` and `byo`; the gradients with respect to
+  the remaining arguments are stored in the class members.
+
+  */
+  inline void compute(const Ref<const Vector<double>> &theta,
+                      const Ref<const Vector<double>> &xo,
+                      const Ref<const Vector<double>> &yo,
+                      const Ref<const Vector<double>> &zo, const double &ro,
+                      const double &inc, const double &obl,
+                      const Vector<Scalar> &u, const Vector<Scalar> &f,
+                      const solver::GreensEmittedTable<Scalar> &table,
+                      int nthreads,
+                      const Ref<const Matrix<double, RowMajor>> &bX,
+                      Ref<Vector<double>> btheta, Ref<Vector<double>> bxo,
+                      Ref<Vector<double>> byo) {
+    size_t npts = size_t(theta.size());
+    if (((size_t)xo.size() != npts) || ((size_t)yo.size() != npts) ||
+        ((size_t)zo.size() != npts))
+      throw std::runtime_error("Incompatible shapes in the design matrix.");
+    if (((size_t)bX.rows() != npts) || (bX.cols() != Ny))
+      throw std::runtime_error("Incompatible shapes in the design matrix.");
+    Scalar inc_ = static_cast<Scalar>(inc);
+    Scalar obl_ = static_cast<Scalar>(obl);
+    computeOperators(inc_, obl_, u, f);
+    Scalar r = static_cast<Scalar>(ro);
+    int nt = getNumThreads(npts, nthreads);
+    while (int(Gs.size()) < nt)
+      Gs.emplace_back(new solver::GreensEmitted<Scalar>(deg));
+
+    // Per-thread accumulators
+    std::vector<Matrix<Scalar>> bRsky_t(nt, Matrix<Scalar>::Zero(Ny, Ny));
+    std::vector<Matrix<Scalar>> bA1InvFA1_t(
+        nt, Matrix<Scalar>::Zero(filter ? N : 0, filter ? Ny : 0));
+    std::vector<RowVector<Scalar>> bYrot_t(nt, RowVector<Scalar>::Zero(Ny));
+    std::vector<Scalar> bro_t(nt, 0.0);
+
+    parallelFor(npts, nt, [&](int t, size_t start, size_t end) {
+      solver::GreensEmitted<Scalar> &G = *Gs[t];
+      Matrix<Scalar> &bRsky = bRsky_t[t];
+      Matrix<Scalar> &bA1InvFA1 = bA1InvFA1_t[t];
+      RowVector<Scalar> &bYrot = bYrot_t[t];
+      Scalar &br = bro_t[t];
+      Matrix<Scalar, RowMajor> dsTdb, dsTdr, sTA, sTAR, V, Y, bZ, bXR, bY,
+          bYocc, bV, bsTAR, bsTA, bsT;
+      RowVector<Scalar> c, s;
+      std::vector<Scalar> thetaz;
+      for (size_t n0 = start; n0 < end; n0 += STARRY_DESIGN_BLOCK) {
+        size_t n1 = std::min(n0 + STARRY_DESIGN_BLOCK, end);
+        int nrows = n1 - n0;
+
+        // Recompute the forward pass up to the phase rotation
+        Y.resize(nrows, Ny);
+        Y.rowwise() = rTA1FR;
+        std::vector<int> occ = getOcculted(xo, yo, zo, ro, n0, n1);
+        int nocc = occ.size();
+        Vector<Scalar> b(nocc);
+        thetaz.resize(nocc);
+        if (nocc) {
+          Matrix<Scalar, RowMajor> sT(nocc, N);
+          dsTdb.resize(nocc, N);
+          dsTdr.resize(nocc, N);
+          for (int k = 0; k < nocc; ++k) {
+            Scalar x = xo(n0 + occ[k]);
+            Scalar y = yo(n0 + occ[k]);
+            b(k) = sqrt(x * x + y * y);
+            thetaz[k] = atan2(x, y);
+          }
+          solver::computeBatch<true>(G, table, b, r, [&](int k) {
+            sT.row(k) = G.sT;
+            dsTdb.row(k) = G.dsTdb;
+            dsTdr.row(k) = G.dsTdr;
+          });
+          sTA = sT * B.A;
+          sTAR.resize(nocc, N);
+          for (int k = 0; k < nocc; ++k) {
+            computeCosSin(deg, thetaz[k], c, s);
+            rotateZ(deg, c, s, sTA, k, sTAR);
+          }
+          if (filter)
+            V = sTAR * A1InvFA1;
+          else
+            V = sTAR;
+          Matrix<Scalar, RowMajor> Z;
+          dotBlockDiagonal(ydeg, V, Rsky, Z);
+          for (int k = 0; k < nocc; ++k) Y.row(occ[k]) = Z.row(k);
+        }
+
+        // Backprop through the rotation to the sky frame and the phase
+        bXR = bX.block(n0, 0, nrows, Ny).template cast<Scalar>();
+        dotBlockDiagonal<true>(ydeg, bXR, Rpolar, bZ);
+        bY.resize(nrows, Ny);
+        for (int i = 0; i < nrows; ++i) {
+          computeCosSin(ydeg, static_cast<Scalar>(theta(n0 + i)), c, s);
+          btheta(n0 + i) = static_cast<double>(
+              rotateZ(ydeg, c, s, Y, i, bZ, bY));
+        }
+
+        // Backprop into the rotation solution rows
+        std::vector<bool> is_occ(nrows, false);
+        for (int k = 0; k < nocc; ++k) is_occ[occ[k]] = true;
+        for (int i = 0; i < nrows; ++i) {
+          bxo(n0 + i) = 0.0;
+          byo(n0 + i) = 0.0;
+          if (!is_occ[i]) bYrot += bY.row(i);
+        }
+        if (!nocc) continue;
+
+        // Backprop into the occultation solution rows
+        bYocc.resize(nocc, Ny);
+        for (int k = 0; k < nocc; ++k) bYocc.row(k) = bY.row(occ[k]);
+        for (int l = 0; l < ydeg + 1; ++l) {
+          bRsky.block(l * l, l * l, 2 * l + 1, 2 * l + 1) +=
+              V.middleCols(l * l, 2 * l + 1).transpose() *
+              bYocc.middleCols(l * l, 2 * l + 1);
+        }
+        dotBlockDiagonal<true>(ydeg, bYocc, Rsky, bV);
+        if (filter) {
+          bA1InvFA1 += sTAR.transpose() * bV;
+          bsTAR = bV * A1InvFA1.transpose();
+        } else {
+          bsTAR = bV;
+        }
+        bsTA.resize(nocc, N);
+        for (int k = 0; k < nocc; ++k) {
+          computeCosSin(deg, thetaz[k], c, s);
+          Scalar bthetaz = rotateZ(deg, c, s, sTA, k, bsTAR, bsTA);
+          Scalar x = xo(n0 + occ[k]);
+          Scalar y = yo(n0 + occ[k]);
+          Scalar bsq = b(k) * b(k);
+          Scalar bb = 0.0;
+          bsT = bsTA.row(k) * B.A.transpose();
+          bb = dsTdb.row(k).dot(bsT.row(0));
+          br += dsTdr.row(k).dot(bsT.row(0));
+          if (b(k) > 0) {
+            bxo(n0 + occ[k]) =
+                static_cast<double>(bb * x / b(k) + bthetaz * y / bsq);
+            byo(n0 + occ[k]) =
+                static_cast<double>(bb * y / b(k) - bthetaz * x / bsq);
+          }
+        }
+      }
+    });
+
+    // Reduce the thread accumulators
+    Matrix<Scalar> bRsky = Matrix<Scalar>::Zero(Ny, Ny);
+    Matrix<Scalar> bA1InvFA1;
+    RowVector<Scalar> bYrot = RowVector<Scalar>::Zero(Ny);
+    bro = 0.0;
+    if (filter) bA1InvFA1.setZero(N, Ny);
+    for (int t = 0; t < nt; ++t) {
+      bRsky += bRsky_t[t];
+      if (filter) bA1InvFA1 += bA1InvFA1_t[t];
+      bYrot += bYrot_t[t];
+      bro += bro_t[t];
+    }
+
+    // The rotation solution rows
+    bRsky += rTA1F.transpose() * bYrot;
+    RowVector<Scalar> brTA1F = bYrot * Rsky.transpose();
+
+    // Backprop through the sky frame rotations
+    binc = 0.0;
+    bobl = 0.0;
+    W.dotR(Rincobl, Scalar(1.0), Scalar(0.0), Scalar(0.0),
+           -0.5 * pi<Scalar>(), bRsky);
+    Matrix<Scalar> bRincobl = W.dotR_bM;
+    W.dotR(Rinc, Scalar(0.0), Scalar(0.0), Scalar(1.0), obl_, bRincobl);
+    Matrix<Scalar> bRinc = W.dotR_bM;
+    bobl += W.dotR_btheta;
+    Matrix<Scalar> I = Matrix<Scalar>::Identity(Ny, Ny);
+    W.dotR(I, -cos(obl_), -sin(obl_), Scalar(0.0),
+           inc_ - 0.5 * pi<Scalar>(), bRinc);
+    bobl += W.dotR_bx * sin(obl_) - W.dotR_by * cos(obl_);
+    binc += W.dotR_btheta;
+
+    // Backprop through the filter
+    if (filter) {
+      Matrix<Scalar> bF = B.rT.transpose() * (brTA1F * B.A1.transpose());
+      bF += B.A1Inv.transpose() * bA1InvFA1 * B.A1.transpose();
+      F.computeF(u, f, bF);
+      bu = F.bu;
+      bf = F.bf;
+    } else {
+      bu.setZero(u.size());
+      bf.setZero(f.size());
+    }
+  }
+};
+
+}  // namespace design
+}  // namespace starry
+
+#endif
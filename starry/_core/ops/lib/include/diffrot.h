@@ -7,6 +7,7 @@
 #ifndef _STARRY_DIFFROT_H_
 #define _STARRY_DIFFROT_H_
 
+#include <map>
 #include "basis.h"
 #include "utils.h"
 
@@ -18,12 +19,30 @@ using namespace utils;
 /**
 Differential rotation operator class.
 
+The operator is a polynomial in `wta` whose coefficients depend only
+on `ydeg` and `drorder`, so we expand it once in the constructor as
+
+    D(wta) = sum_p wta^p E_p
+
+(in Ylm space) and evaluate it for all times as a batched polynomial
+contraction.
+
 */
 template <typename Scalar>
 class DiffRot {
  protected:
+  /**
+  A term in the polynomial basis, indexed by `(l, m)`, whose
+  coefficient is itself a polynomial in `wta` (lowest power first).
+
+  */
+  struct Term {
+    int l;
+    int m;
+    Vector<Scalar> c;
+  };
+  using Terms = std::vector<Term>;
   using Triplet = Eigen::Triplet<Scalar>;
-  using Triplets = std::vector<Triplet>;
 
   basis::Basis<Scalar> &B;
   const int ydeg;    /**< */
@@ -32,17 +51,63 @@ class DiffRot {
   const int ddeg;
   const int Ddeg;
   const int ND;
-
-  Triplets t_0, t_1, t_x, t_z, t_neg_z, t_y;
-  Triplets t_c, t_s, t_dc, t_ds;
-  Triplets t_xc, t_zc, t_xs, t_zs, t_neg_zs;
-  Triplets t_dxc, t_dzc, t_dxs, t_dzs, t_neg_dzs;
-  Triplets t_xD, t_zD, t_dxD, t_dzD;
-  Triplets coeffs, dcoeffs;
-  std::vector<Triplets> t_D, t_dD;
+  const int wdeg;    /**< Degree of the operator as a polynomial in `wta` */
 
   Eigen::SparseMatrix<Scalar> A1, A1Inv;
-  Eigen::SparseMatrix<Scalar> D, dD;
+
+  // The coefficients `E_p` of the operator and their powers `p`
+  std::vector<int> powers;
+  std::vector<Eigen::SparseMatrix<Scalar>> E;
+
+  inline Term term(int l, int m, int p, const Scalar &value) const {
+    Term t;
+    t.l = l;
+    t.m = m;
+    t.c.setZero(wdeg + 1);
+    t.c(p) = value;
+    return t;
+  }
+
+  /**
+  Multiply two polynomials, merging terms with the same `(l, m)`.
+
+  */
+  inline void multiply(const Terms &p1, const Terms &p2, Terms &p1p2) const {
+    std::map<std::pair<int, int>, Vector<Scalar>> prod;
+    auto add = [&](int l, int m, const Vector<Scalar> &c) {
+      auto it = prod.find(std::make_pair(l, m));
+      if (it == prod.end())
+        prod[std::make_pair(l, m)] = c;
+      else
+        it->second += c;
+    };
+    Vector<Scalar> c(wdeg + 1);
+    for (const Term &t1 : p1) {
+      bool odd1 = (t1.l + t1.m) % 2 != 0;
+      for (const Term &t2 : p2) {
+        c.setZero();
+        for (int i = 0; i < wdeg + 1; ++i) {
+          if (t1.c(i) == 0) continue;
+          for (int j = 0; j < wdeg + 1 - i; ++j) c(i + j) += t1.c(i) * t2.c(j);
+        }
+        if (odd1 && ((t2.l + t2.m) % 2 != 0)) {
+          add(t1.l + t2.l - 2, t1.m + t2.m, c);
+          add(t1.l + t2.l, t1.m + t2.m - 2, -c);
+          add(t1.l + t2.l, t1.m + t2.m + 2, -c);
+        } else {
+          add(t1.l + t2.l, t1.m + t2.m, c);
+        }
+      }
+    }
+    p1p2.clear();
+    for (auto &t : prod) {
+      Term term;
+      term.l = t.first.first;
+      term.m = t.first.second;
+      term.c = t.second;
+      p1p2.push_back(term);
+    }
+  }
 
  public:
   Matrix<Scalar> tensordotD_result;
@@ -52,20 +117,13 @@ class DiffRot {
   // Constructor: compute the matrices
   explicit DiffRot(basis::Basis<Scalar> &B, const int &drorder) :
       B(B), ydeg(B.ydeg), Ny((ydeg + 1) * (ydeg + 1)), drorder(drorder),
-      ddeg(4 * drorder), Ddeg((ddeg + 1) * ydeg), ND((Ddeg + 1) * (Ddeg + 1)) {
+      ddeg(4 * drorder), Ddeg((ddeg + 1) * ydeg), ND((Ddeg + 1) * (Ddeg + 1)),
+      wdeg(2 * drorder * ydeg) {
     // Trivial cases
     if ((ydeg == 0) || (drorder == 0)) {
       return;
     }
 
-    // Initialize the constant triplets
-    t_0.push_back(Triplet(0, 0, 0));
-    t_1.push_back(Triplet(0, 0, 1));
-    t_x.push_back(Triplet(1, -1, 1));
-    t_z.push_back(Triplet(1, 0, 1));
-    t_neg_z.push_back(Triplet(1, 0, -1));
-    t_y.push_back(Triplet(1, 1, 1));
-
     // Pre-compute the change-of-basis matrices
     // A1 is (Ny x Ny) as usual, but we need
     // A1Inv to be (Ny x ND)
@@ -74,47 +132,83 @@ class DiffRot {
     A1Inv = A1Inv.topRows(Ny);
     A1 = B.A1;
 
-    // Initialize the sparse D matrix
-    D.resize(ND, Ny);
-    dD.resize(ND, Ny);
-  }
+    // Cosine and sine expansions
+    Terms c, s;
+    Scalar fac = 1.0;
+    for (int l = 0, p = 0; l < ddeg + 1; l += 4, p += 2) {
+      c.push_back(term(l, l, p, fac));
+      fac *= -4.0 / ((l + 4.0) * (l + 2.0));
+    }
+    fac = 1.0;
+    for (int l = 2, p = 1; l < ddeg + 1; l += 4, p += 2) {
+      s.push_back(term(l, l, p, fac));
+      fac *= -4.0 / ((l + 4.0) * (l + 2.0));
+    }
 
-  /**
-  Compute a sparse polynomial product using Eigen Triplets.
+    // Differentially-rotated x and z terms
+    Terms x{term(1, -1, 0, 1)}, y{term(1, 1, 0, 1)}, z{term(1, 0, 0, 1)},
+        neg_z{term(1, 0, 0, -1)};
+    Terms xD, zD, tmp;
+    multiply(x, c, xD);
+    multiply(neg_z, s, tmp);
+    xD.insert(xD.end(), tmp.begin(), tmp.end());
+    multiply(x, s, zD);
+    multiply(z, c, tmp);
+    zD.insert(zD.end(), tmp.begin(), tmp.end());
+
+    // The columns of the operator in polynomial space
+    std::vector<Terms> t_D(Ny);
+    t_D[0] = Terms{term(0, 0, 0, 1)};
+    t_D[1] = xD;
+    t_D[2] = zD;
+    t_D[3] = y;
+    for (int l = 2; l < ydeg + 1; ++l) {
+      // First index of previous & current degree
+      int np = (l - 1) * (l - 1);
+      int nc = l * l;
+
+      // Multiply every term of the previous degree by xD
+      int n = nc;
+      for (int j = np; j < nc; ++j) {
+        multiply(t_D[j], xD, t_D[n]);
+        ++n;
+      }
 
-  */
-  inline void computeSparsePolynomialProduct(const Triplets &p1,
-                                             const Triplets &p2,
-                                             Triplets &p1p2) {
-    int l1, m1, l2, m2;
-    bool odd1;
-    Scalar prod;
-    p1p2.clear();
-    for (Triplet t1 : p1) {
-      l1 = t1.row();
-      m1 = t1.col();
-      odd1 = (l1 + m1) % 2 == 0 ? false : true;
-      for (Triplet t2 : p2) {
-        l2 = t2.row();
-        m2 = t2.col();
-        prod = t1.value() * t2.value();
-        if (odd1 && ((l2 + m2) % 2 != 0)) {
-          p1p2.push_back(Triplet(l1 + l2 - 2, m1 + m2, prod));
-          p1p2.push_back(Triplet(l1 + l2, m1 + m2 - 2, -prod));
-          p1p2.push_back(Triplet(l1 + l2, m1 + m2 + 2, -prod));
-        } else {
-          p1p2.push_back(Triplet(l1 + l2, m1 + m2, prod));
+      // The last two terms of this degree
+      multiply(t_D[nc - 1], y, t_D[n + 1]);
+      multiply(t_D[nc - 2], y, t_D[n]);
+    }
+
+    // Split the operator by powers of `wta` and rotate to Ylm space
+    std::vector<std::vector<Triplet>> coeffs(wdeg + 1);
+    for (int col = 0; col < Ny; ++col) {
+      for (const Term &t : t_D[col]) {
+        int row = t.l * t.l + t.l + t.m;
+        for (int p = 0; p < wdeg + 1; ++p) {
+          if (t.c(p) != 0) coeffs[p].push_back(Triplet(row, col, t.c(p)));
         }
       }
     }
+    Eigen::SparseMatrix<Scalar> Dp(ND, Ny);
+    for (int p = 0; p < wdeg + 1; ++p) {
+      if (coeffs[p].empty()) continue;
+      Dp.setFromTriplets(coeffs[p].begin(), coeffs[p].end());
+      Eigen::SparseMatrix<Scalar> Ep = A1Inv * Dp * A1;
+      if (Ep.nonZeros() == 0) continue;
+      powers.push_back(p);
+      E.push_back(Ep);
+    }
   }
 
   /**
   Apply the differential rotation operator to a matrix `M` on the right.
+  Row `i` of `M` is rotated by `wta(i)`; the rows are split across
+  `nthreads` threads.
 
   */
   template <typename T1>
-  void tensordotD(const MatrixBase<T1> &M, const Vector<Scalar> &wta) {
+  void tensordotD(const MatrixBase<T1> &M, const Vector<Scalar> &wta,
+                  int nthreads = STARRY_NTHREADS) {
     // Trivial cases
     if ((ydeg == 0) || (drorder == 0)) {
       tensordotD_result = M;
@@ -126,101 +220,31 @@ class DiffRot {
     if (((size_t)M.rows() != npts) || ((int)M.cols() != Ny))
       throw std::runtime_error("Incompatible shapes in `tensordotD`.");
 
-    // Rotate the matrix into polynomial space
-    Matrix<Scalar> MA1Inv = M * A1Inv;
-    Matrix<Scalar> MA1InvD(npts, Ny);
-
-    // Loop over all times
-    for (int i = 0; i < wta.size(); ++i) {
-      Scalar wtai_2 = wta(i) * wta(i);
-      t_c.clear();
-      t_s.clear();
-      t_xD.clear();
-      t_zD.clear();
-
-      // Cosine expansion
-      Scalar fac = 1.0;
-      for (int l = 0; l < ddeg + 1; l += 4) {
-        t_c.push_back(Triplet(l, l, fac));
-        fac *= -(4.0 * wtai_2) / ((l + 4.0) * (l + 2.0));
-      }
-      computeSparsePolynomialProduct(t_x, t_c, t_xc);
-      computeSparsePolynomialProduct(t_z, t_c, t_zc);
-
-      // Sine expansion
-      fac = wta(i);
-      for (int l = 2; l < ddeg + 1; l += 4) {
-        t_s.push_back(Triplet(l, l, fac));
-        fac *= -(4.0 * wtai_2) / ((l + 4.0) * (l + 2.0));
-      }
-      computeSparsePolynomialProduct(t_x, t_s, t_xs);
-      computeSparsePolynomialProduct(t_z, t_s, t_zs);
-      computeSparsePolynomialProduct(t_neg_z, t_s, t_neg_zs);
-
-      // Differentially-rotated x and z terms
-      for (Triplet term : t_xc) t_xD.push_back(term);
-      for (Triplet term : t_neg_zs) t_xD.push_back(term);
-      for (Triplet term : t_xs) t_zD.push_back(term);
-      for (Triplet term : t_zc) t_zD.push_back(term);
-
-      // Construct the matrix
-      t_D.clear();
-      t_D.resize(Ny);
-
-      // l = 0
-      t_D[0] = t_1;
-
-      // l = 1
-      t_D[1] = t_xD;
-      t_D[2] = t_zD;
-      t_D[3] = t_y;
-
-      // Loop over the remaining degrees
-      int np, nc, n;
-      for (int l = 2; l < ydeg + 1; ++l) {
-        // First index of previous & current degree
-        np = (l - 1) * (l - 1);
-        nc = l * l;
-
-        // Multiply every term of the previous degree by xD
-        n = nc;
-        for (int j = np; j < nc; ++j) {
-          computeSparsePolynomialProduct(t_D[j], t_xD, t_D[n]);
-          ++n;
-        }
-
-        // The last two terms of this degree
-        computeSparsePolynomialProduct(t_D[nc - 1], t_y, t_D[n + 1]);
-        computeSparsePolynomialProduct(t_D[nc - 2], t_y, t_D[n]);
-      }
-
-      // Construct the sparse D operator from the triplets
-      coeffs.clear();
-      for (int col = 0; col < Ny; ++col) {
-        for (Triplet term : t_D[col]) {
-          int l = term.row();
-          int m = term.col();
-          int row = l * l + l + m;
-          coeffs.push_back(Triplet(row, col, term.value()));
-        }
-      }
-      D.setFromTriplets(coeffs.begin(), coeffs.end());
-
-      // Dot it into the current row
-      MA1InvD.row(i) = MA1Inv.row(i) * D;
-    }
-
-    // Rotate fully to Ylm space
-    tensordotD_result = MA1InvD * A1;
+    // Evaluate the polynomial for each chunk of times
+    tensordotD_result.setZero(npts, Ny);
+    int nt = getNumThreads(npts, nthreads);
+    parallelFor(npts, nt, [&](int, size_t start, size_t end) {
+      size_t n = end - start;
+      Matrix<Scalar> Mn = M.middleRows(start, n);
+      Matrix<Scalar> wp(n, wdeg + 1);
+      wp.col(0).setOnes();
+      for (int p = 1; p < wdeg + 1; ++p)
+        wp.col(p) = wp.col(p - 1).cwiseProduct(wta.segment(start, n));
+      Matrix<Scalar> result = Matrix<Scalar>::Zero(n, Ny);
+      for (size_t k = 0; k < E.size(); ++k)
+        result += wp.col(powers[k]).asDiagonal() * (Mn * E[k]);
+      tensordotD_result.middleRows(start, n) = result;
+    });
   }
 
   /**
   Compute the gradient of the differential rotation operation.
 
   */
-  template <typename T1>
+  template <typename T1, typename T2>
   inline void tensordotD(const MatrixBase<T1> &M, const Vector<Scalar> &wta,
-                         const Matrix<Scalar> &bf) {
+                         const MatrixBase<T2> &bf,
+                         int nthreads = STARRY_NTHREADS) {
     // Size checks
     size_t npts = wta.size();
     if (((size_t)M.rows() != npts) || ((int)M.cols() != Ny))
@@ -235,143 +259,30 @@ class DiffRot {
       return;
     }
 
-    // Temporary matrices for computing bM and bwta
-    Matrix<Scalar> A1bfT = A1 * bf.transpose();
-    Matrix<Scalar> DA1bfT(ND, npts);
-    Matrix<Scalar> MA1Inv = M * A1Inv;
-
-    // Loop over all times
-    for (int i = 0; i < wta.size(); ++i) {
-      t_c.clear();
-      t_dc.clear();
-      t_s.clear();
-      t_ds.clear();
-      t_xD.clear();
-      t_dxD.clear();
-      t_zD.clear();
-      t_dzD.clear();
-
-      // Cosine expansion
-      Scalar fac = 1.0;
-      Scalar dfac = 0.0;
-      Scalar tmp;
-      for (int l = 0; l < ddeg + 1; l += 4) {
-        t_c.push_back(Triplet(l, l, fac));
-        t_dc.push_back(Triplet(l, l, dfac));
-        tmp = -(4.0 * wta(i)) / ((l + 4.0) * (l + 2.0));
-        dfac = tmp * (wta(i) * dfac + 2 * fac);
-        fac = tmp * wta(i) * fac;
-      }
-      computeSparsePolynomialProduct(t_x, t_c, t_xc);
-      computeSparsePolynomialProduct(t_x, t_dc, t_dxc);
-      computeSparsePolynomialProduct(t_z, t_c, t_zc);
-      computeSparsePolynomialProduct(t_z, t_dc, t_dzc);
-
-      // Sine expansion
-      fac = wta(i);
-      dfac = 1.0;
-      for (int l = 2; l < ddeg + 1; l += 4) {
-        t_s.push_back(Triplet(l, l, fac));
-        t_ds.push_back(Triplet(l, l, dfac));
-        tmp = -(4.0 * wta(i)) / ((l + 4.0) * (l + 2.0));
-        dfac = tmp * (wta(i) * dfac + 2 * fac);
-        fac = tmp * wta(i) * fac;
-      }
-      computeSparsePolynomialProduct(t_x, t_s, t_xs);
-      computeSparsePolynomialProduct(t_x, t_ds, t_dxs);
-      computeSparsePolynomialProduct(t_z, t_s, t_zs);
-      computeSparsePolynomialProduct(t_z, t_ds, t_dzs);
-      computeSparsePolynomialProduct(t_neg_z, t_s, t_neg_zs);
-      computeSparsePolynomialProduct(t_neg_z, t_ds, t_neg_dzs);
-
-      // Differentially-rotated x and z terms
-      for (Triplet term : t_xc) t_xD.push_back(term);
-      for (Triplet term : t_dxc) t_dxD.push_back(term);
-      for (Triplet term : t_neg_zs) t_xD.push_back(term);
-      for (Triplet term : t_neg_dzs) t_dxD.push_back(term);
-      for (Triplet term : t_xs) t_zD.push_back(term);
-      for (Triplet term : t_dxs) t_dzD.push_back(term);
-      for (Triplet term : t_zc) t_zD.push_back(term);
-      for (Triplet term : t_dzc) t_dzD.push_back(term);
-
-      // Construct the matrix
-      t_D.clear();
-      t_dD.clear();
-      t_D.resize(Ny);
-      t_dD.resize(Ny);
-
-      // l = 0
-      t_D[0] = t_1;
-      t_dD[0] = t_0;
-
-      // l = 1
-      t_D[1] = t_xD;
-      t_dD[1] = t_dxD;
-      t_D[2] = t_zD;
-      t_dD[2] = t_dzD;
-      t_D[3] = t_y;
-      t_dD[3] = t_0;
-
-      // Loop over the remaining degrees
-      int np, nc, n;
-      for (int l = 2; l < ydeg + 1; ++l) {
-        // First index of previous & current degree
-        np = (l - 1) * (l - 1);
-        nc = l * l;
-
-        // Multiply every term of the previous degree by xD
-        n = nc;
-        for (int j = np; j < nc; ++j) {
-          computeSparsePolynomialProduct(t_D[j], t_xD, t_D[n]);
-          // Chain rule
-          Triplets tmp;
-          computeSparsePolynomialProduct(t_dD[j], t_xD, t_dD[n]);
-          computeSparsePolynomialProduct(t_D[j], t_dxD, tmp);
-          for (Triplet term : tmp) {
-            t_dD[n].push_back(term);
-          }
-          ++n;
-        }
-
-        // The last two terms of this degree
-        computeSparsePolynomialProduct(t_D[nc - 1], t_y, t_D[n + 1]);
-        computeSparsePolynomialProduct(t_D[nc - 2], t_y, t_D[n]);
-        // Chain rule
-        computeSparsePolynomialProduct(t_dD[nc - 1], t_y, t_dD[n + 1]);
-        computeSparsePolynomialProduct(t_dD[nc - 2], t_y, t_dD[n]);
-
-      }
-
-      // Construct the sparse D operator from the triplets
-      coeffs.clear();
-      dcoeffs.clear();
-      for (int col = 0; col < Ny; ++col) {
-        for (Triplet term : t_D[col]) {
-          int l = term.row();
-          int m = term.col();
-          int row = l * l + l + m;
-          coeffs.push_back(Triplet(row, col, term.value()));
-        }
-        for (Triplet term : t_dD[col]) {
-          int l = term.row();
-          int m = term.col();
-          int row = l * l + l + m;
-          dcoeffs.push_back(Triplet(row, col, term.value()));
+    // The adjoint of the polynomial, and its derivative in `wta`
+    int nt = getNumThreads(npts, nthreads);
+    parallelFor(npts, nt, [&](int, size_t start, size_t end) {
+      size_t n = end - start;
+      Matrix<Scalar> Mn = M.middleRows(start, n);
+      Matrix<Scalar> bfn = bf.middleRows(start, n);
+      Matrix<Scalar> wp(n, wdeg + 1);
+      wp.col(0).setOnes();
+      for (int p = 1; p < wdeg + 1; ++p)
+        wp.col(p) = wp.col(p - 1).cwiseProduct(wta.segment(start, n));
+      Matrix<Scalar> bM = Matrix<Scalar>::Zero(n, Ny);
+      Vector<Scalar> bwta = Vector<Scalar>::Zero(n);
+      for (size_t k = 0; k < E.size(); ++k) {
+        int p = powers[k];
+        bM += (wp.col(p).asDiagonal() * bfn) * E[k].transpose();
+        if (p > 0) {
+          Matrix<Scalar> MEk = Mn * E[k];
+          bwta += Scalar(p) * wp.col(p - 1).cwiseProduct(
+                                  MEk.cwiseProduct(bfn).rowwise().sum());
         }
       }
-      D.setFromTriplets(coeffs.begin(), coeffs.end());
-      dD.setFromTriplets(dcoeffs.begin(), dcoeffs.end());
-
-      // Used to compute bM below
-      DA1bfT.col(i) = D * A1bfT.col(i);
-
-      // bwta
-      tensordotD_bwta(i) = MA1Inv.row(i) * dD * A1bfT.col(i);
-    }
-
-    // Finish computing bM
-    tensordotD_bM = (A1Inv * DA1bfT).transpose();
-
+      tensordotD_bM.middleRows(start, n) = bM;
+      tensordotD_bwta.segment(start, n) = bwta;
+    });
   }
 };
 
@@ -20,12 +20,18 @@ Based in part on Daniel Foreman-Mackey's
 #include "utils.h"
 #include <cmath>
 
+//! Number of lanes in the batched `CEL` evaluation
+#ifndef STARRY_ELLIP_LANES
+#define STARRY_ELLIP_LANES 8
+#endif
+
 namespace starry {
 namespace ellip {
 
 using std::abs;
 using utils::mach_eps;
 using utils::pi;
+using utils::Vector;
 
 /**
 Computes the function `cel(kc, p, a, b)` from Bulirsch (1969)
@@ -218,6 +224,142 @@ inline void CEL(T k2, T kc, T p, T a1, T a2, T a3, T b1, T b2, T b3, T &Piofk,
   Em1mKdm = 0.5 * pi<T>() * (a3 * m + b3) / (m * (m + p1));
 }
 
+/**
+Computes the function `cel(kc, p, a, b)` from Bulirsch (1969).
+Batched version of the three-integral overload above, which
+evaluates `Piofk`, `Eofk` and `Em1mKdm` for arrays of arguments.
+Points are processed in blocks of `STARRY_ELLIP_LANES` lanes,
+all of which are iterated until every lane in the block has
+converged. The lane arithmetic is written in terms of fixed-size
+Eigen arrays, so it gets vectorized on whatever instruction set
+we're compiling for (and falls back to scalar code otherwise).
+
+*/
+template <typename T>
+inline void CEL(const Vector<T> &k2_, const Vector<T> &kc_,
+                const Vector<T> &p_, const Vector<T> &a1_,
+                const Vector<T> &a2_, const Vector<T> &a3_,
+                const Vector<T> &b1_, const Vector<T> &b2_,
+                const Vector<T> &b3_, Vector<T> &Piofk, Vector<T> &Eofk,
+                Vector<T> &Em1mKdm) {
+  using Lanes = Eigen::Array<T, STARRY_ELLIP_LANES, 1>;
+  int npts = k2_.size();
+  Piofk.resize(npts);
+  Eofk.resize(npts);
+  Em1mKdm.resize(npts);
+  Lanes k2, kc, p, a1, a2, a3, b1, b2, b3, ca;
+  Lanes p1, pinv, pinv1, g, g1, f1, f2, f3, ee, m;
+  for (int n0 = 0; n0 < npts; n0 += STARRY_ELLIP_LANES) {
+    // Load the lanes, padding the last block by repeating a point.
+    // The initialization is branchy, so we do it one lane at a time.
+    for (int i = 0; i < STARRY_ELLIP_LANES; ++i) {
+      int n = n0 + i < npts ? n0 + i : npts - 1;
+      k2(i) = k2_(n);
+      kc(i) = kc_(n);
+      p(i) = p_(n);
+      a1(i) = a1_(n);
+      b1(i) = b1_(n);
+      a2(i) = a2_(n);
+      b2(i) = b2_(n);
+      a3(i) = a3_(n);
+      b3(i) = b3_(n);
+
+      // Bounds checks
+      if (unlikely(k2(i) > 1))
+        throw std::invalid_argument(
+            "Invalid value of `k2` passed to `ellip::CEL`.");
+      else if (unlikely((k2(i) == 1.0) || (kc(i) == 0.0)))
+        kc(i) = mach_eps<T>() * k2(i);
+      else if (unlikely(k2(i) < mach_eps<T>()))
+        k2(i) = mach_eps<T>();
+
+      // Tolerance
+      ca(i) = sqrt(mach_eps<T>() * k2(i));
+
+      // Initialize values
+      if (p(i) > 0.0) {
+        p(i) = sqrt(p(i));
+        pinv(i) = 1.0 / p(i);
+        b1(i) *= pinv(i);
+      } else {
+        T q = k2(i);
+        T g0 = 1.0 - p(i);
+        T f = g0 - k2(i);
+        q *= (b1(i) - a1(i) * p(i));
+        T ginv = 1.0 / g0;
+        p(i) = sqrt(f * ginv);
+        a1(i) = (a1(i) - b1(i)) * ginv;
+        pinv(i) = 1.0 / p(i);
+        b1(i) = -q * ginv * ginv * pinv(i) + a1(i) * p(i);
+      }
+    }
+
+    // Compute recursion
+    ee = kc;
+    m.setOnes();
+    f1 = a1;
+    a1 += b1 * pinv;
+    g = ee * pinv;
+    b1 += f1 * g;
+    b1 += b1;
+    p += g;
+    g = m;
+    p1.setOnes();
+    g1 = ee;
+    f2 = a2;
+    f3 = a3;
+    a2 += b2;
+    b2 += f2 * g1;
+    b2 += b2;
+    a3 += b3;
+    b3 += f3 * g1;
+    b3 += b3;
+    p1 += g1;
+    g1 = m;
+    m += kc;
+    size_t iter = 0;
+    while (((((g - kc).abs() > g * ca).any()) ||
+            (((g1 - kc).abs() > g1 * ca).any())) &&
+           (iter < STARRY_ELLIP_MAX_ITER)) {
+      kc = ee.sqrt();
+      kc += kc;
+      ee = kc * m;
+      f1 = a1;
+      f2 = a2;
+      f3 = a3;
+      pinv = p.inverse();
+      pinv1 = p1.inverse();
+      a1 += b1 * pinv;
+      a2 += b2 * pinv1;
+      a3 += b3 * pinv1;
+      g = ee * pinv;
+      g1 = ee * pinv1;
+      b1 += f1 * g;
+      b2 += f2 * g1;
+      b3 += f3 * g1;
+      b1 += b1;
+      b2 += b2;
+      b3 += b3;
+      p += g;
+      p1 += g1;
+      g = m;
+      m += kc;
+      ++iter;
+    }
+    if (iter == STARRY_ELLIP_MAX_ITER)
+      throw std::runtime_error("Elliptic integral CEL did not converge.");
+
+    // Store the results
+    int nlanes = npts - n0 < STARRY_ELLIP_LANES ? npts - n0 : STARRY_ELLIP_LANES;
+    Piofk.segment(n0, nlanes) =
+        (0.5 * pi<T>() * (a1 * m + b1) / (m * (m + p))).head(nlanes);
+    Eofk.segment(n0, nlanes) =
+        (0.5 * pi<T>() * (a2 * m + b2) / (m * (m + p1))).head(nlanes);
+    Em1mKdm.segment(n0, nlanes) =
+        (0.5 * pi<T>() * (a3 * m + b3) / (m * (m + p1))).head(nlanes);
+  }
+}
+
 } // namespace ellip
 } // namespace starry
 
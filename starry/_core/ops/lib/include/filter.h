@@ -7,6 +7,7 @@
 #ifndef _STARRY_FILTER_H_
 #define _STARRY_FILTER_H_
 
+#include <array>
 #include "basis.h"
 #include "utils.h"
 
@@ -32,13 +33,25 @@ class Filter {
   const int deg;  /**< */
   const int N;    /**< */
   const int Nuf;  /**< */
-  Vector<Eigen::SparseMatrix<Scalar>>
-      DFDp; /**< Deriv of the filter operator w/ respect to the complete filter
-               polynomial */
+
+  /**
+  A single term in the polynomial product matrix: the nonzero `k` of `F`
+  (its index into `F.valuePtr()`) in column `col` gets `sign` times the
+  `n`-th coefficient of the filter polynomial.
+
+  */
+  struct Term {
+    int k;
+    int col;
+    int n;
+    int sign;
+  };
+  std::vector<Term> terms; /**< The terms of `dF / dp`, sorted by `k` */
 
  public:
-  Matrix<Scalar>
-      F; /**< The filter operator in the polynomial basis. TODO: Make sparse? */
+  Eigen::SparseMatrix<Scalar>
+      F; /**< The filter operator in the polynomial basis. The sparsity
+            pattern is fixed at construction; only the values change. */
   Vector<Scalar> bu;
   Vector<Scalar> bf;
 
@@ -46,44 +59,9 @@ class Filter {
   explicit Filter(basis::Basis<Scalar> &B) :
       B(B), ydeg(B.ydeg), Ny((ydeg + 1) * (ydeg + 1)), udeg(B.udeg),
       Nu(udeg + 1), fdeg(B.fdeg), Nf((fdeg + 1) * (fdeg + 1)), deg(B.deg),
-      N((deg + 1) * (deg + 1)), Nuf((udeg + fdeg + 1) * (udeg + fdeg + 1)),
-      DFDp((udeg + fdeg + 1) * (udeg + fdeg + 1)) {
-    // Pre-compute dF / dp
-    computePolynomialProductMatrixGradient();
-  }
-
-  /**
-  Compute the polynomial product matrix.
-
-  */
-  inline void computePolynomialProductMatrix(const int plmax,
-                                             const Vector<Scalar> &p,
-                                             Matrix<Scalar> &M) {
-    bool odd1;
-    int l, n;
-    int n1 = 0, n2 = 0;
-    M.setZero((plmax + ydeg + 1) * (plmax + ydeg + 1), Ny);
-    for (int l1 = 0; l1 < ydeg + 1; ++l1) {
-      for (int m1 = -l1; m1 < l1 + 1; ++m1) {
-        odd1 = (l1 + m1) % 2 == 0 ? false : true;
-        n2 = 0;
-        for (int l2 = 0; l2 < plmax + 1; ++l2) {
-          for (int m2 = -l2; m2 < l2 + 1; ++m2) {
-            l = l1 + l2;
-            n = l * l + l + m1 + m2;
-            if (odd1 && ((l2 + m2) % 2 != 0)) {
-              M(n - 4 * l + 2, n1) += p(n2);
-              M(n - 2, n1) -= p(n2);
-              M(n + 2, n1) -= p(n2);
-            } else {
-              M(n, n1) += p(n2);
-            }
-            ++n2;
-          }
-        }
-        ++n1;
-      }
-    }
+      N((deg + 1) * (deg + 1)), Nuf((udeg + fdeg + 1) * (udeg + fdeg + 1)) {
+    // Pre-compute the sparsity pattern of F and dF / dp
+    computePolynomialProductMatrixPattern();
   }
 
   /**
@@ -125,17 +103,19 @@ class Filter {
   }
 
   /**
-  Compute the gradient of the polynomial product matrix.
-  This is independent of the filter polynomials, so we can
-  just pre-compute it!
+  Compute the sparsity pattern of the polynomial product matrix and the
+  individual terms that make it up. Since the matrix is linear in the
+  filter polynomial, these terms are also its gradient. This is
+  independent of the filter polynomials, so we can just pre-compute it!
 
   */
-  inline void computePolynomialProductMatrixGradient() {
+  inline void computePolynomialProductMatrixPattern() {
+    using Triplet = Eigen::Triplet<Scalar>;
     bool odd1;
     int l, n;
     int n1 = 0, n2 = 0;
-    Vector<Matrix<Scalar>> DFDp_dense(Nuf);
-    for (n = 0; n < Nuf; ++n) DFDp_dense(n).setZero(N, Ny);
+    std::vector<Triplet> pattern;
+    std::vector<std::array<int, 4>> raw;
     for (int l1 = 0; l1 < ydeg + 1; ++l1) {
       for (int m1 = -l1; m1 < l1 + 1; ++m1) {
         odd1 = (l1 + m1) % 2 == 0 ? false : true;
@@ -145,11 +125,11 @@ class Filter {
             l = l1 + l2;
             n = l * l + l + m1 + m2;
             if (odd1 && ((l2 + m2) % 2 != 0)) {
-              DFDp_dense[n2](n - 4 * l + 2, n1) += 1;
-              DFDp_dense[n2](n - 2, n1) -= 1;
-              DFDp_dense[n2](n + 2, n1) -= 1;
+              raw.push_back({{n - 4 * l + 2, n1, n2, 1}});
+              raw.push_back({{n - 2, n1, n2, -1}});
+              raw.push_back({{n + 2, n1, n2, -1}});
             } else {
-              DFDp_dense[n2](n, n1) += 1;
+              raw.push_back({{n, n1, n2, 1}});
             }
             ++n2;
           }
@@ -157,7 +137,26 @@ class Filter {
         ++n1;
       }
     }
-    for (n = 0; n < Nuf; ++n) DFDp(n) = DFDp_dense(n).sparseView();
+
+    // Build the (compressed) pattern
+    for (auto const &t : raw) pattern.push_back(Triplet(t[0], t[1], 1));
+    F.resize(N, Ny);
+    F.setFromTriplets(pattern.begin(), pattern.end());
+    F.makeCompressed();
+
+    // Locate each term in the value array
+    const int *outer = F.outerIndexPtr();
+    const int *inner = F.innerIndexPtr();
+    terms.resize(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+      int k = std::lower_bound(inner + outer[raw[i][1]],
+                               inner + outer[raw[i][1] + 1], raw[i][0]) -
+              inner;
+      terms[i] = {k, raw[i][1], raw[i][2], raw[i][3]};
+    }
+    std::sort(terms.begin(), terms.end(),
+              [](const Term &a, const Term &b) { return a.k < b.k; });
+    F.coeffs().setZero();
   }
 
   /**
@@ -227,7 +226,9 @@ class Filter {
     }
 
     // Compute the polynomial filter operator
-    computePolynomialProductMatrix(udeg + fdeg, p, F);
+    Scalar *values = F.valuePtr();
+    F.coeffs().setZero();
+    for (auto const &t : terms) values[t.k] += t.sign * p(t.n);
   }
 
   /**
@@ -256,9 +257,10 @@ class Filter {
       computePolynomialProduct(fdeg, pf, udeg, pu, DpDpf, DpDpu);
     }
 
-    // Backprop p
-    RowVector<Scalar> bp(Nuf);
-    for (int j = 0; j < Nuf; ++j) bp(j) = DFDp(j).cwiseProduct(bF).sum();
+    // Backprop p, gathering `bF` only at the nonzeros of `F`
+    const int *inner = F.innerIndexPtr();
+    RowVector<Scalar> bp = RowVector<Scalar>::Zero(Nuf);
+    for (auto const &t : terms) bp(t.n) += t.sign * bF(inner[t.k], t.col);
 
     // Compute the limb darkening derivatives
     Matrix<Scalar> DpuDu =
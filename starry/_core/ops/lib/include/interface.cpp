@@ -29,6 +29,86 @@ using Scalar = Multi;
 using Scalar = double;
 #endif
 
+// Zero-copy views of NumPy arrays. Inputs are only copied
+// if their dtype or memory layout doesn't match.
+using InMatrix = Eigen::Ref<const starry::utils::Matrix<double, RowMajor>>;
+using InRowVector = Eigen::Ref<const starry::utils::RowVector<double>>;
+using InVector = Eigen::Ref<const starry::utils::Vector<double>>;
+using OutMatrix = Eigen::Ref<starry::utils::Matrix<double, RowMajor>>;
+
+/**
+Copy a result into a preallocated output array.
+
+*/
+template <typename T>
+inline void copyToOutput(const Eigen::MatrixBase<T> &result, OutMatrix out) {
+  if ((out.rows() != result.rows()) || (out.cols() != result.cols()))
+    throw std::runtime_error("Output array has the wrong shape.");
+  out = result.template cast<double>();
+}
+
+/**
+Bind the projection operator `M . Rsky . Rz(theta) . Rpolar` (or, if
+`TRANSPOSE` is set, its transpose) and its gradient as `name`.
+
+*/
+template <bool TRANSPOSE>
+void defineProjection(py::class_<starry::Ops<Scalar>> &Ops, const char *name) {
+  using namespace starry::utils;
+
+  // Projection operator
+  Ops.def(name, [](starry::Ops<Scalar> &ops, const InMatrix &M,
+                   const double &inc, const double &obl,
+                   const InVector &theta) {
+    Matrix<double, RowMajor> MR;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.template dotProjection<TRANSPOSE>(
+          M.template cast<Scalar>(), static_cast<Scalar>(inc),
+          static_cast<Scalar>(obl), theta.template cast<Scalar>());
+      MR = ops.W.dotProjection_result.template cast<double>();
+    }
+    return MR;
+  });
+
+  // Gradient of the projection operator
+  Ops.def(name, [](starry::Ops<Scalar> &ops, const InMatrix &M,
+                   const double &inc, const double &obl,
+                   const InVector &theta, const InMatrix &bMR) {
+    Matrix<double, RowMajor> bM;
+    Vector<double> btheta;
+    double binc, bobl;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.template dotProjection<TRANSPOSE>(
+          M.template cast<Scalar>(), static_cast<Scalar>(inc),
+          static_cast<Scalar>(obl), theta.template cast<Scalar>(),
+          bMR.template cast<Scalar>());
+      bM = ops.W.dotProjection_bM.template cast<double>();
+      binc = static_cast<double>(ops.W.dotProjection_binc);
+      bobl = static_cast<double>(ops.W.dotProjection_bobl);
+      btheta = ops.W.dotProjection_btheta.template cast<double>();
+    }
+    return py::make_tuple(bM, binc, bobl, btheta);
+  });
+
+  // Projection operator (preallocated output)
+  Ops.def(name,
+          [](starry::Ops<Scalar> &ops, const InMatrix &M, const double &inc,
+             const double &obl, const InVector &theta, OutMatrix out) {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(ops.mutex);
+            ops.W.template dotProjection<TRANSPOSE>(
+                M.template cast<Scalar>(), static_cast<Scalar>(inc),
+                static_cast<Scalar>(obl), theta.template cast<Scalar>());
+            copyToOutput(ops.W.dotProjection_result, out);
+          },
+          py::arg("M"), py::arg("inc"), py::arg("obl"), py::arg("theta"),
+          py::arg("out"));
+}
+
 // Register the Python module
 PYBIND11_MODULE(_c_ops, m) {
   // Import some useful stuff
@@ -60,35 +140,54 @@ PYBIND11_MODULE(_c_ops, m) {
   Ops.def_property_readonly(
       "drorder", [](starry::Ops<Scalar> &ops) { return ops.drorder; });
 
+  // Number of threads used in batched calls (0 = one per core)
+  Ops.def_readwrite("nthreads", &starry::Ops<Scalar>::nthreads);
+
+  // Tolerance of the tabulated `sT` at fixed `r` (0 = exact solution)
+  Ops.def_property(
+      "sT_tol",
+      [](starry::Ops<Scalar> &ops) {
+        return static_cast<double>(ops.Gtable.getTolerance());
+      },
+      [](starry::Ops<Scalar> &ops, const double &tol) {
+        std::lock_guard<std::mutex> lock(ops.Gs_mutex);
+        ops.Gtable.setTolerance(static_cast<Scalar>(tol));
+      });
+
   // Occultation solution in emitted light
-  Ops.def("sT", [](starry::Ops<Scalar> &ops, const Vector<double> &b,
+  Ops.def("sT", [](starry::Ops<Scalar> &ops, const InVector &b,
                    const double &r) {
-    size_t npts = size_t(b.size());
-    Matrix<double, RowMajor> sT(npts, ops.N);
-    for (size_t n = 0; n < npts; ++n) {
-      ops.G.compute(static_cast<Scalar>(b(n)), static_cast<Scalar>(r));
-      sT.row(n) = ops.G.sT.template cast<double>();
+    Matrix<double, RowMajor> sT(b.size(), ops.N);
+    {
+      py::gil_scoped_release release;
+      ops.sT(b, r, sT);
     }
     return sT;
   });
 
   // Gradient of occultation solution in emitted light
-  Ops.def("sT", [](starry::Ops<Scalar> &ops, const Vector<double> &b,
-                   const double &r, const Matrix<double, RowMajor> &bsT) {
-    size_t npts = size_t(b.size());
-    Vector<double> bb(npts);
-    double br = 0.0;
-    for (size_t n = 0; n < npts; ++n) {
-      ops.G.template compute<true>(static_cast<Scalar>(b(n)),
-                                   static_cast<Scalar>(r));
-      bb(n) = static_cast<double>(
-          ops.G.dsTdb.dot(bsT.row(n).template cast<Scalar>()));
-      br += static_cast<double>(
-          ops.G.dsTdr.dot(bsT.row(n).template cast<Scalar>()));
+  Ops.def("sT", [](starry::Ops<Scalar> &ops, const InVector &b,
+                   const double &r, const InMatrix &bsT) {
+    Vector<double> bb(b.size());
+    double br;
+    {
+      py::gil_scoped_release release;
+      br = ops.sT(b, r, bsT, bb);
     }
     return py::make_tuple(bb, br);
   });
 
+  // Occultation solution in emitted light (preallocated output)
+  Ops.def("sT",
+          [](starry::Ops<Scalar> &ops, const InVector &b, const double &r,
+             OutMatrix out) {
+            if ((out.rows() != b.size()) || (out.cols() != ops.N))
+              throw std::runtime_error("Output array has the wrong shape.");
+            py::gil_scoped_release release;
+            ops.sT(b, r, out);
+          },
+          py::arg("b"), py::arg("r"), py::arg("out"));
+
   // Change of basis matrix: Ylm to poly
   Ops.def_property_readonly("A1", [](starry::Ops<Scalar> &ops) {
 #ifdef STARRY_MULTI
@@ -131,200 +230,761 @@ PYBIND11_MODULE(_c_ops, m) {
   });
 
   // Rotation solution in reflected light
-  Ops.def("rTReflected",
-          [](starry::Ops<Scalar> &ops, const Vector<double> &bterm) {
-            size_t npts = size_t(bterm.size());
-            Matrix<double, RowMajor> rT(npts, ops.N);
-            for (size_t n = 0; n < npts; ++n) {
-              ops.GRef.compute(static_cast<Scalar>(bterm(n)));
-              rT.row(n) = ops.GRef.rT.template cast<double>();
-            }
-            return rT;
-          });
+  Ops.def("rTReflected", [](starry::Ops<Scalar> &ops, const InVector &bterm) {
+    Matrix<double, RowMajor> rT(bterm.size(), ops.N);
+    {
+      py::gil_scoped_release release;
+      ops.rTReflected(bterm, rT);
+    }
+    return rT;
+  });
 
   // Gradient of rotation solution in reflected light
-  Ops.def("rTReflected", [](starry::Ops<Scalar> &ops,
-                            const Vector<double> &bterm,
-                            const Matrix<double, RowMajor> &brT) {
-    size_t npts = size_t(bterm.size());
-    Vector<double> bb(npts);
-    for (size_t n = 0; n < npts; ++n) {
-      bb(n) = static_cast<double>(ops.GRef.compute(
-          static_cast<Scalar>(bterm(n)), brT.row(n).template cast<Scalar>()));
+  Ops.def("rTReflected", [](starry::Ops<Scalar> &ops, const InVector &bterm,
+                            const InMatrix &brT) {
+    Vector<double> bb(bterm.size());
+    {
+      py::gil_scoped_release release;
+      ops.rTReflected(bterm, brT, bb);
     }
     return bb;
   });
 
+  // Rotation solution in reflected light (preallocated output)
+  Ops.def("rTReflected",
+          [](starry::Ops<Scalar> &ops, const InVector &bterm, OutMatrix out) {
+            if ((out.rows() != bterm.size()) || (out.cols() != ops.N))
+              throw std::runtime_error("Output array has the wrong shape.");
+            py::gil_scoped_release release;
+            ops.rTReflected(bterm, out);
+          },
+          py::arg("bterm"), py::arg("out"));
+
+  // Occultation solution in reflected light
+  Ops.def("sTReflected",
+          [](starry::Ops<Scalar> &ops, const InVector &bterm,
+             const InVector &xo, const InVector &yo, const InVector &zo,
+             const double &ro) {
+            Matrix<double, RowMajor> sT(bterm.size(), ops.N);
+            {
+              py::gil_scoped_release release;
+              ops.sTReflected(bterm, xo, yo, zo, ro, sT);
+            }
+            return sT;
+          });
+
+  // Gradient of occultation solution in reflected light
+  Ops.def("sTReflected",
+          [](starry::Ops<Scalar> &ops, const InVector &bterm,
+             const InVector &xo, const InVector &yo, const InVector &zo,
+             const double &ro, const InMatrix &bsT) {
+            Vector<double> bb(bterm.size());
+            Vector<double> bxo(bterm.size());
+            Vector<double> byo(bterm.size());
+            double bro;
+            {
+              py::gil_scoped_release release;
+              bro = ops.sTReflected(bterm, xo, yo, zo, ro, bsT, bb, bxo, byo);
+            }
+            return py::make_tuple(bb, bxo, byo, bro);
+          });
+
+  // Occultation solution in reflected light (preallocated output)
+  Ops.def("sTReflected",
+          [](starry::Ops<Scalar> &ops, const InVector &bterm,
+             const InVector &xo, const InVector &yo, const InVector &zo,
+             const double &ro, OutMatrix out) {
+            if ((out.rows() != bterm.size()) || (out.cols() != ops.N))
+              throw std::runtime_error("Output array has the wrong shape.");
+            py::gil_scoped_release release;
+            ops.sTReflected(bterm, xo, yo, zo, ro, out);
+          },
+          py::arg("bterm"), py::arg("xo"), py::arg("yo"), py::arg("zo"),
+          py::arg("ro"), py::arg("out"));
+
   // Rotation solution in emitted light dotted into Ylm space
   Ops.def_property_readonly("rTA1", [](starry::Ops<Scalar> &ops) {
     return ops.B.rTA1.template cast<double>();
   });
 
   // Polynomial basis at a vector of points
-  Ops.def("pT", [](starry::Ops<Scalar> &ops, const RowVector<double> &x,
-                   const RowVector<double> &y, const RowVector<double> &z) {
-    ops.B.computePolyBasis(x.template cast<Scalar>(), y.template cast<Scalar>(),
-                           z.template cast<Scalar>());
-    return ops.B.pT.template cast<double>();
+  Ops.def("pT", [](starry::Ops<Scalar> &ops, const InRowVector &x,
+                   const InRowVector &y, const InRowVector &z) {
+    Matrix<double, RowMajor> pT;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.B.computePolyBasis(x.template cast<Scalar>(),
+                             y.template cast<Scalar>(),
+                             z.template cast<Scalar>());
+      pT = ops.B.pT.template cast<double>();
+    }
+    return pT;
+  });
+
+  // Polynomial basis at a vector of points (preallocated output)
+  Ops.def("pT",
+          [](starry::Ops<Scalar> &ops, const InRowVector &x,
+             const InRowVector &y, const InRowVector &z, OutMatrix out) {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(ops.mutex);
+            ops.B.computePolyBasis(x.template cast<Scalar>(),
+                                   y.template cast<Scalar>(),
+                                   z.template cast<Scalar>());
+            copyToOutput(ops.B.pT, out);
+          },
+          py::arg("x"), py::arg("y"), py::arg("z"), py::arg("out"));
+
+  // Gradient of the rendered image. This overload comes first, since
+  // the one below would otherwise accept `bimage` as its output
+  Ops.def("render", [](starry::Ops<Scalar> &ops, const int &res,
+                       const int &projection, const InMatrix &P,
+                       const InMatrix &bimage) {
+    if (P.rows() != ops.N)
+      throw std::runtime_error("Incompatible shapes in the map.");
+    Matrix<double> bP;
+    {
+      py::gil_scoped_release release;
+      starry::render::render(res, projection, P, bimage, ops.nthreads, bP);
+    }
+    return bP;
   });
 
+  // Render polynomial maps on an image, one tile of pixels at a time
+  Ops.def("render",
+          [](starry::Ops<Scalar> &ops, const int &res, const int &projection,
+             const InMatrix &P, OutMatrix out) {
+            if (P.rows() != ops.N)
+              throw std::runtime_error("Incompatible shapes in the map.");
+            py::gil_scoped_release release;
+            starry::render::render(res, projection, P, ops.nthreads, out);
+          },
+          py::arg("res"), py::arg("projection"), py::arg("P"),
+          py::arg("out"));
+
   // Rotation dot product operator (vectors)
-  Ops.def("dotR", [](starry::Ops<Scalar> &ops, const RowVector<double> &M,
+  Ops.def("dotR", [](starry::Ops<Scalar> &ops, const InRowVector &M,
                      const double &x, const double &y, const double &z,
                      const double &theta) {
-    ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
-               static_cast<Scalar>(y), static_cast<Scalar>(z),
-               static_cast<Scalar>(theta));
-    return ops.W.dotR_result.template cast<double>();
+    Matrix<double, RowMajor> MR;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
+                 static_cast<Scalar>(y), static_cast<Scalar>(z),
+                 static_cast<Scalar>(theta));
+      MR = ops.W.dotR_result.template cast<double>();
+    }
+    return MR;
   });
 
   // Rotation dot product operator (matrices)
-  Ops.def("dotR",
-          [](starry::Ops<Scalar> &ops, const Matrix<double> &M, const double &x,
-             const double &y, const double &z, const double &theta) {
-            ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
-                       static_cast<Scalar>(y), static_cast<Scalar>(z),
-                       static_cast<Scalar>(theta));
-            return ops.W.dotR_result.template cast<double>();
-          });
+  Ops.def("dotR", [](starry::Ops<Scalar> &ops, const InMatrix &M,
+                     const double &x, const double &y, const double &z,
+                     const double &theta) {
+    Matrix<double, RowMajor> MR;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
+                 static_cast<Scalar>(y), static_cast<Scalar>(z),
+                 static_cast<Scalar>(theta));
+      MR = ops.W.dotR_result.template cast<double>();
+    }
+    return MR;
+  });
 
   // Gradient of rotation dot product operator (vectors)
-  Ops.def("dotR", [](starry::Ops<Scalar> &ops, const RowVector<double> &M,
+  Ops.def("dotR", [](starry::Ops<Scalar> &ops, const InRowVector &M,
                      const double &x, const double &y, const double &z,
-                     const double &theta, const Matrix<double> &bMR) {
-    ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
-               static_cast<Scalar>(y), static_cast<Scalar>(z),
-               static_cast<Scalar>(theta), bMR.template cast<Scalar>());
-    return py::make_tuple(ops.W.dotR_bM.template cast<double>(),
-                          static_cast<double>(ops.W.dotR_bx),
-                          static_cast<double>(ops.W.dotR_by),
-                          static_cast<double>(ops.W.dotR_bz),
-                          static_cast<double>(ops.W.dotR_btheta));
+                     const double &theta, const InMatrix &bMR) {
+    Matrix<double, RowMajor> bM;
+    double bx, by, bz, btheta;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
+                 static_cast<Scalar>(y), static_cast<Scalar>(z),
+                 static_cast<Scalar>(theta), bMR.template cast<Scalar>());
+      bM = ops.W.dotR_bM.template cast<double>();
+      bx = static_cast<double>(ops.W.dotR_bx);
+      by = static_cast<double>(ops.W.dotR_by);
+      bz = static_cast<double>(ops.W.dotR_bz);
+      btheta = static_cast<double>(ops.W.dotR_btheta);
+    }
+    return py::make_tuple(bM, bx, by, bz, btheta);
   });
 
   // Gradient of rotation dot product operator (matrices)
-  Ops.def("dotR", [](starry::Ops<Scalar> &ops, const Matrix<double> &M,
+  Ops.def("dotR", [](starry::Ops<Scalar> &ops, const InMatrix &M,
                      const double &x, const double &y, const double &z,
-                     const double &theta, const Matrix<double> &bMR) {
-    ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
-               static_cast<Scalar>(y), static_cast<Scalar>(z),
-               static_cast<Scalar>(theta), bMR.template cast<Scalar>());
-    return py::make_tuple(ops.W.dotR_bM.template cast<double>(),
-                          static_cast<double>(ops.W.dotR_bx),
-                          static_cast<double>(ops.W.dotR_by),
-                          static_cast<double>(ops.W.dotR_bz),
-                          static_cast<double>(ops.W.dotR_btheta));
+                     const double &theta, const InMatrix &bMR) {
+    Matrix<double, RowMajor> bM;
+    double bx, by, bz, btheta;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
+                 static_cast<Scalar>(y), static_cast<Scalar>(z),
+                 static_cast<Scalar>(theta), bMR.template cast<Scalar>());
+      bM = ops.W.dotR_bM.template cast<double>();
+      bx = static_cast<double>(ops.W.dotR_bx);
+      by = static_cast<double>(ops.W.dotR_by);
+      bz = static_cast<double>(ops.W.dotR_bz);
+      btheta = static_cast<double>(ops.W.dotR_btheta);
+    }
+    return py::make_tuple(bM, bx, by, bz, btheta);
   });
 
+  // Rotation dot product operator (vectors, preallocated output)
+  Ops.def("dotR",
+          [](starry::Ops<Scalar> &ops, const InRowVector &M, const double &x,
+             const double &y, const double &z, const double &theta,
+             OutMatrix out) {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(ops.mutex);
+            ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
+                       static_cast<Scalar>(y), static_cast<Scalar>(z),
+                       static_cast<Scalar>(theta));
+            copyToOutput(ops.W.dotR_result, out);
+          },
+          py::arg("M"), py::arg("x"), py::arg("y"), py::arg("z"),
+          py::arg("theta"), py::arg("out"));
+
+  // Rotation dot product operator (matrices, preallocated output)
+  Ops.def("dotR",
+          [](starry::Ops<Scalar> &ops, const InMatrix &M, const double &x,
+             const double &y, const double &z, const double &theta,
+             OutMatrix out) {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(ops.mutex);
+            ops.W.dotR(M.template cast<Scalar>(), static_cast<Scalar>(x),
+                       static_cast<Scalar>(y), static_cast<Scalar>(z),
+                       static_cast<Scalar>(theta));
+            copyToOutput(ops.W.dotR_result, out);
+          },
+          py::arg("M"), py::arg("x"), py::arg("y"), py::arg("z"),
+          py::arg("theta"), py::arg("out"));
+
+  // Projection onto the sky, i.e., the right and left hand side of
+  // the full rotation operator for given `inc`, `obl` and `theta`
+  defineProjection<false>(Ops, "dotProjection");
+  defineProjection<true>(Ops, "dotProjectionT");
+
   // Z rotation operator (vectors)
-  Ops.def("tensordotRz", [](starry::Ops<Scalar> &ops,
-                            const RowVector<double> &M,
-                            const Vector<double> &theta) {
-    ops.W.tensordotRz(M.template cast<Scalar>(), theta.template cast<Scalar>());
-    return ops.W.tensordotRz_result.template cast<double>();
+  Ops.def("tensordotRz", [](starry::Ops<Scalar> &ops, const InRowVector &M,
+                            const InVector &theta) {
+    Matrix<double, RowMajor> MRz;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.tensordotRz(M.template cast<Scalar>(),
+                        theta.template cast<Scalar>());
+      MRz = ops.W.tensordotRz_result.template cast<double>();
+    }
+    return MRz;
   });
 
   // Z rotation operator (matrices)
-  Ops.def("tensordotRz", [](starry::Ops<Scalar> &ops, const Matrix<double> &M,
-                            const Vector<double> &theta) {
-    ops.W.tensordotRz(M.template cast<Scalar>(), theta.template cast<Scalar>());
-    return ops.W.tensordotRz_result.template cast<double>();
+  Ops.def("tensordotRz", [](starry::Ops<Scalar> &ops, const InMatrix &M,
+                            const InVector &theta) {
+    Matrix<double, RowMajor> MRz;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.tensordotRz(M.template cast<Scalar>(),
+                        theta.template cast<Scalar>());
+      MRz = ops.W.tensordotRz_result.template cast<double>();
+    }
+    return MRz;
   });
 
   // Gradient of Z rotation matrix (vectors)
-  Ops.def("tensordotRz", [](starry::Ops<Scalar> &ops,
-                            const RowVector<double> &M,
-                            const Vector<double> &theta,
-                            const Matrix<double> &bMRz) {
-    ops.W.tensordotRz(M.template cast<Scalar>(), theta.template cast<Scalar>(),
-                      bMRz.template cast<Scalar>());
-    return py::make_tuple(ops.W.tensordotRz_bM.template cast<double>(),
-                          ops.W.tensordotRz_btheta.template cast<double>());
+  Ops.def("tensordotRz", [](starry::Ops<Scalar> &ops, const InRowVector &M,
+                            const InVector &theta, const InMatrix &bMRz) {
+    Matrix<double, RowMajor> bM;
+    Vector<double> btheta;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.tensordotRz(M.template cast<Scalar>(),
+                        theta.template cast<Scalar>(),
+                        bMRz.template cast<Scalar>());
+      bM = ops.W.tensordotRz_bM.template cast<double>();
+      btheta = ops.W.tensordotRz_btheta.template cast<double>();
+    }
+    return py::make_tuple(bM, btheta);
   });
 
   // Gradient of Z rotation matrix (matrices)
-  Ops.def("tensordotRz", [](starry::Ops<Scalar> &ops, const Matrix<double> &M,
-                            const Vector<double> &theta,
-                            const Matrix<double> &bMRz) {
-    ops.W.tensordotRz(M.template cast<Scalar>(), theta.template cast<Scalar>(),
-                      bMRz.template cast<Scalar>());
-    return py::make_tuple(ops.W.tensordotRz_bM.template cast<double>(),
-                          ops.W.tensordotRz_btheta.template cast<double>());
+  Ops.def("tensordotRz", [](starry::Ops<Scalar> &ops, const InMatrix &M,
+                            const InVector &theta, const InMatrix &bMRz) {
+    Matrix<double, RowMajor> bM;
+    Vector<double> btheta;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.W.tensordotRz(M.template cast<Scalar>(),
+                        theta.template cast<Scalar>(),
+                        bMRz.template cast<Scalar>());
+      bM = ops.W.tensordotRz_bM.template cast<double>();
+      btheta = ops.W.tensordotRz_btheta.template cast<double>();
+    }
+    return py::make_tuple(bM, btheta);
   });
 
+  // Z rotation operator (vectors, preallocated output)
+  Ops.def("tensordotRz",
+          [](starry::Ops<Scalar> &ops, const InRowVector &M,
+             const InVector &theta, OutMatrix out) {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(ops.mutex);
+            ops.W.tensordotRz(M.template cast<Scalar>(),
+                              theta.template cast<Scalar>());
+            copyToOutput(ops.W.tensordotRz_result, out);
+          },
+          py::arg("M"), py::arg("theta"), py::arg("out"));
+
+  // Z rotation operator (matrices, preallocated output)
+  Ops.def("tensordotRz",
+          [](starry::Ops<Scalar> &ops, const InMatrix &M,
+             const InVector &theta, OutMatrix out) {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(ops.mutex);
+            ops.W.tensordotRz(M.template cast<Scalar>(),
+                              theta.template cast<Scalar>());
+            copyToOutput(ops.W.tensordotRz_result, out);
+          },
+          py::arg("M"), py::arg("theta"), py::arg("out"));
+
   // Filter operator
-  Ops.def("F", [](starry::Ops<Scalar> &ops, const Vector<double> &u,
-                  const Vector<double> &f) {
-    ops.F.computeF(u.template cast<Scalar>(), f.template cast<Scalar>());
-    return ops.F.F.template cast<double>();
+  Ops.def("F", [](starry::Ops<Scalar> &ops, const InVector &u,
+                  const InVector &f) {
+    Matrix<double, RowMajor> F;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.F.computeF(u.template cast<Scalar>(), f.template cast<Scalar>());
+      F = ops.F.F.template cast<double>();
+    }
+    return F;
   });
 
   // Gradient of filter operator
-  Ops.def("F", [](starry::Ops<Scalar> &ops, const Vector<double> &u,
-                  const Vector<double> &f, const Matrix<double> &bF) {
-    ops.F.computeF(u.template cast<Scalar>(), f.template cast<Scalar>(),
-                   bF.template cast<Scalar>());
-    return py::make_tuple(ops.F.bu.template cast<double>(),
-                          ops.F.bf.template cast<double>());
+  Ops.def("F", [](starry::Ops<Scalar> &ops, const InVector &u,
+                  const InVector &f, const InMatrix &bF) {
+    Vector<double> bu, bf;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.F.computeF(u.template cast<Scalar>(), f.template cast<Scalar>(),
+                     bF.template cast<Scalar>());
+      bu = ops.F.bu.template cast<double>();
+      bf = ops.F.bf.template cast<double>();
+    }
+    return py::make_tuple(bu, bf);
   });
 
+  // Filter operator (preallocated output)
+  Ops.def("F",
+          [](starry::Ops<Scalar> &ops, const InVector &u, const InVector &f,
+             OutMatrix out) {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(ops.mutex);
+            ops.F.computeF(u.template cast<Scalar>(),
+                           f.template cast<Scalar>());
+            copyToOutput(ops.F.F.toDense(), out);
+          },
+          py::arg("u"), py::arg("f"), py::arg("out"));
+
   // Compute the Ylm expansion of a gaussian spot
-  Ops.def(
-      "spotYlm", [](starry::Ops<Scalar> &ops, const RowVector<Scalar> &amp,
-                    const Scalar &sigma, const Scalar &lat, const Scalar &lon) {
-        return ops
-            .spotYlm(amp.template cast<double>(), static_cast<Scalar>(sigma),
-                     static_cast<Scalar>(lat), static_cast<Scalar>(lon))
-            .template cast<double>();
-      });
+  Ops.def("spotYlm", [](starry::Ops<Scalar> &ops, const InRowVector &amp,
+                        const double &sigma, const double &lat,
+                        const double &lon) {
+    Matrix<double, RowMajor> y;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      y = ops.spotYlm(amp.template cast<Scalar>(), static_cast<Scalar>(sigma),
+                      static_cast<Scalar>(lat), static_cast<Scalar>(lon))
+              .template cast<double>();
+    }
+    return y;
+  });
 
   // Gradient of the Ylm expansion of a gaussian spot
-  Ops.def(
-      "spotYlm", [](starry::Ops<Scalar> &ops, const RowVector<Scalar> &amp,
-                    const Scalar &sigma, const Scalar &lat, const Scalar &lon, 
-                    const Matrix<double> &by) {
-        ops.spotYlm(amp.template cast<double>(), static_cast<Scalar>(sigma),
-                     static_cast<Scalar>(lat), static_cast<Scalar>(lon), 
-                     by.template cast<Scalar>());
-        return py::make_tuple(ops.bamp.template cast<double>(),
-                              static_cast<double>(ops.bsigma),
-                              static_cast<double>(ops.blat),
-                              static_cast<double>(ops.blon));
-      });
+  Ops.def("spotYlm", [](starry::Ops<Scalar> &ops, const InRowVector &amp,
+                        const double &sigma, const double &lat,
+                        const double &lon, const Matrix<double> &by) {
+    RowVector<double> bamp;
+    double bsigma, blat, blon;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.spotYlm(amp.template cast<Scalar>(), static_cast<Scalar>(sigma),
+                  static_cast<Scalar>(lat), static_cast<Scalar>(lon), by);
+      bamp = ops.bamp.template cast<double>();
+      bsigma = static_cast<double>(ops.bsigma);
+      blat = static_cast<double>(ops.blat);
+      blon = static_cast<double>(ops.blon);
+    }
+    return py::make_tuple(bamp, bsigma, blat, blon);
+  });
+
+  // Summed Ylm expansion of a batch of gaussian spots
+  Ops.def("spotYlms", [](starry::Ops<Scalar> &ops, const InMatrix &amp,
+                         const InVector &sigma, const InVector &lat,
+                         const InVector &lon) {
+    Matrix<double, RowMajor> y;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      y = ops.spotYlm(Matrix<Scalar>(amp.template cast<Scalar>()),
+                      Vector<Scalar>(sigma.template cast<Scalar>()),
+                      Vector<Scalar>(lat.template cast<Scalar>()),
+                      Vector<Scalar>(lon.template cast<Scalar>()))
+              .template cast<double>();
+    }
+    return y;
+  });
+
+  // Gradient of the summed Ylm expansion of a batch of gaussian spots
+  Ops.def("spotYlms", [](starry::Ops<Scalar> &ops, const InMatrix &amp,
+                         const InVector &sigma, const InVector &lat,
+                         const InVector &lon, const Matrix<double> &by) {
+    Matrix<double, RowMajor> bamp;
+    Vector<double> bsigma, blat, blon;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.spotYlm(Matrix<Scalar>(amp.template cast<Scalar>()),
+                  Vector<Scalar>(sigma.template cast<Scalar>()),
+                  Vector<Scalar>(lat.template cast<Scalar>()),
+                  Vector<Scalar>(lon.template cast<Scalar>()), by);
+      bamp = ops.bamps.template cast<double>();
+      bsigma = ops.bsigmas.template cast<double>();
+      blat = ops.blats.template cast<double>();
+      blon = ops.blons.template cast<double>();
+    }
+    return py::make_tuple(bamp, bsigma, blat, blon);
+  });
 
   // Differential rotation operator (matrices)
-  Ops.def("tensordotD", [](starry::Ops<Scalar> &ops, const Matrix<double> &M,
-                           const Vector<double> &wta) {
-    ops.D.tensordotD(M.template cast<Scalar>(), wta.template cast<Scalar>());
-    return ops.D.tensordotD_result.template cast<double>();
+  Ops.def("tensordotD", [](starry::Ops<Scalar> &ops, const InMatrix &M,
+                           const InVector &wta) {
+    Matrix<double, RowMajor> MD;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.D.tensordotD(M.template cast<Scalar>(), wta.template cast<Scalar>(),
+                       ops.nthreads);
+      MD = ops.D.tensordotD_result.template cast<double>();
+    }
+    return MD;
   });
 
   // Differential rotation operator (vectors)
-  Ops.def("tensordotD", [](starry::Ops<Scalar> &ops, const RowVector<double> &M,
-                           const Vector<double> &wta) {
-    ops.D.tensordotD(M.template cast<Scalar>(), wta.template cast<Scalar>());
-    return ops.D.tensordotD_result.template cast<double>();
+  Ops.def("tensordotD", [](starry::Ops<Scalar> &ops, const InRowVector &M,
+                           const InVector &wta) {
+    Matrix<double, RowMajor> MD;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.D.tensordotD(M.template cast<Scalar>(), wta.template cast<Scalar>(),
+                       ops.nthreads);
+      MD = ops.D.tensordotD_result.template cast<double>();
+    }
+    return MD;
   });
 
   // Gradient of differential rotation operator (vectors)
-  Ops.def(
-      "tensordotD", [](starry::Ops<Scalar> &ops, const RowVector<double> &M,
-                       const Vector<double> &wta, const Matrix<double> &bMD) {
-        ops.D.tensordotD(M.template cast<Scalar>(), wta.template cast<Scalar>(),
-                         bMD.template cast<Scalar>());
-        return py::make_tuple(ops.D.tensordotD_bM.template cast<double>(),
-                              ops.D.tensordotD_bwta.template cast<double>());
-      });
+  Ops.def("tensordotD", [](starry::Ops<Scalar> &ops, const InRowVector &M,
+                           const InVector &wta, const InMatrix &bMD) {
+    Matrix<double, RowMajor> bM;
+    Vector<double> bwta;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.D.tensordotD(M.template cast<Scalar>(), wta.template cast<Scalar>(),
+                       bMD.template cast<Scalar>(), ops.nthreads);
+      bM = ops.D.tensordotD_bM.template cast<double>();
+      bwta = ops.D.tensordotD_bwta.template cast<double>();
+    }
+    return py::make_tuple(bM, bwta);
+  });
 
   // Gradient of differential rotation operator (matrices)
-  Ops.def(
-      "tensordotD", [](starry::Ops<Scalar> &ops, const Matrix<double> &M,
-                       const Vector<double> &wta, const Matrix<double> &bMD) {
-        ops.D.tensordotD(M.template cast<Scalar>(), wta.template cast<Scalar>(),
-                         bMD.template cast<Scalar>());
-        return py::make_tuple(ops.D.tensordotD_bM.template cast<double>(),
-                              ops.D.tensordotD_bwta.template cast<double>());
+  Ops.def("tensordotD", [](starry::Ops<Scalar> &ops, const InMatrix &M,
+                           const InVector &wta, const InMatrix &bMD) {
+    Matrix<double, RowMajor> bM;
+    Vector<double> bwta;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(ops.mutex);
+      ops.D.tensordotD(M.template cast<Scalar>(), wta.template cast<Scalar>(),
+                       bMD.template cast<Scalar>(), ops.nthreads);
+      bM = ops.D.tensordotD_bM.template cast<double>();
+      bwta = ops.D.tensordotD_bwta.template cast<double>();
+    }
+    return py::make_tuple(bM, bwta);
+  });
+
+  // Differential rotation operator (matrices, preallocated output)
+  Ops.def("tensordotD",
+          [](starry::Ops<Scalar> &ops, const InMatrix &M, const InVector &wta,
+             OutMatrix out) {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(ops.mutex);
+            ops.D.tensordotD(M.template cast<Scalar>(),
+                             wta.template cast<Scalar>(), ops.nthreads);
+            copyToOutput(ops.D.tensordotD_result, out);
+          },
+          py::arg("M"), py::arg("wta"), py::arg("out"));
+
+  // Differential rotation operator (vectors, preallocated output)
+  Ops.def("tensordotD",
+          [](starry::Ops<Scalar> &ops, const InRowVector &M,
+             const InVector &wta, OutMatrix out) {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(ops.mutex);
+            ops.D.tensordotD(M.template cast<Scalar>(),
+                             wta.template cast<Scalar>(), ops.nthreads);
+            copyToOutput(ops.D.tensordotD_result, out);
+          },
+          py::arg("M"), py::arg("wta"), py::arg("out"));
+
+  // Light curve design matrix
+  Ops.def("X", [](starry::Ops<Scalar> &ops, const InVector &theta,
+                  const InVector &xo, const InVector &yo, const InVector &zo,
+                  const double &ro, const double &inc, const double &obl,
+                  const InVector &u, const InVector &f) {
+    Matrix<double, RowMajor> X(theta.size(), ops.Ny);
+    {
+      py::gil_scoped_release release;
+      ops.X(theta, xo, yo, zo, ro, inc, obl, u, f, X);
+    }
+    return X;
+  });
+
+  // Gradient of the light curve design matrix
+  Ops.def("X", [](starry::Ops<Scalar> &ops, const InVector &theta,
+                  const InVector &xo, const InVector &yo, const InVector &zo,
+                  const double &ro, const double &inc, const double &obl,
+                  const InVector &u, const InVector &f, const InMatrix &bX) {
+    Vector<double> btheta(theta.size()), bxo(theta.size()),
+        byo(theta.size());
+    Vector<double> bu, bf;
+    double bro, binc, bobl;
+    {
+      py::gil_scoped_release release;
+      ops.X(theta, xo, yo, zo, ro, inc, obl, u, f, bX, btheta, bxo, byo);
+      bro = static_cast<double>(ops.DM.bro);
+      binc = static_cast<double>(ops.DM.binc);
+      bobl = static_cast<double>(ops.DM.bobl);
+      bu = ops.DM.bu.template cast<double>();
+      bf = ops.DM.bf.template cast<double>();
+    }
+    return py::make_tuple(btheta, bxo, byo, bro, binc, bobl, bu, bf);
+  });
+
+  // Light curve design matrix (preallocated output)
+  Ops.def("X",
+          [](starry::Ops<Scalar> &ops, const InVector &theta,
+             const InVector &xo, const InVector &yo, const InVector &zo,
+             const double &ro, const double &inc, const double &obl,
+             const InVector &u, const InVector &f, OutMatrix out) {
+            if ((out.rows() != theta.size()) || (out.cols() != ops.Ny))
+              throw std::runtime_error("Output array has the wrong shape.");
+            py::gil_scoped_release release;
+            ops.X(theta, xo, yo, zo, ro, inc, obl, u, f, out);
+          },
+          py::arg("theta"), py::arg("xo"), py::arg("yo"), py::arg("zo"),
+          py::arg("ro"), py::arg("inc"), py::arg("obl"), py::arg("u"),
+          py::arg("f"), py::arg("out"));
+
+  // Streaming least-squares solution for the map
+  Ops.def("solve", [](starry::Ops<Scalar> &ops, const InVector &theta,
+                      const InVector &xo, const InVector &yo,
+                      const InVector &zo, const double &ro, const double &inc,
+                      const double &obl, const InVector &u, const InVector &f,
+                      const InVector &flux, const InVector &CInv,
+                      const InVector &mu, const InMatrix &LInv) {
+    Vector<double> yhat;
+    Matrix<double> cho_ycov;
+    {
+      py::gil_scoped_release release;
+      ops.solve(theta, xo, yo, zo, ro, inc, obl, u, f, flux, CInv, mu, LInv,
+                yhat, cho_ycov);
+    }
+    return py::make_tuple(yhat, cho_ycov);
+  });
+
+  // Streaming least-squares solution given the design matrix
+  m.def("solve", [](const InMatrix &X, const InVector &flux,
+                    const InVector &CInv, const InVector &mu,
+                    const InMatrix &LInv) {
+    Vector<double> yhat;
+    Matrix<double> cho_ycov;
+    {
+      py::gil_scoped_release release;
+      starry::linalg::solve(X, flux, CInv, mu, LInv, STARRY_NTHREADS, yhat,
+                            cho_ycov);
+    }
+    return py::make_tuple(yhat, cho_ycov);
+  });
+
+  // Least-squares solution given the normal equations
+  m.def("solve", [](const InMatrix &W, const InVector &b, const InVector &mu,
+                    const InMatrix &LInv) {
+    if ((W.rows() != W.cols()) || (b.size() != W.rows()))
+      throw std::runtime_error("Incompatible shapes in the normal equations.");
+    if ((mu.size() != b.size()) || (LInv.rows() != b.size()) ||
+        (LInv.cols() != b.size()))
+      throw std::runtime_error("Incompatible shapes in the prior.");
+    Matrix<double> W_ = W;
+    Vector<double> b_ = b;
+    Vector<double> yhat;
+    Matrix<double> cho_ycov;
+    {
+      py::gil_scoped_release release;
+      starry::linalg::solve(W_, b_, mu, LInv, yhat, cho_ycov);
+    }
+    return py::make_tuple(yhat, cho_ycov);
+  });
+
+  // Incrementally updated posterior of the least-squares problem
+  py::class_<starry::linalg::Posterior> Posterior(m, "Posterior");
+  Posterior.def(py::init<const InVector &, const InMatrix &>());
+  Posterior.def("update",
+                [](starry::linalg::Posterior &posterior, const InMatrix &X,
+                   const InVector &flux, const InVector &CInv, int sign) {
+                  py::gil_scoped_release release;
+                  posterior.update(X, flux, CInv, sign);
+                });
+  Posterior.def_property_readonly(
+      "yhat", [](starry::linalg::Posterior &posterior) {
+        return posterior.yhat;
       });
+  Posterior.def_property_readonly(
+      "cho_ycov", [](starry::linalg::Posterior &posterior) {
+        return posterior.cho_ycov;
+      });
+
+  // Solve a linear system with a semiseparable matrix
+  m.def("semiseparable", [](const InVector &A, const InMatrix &U,
+                            const InMatrix &V, const InMatrix &P,
+                            const InMatrix &Y) {
+    starry::linalg::Semiseparable S;
+    {
+      py::gil_scoped_release release;
+      S.compute(A, U, V, P, Y);
+    }
+    return py::make_tuple(S.Z, S.lndet);
+  });
+
+  // Gradient of the semiseparable solve
+  m.def("semiseparable", [](const InVector &A, const InMatrix &U,
+                            const InMatrix &V, const InMatrix &P,
+                            const InMatrix &Y, const InMatrix &bZ,
+                            const double &blndet) {
+    starry::linalg::Semiseparable S;
+    {
+      py::gil_scoped_release release;
+      S.compute(A, U, V, P, Y, bZ, blndet);
+    }
+    return py::make_tuple(S.bA, S.bU, S.bV, S.bP, S.bY);
+  });
+
+  // Solve a linear system with a banded matrix
+  m.def("banded", [](const InMatrix &B, const InMatrix &Y) {
+    starry::linalg::Banded S;
+    {
+      py::gil_scoped_release release;
+      S.compute(B, Y);
+    }
+    return py::make_tuple(S.Z, S.lndet);
+  });
+
+  // Gradient of the banded solve
+  m.def("banded", [](const InMatrix &B, const InMatrix &Y, const InMatrix &bZ,
+                     const double &blndet) {
+    starry::linalg::Banded S;
+    {
+      py::gil_scoped_release release;
+      S.compute(B, Y, bZ, blndet);
+    }
+    return py::make_tuple(S.bB, S.bY);
+  });
+
+  // Keplerian orbits of the secondaries relative to the primary
+  m.def("kepler", [](const InVector &t, const double &pri_m,
+                     const InVector &sec_m, const InVector &sec_t0,
+                     const InVector &sec_porb, const InVector &sec_ecc,
+                     const InVector &sec_w, const InVector &sec_Omega,
+                     const InVector &sec_inc, const double &G,
+                     const double &clight) {
+    Matrix<double, RowMajor> x, y, z, vx, vy, vz;
+    {
+      py::gil_scoped_release release;
+      starry::kepler::Kepler<Scalar> K;
+      K.compute(t.template cast<Scalar>(), static_cast<Scalar>(pri_m),
+                sec_m.template cast<Scalar>(), sec_t0.template cast<Scalar>(),
+                sec_porb.template cast<Scalar>(),
+                sec_ecc.template cast<Scalar>(), sec_w.template cast<Scalar>(),
+                sec_Omega.template cast<Scalar>(),
+                sec_inc.template cast<Scalar>(), static_cast<Scalar>(G),
+                static_cast<Scalar>(clight));
+      x = K.x.template cast<double>();
+      y = K.y.template cast<double>();
+      z = K.z.template cast<double>();
+      vx = K.vx.template cast<double>();
+      vy = K.vy.template cast<double>();
+      vz = K.vz.template cast<double>();
+    }
+    return py::make_tuple(x, y, z, vx, vy, vz);
+  });
+
+  // Gradient of the Keplerian orbits
+  m.def("kepler", [](const InVector &t, const double &pri_m,
+                     const InVector &sec_m, const InVector &sec_t0,
+                     const InVector &sec_porb, const InVector &sec_ecc,
+                     const InVector &sec_w, const InVector &sec_Omega,
+                     const InVector &sec_inc, const double &G,
+                     const double &clight, const InMatrix &bx,
+                     const InMatrix &by, const InMatrix &bz,
+                     const InMatrix &bvx, const InMatrix &bvy,
+                     const InMatrix &bvz) {
+    Vector<double> bt, bsec_m, bt0, bporb, becc, bw, bOmega, binc;
+    double bpri_m;
+    {
+      py::gil_scoped_release release;
+      starry::kepler::Kepler<Scalar> K;
+      K.compute(t.template cast<Scalar>(), static_cast<Scalar>(pri_m),
+                sec_m.template cast<Scalar>(), sec_t0.template cast<Scalar>(),
+                sec_porb.template cast<Scalar>(),
+                sec_ecc.template cast<Scalar>(), sec_w.template cast<Scalar>(),
+                sec_Omega.template cast<Scalar>(),
+                sec_inc.template cast<Scalar>(), static_cast<Scalar>(G),
+                static_cast<Scalar>(clight),
+                Matrix<Scalar>(bx.template cast<Scalar>()),
+                Matrix<Scalar>(by.template cast<Scalar>()),
+                Matrix<Scalar>(bz.template cast<Scalar>()),
+                Matrix<Scalar>(bvx.template cast<Scalar>()),
+                Matrix<Scalar>(bvy.template cast<Scalar>()),
+                Matrix<Scalar>(bvz.template cast<Scalar>()));
+      bt = K.bt.template cast<double>();
+      bpri_m = static_cast<double>(K.bpri_m);
+      bsec_m = K.bsec_m.template cast<double>();
+      bt0 = K.bt0.template cast<double>();
+      bporb = K.bporb.template cast<double>();
+      becc = K.becc.template cast<double>();
+      bw = K.bw.template cast<double>();
+      bOmega = K.bOmega.template cast<double>();
+      binc = K.binc.template cast<double>();
+    }
+    return py::make_tuple(bt, bpri_m, bsec_m, bt0, bporb, becc, bw, bOmega,
+                          binc);
+  });
 
   // Sturm's theorem to get number of poly roots between `a` and `b`
   m.def("nroots",
@@ -333,4 +993,17 @@ PYBIND11_MODULE(_c_ops, m) {
                                                static_cast<Scalar>(a),
                                                static_cast<Scalar>(b));
         });
+
+  // Sturm's theorem for each of the polynomials in the rows of `P`
+  m.def("nrootsBatch",
+        [](const InMatrix &P, const double &a, const double &b) {
+          Eigen::VectorXi count;
+          {
+            py::gil_scoped_release release;
+            starry::sturm::polycountroots(
+                Matrix<Scalar, RowMajor>(P.template cast<Scalar>()),
+                static_cast<Scalar>(a), static_cast<Scalar>(b), count);
+          }
+          return count;
+        });
 }
\ No newline at end of file
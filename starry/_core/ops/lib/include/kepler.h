@@ -0,0 +1,424 @@
+/**
+\file kepler.h
+\brief Keplerian orbits of the secondary bodies relative to the primary.
+
+*/
+
+#ifndef _STARRY_KEPLER_H_
+#define _STARRY_KEPLER_H_
+
+#include "utils.h"
+
+namespace starry {
+namespace kepler {
+
+using namespace utils;
+
+//! Index of each orbital parameter in the Jacobians below
+enum { KT, KT0, KPORB, KECC, KW, KOMEGA, KINC, KMTOT, KNPARAMS };
+
+/**
+Solve Kepler's equation `E - e sin(E) = M` for all mean anomalies `M` at
+once and return `sin(E)` and `cos(E)`. The anomalies are reduced to
+`[-pi, pi)`, and starting from Danby's guess `E = M + 0.85 e sign(sin(M))`
+we apply Danby's quartic correction to the whole array until the largest
+update is at the level of machine precision.
+
+*/
+template <typename Scalar>
+inline void solveKepler(const Vector<Scalar> &M, const Scalar &ecc,
+                        Vector<Scalar> &sinE, Vector<Scalar> &cosE) {
+  int npts = M.size();
+  Scalar twopi = 2 * pi<Scalar>();
+  Vector<Scalar> E(npts);
+  for (int i = 0; i < npts; ++i)
+    E(i) = M(i) - twopi * floor((M(i) + pi<Scalar>()) / twopi);
+  if ((ecc > 0) && (npts > 0)) {
+    Vector<Scalar> Mr = E;
+    for (int i = 0; i < npts; ++i)
+      E(i) += (sin(Mr(i)) < 0 ? -0.85 : 0.85) * ecc;
+    Scalar tol = 10 * mach_eps<Scalar>();
+    Eigen::Array<Scalar, Eigen::Dynamic, 1> esinE, ecosE, f, fp, d1, d2, d3;
+    for (int iter = 0; iter < STARRY_KEPLER_MAX_ITER; ++iter) {
+      esinE = ecc * E.array().sin();
+      ecosE = ecc * E.array().cos();
+      f = E.array() - esinE - Mr.array();
+      fp = 1 - ecosE;
+      d1 = -f / fp;
+      d2 = -f / (fp + 0.5 * d1 * esinE);
+      d3 = -f / (fp + 0.5 * d2 * esinE + d2 * d2 * ecosE / 6.0);
+      E.array() += d3;
+      if (d3.abs().maxCoeff() < tol) break;
+    }
+  }
+  sinE = E.array().sin();
+  cosE = E.array().cos();
+}
+
+/**
+Positions (and velocities) of a set of secondary bodies on Keplerian
+orbits relative to the primary, following the conventions of
+`exoplanet.orbits.KeplerianOrbit`: `t0` is the time of transit, the
+orbit is rotated by `w` in its plane, by `-inc` about the line of nodes
+and by `Omega` about the line of sight, and `z` points toward the
+observer. Times are in days, masses in solar masses and distances in
+solar radii if `G` is the gravitational constant in those units.
+
+If the speed of light `clight` is positive, the positions are evaluated
+at the retarded time `t_e = t + z(t_e) / clight`, i.e., they are where
+each body *appears* to be relative to the primary. The velocities are
+evaluated at the same retarded time, so they are the velocities of the
+body at the point where it appears to be.
+
+*/
+template <typename Scalar>
+class Kepler {
+ protected:
+  using Vec3 = Eigen::Matrix<Scalar, 3, 1>;
+  using Jac = Eigen::Matrix<Scalar, 3, KNPARAMS>;
+
+  //! Per-orbit constants
+  struct Orbit {
+    Scalar t0, porb, ecc, mtot;
+    Scalar n, a, s, M0, dM0de, dM0dw;
+    Scalar cosw, sinw, cosO, sinO, cosi, sini;
+  };
+  std::vector<Orbit> orbits;
+  Scalar clight;
+
+  /**
+  Compute the constants of each orbit, including the mean anomaly at
+  transit `M0` and its derivatives.
+
+  */
+  inline void setup(const Scalar &pri_m, const Vector<Scalar> &sec_m,
+                    const Vector<Scalar> &t0, const Vector<Scalar> &porb,
+                    const Vector<Scalar> &ecc, const Vector<Scalar> &w,
+                    const Vector<Scalar> &Omega, const Vector<Scalar> &inc,
+                    const Scalar &G) {
+    int K = sec_m.size();
+    if ((t0.size() != K) || (porb.size() != K) || (ecc.size() != K) ||
+        (w.size() != K) || (Omega.size() != K) || (inc.size() != K))
+      throw std::runtime_error(
+          "Mismatch in the number of orbital parameters.");
+    orbits.resize(K);
+    for (int k = 0; k < K; ++k) {
+      Orbit &o = orbits[k];
+      if ((ecc(k) < 0) || (ecc(k) >= 1))
+        throw std::runtime_error("Eccentricity must be in the range [0, 1).");
+      o.t0 = t0(k);
+      o.porb = porb(k);
+      o.ecc = ecc(k);
+      o.mtot = pri_m + sec_m(k);
+      o.n = 2 * pi<Scalar>() / porb(k);
+      o.a = pow(G * o.mtot / (o.n * o.n), Scalar(1.0) / 3);
+      o.s = sqrt(1 - o.ecc * o.ecc);
+      o.cosw = cos(w(k));
+      o.sinw = sin(w(k));
+      o.cosO = cos(Omega(k));
+      o.sinO = sin(Omega(k));
+      o.cosi = cos(inc(k));
+      o.sini = sin(inc(k));
+
+      // The eccentric & mean anomaly at transit, where `f = pi / 2 - w`
+      Scalar sqrtm = sqrt(1 - o.ecc), sqrtp = sqrt(1 + o.ecc);
+      Scalar u = sqrtm * o.cosw, v = sqrtp * (1 + o.sinw);
+      Scalar E0 = 2 * atan2(u, v);
+      Scalar sinE0 = sin(E0), cosE0 = cos(E0);
+      o.M0 = E0 - o.ecc * sinE0;
+      Scalar fac = 2 / (u * u + v * v);
+      Scalar dE0de = fac * (-v * o.cosw / (2 * sqrtm) -
+                            u * (1 + o.sinw) / (2 * sqrtp));
+      Scalar dE0dw = fac * (-v * sqrtm * o.sinw - u * sqrtp * o.cosw);
+      o.dM0de = (1 - o.ecc * cosE0) * dE0de - sinE0;
+      o.dM0dw = (1 - o.ecc * cosE0) * dE0dw;
+    }
+  }
+
+  /**
+  Solve for the eccentric anomaly at times `t`. If `RETARDED` is set and
+  light travel time is enabled, the times are replaced in place by the
+  retarded times.
+
+  */
+  template <bool RETARDED>
+  inline void anomaly(const Orbit &o, Vector<Scalar> &t, Vector<Scalar> &sinE,
+                      Vector<Scalar> &cosE) {
+    Vector<Scalar> M = (o.n * (t.array() - o.t0) + o.M0).matrix();
+    solveKepler(M, o.ecc, sinE, cosE);
+    if (!RETARDED || (clight <= 0)) return;
+    Vector<Scalar> tobs = t, px, py, pz, pvx, pvy, pvz;
+    Scalar tol = 10 * mach_eps<Scalar>();
+    for (int iter = 0; iter < STARRY_KEPLER_MAX_ITER; ++iter) {
+      // Newton step on `t_e - z(t_e) / c - t = 0`
+      position(o, sinE, cosE, px, py, pz);
+      velocity(o, sinE, cosE, pvx, pvy, pvz);
+      Eigen::Array<Scalar, Eigen::Dynamic, 1> dt =
+          (tobs - t + pz / clight).array() / (1 - pvz.array() / clight);
+      Scalar err = (dt.abs() / (1 + tobs.array().abs())).maxCoeff();
+      t.array() += dt;
+      M = (o.n * (t.array() - o.t0) + o.M0).matrix();
+      solveKepler(M, o.ecc, sinE, cosE);
+      if (err < tol) break;
+    }
+  }
+
+  /**
+  Rotate the vectors with in-plane components `(X0, Y0)` to the sky.
+
+  */
+  inline void rotate(const Orbit &o, const Vector<Scalar> &X0,
+                     const Vector<Scalar> &Y0, Vector<Scalar> &px,
+                     Vector<Scalar> &py, Vector<Scalar> &pz) {
+    Vector<Scalar> b1 = o.sinw * X0 + o.cosw * Y0;
+    Vector<Scalar> X = o.cosw * X0 - o.sinw * Y0;
+    Vector<Scalar> Y = o.cosi * b1;
+    px = o.cosO * X - o.sinO * Y;
+    py = o.sinO * X + o.cosO * Y;
+    pz = -o.sini * b1;
+  }
+
+  //! Same as above, for a single vector
+  inline Vec3 rotate(const Orbit &o, const Scalar &X0, const Scalar &Y0) {
+    Scalar b1 = o.sinw * X0 + o.cosw * Y0;
+    Scalar X = o.cosw * X0 - o.sinw * Y0;
+    Scalar Y = o.cosi * b1;
+    return Vec3(o.cosO * X - o.sinO * Y, o.sinO * X + o.cosO * Y,
+                -o.sini * b1);
+  }
+
+  //! Positions given the eccentric anomaly
+  inline void position(const Orbit &o, const Vector<Scalar> &sinE,
+                       const Vector<Scalar> &cosE, Vector<Scalar> &px,
+                       Vector<Scalar> &py, Vector<Scalar> &pz) {
+    rotate(o, (-o.a * (cosE.array() - o.ecc)).matrix(),
+           (-o.a * o.s) * sinE, px, py, pz);
+  }
+
+  //! Velocities given the eccentric anomaly
+  inline void velocity(const Orbit &o, const Vector<Scalar> &sinE,
+                       const Vector<Scalar> &cosE, Vector<Scalar> &pvx,
+                       Vector<Scalar> &pvy, Vector<Scalar> &pvz) {
+    Eigen::Array<Scalar, Eigen::Dynamic, 1> fac =
+        -o.a * o.n / (1 - o.ecc * cosE.array());
+    rotate(o, (-fac * sinE.array()).matrix(),
+           (fac * o.s * cosE.array()).matrix(), pvx, pvy, pvz);
+  }
+
+  /**
+  Compute the position (or, if `VELOCITY` is set, the velocity) of a body
+  at time `t` and its Jacobian with respect to all orbital parameters,
+  given the eccentric anomaly. The in-plane vector is `A h(E, e)`, where
+  the amplitude `A` only depends on `porb` and the total mass.
+
+  */
+  template <bool VELOCITY>
+  inline void point(const Orbit &o, const Scalar &t, const Scalar &sinE,
+                    const Scalar &cosE, Vec3 &r, Jac &J) {
+    Scalar e = o.ecc;
+    Scalar D = 1 - e * cosE;
+    Scalar A, dlnAdP, hx, hy, hEx, hEy, hex, hey;
+    if (!VELOCITY) {
+      A = -o.a;
+      dlnAdP = 2 / (3 * o.porb);
+      hx = cosE - e;
+      hy = o.s * sinE;
+      hEx = -sinE;
+      hEy = o.s * cosE;
+      hex = -1;
+      hey = -e / o.s * sinE;
+    } else {
+      A = -o.a * o.n;
+      dlnAdP = -1 / (3 * o.porb);
+      hx = -sinE / D;
+      hy = o.s * cosE / D;
+      hEx = -cosE / D - hx * e * sinE / D;
+      hEy = -o.s * sinE / D - hy * e * sinE / D;
+      hex = hx * cosE / D;
+      hey = -e * cosE / (o.s * D) + hy * cosE / D;
+    }
+    Scalar dlnAdM = 1 / (3 * o.mtot);
+
+    // Derivatives of the eccentric anomaly
+    Scalar dEdM = 1 / D;
+    Scalar dEdp[KNPARAMS] = {0};
+    dEdp[KT] = o.n * dEdM;
+    dEdp[KT0] = -o.n * dEdM;
+    dEdp[KPORB] = -o.n * (t - o.t0) / o.porb * dEdM;
+    dEdp[KECC] = (o.dM0de + sinE) * dEdM;
+    dEdp[KW] = o.dM0dw * dEdM;
+
+    // Value
+    Scalar X0 = A * hx, Y0 = A * hy;
+    r = rotate(o, X0, Y0);
+
+    // Derivatives of the in-plane vector
+    for (int p = 0; p < KNPARAMS; ++p) {
+      Scalar dX0 = A * hEx * dEdp[p], dY0 = A * hEy * dEdp[p];
+      if (p == KECC) {
+        dX0 += A * hex;
+        dY0 += A * hey;
+      } else if (p == KPORB) {
+        dX0 += X0 * dlnAdP;
+        dY0 += Y0 * dlnAdP;
+      } else if (p == KMTOT) {
+        dX0 += X0 * dlnAdM;
+        dY0 += Y0 * dlnAdM;
+      }
+      J.col(p) = rotate(o, dX0, dY0);
+    }
+
+    // Derivatives of the rotation
+    J.col(KW) += rotate(o, -Y0, X0);
+    Scalar b1 = o.sinw * X0 + o.cosw * Y0;
+    J(0, KINC) = o.sinO * o.sini * b1;
+    J(1, KINC) = -o.cosO * o.sini * b1;
+    J(2, KINC) = -o.cosi * b1;
+    J(0, KOMEGA) = -r(1);
+    J(1, KOMEGA) = r(0);
+    J(2, KOMEGA) = 0;
+  }
+
+ public:
+  int nthreads; /**< Number of threads (0 = one per core) */
+
+  // Results, one column per secondary
+  Matrix<Scalar> x, y, z;    /**< The (apparent) relative positions */
+  Matrix<Scalar> vx, vy, vz; /**< The relative velocities at the same times */
+
+  // Gradients
+  Vector<Scalar> bt;
+  Scalar bpri_m;
+  Vector<Scalar> bsec_m, bt0, bporb, becc, bw, bOmega, binc;
+
+  explicit Kepler(int nthreads = STARRY_NTHREADS) : nthreads(nthreads) {}
+
+  /**
+  Compute the positions and velocities of all secondaries relative to the
+  primary at times `t`.
+
+  */
+  inline void compute(const Vector<Scalar> &t, const Scalar &pri_m,
+                      const Vector<Scalar> &sec_m, const Vector<Scalar> &t0,
+                      const Vector<Scalar> &porb, const Vector<Scalar> &ecc,
+                      const Vector<Scalar> &w, const Vector<Scalar> &Omega,
+                      const Vector<Scalar> &inc, const Scalar &G,
+                      const Scalar &clight_ = 0) {
+    setup(pri_m, sec_m, t0, porb, ecc, w, Omega, inc, G);
+    clight = clight_;
+    size_t npts = t.size();
+    int K = orbits.size();
+    x.resize(npts, K);
+    y.resize(npts, K);
+    z.resize(npts, K);
+    vx.resize(npts, K);
+    vy.resize(npts, K);
+    vz.resize(npts, K);
+    int nt = getNumThreads(npts * K, nthreads);
+    parallelFor(npts, nt, [&](int, size_t start, size_t end) {
+      size_t len = end - start;
+      Vector<Scalar> tk, sinE, cosE, px, py, pz;
+      for (int k = 0; k < K; ++k) {
+        const Orbit &o = orbits[k];
+        tk = t.segment(start, len);
+        anomaly<true>(o, tk, sinE, cosE);
+        position(o, sinE, cosE, px, py, pz);
+        x.col(k).segment(start, len) = px;
+        y.col(k).segment(start, len) = py;
+        z.col(k).segment(start, len) = pz;
+        velocity(o, sinE, cosE, px, py, pz);
+        vx.col(k).segment(start, len) = px;
+        vy.col(k).segment(start, len) = py;
+        vz.col(k).segment(start, len) = pz;
+      }
+    });
+  }
+
+  /**
+  Compute the gradient of the positions and velocities of all secondaries
+  (see above) given the gradients `bx, ..., bvz` of the result.
+
+  With light travel time, the position and velocity at the retarded
+  time `t_e` depend on the parameters both explicitly and through `t_e`,
+  whose derivatives follow from differentiating `t_e = t + z(t_e) / c`.
+
+  */
+  template <typename T1>
+  inline void compute(const Vector<Scalar> &t, const Scalar &pri_m,
+                      const Vector<Scalar> &sec_m, const Vector<Scalar> &t0,
+                      const Vector<Scalar> &porb, const Vector<Scalar> &ecc,
+                      const Vector<Scalar> &w, const Vector<Scalar> &Omega,
+                      const Vector<Scalar> &inc, const Scalar &G,
+                      const Scalar &clight_, const MatrixBase<T1> &bx,
+                      const MatrixBase<T1> &by, const MatrixBase<T1> &bz,
+                      const MatrixBase<T1> &bvx, const MatrixBase<T1> &bvy,
+                      const MatrixBase<T1> &bvz) {
+    setup(pri_m, sec_m, t0, porb, ecc, w, Omega, inc, G);
+    clight = clight_;
+    size_t npts = t.size();
+    int K = orbits.size();
+    for (auto *b : {&bx, &by, &bz, &bvx, &bvy, &bvz}) {
+      if ((size_t(b->rows()) != npts) || (b->cols() != K))
+        throw std::runtime_error("Invalid shape for the output gradients.");
+    }
+    bt.setZero(npts);
+    int nt = getNumThreads(npts * K, nthreads);
+    std::vector<Matrix<Scalar>> bp(nt, Matrix<Scalar>::Zero(K, KNPARAMS));
+    parallelFor(npts, nt, [&](int thread, size_t start, size_t end) {
+      size_t len = end - start;
+      Matrix<Scalar> &g = bp[thread];
+      Vector<Scalar> te, sinE, cosE;
+      Vec3 r, b;
+      Jac J;
+      Eigen::Matrix<Scalar, 1, KNPARAMS> Jz, grad;
+      for (int k = 0; k < K; ++k) {
+        const Orbit &o = orbits[k];
+        te = t.segment(start, len);
+        anomaly<true>(o, te, sinE, cosE);
+        for (size_t i = 0; i < len; ++i) {
+          // Position
+          point<false>(o, te(i), sinE(i), cosE(i), r, J);
+          Scalar dtedt = 1;
+          if (clight > 0) {
+            Jz = J.row(2);
+            dtedt = 1 / (1 - Jz(KT) / clight);
+            J.col(KT) *= dtedt;
+            for (int p = 1; p < KNPARAMS; ++p)
+              J.col(p) += J.col(KT) * Jz(p) / clight;
+          }
+          b << bx(start + i, k), by(start + i, k), bz(start + i, k);
+          grad = b.transpose() * J;
+
+          // Velocity
+          point<true>(o, te(i), sinE(i), cosE(i), r, J);
+          if (clight > 0) {
+            J.col(KT) *= dtedt;
+            for (int p = 1; p < KNPARAMS; ++p)
+              J.col(p) += J.col(KT) * Jz(p) / clight;
+          }
+          b << bvx(start + i, k), bvy(start + i, k), bvz(start + i, k);
+          grad += b.transpose() * J;
+
+          bt(start + i) += grad(KT);
+          g.row(k) += grad;
+        }
+      }
+    });
+
+    // Reduce over threads
+    Matrix<Scalar> g = bp[0];
+    for (int thread = 1; thread < nt; ++thread) g += bp[thread];
+    bt0 = g.col(KT0);
+    bporb = g.col(KPORB);
+    becc = g.col(KECC);
+    bw = g.col(KW);
+    bOmega = g.col(KOMEGA);
+    binc = g.col(KINC);
+    bsec_m = g.col(KMTOT);
+    bpri_m = bsec_m.sum();
+  }
+};
+
+}  // namespace kepler
+}  // namespace starry
+#endif
@@ -10,8 +10,10 @@ TODO: Test all special cases
 #ifndef _STARRY_LIMBDARK_H_
 #define _STARRY_LIMBDARK_H_
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <vector>
 #include "ellip.h"
 #include "utils.h"
 
@@ -54,13 +56,142 @@ inline T wallis(int n) {
     return B / A;
 }
 
+/**
+Compute the Agol `c_n` coefficients of a limb darkening profile from
+its polynomial coefficients `u` (both of length `N`). The first
+coefficient, `u(0)`, is ignored.
+
+*/
+template <typename TU, typename TC>
+inline void getCl(int N, const TU* u, TC* c) {
+  typedef TC T;
+  Eigen::Matrix<T, Eigen::Dynamic, 1> a(N);
+  a.setZero();
+  a(0) = 1;
+
+  // Compute the a_n coefficients
+  T bcoeff;
+  int sign;
+  for (int i = 1; i < N; ++i) {
+    bcoeff = 1;
+    sign = 1;
+    for (int j = 0; j <= i; ++j) {
+      a(j) -= u[i] * bcoeff * sign;
+      sign *= -1;
+      bcoeff *= (T(i - j) / (j + 1));
+    }
+  }
+
+  // Now, compute the c_n coefficients
+  for (int j = N - 1; j >= std::max<int>(2, N - 2); --j) {
+    c[j] = a(j) / (j + 2);
+  }
+  for (int j = N - 3; j >= 2; --j) {
+    c[j] = a(j) / (j + 2) + c[j + 2];
+  }
+  if (N >= 4)
+    c[1] = a(1) + 3 * c[3];
+  else if (N >= 2)
+    c[1] = a(1);
+  if (N >= 3)
+    c[0] = a(0) + 2 * c[2];
+  else
+    c[0] = a(0);
+}
+
+/**
+Backpropagate the gradient `bc` of the Agol `c_n` coefficients onto
+the polynomial limb darkening coefficients, `bu`.
+
+*/
+template <typename TC, typename TU>
+inline void getClRev(int N, const TC* bc_in, TU* bu) {
+  typedef TU T;
+  Eigen::Matrix<T, Eigen::Dynamic, 1> bc(N);
+  Eigen::Matrix<T, Eigen::Dynamic, 1> ba(N);
+
+  for (int i = 0; i < N; ++i) {
+    bc(i) = bc_in[i];
+    bu[i] = 0;
+  }
+
+  if (N >= 3) {
+    // c[0] = a(0) + 2 * c[2];
+    ba(0) = bc(0);
+    bc(2) += 2 * bc(0);
+  } else {
+    // c[0] = a(0);
+    ba(0) = bc(0);
+  }
+
+  if (N >= 4) {
+    // c[1] = a(1) + 3 * c[3];
+    ba(1) = bc(1);
+    bc(3) += 3 * bc(1);
+  } else if (N >= 2) {
+    // c[1] = a(1);
+    ba(1) = bc(1);
+  }
+
+  for (int j = 2; j <= N - 3; ++j) {
+    // c[j] = a(j) / (j + 2) + c[j + 2];
+    ba(j) = bc(j) / (j + 2);
+    bc(j + 2) += bc(j);
+  }
+  for (int j = std::max<int>(2, N - 2); j <= N - 1; ++j) {
+    // c[j] = a(j) / (j + 2);
+    ba(j) = bc(j) / (j + 2);
+  }
+
+  // Compute the a_n coefficients
+  T bcoeff;
+  int sign;
+  for (int i = 1; i < N; ++i) {
+    bcoeff = 1;
+    sign = 1;
+    for (int j = 0; j <= i; ++j) {
+      // a(j) -= u[i] * bcoeff * sign;
+      bu[i] -= ba(j) * bcoeff * sign;
+      sign *= -1;
+      bcoeff *= (T(i - j) / (j + 1));
+    }
+  }
+}
+
 /**
 Greens integration housekeeping data.
 
+If `LMAX` is given, the degree is fixed at compile time: all vectors
+and series coefficients are fixed-size, so the solver never touches
+the heap, and the recursions have constant trip counts, which lets
+the compiler unroll them. This is much faster for the common
+low-order (e.g., quadratic) limb darkening laws.
+
 */
-template <class T>
+template <class T, int LMAX = Eigen::Dynamic>
 class GreensLimbDark {
+  static constexpr int SIZE =
+      (LMAX == Eigen::Dynamic) ? Eigen::Dynamic : LMAX + 1;
+  static constexpr int SIZE2 =
+      (LMAX == Eigen::Dynamic) ? Eigen::Dynamic : LMAX + 3;
+  static constexpr int NITER =
+      (LMAX == Eigen::Dynamic) ? Eigen::Dynamic : STARRY_MN_MAX_ITER;
+  using Vec = Eigen::Matrix<T, 1, SIZE>;
+  using Vec2 = Eigen::Matrix<T, 1, SIZE2>;
+  using CoeffM = Eigen::Matrix<T, 4, NITER>;
+  using CoeffN = Eigen::Matrix<T, 2, NITER>;
+
+  /**
+  The degree of the expansion, as a compile-time constant if possible.
+
+  */
+  inline int degree() const {
+    return (LMAX == Eigen::Dynamic) ? lmax : LMAX;
+  }
+
  public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   // Indices
   int lmax;
 
@@ -97,27 +228,29 @@ class GreensLimbDark {
   T Em1mKdm;
 
   // Helper intergrals
-  RowVector<T> M;
-  RowVector<T> N;
-  Matrix<T> M_coeff;
-  Matrix<T> N_coeff;
+  Vec M;
+  Vec N;
+  CoeffM M_coeff;
+  CoeffN N_coeff;
 
   // Helper arrays
-  RowVector<T> n_;
-  RowVector<T> invn;
-  RowVector<T> ndnp2;
+  Vec2 n_;
+  Vec2 invn;
+  Vec2 ndnp2;
 
   // The solution vector
-  RowVector<T> sT;
-  RowVector<T> dsTdb;
-  RowVector<T> dsTdr;
+  Vec sT;
+  Vec dsTdb;
+  Vec dsTdr;
 
   // Constructor
   explicit GreensLimbDark(int lmax) :
       lmax(lmax), M(lmax + 1), N(lmax + 1), M_coeff(4, STARRY_MN_MAX_ITER),
       N_coeff(2, STARRY_MN_MAX_ITER), n_(lmax + 3), invn(lmax + 3),
-      ndnp2(lmax + 3), sT(RowVector<T>::Zero(lmax + 1)),
-      dsTdb(RowVector<T>::Zero(lmax + 1)), dsTdr(RowVector<T>::Zero(lmax + 1)) {
+      ndnp2(lmax + 3), sT(Vec::Zero(lmax + 1)), dsTdb(Vec::Zero(lmax + 1)),
+      dsTdr(Vec::Zero(lmax + 1)) {
+    if ((LMAX != Eigen::Dynamic) && (lmax != LMAX))
+      throw std::runtime_error("Limb darkening degree mismatch.");
     // Constants
     computeMCoeff();
     computeNCoeff();
@@ -156,9 +289,9 @@ class GreensLimbDark {
 The linear limb darkening flux term.
 
 */
-template <class T>
+template <class T, int LMAX>
 template <bool GRADIENT>
-inline void GreensLimbDark<T>::computeS1() {
+inline void GreensLimbDark<T, LMAX>::computeS1() {
   T Lambda1 = 0;
   if ((b >= 1.0 + r) || (r == 0.0)) {
     // No occultation (Case 1)
@@ -274,14 +407,14 @@ Compute the coefficients of the series expansion
 for the highest four terms of the `M` integral.
 
 */
-template <class T>
-inline void GreensLimbDark<T>::computeMCoeff() {
+template <class T, int LMAX>
+inline void GreensLimbDark<T, LMAX>::computeMCoeff() {
   T coeff;
   int n;
 
   // ksq < 1
   for (int j = 0; j < 4; ++j) {
-    n = lmax - 3 + j;
+    n = degree() - 3 + j;
     coeff = root_pi<T>() * wallis<T>(n);
 
     // Add leading term to M
@@ -299,8 +432,8 @@ inline void GreensLimbDark<T>::computeMCoeff() {
 Compute the first four terms of the M integral.
 
 */
-template <class T>
-inline void GreensLimbDark<T>::computeM0123() {
+template <class T, int LMAX>
+inline void GreensLimbDark<T, LMAX>::computeM0123() {
   if (ksq < 1.0) {
     M(0) = kap0;
     M(1) = 2 * sqbr * 2 * ksq * Em1mKdm;
@@ -320,13 +453,13 @@ inline void GreensLimbDark<T>::computeM0123() {
 Compute the terms in the M integral by upward recursion.
 
 */
-template <class T>
-inline void GreensLimbDark<T>::upwardM() {
+template <class T, int LMAX>
+inline void GreensLimbDark<T, LMAX>::upwardM() {
   // Compute lowest four exactly
   computeM0123();
 
   // Recurse upward
-  for (int n = 4; n < lmax + 1; ++n)
+  for (int n = 4; n < degree() + 1; ++n)
     M(n) =
         (2.0 * (n - 1) * onemr2mb2 * M(n - 2) + (n - 2) * sqarea * M(n - 4)) *
         invn(n);
@@ -336,8 +469,8 @@ inline void GreensLimbDark<T>::upwardM() {
 Compute the terms in the M integral by downward recursion.
 
 */
-template <class T>
-inline void GreensLimbDark<T>::downwardM() {
+template <class T, int LMAX>
+inline void GreensLimbDark<T, LMAX>::downwardM() {
   T val, k2n, tol, fac, term;
   T invsqarea = T(1.0) / sqarea;
 
@@ -347,7 +480,7 @@ inline void GreensLimbDark<T>::downwardM() {
     tol = mach_eps<T>() * ksq;
     term = 0.0;
     fac = 1.0;
-    for (int n = 0; n < lmax - 3; ++n) fac *= sqonembmr2;
+    for (int n = 0; n < degree() - 3; ++n) fac *= sqonembmr2;
     fac *= k;
 
     // Now, compute higher order terms until
@@ -364,7 +497,7 @@ inline void GreensLimbDark<T>::downwardM() {
         val += term;
         if (abs(term) < tol) break;
       }
-      M(lmax - 3 + j) = val * fac;
+      M(degree() - 3 + j) = val * fac;
       fac *= sqonembmr2;
     }
 
@@ -374,7 +507,7 @@ inline void GreensLimbDark<T>::downwardM() {
   }
 
   // Recurse downward
-  for (int n = lmax - 4; n > 3; --n)
+  for (int n = degree() - 4; n > 3; --n)
     M(n) = ((n + 4) * M(n + 4) - 2.0 * (n + 3) * onemr2mb2 * M(n + 2)) *
            invsqarea * invn(n + 2);
 
@@ -387,14 +520,14 @@ Compute the coefficients of the series expansion
 for the highest two terms of the `N` integral.
 
 */
-template <class T>
-inline void GreensLimbDark<T>::computeNCoeff() {
+template <class T, int LMAX>
+inline void GreensLimbDark<T, LMAX>::computeNCoeff() {
   T coeff = 0.0;
   int n;
 
   // ksq < 1
   for (int j = 0; j < 2; ++j) {
-    n = lmax - 1 + j;
+    n = degree() - 1 + j;
 
     // Add leading term to N
     coeff = root_pi<T>() * wallis<T>(n) / (n + 3.0);
@@ -413,8 +546,8 @@ inline void GreensLimbDark<T>::computeNCoeff() {
 Compute the first two terms of the N integral.
 
 */
-template <class T>
-inline void GreensLimbDark<T>::computeN01() {
+template <class T, int LMAX>
+inline void GreensLimbDark<T, LMAX>::computeN01() {
   if (ksq <= 1.0) {
     N(0) = 0.5 * kap0 - k * kc;
     N(1) = 4.0 * third * sqbr * ksq * (-Eofk + 2.0 * Em1mKdm);
@@ -428,13 +561,13 @@ inline void GreensLimbDark<T>::computeN01() {
 Compute the terms in the N integral by upward recursion.
 
 */
-template <class T>
-inline void GreensLimbDark<T>::upwardN() {
+template <class T, int LMAX>
+inline void GreensLimbDark<T, LMAX>::upwardN() {
   // Compute lowest two exactly
   computeN01();
 
   // Recurse upward
-  for (int n = 2; n < lmax + 1; ++n)
+  for (int n = 2; n < degree() + 1; ++n)
     N(n) = (M(n) + n * onembpr2 * N(n - 2)) * invn(n + 2);
 }
 
@@ -442,8 +575,8 @@ inline void GreensLimbDark<T>::upwardN() {
 Compute the terms in the N integral by downward recursion.
 
 */
-template <class T>
-inline void GreensLimbDark<T>::downwardN() {
+template <class T, int LMAX>
+inline void GreensLimbDark<T, LMAX>::downwardN() {
   // Compute highest two using a series solution
   if (ksq < 1) {
     // Compute leading coefficient (n=0)
@@ -451,7 +584,7 @@ inline void GreensLimbDark<T>::downwardN() {
     T tol = mach_eps<T>() * ksq;
     T term = 0.0;
     T fac = 1.0;
-    for (int n = 0; n < lmax - 1; ++n) fac *= sqonembmr2;
+    for (int n = 0; n < degree() - 1; ++n) fac *= sqonembmr2;
     fac *= k * ksq;
 
     // Now, compute higher order terms until
@@ -465,7 +598,7 @@ inline void GreensLimbDark<T>::downwardN() {
         val += term;
         if (abs(term) < tol) break;
       }
-      N(lmax - 1 + j) = val * fac;
+      N(degree() - 1 + j) = val * fac;
       fac *= sqonembmr2;
     }
 
@@ -476,7 +609,7 @@ inline void GreensLimbDark<T>::downwardN() {
 
   // Recurse downward
   T onembpr2inv = T(1.0) / onembpr2;
-  for (int n = lmax - 2; n > 1; --n)
+  for (int n = degree() - 2; n > 1; --n)
     N(n) = ((n + 4) * N(n + 2) - M(n + 2)) * onembpr2inv * invn(n + 2);
 
   // Compute lowest two exactly
@@ -487,9 +620,9 @@ inline void GreensLimbDark<T>::downwardN() {
 Compute the `s^T` occultation solution vector
 
 */
-template <class T>
+template <class T, int LMAX>
 template <bool GRADIENT>
-inline void GreensLimbDark<T>::compute(const T& b_, const T& r_) {
+inline void GreensLimbDark<T, LMAX>::compute(const T& b_, const T& r_) {
   // Initialize the basic variables
   b = b_;
   r = r_;
@@ -593,14 +726,14 @@ inline void GreensLimbDark<T>::compute(const T& b_, const T& r_) {
   }
 
   // Special case
-  if (unlikely(lmax == 0)) return;
+  if (unlikely(degree() == 0)) return;
 
   // Compute the linear limb darkening term
   // and the elliptic integrals
   computeS1<GRADIENT>();
 
   // Special case
-  if (unlikely(lmax == 1)) return;
+  if (unlikely(degree() == 1)) return;
 
   // Special case
   if (unlikely(b == 0)) {
@@ -608,7 +741,7 @@ inline void GreensLimbDark<T>::compute(const T& b_, const T& r_) {
     T dtermdr = -2 * r;
     T fac = sqrt(term);
     T dfacdr = -r / fac;
-    for (int n = 2; n < lmax + 1; ++n) {
+    for (int n = 2; n < degree() + 1; ++n) {
       sT(n) = -term * r2 * 2 * pi<T>();
       if (GRADIENT) {
         dsTdb(n) = 0;
@@ -647,54 +780,372 @@ inline void GreensLimbDark<T>::compute(const T& b_, const T& r_) {
     dsTdr(2) = 2 * dsTdr(0) + detadr;
   }
 
-  if (lmax == 2) return;
+  if (degree() == 2) return;
 
   // Now onto the higher order terms...
-  if ((ksq < 0.5) && (lmax > 3))
+  if ((ksq < 0.5) && (degree() > 3))
     downwardM();
   else
     upwardM();
 
   // Compute the remaining terms in the `sT` vector
-  sT.segment(3, lmax - 2) =
-      -2.0 * r2 * M.segment(3, lmax - 2) +
-      ndnp2.segment(3, lmax - 2)
-          .cwiseProduct(onemr2mb2 * M.segment(3, lmax - 2) +
-                        sqarea * M.segment(1, lmax - 2));
+  sT.segment(3, degree() - 2) =
+      -2.0 * r2 * M.segment(3, degree() - 2) +
+      ndnp2.segment(3, degree() - 2)
+          .cwiseProduct(onemr2mb2 * M.segment(3, degree() - 2) +
+                        sqarea * M.segment(1, degree() - 2));
 
   // Compute gradients
   if (GRADIENT) {
     // Compute ds/dr
-    dsTdr.segment(3, lmax - 2) =
+    dsTdr.segment(3, degree() - 2) =
         -2 * r *
-        (n_.segment(5, lmax - 2).cwiseProduct(M.segment(3, lmax - 2)) -
-         n_.segment(3, lmax - 2).cwiseProduct(M.segment(1, lmax - 2)));
+        (n_.segment(5, degree() - 2).cwiseProduct(M.segment(3, degree() - 2)) -
+         n_.segment(3, degree() - 2).cwiseProduct(M.segment(1, degree() - 2)));
 
     if (b > STARRY_BCUT) {
       // Compute ds/db
-      dsTdb.segment(3, lmax - 2) =
-          (-invb * n_.segment(3, lmax - 2))
-              .cwiseProduct((r2 + b2) * (M.segment(3, lmax - 2) -
-                                         M.segment(1, lmax - 2)) +
-                            b2mr22 * M.segment(1, lmax - 2));
+      dsTdb.segment(3, degree() - 2) =
+          (-invb * n_.segment(3, degree() - 2))
+              .cwiseProduct((r2 + b2) * (M.segment(3, degree() - 2) -
+                                         M.segment(1, degree() - 2)) +
+                            b2mr22 * M.segment(1, degree() - 2));
     } else {
       // Compute ds/db using the small b reparametrization
       T r3 = r2 * r;
       T b3 = b2 * b;
-      if ((ksq < 0.5) && (lmax > 3))
+      if ((ksq < 0.5) && (degree() > 3))
         downwardN();
       else
         upwardN();
-      dsTdb.segment(3, lmax - 2) =
-          -n_.segment(3, lmax - 2)
+      dsTdb.segment(3, degree() - 2) =
+          -n_.segment(3, degree() - 2)
                .cwiseProduct((2.0 * r3 + b3 - b - 3.0 * r2 * b) *
-                                 M.segment(1, lmax - 2) +
-                             b * M.segment(3, lmax - 2) -
-                             4.0 * r3 * N.segment(1, lmax - 2));
+                                 M.segment(1, degree() - 2) +
+                             b * M.segment(3, degree() - 2) -
+                             4.0 * r3 * N.segment(1, degree() - 2));
     }
   }
 }
 
+/**
+Exposure time integration of the limb-darkened occultation flux.
+
+The sky position of the occultor is expanded to second order about
+the middle of the exposure, `(xo, yo) + (vx, vy) * t + (ax, ay) * t^2 / 2`,
+and the normalized flux is averaged over `-texp / 2 <= t <= texp / 2`.
+The flux is only
+non-smooth at the contact points, where it behaves like a power law
+with exponent `3/2`, so we split the exposure there. Segments that
+are out of transit contribute exactly. On the rest we use adaptive
+Simpson quadrature with an absolute tolerance `tol` on the exposure-
+averaged flux, after a change of variables `s = s(tau)` with a
+vanishing derivative at the contact points, which smooths them out.
+
+Since the quadrature is linear in the flux, the gradient is just the
+weighted sum of the gradients at the quadrature nodes.
+
+*/
+template <class T>
+class LimbDarkExposure {
+ protected:
+  using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+  using RowVector = Eigen::Matrix<T, 1, Eigen::Dynamic>;
+
+  GreensLimbDark<T> L;
+  const T tol;
+  const int maxdepth;
+
+  // The current exposure and segment
+  const Matrix* cn;
+  T xo, yo, dx, dy, qx, qy, r;
+  T s0, h;
+  bool contact0, contact1;
+  std::vector<RowVector> values;
+  std::vector<T> jacobian;
+
+  /**
+  Impact parameter at the time `s`, in units of the exposure time.
+
+  */
+  inline T impact(const T& s) const {
+    T px = xo + (dx + 0.5 * qx * s) * s;
+    T py = yo + (dy + 0.5 * qy * s) * s;
+    return sqrt(px * px + py * py);
+  }
+
+  /**
+  Return the sorted roots in `(-1/2, 1/2)` of the polynomial with
+  coefficients `c` (in increasing order of degree), given the points
+  `brk` between which it is monotonic. Each root is bracketed by a
+  sign change and found by bisection.
+
+  */
+  static std::vector<T> monotoneRoots(const std::vector<T>& c,
+                                      std::vector<T> brk) {
+    auto poly = [&c](const T& s) {
+      T value = 0;
+      for (int k = c.size() - 1; k >= 0; --k) value = value * s + c[k];
+      return value;
+    };
+    std::vector<T> roots;
+    for (T& x : brk) x = std::min(T(0.5), std::max(T(-0.5), x));
+    std::sort(brk.begin(), brk.end());
+    for (size_t k = 0; k + 1 < brk.size(); ++k) {
+      T lo = brk[k], hi = brk[k + 1];
+      T flo = poly(lo), fhi = poly(hi);
+      if ((lo == hi) || (flo == 0) || ((flo < 0) == (fhi < 0))) continue;
+      for (int n = 0; n < 200; ++n) {
+        T mid = 0.5 * (lo + hi);
+        if ((mid <= lo) || (mid >= hi)) break;
+        if ((poly(mid) < 0) == (flo < 0))
+          lo = mid;
+        else
+          hi = mid;
+      }
+      roots.push_back(0.5 * (lo + hi));
+    }
+    return roots;
+  }
+
+  /**
+  Polish a contact point `s`, where the impact parameter is `R`,
+  with Newton's method.
+
+  */
+  inline T polish(T s, const T& R) const {
+    for (int n = 0; n < 8; ++n) {
+      T px = xo + (dx + 0.5 * qx * s) * s;
+      T py = yo + (dy + 0.5 * qy * s) * s;
+      T dg = 2 * (px * (dx + qx * s) + py * (dy + qy * s));
+      if (dg == 0) break;
+      T ds = (px * px + py * py - R * R) / dg;
+      s -= ds;
+      if (abs(ds) < mach_eps<T>()) break;
+    }
+    return s;
+  }
+
+  /**
+  Add a quadrature node at `tau` on the current segment and
+  return its index. The stored value includes the Jacobian
+  `ds / dtau`.
+
+  */
+  inline size_t evaluate(const T& tau) {
+    T s, jac;
+    if (contact0 && contact1) {
+      s = s0 + h * tau * tau * (3 - 2 * tau);
+      jac = 6 * h * tau * (1 - tau);
+    } else if (contact0) {
+      s = s0 + h * tau * tau;
+      jac = 2 * h * tau;
+    } else if (contact1) {
+      s = s0 + h * tau * (2 - tau);
+      jac = 2 * h * (1 - tau);
+    } else {
+      s = s0 + h * tau;
+      jac = h;
+    }
+    T b = impact(s);
+    if (jac <= 0) {
+      values.push_back(RowVector::Zero(cn->rows()));
+    } else if (b < 1 + r) {
+      L.template compute<false>(b, r);
+      values.push_back(jac * L.sT * cn->transpose());
+    } else {
+      values.push_back(RowVector::Constant(cn->rows(), jac));
+    }
+    nodes.push_back(s);
+    weights.push_back(0);
+    jacobian.push_back(jac);
+    return nodes.size() - 1;
+  }
+
+  /**
+  Recursive step of the adaptive Simpson quadrature on `[a, b]`.
+
+  */
+  void refine(const T& a, const T& b, size_t ia, size_t im, size_t ib,
+              const RowVector& whole, const T& eps, int depth) {
+    T w = b - a;
+    T m = 0.5 * (a + b);
+    size_t il = evaluate(0.5 * (a + m));
+    size_t ir = evaluate(0.5 * (m + b));
+    RowVector left = (w / 12) * (values[ia] + 4 * values[il] + values[im]);
+    RowVector right = (w / 12) * (values[im] + 4 * values[ir] + values[ib]);
+    if ((depth <= 0) ||
+        ((left + right - whole).cwiseAbs().maxCoeff() <= 15 * eps)) {
+      // Accept the Richardson-extrapolated estimate (Boole's rule)
+      weights[ia] += 7 * w / 90;
+      weights[il] += 32 * w / 90;
+      weights[im] += 12 * w / 90;
+      weights[ir] += 32 * w / 90;
+      weights[ib] += 7 * w / 90;
+    } else {
+      refine(a, m, ia, il, im, left, 0.5 * eps, depth - 1);
+      refine(m, b, im, ir, ib, right, 0.5 * eps, depth - 1);
+    }
+  }
+
+ public:
+  std::vector<T> nodes;    /**< Quadrature nodes in units of `texp` */
+  std::vector<T> weights;  /**< Quadrature weights */
+  T unocculted;            /**< Fraction of the exposure out of transit */
+  RowVector flux;          /**< The exposure-averaged flux */
+
+  explicit LimbDarkExposure(int lmax, const T& tol = 1e-10,
+                            int maxdepth = 16)
+      : L(lmax), tol(tol), maxdepth(maxdepth) {
+    if (tol <= 0) throw std::runtime_error("The tolerance must be positive.");
+  }
+
+  /**
+  Compute the exposure-averaged flux for the normalized Agol
+  coefficients `cn` (one channel per row).
+
+  */
+  void compute(const Matrix& cn_, const T& xo_, const T& yo_, const T& vx,
+               const T& vy, const T& ax, const T& ay, const T& r_,
+               const T& texp) {
+    cn = &cn_;
+    xo = xo_;
+    yo = yo_;
+    dx = vx * texp;
+    dy = vy * texp;
+    qx = ax * texp * texp;
+    qy = ay * texp * texp;
+    r = r_;
+    nodes.clear();
+    weights.clear();
+    values.clear();
+    jacobian.clear();
+    unocculted = 0;
+    flux.setZero(cn->rows());
+
+    // Split the exposure at the contact points, where the
+    // impact parameter crosses `1 + r` or `|1 - r|` along the full
+    // quadratic trajectory `p(s) = p0 + d s + q s^2 / 2`. The squared
+    // impact parameter is a quartic in `s`, monotonic between the
+    // roots of the cubic `p . p'`, which is in turn monotonic between
+    // the roots of its (quadratic) derivative, so every root can be
+    // bracketed and bisected
+    T cd = xo * dx + yo * dy, cq = xo * qx + yo * qy;
+    T dd = dx * dx + dy * dy, dq = dx * qx + dy * qy;
+    T qq = qx * qx + qy * qy, cc = xo * xo + yo * yo;
+    std::vector<T> brk{-0.5, 0.5};
+    T A2 = 1.5 * qq, A1 = 3 * dq, A0 = dd + cq;
+    if (A2 != 0) {
+      T disc = A1 * A1 - 4 * A2 * A0;
+      if (disc > 0) {
+        T sqrtdisc = sqrt(disc);
+        brk.push_back((-A1 - sqrtdisc) / (2 * A2));
+        brk.push_back((-A1 + sqrtdisc) / (2 * A2));
+      }
+    } else if (A1 != 0) {
+      brk.push_back(-A0 / A1);
+    }
+    brk = monotoneRoots({cd, dd + cq, 1.5 * dq, 0.5 * qq}, brk);
+    brk.push_back(-0.5);
+    brk.push_back(0.5);
+    std::vector<T> s{-0.5};
+    for (T R : {1 + r, abs(1 - r)}) {
+      for (T root : monotoneRoots(
+               {cc - R * R, 2 * cd, dd + cq, dq, 0.25 * qq}, brk)) {
+        root = polish(root, R);
+        if ((root > -0.5) && (root < 0.5)) s.push_back(root);
+      }
+    }
+    s.push_back(0.5);
+    int ns = s.size();
+    std::sort(s.begin() + 1, s.end() - 1);
+
+    if ((dd == 0) && (qq == 0)) {
+      // The occultor doesn't move
+      if (impact(0) < 1 + r) {
+        s0 = -0.5;
+        h = 1;
+        contact0 = contact1 = false;
+        evaluate(0.5);
+        weights[0] = 1;
+        flux = values[0] / jacobian[0];
+      } else {
+        unocculted = 1;
+      }
+    } else {
+      for (int k = 0; k < ns - 1; ++k) {
+        s0 = s[k];
+        h = s[k + 1] - s[k];
+        contact0 = (k > 0);
+        contact1 = (k < ns - 2);
+        if (h <= 0) continue;
+        // No segment straddles a contact, so its midpoint tells
+        // whether it is in transit
+        if (impact(s0 + 0.5 * h) >= 1 + r) {
+          unocculted += h;
+        } else {
+          size_t n0 = nodes.size();
+          size_t ia = evaluate(0);
+          size_t im = evaluate(0.5);
+          size_t ib = evaluate(1);
+          RowVector whole = (values[ia] + 4 * values[im] + values[ib]) / 6;
+          refine(0, 1, ia, im, ib, whole, tol * h, maxdepth);
+
+          // Absorb the Jacobian into the weights
+          for (size_t n = n0; n < nodes.size(); ++n) {
+            flux += weights[n] * values[n];
+            weights[n] *= jacobian[n];
+          }
+        }
+      }
+    }
+    flux.array() += unocculted;
+  }
+
+  /**
+  Backpropagate the gradient `bf` of the exposure-averaged flux
+  onto the inputs of `compute`. The gradient with respect to the
+  normalized coefficients is added to `bcn`.
+
+  */
+  void computeRev(const Matrix& cn_, const T& xo_, const T& yo_,
+                  const T& vx, const T& vy, const T& ax, const T& ay,
+                  const T& r_, const T& texp, const RowVector& bf,
+                  Matrix& bcn, T& bxo, T& byo, T& bvx, T& bvy, T& bax,
+                  T& bay, T& br, T& btexp) {
+    compute(cn_, xo_, yo_, vx, vy, ax, ay, r_, texp);
+    bxo = 0;
+    byo = 0;
+    bvx = 0;
+    bvy = 0;
+    bax = 0;
+    bay = 0;
+    br = 0;
+    btexp = 0;
+    RowVector g = bf * cn_;
+    for (size_t n = 0; n < nodes.size(); ++n) {
+      const T& s = nodes[n];
+      T b = impact(s);
+      if ((weights[n] == 0) || (b >= 1 + r)) continue;
+      L.template compute<true>(b, r);
+      br += weights[n] * L.dsTdr.dot(g);
+      bcn.noalias() += weights[n] * bf.transpose() * L.sT;
+      if (b > 0) {
+        T bb = weights[n] * L.dsTdb.dot(g) / b;
+        T bx = bb * (xo + (dx + 0.5 * qx * s) * s);
+        T by = bb * (yo + (dy + 0.5 * qy * s) * s);
+        bxo += bx;
+        byo += by;
+        bvx += bx * texp * s;
+        bvy += by * texp * s;
+        bax += 0.5 * bx * texp * texp * s * s;
+        bay += 0.5 * by * texp * texp * s * s;
+        btexp += (bx * (vx + ax * texp * s) + by * (vy + ay * texp * s)) * s;
+      }
+    }
+  }
+};
+
 }  // namespace limbdark
 }  // namespace starry
 
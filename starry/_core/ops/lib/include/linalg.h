@@ -0,0 +1,644 @@
+/**
+\file linalg.h
+\brief Streaming solution of the linear least-squares problem.
+
+*/
+
+#ifndef _STARRY_LINALG_H_
+#define _STARRY_LINALG_H_
+
+#include "utils.h"
+
+//! Number of rows of a precomputed design matrix reduced at a time
+#ifndef STARRY_NORMAL_BLOCK
+#define STARRY_NORMAL_BLOCK 256
+#endif
+
+namespace starry {
+namespace linalg {
+
+using namespace utils;
+
+/**
+Check the shapes of the inputs to the least-squares solver for a
+design matrix with `npts` rows and `Ny` columns. The data covariance
+is diagonal, so its inverse `CInv` is either a single value or one
+value per row.
+
+*/
+inline void checkShapes(size_t npts, int Ny,
+                        const Ref<const Vector<double>> &flux,
+                        const Ref<const Vector<double>> &CInv,
+                        const Ref<const Vector<double>> &mu,
+                        const Ref<const Matrix<double, RowMajor>> &LInv) {
+  if ((size_t)flux.size() != npts)
+    throw std::runtime_error("Incompatible shapes in the flux vector.");
+  if ((CInv.size() != 1) && ((size_t)CInv.size() != npts))
+    throw std::runtime_error("Incompatible shapes in the data covariance.");
+  // A zero variance has an infinite inverse
+  if ((CInv.array() < 0).any() || !CInv.allFinite())
+    throw std::runtime_error("The data covariance must be positive.");
+  if ((mu.size() != Ny) || (LInv.rows() != Ny) || (LInv.cols() != Ny))
+    throw std::runtime_error("Incompatible shapes in the prior.");
+}
+
+/**
+Accumulator for the normal equations of the generalized least
+squares problem with a diagonal data covariance `C`,
+
+    W = X^T C^-1 X,     b = X^T C^-1 f,
+
+fed one block of rows of the design matrix `X` at a time, so that
+neither `X` nor `C^-1 X` is ever stored in full. Each thread owns
+its own accumulators and updates the lower triangle of `W` with a
+symmetric rank-k update.
+
+*/
+class NormalEquations {
+ protected:
+  const int Ny;
+  std::vector<Matrix<double>> W_t;
+  std::vector<Vector<double>> b_t;
+  std::vector<Matrix<double>> U_t;
+
+ public:
+  Matrix<double> W;
+  Vector<double> b;
+
+  NormalEquations(int Ny, int nthreads) :
+      Ny(Ny), W_t(nthreads, Matrix<double>::Zero(Ny, Ny)),
+      b_t(nthreads, Vector<double>::Zero(Ny)), U_t(nthreads) {}
+
+  /**
+  Add the contribution of the rows of `X` starting at row `n0`
+  of the full design matrix, in thread `t`.
+
+  */
+  template <typename T>
+  inline void update(int t, const MatrixBase<T> &X,
+                     const Ref<const Vector<double>> &flux,
+                     const Ref<const Vector<double>> &CInv, size_t n0) {
+    int nrows = X.rows();
+    Matrix<double> &U = U_t[t];
+    Vector<double> &bt = b_t[t];
+    U.resize(Ny, nrows);
+    for (int i = 0; i < nrows; ++i) {
+      double w = CInv.size() == 1 ? CInv(0) : CInv(n0 + i);
+      U.col(i) = sqrt(w) * X.row(i).transpose();
+      bt += (w * flux(n0 + i)) * X.row(i).transpose();
+    }
+    W_t[t].template selfadjointView<Eigen::Lower>().rankUpdate(U);
+  }
+
+  /**
+  Reduce the thread accumulators into `W` and `b`.
+
+  */
+  inline void reduce() {
+    W.setZero(Ny, Ny);
+    b.setZero(Ny);
+    for (size_t t = 0; t < W_t.size(); ++t) {
+      W += W_t[t];
+      b += b_t[t];
+    }
+    W = W.template selfadjointView<Eigen::Lower>();
+  }
+};
+
+/**
+Given the normal equations `W` and `b`, the prior mean `mu` and the
+inverse prior covariance `LInv`, compute the maximum a posteriori
+coefficients `yhat` and the lower Cholesky factorization `cho_ycov`
+of their posterior covariance. `W` and `b` are overwritten.
+
+*/
+inline void solve(Matrix<double> &W, Vector<double> &b,
+                  const Ref<const Vector<double>> &mu,
+                  const Ref<const Matrix<double, RowMajor>> &LInv,
+                  Vector<double> &yhat, Matrix<double> &cho_ycov) {
+  W += LInv;
+  b += LInv * mu;
+  Eigen::LLT<Matrix<double>> cho_W(W);
+  if (cho_W.info() != Eigen::Success)
+    throw std::runtime_error(
+        "The posterior precision matrix is not positive definite.");
+  yhat = cho_W.solve(b);
+  Eigen::LLT<Matrix<double>> cho(
+      cho_W.solve(Matrix<double>::Identity(W.rows(), W.cols())));
+  if (cho.info() != Eigen::Success)
+    throw std::runtime_error(
+        "The posterior covariance matrix is not positive definite.");
+  cho_ycov = cho.matrixL();
+}
+
+/**
+Solve the least-squares problem for a precomputed design matrix
+`X`, streaming over blocks of its rows in `nthreads` threads.
+
+*/
+inline void solve(const Ref<const Matrix<double, RowMajor>> &X,
+                  const Ref<const Vector<double>> &flux,
+                  const Ref<const Vector<double>> &CInv,
+                  const Ref<const Vector<double>> &mu,
+                  const Ref<const Matrix<double, RowMajor>> &LInv,
+                  int nthreads, Vector<double> &yhat,
+                  Matrix<double> &cho_ycov) {
+  size_t npts = X.rows();
+  checkShapes(npts, X.cols(), flux, CInv, mu, LInv);
+  int nt = getNumThreads(npts, nthreads);
+  NormalEquations NE(X.cols(), nt);
+  parallelFor(npts, nt, [&](int t, size_t start, size_t end) {
+    for (size_t n0 = start; n0 < end; n0 += STARRY_NORMAL_BLOCK) {
+      size_t n1 = std::min(n0 + STARRY_NORMAL_BLOCK, end);
+      NE.update(t, X.middleRows(n0, n1 - n0), flux, CInv, n0);
+    }
+  });
+  NE.reduce();
+  solve(NE.W, NE.b, mu, LInv, yhat, cho_ycov);
+}
+
+/**
+The posterior over the coefficients of the least-squares problem with
+a diagonal data covariance, updated incrementally as rows of the
+design matrix are added or removed.
+
+The precision `W = X^T C^-1 X + L^-1` and the vector
+`b = X^T C^-1 f + L^-1 mu` are kept along with the Cholesky factors
+of both `W` and the posterior covariance `W^-1`. Adding (removing)
+`k` rows changes `W` by a rank-`k` update (downdate) and `W^-1` by the
+corresponding downdate (update) given by the Woodbury identity, so
+both factors are updated with `k` rank-one updates in `O(k Ny^2)`. If
+a downdate fails because of loss of precision, everything is
+refactored from `W` in `O(Ny^3)`.
+
+*/
+class Posterior {
+ protected:
+  const int Ny;
+  Matrix<double> W;
+  Vector<double> b;
+  Eigen::LLT<Matrix<double>> cho_W;
+  Eigen::LLT<Matrix<double>> cho_cov;
+
+  /**
+  Factor `W` and `W^-1` from scratch.
+
+  */
+  inline void refactor() {
+    cho_W.compute(W);
+    if (cho_W.info() != Eigen::Success)
+      throw std::runtime_error(
+          "The posterior precision matrix is not positive definite.");
+    cho_cov.compute(cho_W.solve(Matrix<double>::Identity(Ny, Ny)));
+    if (cho_cov.info() != Eigen::Success)
+      throw std::runtime_error(
+          "The posterior covariance matrix is not positive definite.");
+  }
+
+ public:
+  Vector<double> yhat;     /**< The MAP coefficients */
+  Matrix<double> cho_ycov; /**< Lower Cholesky factor of the covariance */
+
+  /**
+  Initialize the posterior to the prior with mean `mu` and inverse
+  covariance `LInv`.
+
+  */
+  Posterior(const Ref<const Vector<double>> &mu,
+            const Ref<const Matrix<double, RowMajor>> &LInv) :
+      Ny(mu.size()) {
+    if ((LInv.rows() != Ny) || (LInv.cols() != Ny))
+      throw std::runtime_error("Incompatible shapes in the prior.");
+    W = LInv;
+    b = LInv * mu;
+    refactor();
+    yhat = cho_W.solve(b);
+    cho_ycov = cho_cov.matrixL();
+  }
+
+  /**
+  Add (`sign = 1`) or remove (`sign = -1`) the rows `X` of the design
+  matrix, with observed values `flux` and inverse variances `CInv`
+  (a single value or one per row).
+
+  */
+  inline void update(const Ref<const Matrix<double, RowMajor>> &X,
+                     const Ref<const Vector<double>> &flux,
+                     const Ref<const Vector<double>> &CInv, int sign) {
+    size_t k = X.rows();
+    if (X.cols() != Ny)
+      throw std::runtime_error("Incompatible shapes in the design matrix.");
+    if ((size_t)flux.size() != k)
+      throw std::runtime_error("Incompatible shapes in the flux vector.");
+    if ((CInv.size() != 1) && ((size_t)CInv.size() != k))
+      throw std::runtime_error("Incompatible shapes in the data covariance.");
+    if ((CInv.array() < 0).any() || !CInv.allFinite())
+      throw std::runtime_error("The data covariance must be positive.");
+    if (k == 0) return;
+
+    // The update to the precision, W -> W + sign * V V^T
+    Matrix<double> V(Ny, k);
+    for (size_t i = 0; i < k; ++i) {
+      double w = CInv.size() == 1 ? CInv(0) : CInv(i);
+      V.col(i) = sqrt(w) * X.row(i).transpose();
+      b += (sign * w * flux(i)) * X.row(i).transpose();
+    }
+    W.selfadjointView<Eigen::Lower>().rankUpdate(V, sign);
+    W.triangularView<Eigen::StrictlyUpper>() = W.transpose();
+
+    // The corresponding update to the covariance from the Woodbury
+    // identity, W^-1 -> W^-1 - sign * B B^T, where
+    // B = W^-1 V chol(I + sign * V^T W^-1 V)^-T. If we're adding
+    // or removing more rows than there are coefficients, it's
+    // cheaper to just refactor.
+    bool success = false;
+    if (k < size_t(Ny)) {
+      Matrix<double> CV = cho_cov.matrixL().transpose() * V;
+      Matrix<double> K = Matrix<double>::Identity(k, k);
+      K.selfadjointView<Eigen::Lower>().rankUpdate(CV.transpose(), sign);
+      Eigen::LLT<Matrix<double>> cho_K(K);
+      success = (cho_K.info() == Eigen::Success);
+      if (success) {
+        Matrix<double> B =
+            cho_K.matrixL()
+                .solve(CV.transpose() *
+                       Matrix<double>(cho_cov.matrixL()).transpose())
+                .transpose();
+        for (size_t i = 0; (i < k) && success; ++i) {
+          cho_W.rankUpdate(V.col(i), sign);
+          cho_cov.rankUpdate(B.col(i), -sign);
+          success = (cho_W.info() == Eigen::Success) &&
+                    (cho_cov.info() == Eigen::Success);
+        }
+      }
+    }
+    if (!success) refactor();
+
+    // The new posterior
+    yhat = cho_W.solve(b);
+    cho_ycov = cho_cov.matrixL();
+  }
+};
+
+/**
+Linear algebra with a symmetric semiseparable matrix of the form used
+by `celerite` (Foreman-Mackey et al. 2017),
+
+    C = diag(A) + tril(U V^T) + triu(V U^T),
+
+where the off-diagonal entries are
+
+    C_nm = sum_j U_nj V_mj prod_{k=m}^{n-1} P_kj,     n > m.
+
+For the kernel `sum_j a_j exp(-c_j |t_n - t_m|)`, `U_nj = a_j`,
+`V_nj = 1` and `P_nj = exp(-c_j (t_{n+1} - t_n))`. The matrix is
+factored as `C = L diag(D) L^T` with `L = I + tril(U W^T)`, so
+that solves and the log determinant cost `O(N J^2)` and `O(N J M)`
+for `M` right hand sides. The reverse pass recomputes the forward
+pass and stores the `O(N J^2 + N J M)` intermediate state.
+
+*/
+class Semiseparable {
+ protected:
+  int N;
+  int J;
+  int M;
+
+  // The factorization
+  Vector<double> D;
+  Matrix<double, RowMajor> W;
+
+  // Intermediate state for the reverse pass
+  std::vector<Matrix<double>> S;
+  std::vector<Matrix<double>> F;
+  std::vector<Matrix<double>> G;
+  Matrix<double, RowMajor> Z1;
+
+  /**
+  Compute the factorization `C = L diag(D) L^T`.
+
+  */
+  template <bool STORE>
+  inline void factor(const Ref<const Vector<double>> &A,
+                     const Ref<const Matrix<double, RowMajor>> &U,
+                     const Ref<const Matrix<double, RowMajor>> &V,
+                     const Ref<const Matrix<double, RowMajor>> &P) {
+    N = A.size();
+    J = U.cols();
+    if (N < 1) throw std::runtime_error("The covariance matrix is empty.");
+    if ((U.rows() != N) || (V.rows() != N) || (V.cols() != J) ||
+        (P.rows() != N - 1) || (P.cols() != J))
+      throw std::runtime_error(
+          "Incompatible shapes in the semiseparable matrix.");
+    D.resize(N);
+    W.resize(N, J);
+    if (STORE) S.assign(N, Matrix<double>::Zero(J, J));
+    Matrix<double> Sn = Matrix<double>::Zero(J, J);
+    Vector<double> p, SU;
+    D(0) = A(0);
+    for (int n = 0; n < N; ++n) {
+      if (n > 0) {
+        p = P.row(n - 1).transpose();
+        Sn += D(n - 1) * W.row(n - 1).transpose() * W.row(n - 1);
+        Sn = Sn.cwiseProduct(p * p.transpose());
+        if (STORE) S[n] = Sn;
+        SU = Sn * U.row(n).transpose();
+        D(n) = A(n) - U.row(n).dot(SU);
+      } else {
+        SU.setZero(J);
+      }
+      if (!(D(n) > 0))
+        throw std::runtime_error(
+            "The covariance matrix is not positive definite.");
+      W.row(n) = (V.row(n) - SU.transpose()) / D(n);
+    }
+    lndet = D.array().log().sum();
+  }
+
+  /**
+  Solve `C Z = Y`.
+
+  */
+  template <bool STORE>
+  inline void solve(const Ref<const Matrix<double, RowMajor>> &U,
+                    const Ref<const Matrix<double, RowMajor>> &P,
+                    const Ref<const Matrix<double, RowMajor>> &Y) {
+    if (Y.rows() != N)
+      throw std::runtime_error("Incompatible shapes in the right hand side.");
+    M = Y.cols();
+    Z = Y;
+
+    // Forward substitution, `L Z1 = Y`
+    Matrix<double> Fn = Matrix<double>::Zero(J, M);
+    if (STORE) F.assign(N, Fn);
+    for (int n = 1; n < N; ++n) {
+      Fn += W.row(n - 1).transpose() * Z.row(n - 1);
+      Fn.array().colwise() *= P.row(n - 1).transpose().array();
+      if (STORE) F[n] = Fn;
+      Z.row(n) -= U.row(n) * Fn;
+    }
+    if (STORE) Z1 = Z;
+
+    // Diagonal
+    Z = D.cwiseInverse().asDiagonal() * Z;
+
+    // Backward substitution, `L^T Z = Z1 / D`
+    Matrix<double> Gn = Matrix<double>::Zero(J, M);
+    if (STORE) G.assign(N, Gn);
+    for (int n = N - 2; n >= 0; --n) {
+      Gn += U.row(n + 1).transpose() * Z.row(n + 1);
+      Gn.array().colwise() *= P.row(n).transpose().array();
+      if (STORE) G[n] = Gn;
+      Z.row(n) -= W.row(n) * Gn;
+    }
+  }
+
+ public:
+  // Outputs
+  Matrix<double, RowMajor> Z; /**< The solution `C^-1 Y` */
+  double lndet;               /**< The log determinant of `C` */
+
+  // Gradients
+  Vector<double> bA;
+  Matrix<double, RowMajor> bU;
+  Matrix<double, RowMajor> bV;
+  Matrix<double, RowMajor> bP;
+  Matrix<double, RowMajor> bY;
+
+  /**
+  Compute `Z = C^-1 Y` and the log determinant of `C`.
+
+  */
+  inline void compute(const Ref<const Vector<double>> &A,
+                      const Ref<const Matrix<double, RowMajor>> &U,
+                      const Ref<const Matrix<double, RowMajor>> &V,
+                      const Ref<const Matrix<double, RowMajor>> &P,
+                      const Ref<const Matrix<double, RowMajor>> &Y) {
+    factor<false>(A, U, V, P);
+    solve<false>(U, P, Y);
+  }
+
+  /**
+  Backpropagate the gradients `bZ` and `blndet` of some scalar with
+  respect to `Z` and `lndet` to the inputs.
+
+  */
+  inline void compute(const Ref<const Vector<double>> &A,
+                      const Ref<const Matrix<double, RowMajor>> &U,
+                      const Ref<const Matrix<double, RowMajor>> &V,
+                      const Ref<const Matrix<double, RowMajor>> &P,
+                      const Ref<const Matrix<double, RowMajor>> &Y,
+                      const Ref<const Matrix<double, RowMajor>> &bZ,
+                      const double &blndet) {
+    factor<true>(A, U, V, P);
+    solve<true>(U, P, Y);
+    if ((bZ.rows() != N) || (bZ.cols() != M))
+      throw std::runtime_error("Incompatible shapes in the gradient.");
+    Vector<double> bD = blndet * D.cwiseInverse();
+    Matrix<double, RowMajor> bW = Matrix<double, RowMajor>::Zero(N, J);
+    bA.setZero(N);
+    bU.setZero(N, J);
+    bV.setZero(N, J);
+    bP.setZero(N - 1, J);
+
+    // Backward substitution
+    Matrix<double, RowMajor> bZn = bZ;
+    Matrix<double> bGn = Matrix<double>::Zero(J, M);
+    Matrix<double> H;
+    for (int n = 0; n < N - 1; ++n) {
+      bGn -= W.row(n).transpose() * bZn.row(n);
+      bW.row(n) -= bZn.row(n) * G[n].transpose();
+      H = G[n + 1] + U.row(n + 1).transpose() * Z.row(n + 1);
+      bP.row(n) += bGn.cwiseProduct(H).rowwise().sum().transpose();
+      bGn.array().colwise() *= P.row(n).transpose().array();
+      bU.row(n + 1) += Z.row(n + 1) * bGn.transpose();
+      bZn.row(n + 1) += U.row(n + 1) * bGn;
+    }
+
+    // Diagonal
+    bY = D.cwiseInverse().asDiagonal() * bZn;
+    for (int n = 0; n < N; ++n) bD(n) -= bY.row(n).dot(Z1.row(n)) / D(n);
+
+    // Forward substitution
+    Matrix<double> bFn = Matrix<double>::Zero(J, M);
+    Matrix<double> E;
+    for (int n = N - 1; n > 0; --n) {
+      bFn -= U.row(n).transpose() * bY.row(n);
+      bU.row(n) -= bY.row(n) * F[n].transpose();
+      E = F[n - 1] + W.row(n - 1).transpose() * Z1.row(n - 1);
+      bP.row(n - 1) += bFn.cwiseProduct(E).rowwise().sum().transpose();
+      bFn.array().colwise() *= P.row(n - 1).transpose().array();
+      bW.row(n - 1) += Z1.row(n - 1) * bFn.transpose();
+      bY.row(n - 1) += W.row(n - 1) * bFn;
+    }
+
+    // Factorization
+    Matrix<double> bS = Matrix<double>::Zero(J, J);
+    Matrix<double> Q, Mt, bQ;
+    Vector<double> u, w, tmp, p;
+    for (int n = N - 1; n >= 0; --n) {
+      u = U.row(n).transpose();
+      tmp = bW.row(n).transpose() / D(n);
+      bV.row(n) += tmp.transpose();
+      bD(n) -= bW.row(n).dot(W.row(n)) / D(n);
+      bA(n) += bD(n);
+      if (n == 0) break;
+      bS -= tmp * u.transpose();
+      bU.row(n) -= (S[n].transpose() * tmp).transpose();
+      bU.row(n) -= bD(n) * ((S[n] + S[n].transpose()) * u).transpose();
+      bS -= bD(n) * u * u.transpose();
+      p = P.row(n - 1).transpose();
+      w = W.row(n - 1).transpose();
+      Q = S[n - 1] + D(n - 1) * w * w.transpose();
+      Mt = bS.cwiseProduct(Q);
+      bP.row(n - 1) += (Mt * p + Mt.transpose() * p).transpose();
+      bQ = bS.cwiseProduct(p * p.transpose());
+      bS = bQ;
+      bD(n - 1) += w.dot(bQ * w);
+      bW.row(n - 1) += D(n - 1) * ((bQ + bQ.transpose()) * w).transpose();
+    }
+  }
+};
+
+/**
+Linear algebra with a symmetric banded matrix `C` with `p` nonzero
+subdiagonals, given in the lower band storage of LAPACK's `pbtrf`
+(and `scipy.linalg.cholesky_banded`),
+
+    B_kn = C_{n+k,n},     0 <= k <= p.
+
+The Cholesky factor `L` has the same band structure, so the
+factorization costs `O(N p^2)` and solves cost `O(N p M)` for `M`
+right hand sides. The reverse pass also needs the band of `C^-1`,
+which the Takahashi recurrence computes from `L` in `O(N p^2)`
+without forming any dense matrices.
+
+*/
+class Banded {
+ protected:
+  int N;
+  int p;
+  int M;
+
+  // The factorization, in the same storage as `B`
+  Matrix<double, RowMajor> LB;
+
+  /**
+  Compute the factorization `C = L L^T`.
+
+  */
+  inline void factor(const Ref<const Matrix<double, RowMajor>> &B) {
+    N = B.cols();
+    p = B.rows() - 1;
+    if (N < 1) throw std::runtime_error("The covariance matrix is empty.");
+    if (p < 0)
+      throw std::runtime_error("Incompatible shapes in the banded matrix.");
+    LB.setZero(p + 1, N);
+    for (int j = 0; j < N; ++j) {
+      double d = B(0, j);
+      for (int k = std::max(0, j - p); k < j; ++k)
+        d -= LB(j - k, k) * LB(j - k, k);
+      if (!(d > 0))
+        throw std::runtime_error(
+            "The covariance matrix is not positive definite.");
+      LB(0, j) = sqrt(d);
+      for (int i = j + 1; i < std::min(N, j + p + 1); ++i) {
+        double v = B(i - j, j);
+        for (int k = std::max(0, i - p); k < j; ++k)
+          v -= LB(i - k, k) * LB(j - k, k);
+        LB(i - j, j) = v / LB(0, j);
+      }
+    }
+    lndet = 2 * LB.row(0).array().log().sum();
+  }
+
+  /**
+  Overwrite the right hand side `Z` with `C^-1 Z`.
+
+  */
+  inline void solve(Matrix<double, RowMajor> &Z) {
+    // Forward substitution, `L Z1 = Y`
+    for (int i = 0; i < N; ++i) {
+      for (int k = std::max(0, i - p); k < i; ++k)
+        Z.row(i) -= LB(i - k, k) * Z.row(k);
+      Z.row(i) /= LB(0, i);
+    }
+
+    // Backward substitution, `L^T Z = Z1`
+    for (int i = N - 1; i >= 0; --i) {
+      for (int k = i + 1; k < std::min(N, i + p + 1); ++k)
+        Z.row(i) -= LB(k - i, i) * Z.row(k);
+      Z.row(i) /= LB(0, i);
+    }
+  }
+
+ public:
+  // Outputs
+  Matrix<double, RowMajor> Z; /**< The solution `C^-1 Y` */
+  double lndet;               /**< The log determinant of `C` */
+
+  // Gradients
+  Matrix<double, RowMajor> bB;
+  Matrix<double, RowMajor> bY;
+
+  /**
+  Compute `Z = C^-1 Y` and the log determinant of `C`.
+
+  */
+  inline void compute(const Ref<const Matrix<double, RowMajor>> &B,
+                      const Ref<const Matrix<double, RowMajor>> &Y) {
+    factor(B);
+    if (Y.rows() != N)
+      throw std::runtime_error("Incompatible shapes in the right hand side.");
+    M = Y.cols();
+    Z = Y;
+    solve(Z);
+  }
+
+  /**
+  Backpropagate the gradients `bZ` and `blndet` of some scalar with
+  respect to `Z` and `lndet` to the inputs. Since `C` is symmetric,
+  each off-diagonal element of `B` collects the gradient of both
+  of the elements of `C` it stands for.
+
+  */
+  inline void compute(const Ref<const Matrix<double, RowMajor>> &B,
+                      const Ref<const Matrix<double, RowMajor>> &Y,
+                      const Ref<const Matrix<double, RowMajor>> &bZ,
+                      const double &blndet) {
+    compute(B, Y);
+    if ((bZ.rows() != N) || (bZ.cols() != M))
+      throw std::runtime_error("Incompatible shapes in the gradient.");
+
+    // The gradient of the right hand side is `C^-1 bZ`
+    bY = bZ;
+    solve(bY);
+
+    // The band of `S = C^-1`, from `S L = L^-T`, one column at a time
+    Matrix<double, RowMajor> S = Matrix<double, RowMajor>::Zero(p + 1, N);
+    for (int j = N - 1; j >= 0; --j) {
+      int kmax = std::min(N, j + p + 1);
+      for (int i = kmax - 1; i >= j; --i) {
+        double v = (i == j) ? 1 / LB(0, j) : 0;
+        for (int k = j + 1; k < kmax; ++k)
+          v -= (i >= k ? S(i - k, k) : S(k - i, i)) * LB(k - j, j);
+        S(i - j, j) = v / LB(0, j);
+      }
+    }
+
+    // The gradient of `C` is `-C^-1 bZ Z^T + blndet C^-1`
+    bB.setZero(p + 1, N);
+    for (int n = 0; n < N; ++n) {
+      bB(0, n) = blndet * S(0, n) - bY.row(n).dot(Z.row(n));
+      for (int k = 1; k < std::min(p + 1, N - n); ++k) {
+        bB(k, n) = 2 * blndet * S(k, n) - bY.row(n + k).dot(Z.row(n)) -
+                   bY.row(n).dot(Z.row(n + k));
+      }
+    }
+  }
+};
+
+}  // namespace linalg
+}  // namespace starry
+
+#endif
@@ -7,6 +7,7 @@
 #ifndef _STARRY_MISC_H_
 #define _STARRY_MISC_H_
 
+#include <map>
 #include "utils.h"
 #include "wigner.h"
 
@@ -16,18 +17,17 @@ namespace misc {
 using namespace utils;
 
 /**
-Compute the Ylm expansion of a spot at a given latitude/longitude on the map.
+Compute the (normalized) Legendre coefficients `q_n = sqrt(2n + 1) IP_n / IP_0`
+of a gaussian spot of width `sigma` via the upward recursion for the
+integrals `IP` and `ID`, which are kept for the backward pass below.
 
 */
 template <class Scalar>
-inline Matrix<Scalar> spotYlm(const RowVector<Scalar> &amp, const Scalar &sigma,
-                              const Scalar &lat, const Scalar &lon, int l,
-                              wigner::Wigner<Scalar> &W) {
-  // Compute the integrals recursively
-  Vector<Scalar> IP(l + 1);
-  Vector<Scalar> ID(l + 1);
-  Matrix<Scalar> y((l + 1) * (l + 1), amp.cols());
-  y.setZero();
+inline void spotLegendre(const Scalar &sigma, int l, Vector<Scalar> &IP,
+                         Vector<Scalar> &ID, Vector<Scalar> &q) {
+  IP.resize(l + 1);
+  ID.resize(l + 1);
+  q.resize(l + 1);
 
   // Constants
   Scalar a = 1.0 / (2 * sigma * sigma);
@@ -37,9 +37,11 @@ inline Matrix<Scalar> spotYlm(const RowVector<Scalar> &amp, const Scalar &sigma,
 
   // Seeding values
   IP(0) = root_pi<Scalar>() / (2 * sqrta) * erfa;
-  IP(1) = (root_pi<Scalar>() * sqrta * erfa + term - 1) / (2 * a);
   ID(0) = 0;
-  ID(1) = IP(0);
+  if (l > 0) {
+    IP(1) = (root_pi<Scalar>() * sqrta * erfa + term - 1) / (2 * a);
+    ID(1) = IP(0);
+  }
 
   // Recurse
   int sgn = -1;
@@ -50,152 +52,267 @@ inline Matrix<Scalar> spotYlm(const RowVector<Scalar> &amp, const Scalar &sigma,
     sgn *= -1;
   }
 
-  // Compute the coefficients of the expansion
+  // Normalize
   for (int n = 0; n < l + 1; ++n)
-    y.row(n * n + n) = amp * sqrt(2 * n + 1) * (IP(n) / IP(0));
-
-  // Rotate the spot to the correct lat/lon
-  // We are computing the compound rotation matrix
-  //
-  //         R = R(yhat, lon) . R(xhat, -lat)
-  //
-  // in one go.
-  Scalar tol = 10 * mach_eps<Scalar>();
-  if ((abs(lat) > tol) || (abs(lon) > tol)) {
-    Scalar clat = cos(lat);
-    Scalar clon = cos(lon);
-    Scalar slat = sin(lat);
-    Scalar slon = sin(lon);
-    Scalar costheta = 0.5 * (clon + clat + clon * clat - 1);
-    UnitVector<Scalar> u;
-    u << -slat * (1 + clon), slon * (1 + clat), slon * slat;
-    Scalar normu = u.norm();
-    u /= normu;
-    Scalar sintheta = 0.5 * normu;
-    Scalar theta = atan2(sintheta, costheta);
-    W.dotR(y.transpose(), u(0), u(1), u(2), -theta);
-    y = W.dotR_result.transpose();
+    q(n) = sqrt(Scalar(2 * n + 1)) * (IP(n) / IP(0));
+}
+
+/**
+Backpropagate the gradient `bq` of the Legendre coefficients of a spot
+through the `IP` / `ID` recursion and return the gradient with respect
+to `sigma`. This is the hand-written adjoint of `spotLegendre`.
+
+*/
+template <class Scalar>
+inline Scalar spotLegendreGrad(const Scalar &sigma, int l,
+                               const Vector<Scalar> &IP,
+                               const Vector<Scalar> &ID,
+                               const Vector<Scalar> &bq) {
+  Scalar a = 1.0 / (2 * sigma * sigma);
+  Scalar sqrta = sqrt(a);
+  Scalar erfa = erf(2 * sqrta);
+  Scalar term = exp(-4 * a);
+
+  // q_n = sqrt(2n + 1) IP_n / IP_0
+  Vector<Scalar> bIP(l + 1), bID(l + 1);
+  bID.setZero();
+  for (int n = 0; n < l + 1; ++n)
+    bIP(n) = sqrt(Scalar(2 * n + 1)) * bq(n) / IP(0);
+  bIP(0) -= bIP.dot(IP) / IP(0);
+
+  // Reverse the recursion
+  Scalar ba = 0.0, bterm = 0.0;
+  int sgn = (l % 2 == 0) ? -1 : 1;
+  for (int n = l; n > 1; --n) {
+    bIP(n - 1) += (2.0 * n - 1.0) * bID(n);
+    bID(n - 2) += bID(n);
+    Scalar fac = (2.0 * n - 1.0) / (2.0 * n * a);
+    bID(n - 1) += fac * bIP(n);
+    bterm += fac * sgn * bIP(n);
+    ba -= fac / a * (ID(n - 1) + sgn * term - 1.0) * bIP(n);
+    bIP(n - 1) += (2.0 * n - 1.0) / n * bIP(n);
+    bIP(n - 2) -= (n - 1.0) / n * bIP(n);
+    sgn *= -1;
   }
 
-  return y;
+  // Seeding values
+  Scalar bsqrta = 0.0, berfa = 0.0;
+  if (l > 0) {
+    bIP(0) += bID(1);
+    bsqrta += root_pi<Scalar>() * erfa / (2 * a) * bIP(1);
+    berfa += root_pi<Scalar>() * sqrta / (2 * a) * bIP(1);
+    bterm += bIP(1) / (2 * a);
+    ba -= IP(1) / a * bIP(1);
+  }
+  berfa += root_pi<Scalar>() / (2 * sqrta) * bIP(0);
+  bsqrta -= IP(0) / sqrta * bIP(0);
+
+  // Constants
+  bsqrta += 4 / root_pi<Scalar>() * term * berfa;
+  ba += bsqrta / (2 * sqrta) - 4 * term * bterm;
+  return -2 * a / sigma * ba;
 }
 
 /**
-Compute the gradient of the Ylm expansion of a spot at a 
-given latitude/longitude on the map.
+Compute the Ylm expansion of a sum of `K` gaussian spots with amplitudes
+`amp` (`K` rows, one column per wavelength bin), widths `sigma` and
+latitudes/longitudes `lat`/`lon` on the map.
+
+The spot at `(lat, lon)` is the zonal expansion at the origin rotated by
 
-This routine uses forward diff pretty inefficiently and
-can be sped up if we think about it more carefully.
+        R = R(xhat, lat) . R(yhat, -lon)
+
+and since the zonal expansion only has `m = 0` terms, only the central
+row of `R(xhat, lat)` is ever needed. The Wigner matrices are computed
+once per distinct latitude and once per distinct longitude.
 
 */
 template <class Scalar>
-inline void spotYlm(const RowVector<Scalar> &amp, const Scalar &sigma_,
-                    const Scalar &lat, const Scalar &lon, 
-                    const Matrix<double> &by,
-                    int l, wigner::Wigner<Scalar> &W,
-                    RowVector<Scalar> &bamp,
-                    Scalar &bsigma, Scalar &blat, Scalar &blon) {
-  
-  // Forward diff for sigma
-  // TODO: Compute the backprop expression
-  using ADType = ADScalar<Scalar, 1>;
-  ADType sigma = sigma_;
-  sigma.derivatives() = Vector<Scalar>::Unit(1, 0);
-  
-  // Compute the integrals recursively
-  Vector<ADType> IP(l + 1);
-  Vector<ADType> ID(l + 1);
-  Vector<Scalar> y((l + 1) * (l + 1));
+inline Matrix<Scalar> spotYlm(const Matrix<Scalar> &amp,
+                              const Vector<Scalar> &sigma,
+                              const Vector<Scalar> &lat,
+                              const Vector<Scalar> &lon, int l,
+                              wigner::Wigner<Scalar> &W) {
+  int K = sigma.size();
+  int nw = amp.cols();
+  int Ny = (l + 1) * (l + 1);
+  if ((amp.rows() != K) || (lat.size() != K) || (lon.size() != K))
+    throw std::runtime_error(
+        "Mismatch in the number of spot amplitudes, sizes and positions.");
+
+  // The central rows of the latitude rotations
+  std::map<Scalar, int> ilat, ilon;
+  std::vector<Vector<Scalar>> Alat;
+  for (int k = 0; k < K; ++k) {
+    if (ilat.count(lat(k))) continue;
+    ilat[lat(k)] = Alat.size();
+    const std::vector<Matrix<Scalar>> &R =
+        W.getR(Scalar(1.0), Scalar(0.0), Scalar(0.0), lat(k));
+    Alat.emplace_back(Ny);
+    for (int n = 0; n < l + 1; ++n)
+      Alat.back().segment(n * n, 2 * n + 1) = R[n].row(n).transpose();
+  }
+
+  // The longitude rotations
+  std::vector<std::vector<Matrix<Scalar>>> Blon;
+  for (int k = 0; k < K; ++k) {
+    if (ilon.count(lon(k))) continue;
+    ilon[lon(k)] = Blon.size();
+    Blon.push_back(W.getR(Scalar(0.0), Scalar(1.0), Scalar(0.0), -lon(k)));
+  }
+
+  // Sum the rotated spots
+  Matrix<Scalar> y(Ny, nw);
   y.setZero();
-  ADType yn;
-  Vector<Scalar> dydsigma((l + 1) * (l + 1));
-  dydsigma.setZero();
+  Vector<Scalar> IP, ID, q;
+  for (int k = 0; k < K; ++k) {
+    spotLegendre(sigma(k), l, IP, ID, q);
+    const Vector<Scalar> &A = Alat[ilat[lat(k)]];
+    const std::vector<Matrix<Scalar>> &B = Blon[ilon[lon(k)]];
+    for (int n = 0; n < l + 1; ++n) {
+      y.block(n * n, 0, 2 * n + 1, nw) +=
+          (q(n) * B[n].transpose() * A.segment(n * n, 2 * n + 1)) *
+          amp.row(k);
+    }
+  }
+  return y;
+}
 
-  // Constants
-  ADType a = 1.0 / (2 * sigma * sigma);
-  ADType sqrta = sqrt(a);
-  ADType erfa = erf(2 * sqrta.value());
-  erfa.derivatives()(0) = -sqrt(32 / pi<Scalar>()) * exp(-4 * a.value()) * a.value();
-  ADType term = exp(-4 * a);
+/**
+Compute the gradient of the Ylm expansion of a sum of gaussian spots
+(see above) given the gradient `by` of the result.
 
-  // Seeding values
-  IP(0) = root_pi<Scalar>() / (2 * sqrta) * erfa;
-  IP(1) = (root_pi<Scalar>() * sqrta * erfa + term - 1) / (2 * a);
-  ID(0) = 0;
-  ID(1) = IP(0);
+Since `d R(u, theta) / d theta = K(u) R(u, theta)`, where `K(u)` is the
+generator of rotations about `u`, all derivatives follow from the
+Wigner matrices computed in the forward pass. The products of the
+longitude rotations (and their derivatives) with `by` are shared by
+all spots at the same longitude, so the cost per spot is linear in
+the number of coefficients.
 
-  // Recurse
-  int sgn = -1;
-  for (int n = 2; n < l + 1; ++n) {
-    IP(n) = (2.0 * n - 1.0) / (2.0 * n * a) * (ID(n - 1) + sgn * term - 1.0) +
-            (2.0 * n - 1.0) / n * IP(n - 1) - (n - 1.0) / n * IP(n - 2);
-    ID(n) = (2.0 * n - 1.0) * IP(n - 1) + ID(n - 2);
-    sgn *= -1;
+*/
+template <class Scalar>
+inline void spotYlm(const Matrix<Scalar> &amp, const Vector<Scalar> &sigma,
+                    const Vector<Scalar> &lat, const Vector<Scalar> &lon,
+                    const Matrix<double> &by, int l,
+                    wigner::Wigner<Scalar> &W, Matrix<Scalar> &bamp,
+                    Vector<Scalar> &bsigma, Vector<Scalar> &blat,
+                    Vector<Scalar> &blon) {
+  int K = sigma.size();
+  int nw = amp.cols();
+  int Ny = (l + 1) * (l + 1);
+  if ((amp.rows() != K) || (lat.size() != K) || (lon.size() != K))
+    throw std::runtime_error(
+        "Mismatch in the number of spot amplitudes, sizes and positions.");
+  if ((by.rows() != Ny) || (by.cols() != nw))
+    throw std::runtime_error("Invalid shape for the gradient `by`.");
+  Matrix<Scalar> by_ = by.template cast<Scalar>();
+  const std::vector<Matrix<Scalar>> &Kx = W.getKx();
+  const std::vector<Matrix<Scalar>> &Ky = W.getKy();
+
+  // The central rows of the latitude rotations & their derivatives
+  std::map<Scalar, int> ilat, ilon;
+  std::vector<Vector<Scalar>> Alat, dAlat;
+  for (int k = 0; k < K; ++k) {
+    if (ilat.count(lat(k))) continue;
+    ilat[lat(k)] = Alat.size();
+    const std::vector<Matrix<Scalar>> &R =
+        W.getR(Scalar(1.0), Scalar(0.0), Scalar(0.0), lat(k));
+    Alat.emplace_back(Ny);
+    dAlat.emplace_back(Ny);
+    for (int n = 0; n < l + 1; ++n) {
+      Alat.back().segment(n * n, 2 * n + 1) = R[n].row(n).transpose();
+      dAlat.back().segment(n * n, 2 * n + 1) =
+          (Kx[n].row(n) * R[n]).transpose();
+    }
   }
 
-  // Compute the coefficients of the expansion (w/o the amplitude)
-  for (int n = 0; n < l + 1; ++n) {
-    yn = sqrt(2 * n + 1) * (IP(n) / IP(0));
-    y(n * n + n) = yn.value();
-    dydsigma(n * n + n) = yn.derivatives()(0);
+  // The longitude rotations & their derivatives, dotted into `by`
+  std::vector<Matrix<Scalar>> Hlon, dHlon;
+  for (int k = 0; k < K; ++k) {
+    if (ilon.count(lon(k))) continue;
+    ilon[lon(k)] = Hlon.size();
+    const std::vector<Matrix<Scalar>> &R =
+        W.getR(Scalar(0.0), Scalar(1.0), Scalar(0.0), -lon(k));
+    Hlon.emplace_back(Ny, nw);
+    dHlon.emplace_back(Ny, nw);
+    for (int n = 0; n < l + 1; ++n) {
+      Hlon.back().block(n * n, 0, 2 * n + 1, nw) =
+          R[n] * by_.block(n * n, 0, 2 * n + 1, nw);
+      dHlon.back().block(n * n, 0, 2 * n + 1, nw) =
+          -Ky[n] * Hlon.back().block(n * n, 0, 2 * n + 1, nw);
+    }
   }
 
-  // Rotate the spot to the correct lat/lon
-  Scalar tol = 10 * mach_eps<Scalar>();
-  UnitVector<Scalar> u;
-  Scalar normu;
-  Scalar theta;
-  Scalar clat = cos(lat);
-  Scalar clon = cos(lon);
-  Scalar slat = sin(lat);
-  Scalar slon = sin(lon);
-
-  // Axis & angle of rotation
-  if ((abs(lat) > tol) || (abs(lon) > tol)) {
-    Scalar costheta = 0.5 * (clon + clat + clon * clat - 1);
-    u << -slat * (1 + clon), slon * (1 + clat), slon * slat;
-    normu = u.norm();
-    u /= normu;
-    Scalar sintheta = 0.5 * normu;
-    theta = atan2(sintheta, costheta);
-  } else {
-    theta = 0.0;
-    u << 0, 1, 0;
-    normu = 1;
+  // Backpropagate, one spot at a time
+  bamp.setZero(K, nw);
+  bsigma.resize(K);
+  blat.resize(K);
+  blon.resize(K);
+  Vector<Scalar> IP, ID, q, bq(l + 1);
+  RowVector<Scalar> w;
+  for (int k = 0; k < K; ++k) {
+    spotLegendre(sigma(k), l, IP, ID, q);
+    const Vector<Scalar> &A = Alat[ilat[lat(k)]];
+    const Vector<Scalar> &dA = dAlat[ilat[lat(k)]];
+    const Matrix<Scalar> &H = Hlon[ilon[lon(k)]];
+    const Matrix<Scalar> &dH = dHlon[ilon[lon(k)]];
+    RowVector<Scalar> glat(nw), glon(nw);
+    glat.setZero();
+    glon.setZero();
+    for (int n = 0; n < l + 1; ++n) {
+      w = A.segment(n * n, 2 * n + 1).transpose() *
+          H.block(n * n, 0, 2 * n + 1, nw);
+      bamp.row(k) += q(n) * w;
+      bq(n) = w.dot(amp.row(k));
+      glat += q(n) * dA.segment(n * n, 2 * n + 1).transpose() *
+              H.block(n * n, 0, 2 * n + 1, nw);
+      glon += q(n) * A.segment(n * n, 2 * n + 1).transpose() *
+              dH.block(n * n, 0, 2 * n + 1, nw);
+    }
+    blat(k) = glat.dot(amp.row(k));
+    blon(k) = glon.dot(amp.row(k));
+    bsigma(k) = spotLegendreGrad(sigma(k), l, IP, ID, bq);
   }
+}
 
-  // Gradient w/ respect to lat, lon, and sigma
-  Matrix<Scalar> y_amp = y * amp;
-  W.dotR(y_amp.transpose(), u(0), u(1), u(2), -theta, by.transpose());
-  
-  // lat
-  Scalar termz = (clat * (1 + clon) * (1 + clon) * slat - slat * slon * slon) / (normu * normu * normu);
-  Scalar dxdl = -clat * (1 + clon) / normu + (1 + clon) * slat * termz;
-  Scalar dydl = -slat * slon / normu - (1 + clat) * slon * termz;
-  Scalar dzdl = clat * slon / normu - slat * slon * termz;
-  Scalar dthetadl = -u(0);
-  blat = (dxdl * W.dotR_bx + dydl * W.dotR_by + dzdl * W.dotR_bz - dthetadl * W.dotR_btheta);
-
-  // lon
-  termz = (clon * (1 + clat) * (1 + clat) * slon - slon * slat * slat) / (normu * normu * normu);
-  dxdl = slat * slon / normu + (1 + clon) * slat * termz;
-  dydl = (1 + clat) * clon / normu - (1 + clat) * slon * termz;
-  dzdl = clon * slat / normu - slat * slon * termz;
-  dthetadl = u(1);
-  blon = (dxdl * W.dotR_bx + dydl * W.dotR_by + dzdl * W.dotR_bz - dthetadl * W.dotR_btheta);
-
-  // sigma
-  W.dotR(dydsigma.transpose(), u(0), u(1), u(2), -theta);
-  dydsigma = W.dotR_result.transpose();
-  bsigma = (by.transpose() * dydsigma).dot(amp);
-
-  // Compute the actual result (w/o amplitude)
-  W.dotR(y.transpose(), u(0), u(1), u(2), -theta);
-  y = W.dotR_result.transpose();
-
-  // Gradient of amplitude
-  bamp = y.transpose() * by;
+/**
+Compute the Ylm expansion of a spot at a given latitude/longitude on the map.
+
+*/
+template <class Scalar>
+inline Matrix<Scalar> spotYlm(const RowVector<Scalar> &amp, const Scalar &sigma,
+                              const Scalar &lat, const Scalar &lon, int l,
+                              wigner::Wigner<Scalar> &W) {
+  Matrix<Scalar> amp_ = amp;
+  Vector<Scalar> sigma_(1), lat_(1), lon_(1);
+  sigma_ << sigma;
+  lat_ << lat;
+  lon_ << lon;
+  return spotYlm(amp_, sigma_, lat_, lon_, l, W);
+}
 
+/**
+Compute the gradient of the Ylm expansion of a spot at a
+given latitude/longitude on the map.
+
+*/
+template <class Scalar>
+inline void spotYlm(const RowVector<Scalar> &amp, const Scalar &sigma,
+                    const Scalar &lat, const Scalar &lon,
+                    const Matrix<double> &by,
+                    int l, wigner::Wigner<Scalar> &W,
+                    RowVector<Scalar> &bamp,
+                    Scalar &bsigma, Scalar &blat, Scalar &blon) {
+  Matrix<Scalar> amp_ = amp, bamp_;
+  Vector<Scalar> sigma_(1), lat_(1), lon_(1), bsigma_, blat_, blon_;
+  sigma_ << sigma;
+  lat_ << lat;
+  lon_ << lon;
+  spotYlm(amp_, sigma_, lat_, lon_, by, l, W, bamp_, bsigma_, blat_, blon_);
+  bamp = bamp_.row(0);
+  bsigma = bsigma_(0);
+  blat = blat_(0);
+  blon = blon_(0);
 }
 
 }  // namespace misc
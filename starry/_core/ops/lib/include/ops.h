@@ -5,9 +5,13 @@
 */
 
 #include "basis.h"
+#include "design.h"
 #include "diffrot.h"
 #include "filter.h"
+#include "kepler.h"
+#include "linalg.h"
 #include "misc.h"
+#include "render.h"
 #include "solver_emitted.h"
 #include "solver_reflected.h"
 #include "utils.h"
@@ -30,6 +34,7 @@ class Ops {
   const int deg;
   const int N;
   const int drorder; /**< Order of the differential rotation operator */
+  int nthreads; /**< Number of threads in batched calls (0 = one per core) */
 
   basis::Basis<Scalar> B;
   wigner::Wigner<Scalar> W;
@@ -38,18 +43,43 @@ class Ops {
   filter::Filter<Scalar> F;
   diffrot::DiffRot<Scalar> D;
 
+  // Per-thread occultation solvers for the batched `sT` calls
+  std::vector<std::unique_ptr<solver::GreensEmitted<Scalar>>> Gs;
+  std::mutex Gs_mutex;
+
+  // Per-thread occultation solvers in reflected light
+  std::vector<std::unique_ptr<solver::OccultedReflected<Scalar>>> ORef;
+  std::mutex ORef_mutex;
+
+  // Optional table of `s^T` at fixed `r`, shared by the solvers above
+  solver::GreensEmittedTable<Scalar> Gtable;
+
+  // The fused light curve design matrix
+  design::DesignMatrix<Scalar> DM;
+
+  // Guards the shared workspaces above when called without the GIL
+  std::mutex mutex;
+
   // Spot gradients
   RowVector<Scalar> bamp;
   Scalar bsigma;
   Scalar blat;
   Scalar blon;
 
+  // Batched spot gradients
+  Matrix<Scalar> bamps;
+  Vector<Scalar> bsigmas;
+  Vector<Scalar> blats;
+  Vector<Scalar> blons;
+
   // Constructor
   explicit Ops(int ydeg, int udeg, int fdeg, int drorder) :
       ydeg(ydeg), Ny((ydeg + 1) * (ydeg + 1)), udeg(udeg), Nu(udeg + 1),
       fdeg(fdeg), Nf((fdeg + 1) * (fdeg + 1)), deg(ydeg + udeg + fdeg),
-      N((deg + 1) * (deg + 1)), drorder(drorder), B(ydeg, udeg, fdeg),
-      W(ydeg, udeg, fdeg), G(deg), GRef(deg), F(B), D(B, drorder) {
+      N((deg + 1) * (deg + 1)), drorder(drorder), nthreads(STARRY_NTHREADS),
+      B(ydeg, udeg, fdeg),
+      W(ydeg, udeg, fdeg), G(deg), GRef(deg), F(B), D(B, drorder), Gtable(deg),
+      DM(B, W, F, Gs) {
     // Bounds checks
     if ((ydeg < 0) || (ydeg > STARRY_MAX_LMAX))
       throw std::out_of_range("Spherical harmonic degree out of range.");
@@ -57,6 +87,275 @@ class Ops {
       throw std::out_of_range("Total degree out of range.");
   };
 
+  /**
+  Compute the occultation solution vector `s^T` for a batch of
+  impact parameters `b` at a fixed occultor radius `r`. The batch
+  is split across threads, each with its own solver workspace,
+  and the solutions are written directly into the rows of `sT`.
+  If the table tolerance is nonzero, the solutions are
+  interpolated from a table that is rebuilt only when `r` changes.
+
+  */
+  inline void sT(const Ref<const Vector<double>> &b, const double &r,
+                 Ref<Matrix<double, RowMajor>> sT) {
+    std::lock_guard<std::mutex> lock(Gs_mutex);
+    size_t npts = size_t(b.size());
+    int nt = getNumThreads(npts, nthreads);
+    allocateSolvers(nt);
+    Scalar r_ = static_cast<Scalar>(r);
+    Gtable.update(*Gs[0], r_);
+    parallelFor(npts, nt, [&](int t, size_t start, size_t end) {
+      Vector<Scalar> b_ = b.segment(start, end - start).template cast<Scalar>();
+      solver::GreensEmitted<Scalar> &G = *Gs[t];
+      solver::computeBatch<false>(G, Gtable, b_, r_, [&](int i) {
+        sT.row(start + i) = G.sT.template cast<double>();
+      });
+    });
+  }
+
+  /**
+  Compute the gradient of the batched occultation solution vector
+  given the gradient `bsT` of some scalar with respect to it. The
+  gradient with respect to `b` is written into `bb`; the gradient
+  with respect to `r` is returned.
+
+  */
+  inline double sT(const Ref<const Vector<double>> &b, const double &r,
+                   const Ref<const Matrix<double, RowMajor>> &bsT,
+                   Ref<Vector<double>> bb) {
+    std::lock_guard<std::mutex> lock(Gs_mutex);
+    size_t npts = size_t(b.size());
+    int nt = getNumThreads(npts, nthreads);
+    allocateSolvers(nt);
+    std::vector<double> br(nt, 0.0);
+    Scalar r_ = static_cast<Scalar>(r);
+    Gtable.update(*Gs[0], r_);
+    parallelFor(npts, nt, [&](int t, size_t start, size_t end) {
+      Vector<Scalar> b_ = b.segment(start, end - start).template cast<Scalar>();
+      solver::GreensEmitted<Scalar> &G = *Gs[t];
+      Scalar br_ = 0.0;
+      solver::computeBatch<true>(G, Gtable, b_, r_, [&](int i) {
+        bb(start + i) = static_cast<double>(
+            G.dsTdb.dot(bsT.row(start + i).template cast<Scalar>()));
+        br_ += G.dsTdr.dot(bsT.row(start + i).template cast<Scalar>());
+      });
+      br[t] = static_cast<double>(br_);
+    });
+    double br_tot = 0.0;
+    for (int t = 0; t < nt; ++t)
+      br_tot += br[t];
+    return br_tot;
+  }
+
+  /**
+  Compute the light curve design matrix for a spherical harmonic
+  map without differential rotation, writing it into `X`.
+
+  */
+  inline void X(const Ref<const Vector<double>> &theta,
+                const Ref<const Vector<double>> &xo,
+                const Ref<const Vector<double>> &yo,
+                const Ref<const Vector<double>> &zo, const double &ro,
+                const double &inc, const double &obl,
+                const Ref<const Vector<double>> &u,
+                const Ref<const Vector<double>> &f,
+                Ref<Matrix<double, RowMajor>> X) {
+    std::lock(mutex, Gs_mutex);
+    std::lock_guard<std::mutex> lock(mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> Gs_lock(Gs_mutex, std::adopt_lock);
+    allocateSolvers(1);
+    Gtable.update(*Gs[0], static_cast<Scalar>(ro));
+    DM.compute(theta, xo, yo, zo, ro, inc, obl, u.template cast<Scalar>(),
+               f.template cast<Scalar>(), Gtable, nthreads, X);
+  }
+
+  /**
+  Compute the gradient of the light curve design matrix given the
+  gradient `bX` of some scalar with respect to it. The gradients
+  with respect to `theta`, `xo` and `yo` are written into `btheta`,
+  `bxo` and `byo`; those with respect to `ro`, `inc`, `obl`, `u`
+  and `f` are stored in `DM`.
+
+  */
+  inline void X(const Ref<const Vector<double>> &theta,
+                const Ref<const Vector<double>> &xo,
+                const Ref<const Vector<double>> &yo,
+                const Ref<const Vector<double>> &zo, const double &ro,
+                const double &inc, const double &obl,
+                const Ref<const Vector<double>> &u,
+                const Ref<const Vector<double>> &f,
+                const Ref<const Matrix<double, RowMajor>> &bX,
+                Ref<Vector<double>> btheta, Ref<Vector<double>> bxo,
+                Ref<Vector<double>> byo) {
+    std::lock(mutex, Gs_mutex);
+    std::lock_guard<std::mutex> lock(mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> Gs_lock(Gs_mutex, std::adopt_lock);
+    allocateSolvers(1);
+    Gtable.update(*Gs[0], static_cast<Scalar>(ro));
+    DM.compute(theta, xo, yo, zo, ro, inc, obl, u.template cast<Scalar>(),
+               f.template cast<Scalar>(), Gtable, nthreads, bX, btheta, bxo,
+               byo);
+  }
+
+  /**
+  Solve the linear least-squares problem for the posterior over
+  maps given the light curve `flux`, the inverse `CInv` of its
+  (diagonal) covariance, the prior mean `mu` and the inverse prior
+  covariance `LInv`. The design matrix is computed a block of rows
+  at a time and reduced straight into the normal equations, so it
+  is never stored in memory.
+
+  */
+  inline void solve(const Ref<const Vector<double>> &theta,
+                    const Ref<const Vector<double>> &xo,
+                    const Ref<const Vector<double>> &yo,
+                    const Ref<const Vector<double>> &zo, const double &ro,
+                    const double &inc, const double &obl,
+                    const Ref<const Vector<double>> &u,
+                    const Ref<const Vector<double>> &f,
+                    const Ref<const Vector<double>> &flux,
+                    const Ref<const Vector<double>> &CInv,
+                    const Ref<const Vector<double>> &mu,
+                    const Ref<const Matrix<double, RowMajor>> &LInv,
+                    Vector<double> &yhat, Matrix<double> &cho_ycov) {
+    size_t npts = size_t(theta.size());
+    linalg::checkShapes(npts, Ny, flux, CInv, mu, LInv);
+    std::lock(mutex, Gs_mutex);
+    std::lock_guard<std::mutex> lock(mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> Gs_lock(Gs_mutex, std::adopt_lock);
+    allocateSolvers(1);
+    Gtable.update(*Gs[0], static_cast<Scalar>(ro));
+    int nt = getNumThreads(npts, nthreads);
+    linalg::NormalEquations NE(Ny, nt);
+    DM.computeBlocks(
+        theta, xo, yo, zo, ro, inc, obl, u.template cast<Scalar>(),
+        f.template cast<Scalar>(), Gtable, nt,
+        [&](int t, size_t n0, const Matrix<Scalar, RowMajor> &XR) {
+          NE.update(t, XR.template cast<double>(), flux, CInv, n0);
+        });
+    NE.reduce();
+    linalg::solve(NE.W, NE.b, mu, LInv, yhat, cho_ycov);
+  }
+
+  /**
+  Compute the reflected light rotation solution vector `r^T` for
+  a batch of terminator parameters `bterm`, writing the solutions
+  directly into the rows of `rT`. The batch is split across threads;
+  the batched solver only reads precomputed tables, so the threads
+  can share it.
+
+  */
+  inline void rTReflected(const Ref<const Vector<double>> &bterm,
+                          Ref<Matrix<double, RowMajor>> rT) {
+    size_t npts = bterm.size();
+    int nt = getNumThreads(npts, nthreads);
+    parallelFor(npts, nt, [&](int, size_t start, size_t end) {
+      GRef.compute(bterm.segment(start, end - start),
+                   rT.middleRows(start, end - start));
+    });
+  }
+
+  /**
+  Compute the gradient of the batched reflected light rotation
+  solution vector given the gradient `brT` of some scalar with
+  respect to it. The gradient with respect to `bterm` is written
+  into `bb`.
+
+  */
+  inline void rTReflected(const Ref<const Vector<double>> &bterm,
+                          const Ref<const Matrix<double, RowMajor>> &brT,
+                          Ref<Vector<double>> bb) {
+    size_t npts = bterm.size();
+    int nt = getNumThreads(npts, nthreads);
+    parallelFor(npts, nt, [&](int, size_t start, size_t end) {
+      GRef.compute(bterm.segment(start, end - start),
+                   brT.middleRows(start, end - start),
+                   bb.segment(start, end - start));
+    });
+  }
+
+  /**
+  Compute the reflected light occultation solution vector `s^T` for
+  a batch of terminator parameters `bterm` and occultor positions
+  `(xo, yo, zo)` in the frame where the source lies along `+y`. Rows
+  are the rotation solution `r^T` minus the integrals over the
+  occulted part of the day side, which are only computed for the
+  points where the occultor overlaps the disk.
+
+  */
+  inline void sTReflected(const Ref<const Vector<double>> &bterm,
+                          const Ref<const Vector<double>> &xo,
+                          const Ref<const Vector<double>> &yo,
+                          const Ref<const Vector<double>> &zo,
+                          const double &ro,
+                          Ref<Matrix<double, RowMajor>> sT) {
+    std::lock_guard<std::mutex> lock(ORef_mutex);
+    size_t npts = bterm.size();
+    int nt = getNumThreads(npts, nthreads);
+    allocateReflectedSolvers(nt);
+    parallelFor(npts, nt, [&](int t, size_t start, size_t end) {
+      GRef.compute(bterm.segment(start, end - start),
+                   sT.middleRows(start, end - start));
+      solver::OccultedReflected<Scalar> &O = *ORef[t];
+      for (size_t i = start; i < end; ++i) {
+        if ((zo(i) <= 0) || (ro == 0))
+          continue;
+        O.compute(static_cast<Scalar>(bterm(i)), static_cast<Scalar>(xo(i)),
+                  static_cast<Scalar>(yo(i)), static_cast<Scalar>(ro));
+        sT.row(i) -= O.oT.template cast<double>();
+      }
+    });
+  }
+
+  /**
+  Compute the gradient of the reflected light occultation solution
+  vector given the gradient `bsT` of some scalar with respect to it.
+  The gradients with respect to `bterm`, `xo` and `yo` are written
+  into `bb`, `bxo` and `byo`; the gradient with respect to `ro` is
+  returned.
+
+  */
+  inline double sTReflected(const Ref<const Vector<double>> &bterm,
+                            const Ref<const Vector<double>> &xo,
+                            const Ref<const Vector<double>> &yo,
+                            const Ref<const Vector<double>> &zo,
+                            const double &ro,
+                            const Ref<const Matrix<double, RowMajor>> &bsT,
+                            Ref<Vector<double>> bb, Ref<Vector<double>> bxo,
+                            Ref<Vector<double>> byo) {
+    std::lock_guard<std::mutex> lock(ORef_mutex);
+    size_t npts = bterm.size();
+    int nt = getNumThreads(npts, nthreads);
+    allocateReflectedSolvers(nt);
+    std::vector<double> br(nt, 0.0);
+    parallelFor(npts, nt, [&](int t, size_t start, size_t end) {
+      GRef.compute(bterm.segment(start, end - start),
+                   bsT.middleRows(start, end - start),
+                   bb.segment(start, end - start));
+      solver::OccultedReflected<Scalar> &O = *ORef[t];
+      Scalar br_ = 0.0;
+      for (size_t i = start; i < end; ++i) {
+        bxo(i) = 0.0;
+        byo(i) = 0.0;
+        if ((zo(i) <= 0) || (ro == 0))
+          continue;
+        O.template compute<true>(
+            static_cast<Scalar>(bterm(i)), static_cast<Scalar>(xo(i)),
+            static_cast<Scalar>(yo(i)), static_cast<Scalar>(ro));
+        RowVector<Scalar> bsT_ = bsT.row(i).template cast<Scalar>();
+        bb(i) -= static_cast<double>(O.doTdb.dot(bsT_));
+        bxo(i) = -static_cast<double>(O.doTdxo.dot(bsT_));
+        byo(i) = -static_cast<double>(O.doTdyo.dot(bsT_));
+        br_ -= O.doTdro.dot(bsT_);
+      }
+      br[t] = static_cast<double>(br_);
+    });
+    double br_tot = 0.0;
+    for (int t = 0; t < nt; ++t)
+      br_tot += br[t];
+    return br_tot;
+  }
+
   // Compute the Ylm expansion of a gaussian spot at a
   // given latitude/longitude on the map.
   inline Matrix<Scalar> spotYlm(const RowVector<Scalar> &amp,
@@ -74,6 +373,38 @@ class Ops {
     misc::spotYlm(amp, sigma, lat, lon, by, ydeg, W, bamp, bsigma, blat, blon);
   }
 
+  // Compute the summed Ylm expansion of a batch of gaussian spots.
+  inline Matrix<Scalar> spotYlm(const Matrix<Scalar> &amp,
+                                const Vector<Scalar> &sigma,
+                                const Vector<Scalar> &lat,
+                                const Vector<Scalar> &lon) {
+    return misc::spotYlm(amp, sigma, lat, lon, ydeg, W);
+  }
+
+  // Compute the gradient of the summed Ylm expansion of a batch
+  // of gaussian spots.
+  inline void spotYlm(const Matrix<Scalar> &amp,
+                      const Vector<Scalar> &sigma,
+                      const Vector<Scalar> &lat,
+                      const Vector<Scalar> &lon,
+                      const Matrix<double> &by) {
+    misc::spotYlm(amp, sigma, lat, lon, by, ydeg, W, bamps, bsigmas, blats,
+                  blons);
+  }
+
+ protected:
+  // Make sure we have one occultation solver per thread
+  inline void allocateSolvers(int nt) {
+    while (int(Gs.size()) < nt)
+      Gs.emplace_back(new solver::GreensEmitted<Scalar>(deg));
+  }
+
+  // Same for the occultation solvers in reflected light
+  inline void allocateReflectedSolvers(int nt) {
+    while (int(ORef.size()) < nt)
+      ORef.emplace_back(new solver::OccultedReflected<Scalar>(deg));
+  }
+
 };  // class Ops
 
 }  // namespace starry
\ No newline at end of file
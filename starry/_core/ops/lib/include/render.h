@@ -0,0 +1,178 @@
+/**
+\file render.h
+\brief Tiled evaluation of the polynomial basis on image grids.
+
+*/
+
+#ifndef _STARRY_RENDER_H_
+#define _STARRY_RENDER_H_
+
+#include "utils.h"
+
+//! Number of pixels evaluated at a time when rendering
+#ifndef STARRY_RENDER_TILE
+#define STARRY_RENDER_TILE 256
+#endif
+
+namespace starry {
+namespace render {
+
+using namespace utils;
+
+//! Projections; these match the constants in `_constants.py`
+static const int ORTHOGRAPHIC = 0;
+static const int RECTANGULAR = 1;
+
+/**
+Compute the Cartesian coordinates of the pixels `[start, end)` of a
+`res x res` image in the given projection, in row-major order. These
+are the same grids as `compute_ortho_grid` and `compute_rect_grid`;
+pixels off the disk in the orthographic projection have `z = NaN`.
+
+*/
+inline void computeGrid(int res, int projection, size_t start, size_t end,
+                        Vector<double> &x, Vector<double> &y,
+                        Vector<double> &z) {
+  size_t npix = end - start;
+  x.resize(npix);
+  y.resize(npix);
+  z.resize(npix);
+  if (projection == RECTANGULAR) {
+    double dx = pi<double>() / res;
+    for (size_t k = 0; k < npix; ++k) {
+      size_t i = (start + k) / res, j = (start + k) % res;
+      double lat = -0.5 * pi<double>() + i * dx;
+      double lon = -1.5 * pi<double>() + j * 2 * dx;
+      // Rotated by -pi/2 about the x axis
+      x(k) = cos(lat) * cos(lon);
+      y(k) = sin(lat);
+      z(k) = -cos(lat) * sin(lon);
+    }
+  } else if (projection == ORTHOGRAPHIC) {
+    double dx = 2.0 / res;
+    for (size_t k = 0; k < npix; ++k) {
+      size_t i = (start + k) / res, j = (start + k) % res;
+      x(k) = -1.0 + j * dx;
+      y(k) = -1.0 + i * dx;
+      z(k) = sqrt(1.0 - x(k) * x(k) - y(k) * y(k));
+    }
+  } else {
+    throw std::runtime_error("Invalid projection.");
+  }
+}
+
+/**
+Compute the polynomial basis of degree `deg` at the points `(x, y, z)`.
+This is the same as `Basis::computePolyBasis`, but only stores the
+powers of `x` and `y` rather than two scratch matrices as large as
+`pT` itself.
+
+*/
+inline void computePolyBasis(int deg, const Vector<double> &x,
+                             const Vector<double> &y,
+                             const Vector<double> &z,
+                             Matrix<double> &xpow, Matrix<double> &ypow,
+                             Matrix<double> &pT) {
+  int npts = x.size();
+  xpow.resize(npts, deg + 1);
+  ypow.resize(npts, deg + 1);
+  pT.resize(npts, (deg + 1) * (deg + 1));
+
+  // Ensures we get `nan`s off the disk
+  xpow.col(0) = (0.0 * z).array() + 1.0;
+  ypow.col(0) = xpow.col(0);
+  for (int k = 1; k < deg + 1; ++k) {
+    xpow.col(k) = xpow.col(k - 1).cwiseProduct(x);
+    ypow.col(k) = ypow.col(k - 1).cwiseProduct(y);
+  }
+  int n = 0;
+  for (int l = 0; l < deg + 1; ++l) {
+    for (int m = -l; m < l + 1; ++m) {
+      int mu = l - m, nu = l + m;
+      if (nu % 2 == 0) {
+        pT.col(n) = xpow.col(mu / 2).cwiseProduct(ypow.col(nu / 2));
+      } else {
+        pT.col(n) = xpow.col((mu - 1) / 2)
+                        .cwiseProduct(ypow.col((nu - 1) / 2))
+                        .cwiseProduct(z);
+      }
+      ++n;
+    }
+  }
+}
+
+/**
+Return the degree of the polynomial basis with `N` terms.
+
+*/
+inline int getDegree(int N) {
+  int deg = static_cast<int>(round(sqrt(double(N)))) - 1;
+  if ((deg < 0) || ((deg + 1) * (deg + 1) != N))
+    throw std::runtime_error("Invalid number of polynomial coefficients.");
+  return deg;
+}
+
+/**
+Render the polynomial maps with coefficients given by the columns of
+`P` on a `res x res` image, writing the `res^2 x nframes` result into
+`image`. The basis is evaluated one tile of pixels at a time in each
+of `nthreads` threads, so the memory footprint doesn't grow with
+`res^2 N`.
+
+*/
+inline void render(int res, int projection,
+                   const Ref<const Matrix<double, RowMajor>> &P,
+                   int nthreads, Ref<Matrix<double, RowMajor>> image) {
+  int deg = getDegree(P.rows());
+  size_t npix = size_t(res) * res;
+  if ((size_t(image.rows()) != npix) || (image.cols() != P.cols()))
+    throw std::runtime_error("Output array has the wrong shape.");
+  int nt = getNumThreads(npix, nthreads);
+  parallelFor(npix, nt, [&](int, size_t start, size_t end) {
+    Vector<double> x, y, z;
+    Matrix<double> xpow, ypow, pT;
+    for (size_t n0 = start; n0 < end; n0 += STARRY_RENDER_TILE) {
+      size_t n1 = std::min(n0 + STARRY_RENDER_TILE, end);
+      computeGrid(res, projection, n0, n1, x, y, z);
+      computePolyBasis(deg, x, y, z, xpow, ypow, pT);
+      image.middleRows(n0, n1 - n0).noalias() = pT * P;
+    }
+  });
+}
+
+/**
+Backpropagate the gradient `bimage` of the output of `render`
+into the gradient `bP` of the polynomial coefficients. Pixels off
+the disk don't contribute.
+
+*/
+inline void render(int res, int projection,
+                   const Ref<const Matrix<double, RowMajor>> &P,
+                   const Ref<const Matrix<double, RowMajor>> &bimage,
+                   int nthreads, Matrix<double> &bP) {
+  int deg = getDegree(P.rows());
+  size_t npix = size_t(res) * res;
+  if ((size_t(bimage.rows()) != npix) || (bimage.cols() != P.cols()))
+    throw std::runtime_error("Incompatible shapes in the image gradient.");
+  int nt = getNumThreads(npix, nthreads);
+  std::vector<Matrix<double>> bP_t(nt,
+                                   Matrix<double>::Zero(P.rows(), P.cols()));
+  parallelFor(npix, nt, [&](int t, size_t start, size_t end) {
+    Vector<double> x, y, z;
+    Matrix<double> xpow, ypow, pT;
+    for (size_t n0 = start; n0 < end; n0 += STARRY_RENDER_TILE) {
+      size_t n1 = std::min(n0 + STARRY_RENDER_TILE, end);
+      computeGrid(res, projection, n0, n1, x, y, z);
+      computePolyBasis(deg, x, y, z, xpow, ypow, pT);
+      pT = pT.unaryExpr([](double v) { return std::isnan(v) ? 0.0 : v; });
+      bP_t[t].noalias() += pT.transpose() * bimage.middleRows(n0, n1 - n0);
+    }
+  });
+  bP.setZero(P.rows(), P.cols());
+  for (auto &bPt : bP_t)
+    bP += bPt;
+}
+
+}  // namespace render
+}  // namespace starry
+#endif
@@ -13,6 +13,16 @@ harmonic map during a single-body occultation using Green's theorem.
 #include "ellip.h"
 #include "utils.h"
 
+//! Order of the Chebyshev pieces in the tabulated `s^T` solution
+#ifndef STARRY_SOLVER_TABLE_ORDER
+#define STARRY_SOLVER_TABLE_ORDER 16
+#endif
+
+//! Maximum number of bisections of a piece in the tabulated `s^T` solution
+#ifndef STARRY_SOLVER_TABLE_MAX_DEPTH
+#define STARRY_SOLVER_TABLE_MAX_DEPTH 20
+#endif
+
 namespace starry {
 namespace solver {
 
@@ -27,15 +37,20 @@ class Vieta {
  protected:
   int umax;
   int vmax;
+  bool grad;
   T res;
+  T dres;
   T u_choose_j1;
   T v_choose_c0;
   T fac;
   Vector<T> delta;
+  Vector<T> ddelta;
   Matrix<bool> set;
   Matrix<Vector<T>> vec;
+  Matrix<Vector<T>> dvec;
 
   //! Compute the double-binomial coefficient A_{i,u,v}
+  //! and (optionally) its derivative with respect to `delta`
   inline void compute(int u, int v) {
     int j1 = u;
     int j2 = u;
@@ -45,10 +60,12 @@ class Vieta {
     v_choose_c0 = 1.0;
     for (int i = 0; i < u + v + 1; ++i) {
       res = 0;
+      dres = 0;
       int c = c0;
       fac = sgn0 * u_choose_j1 * v_choose_c0;
       for (int j = j1; j < j2 + 1; ++j) {
         res += fac * delta(c);
+        if (grad) dres += fac * ddelta(c);
         --c;
         fac *= -((u - j) * (c + 1.0)) / ((j + 1.0) * (v - c));
       }
@@ -65,6 +82,7 @@ class Vieta {
           v_choose_c0 = 1.0;
       }
       vec(u, v)(i) = res;
+      if (grad) dvec(u, v)(i) = dres;
     }
     set(u, v) = true;
   }
@@ -85,13 +103,16 @@ class Vieta {
   //! Constructor
   explicit Vieta(int lmax) :
       umax(is_even(lmax) ? (lmax + 2) / 2 : (lmax + 3) / 2),
-      vmax(lmax > 0 ? lmax : 1), delta(vmax + 1), set(umax + 1, vmax + 1),
-      vec(umax + 1, vmax + 1) {
+      vmax(lmax > 0 ? lmax : 1), grad(false), delta(vmax + 1),
+      ddelta(vmax + 1), set(umax + 1, vmax + 1), vec(umax + 1, vmax + 1),
+      dvec(umax + 1, vmax + 1) {
     delta(0) = 1.0;
+    ddelta(0) = 0.0;
     set.setZero();
     for (int u = 0; u < umax + 1; ++u) {
       for (int v = 0; v < vmax + 1; ++v) {
         vec(u, v).resize(u + v + 1);
+        dvec(u, v).resize(u + v + 1);
       }
     }
   }
@@ -99,11 +120,20 @@ class Vieta {
   //! Overload () to get the function value without calling `get_value()`
   inline Vector<T> &operator()(int u, int v) { return get_value(u, v); }
 
+  //! Derivative of A_{i,u,v} with respect to `delta`. Only
+  //! available if the last call to `reset()` requested it.
+  inline Vector<T> &deriv(int u, int v) {
+    get_value(u, v);
+    return dvec(u, v);
+  }
+
   //! Resetter
-  void reset(const T &delta_) {
+  void reset(const T &delta_, bool grad_ = false) {
     set.setZero();
+    grad = grad_;
     for (int v = 1; v < vmax + 1; ++v) {
       delta(v) = delta(v - 1) * delta_;
+      if (grad) ddelta(v) = v * delta(v - 1);
     }
   }
 };
@@ -202,6 +232,20 @@ class HIntegral {
 
   //! Overload () to get the function value without calling `get_value()`
   inline T operator()(int u, int v) { return get_value(u, v); }
+
+  /**
+  The derivative of `H_{u,v}` with respect to `sin(lambda)`, valid
+  for `u > 0`. Since `H_{u,v}` is the integral of `cos^u(phi) sin^v(phi)`
+  from `pi - lambda` to `2 pi + lambda`, this is just twice the integrand
+  at `lambda` divided by `cos(lambda)`.
+
+  */
+  inline T deriv(int u, int v) {
+    CHECK_BOUNDS(u, 1, umax);
+    CHECK_BOUNDS(v, 0, vmax);
+    if ((coslam_is_zero) || (!is_even(u))) return T(0.0);
+    return 2.0 * pow_coslam(u - 1) * pow_sinlam(v);
+  }
 };
 
 template <typename T>
@@ -306,19 +350,97 @@ inline void computeS0_(const Scalar &b, const Scalar &r, const Scalar &ksq,
   }
 }
 
+/**
+Returns true if computing `s2` requires a call to `CEL`, i.e., if
+we're not in one of the special cases handled in `computeS2_`.
+
+*/
+template <class Scalar>
+inline bool needsCEL_(const Scalar &b, const Scalar &r, const Scalar &ksq) {
+  return !((b >= 1.0 + r) || (r == 0.0) || (b <= r - 1.0) || (b == 0) ||
+           (b == r) || (ksq == 1));
+}
+
+/**
+Compute the nine arguments to the three-integral `CEL` overload
+we need in the general case of `computeS2_`.
+
+*/
+template <class Scalar>
+inline void computeS2CELArgs_(const Scalar &b, const Scalar &r,
+                              const Scalar &ksq, const Scalar &kc,
+                              const Scalar &kcsq, const Scalar &invksq,
+                              Scalar *args) {
+  if (ksq < 1) {
+    // Case 2, Case 8
+    args[0] = ksq;
+    args[1] = kc;
+    args[2] = (b - r) * (b - r) * kcsq;
+    args[3] = 0.0;
+    args[4] = 1.0;
+    args[5] = 1.0;
+    args[6] = 3 * kcsq * (b - r) * (b + r);
+    args[7] = kcsq;
+    args[8] = 0.0;
+  } else {
+    // Case 3, Case 9
+    Scalar bpr = b + r;
+    Scalar bmr = b - r;
+    Scalar onembpr2 = (Scalar(1.0) + bpr) * (Scalar(1.0) - bpr);
+    Scalar onembmr2inv =
+        Scalar(1.0) / ((Scalar(1.0) + bmr) * (Scalar(1.0) - bmr));
+    Scalar bmrdbpr = (b - r) / (b + r);
+    Scalar mu = 3 * bmrdbpr * onembmr2inv;
+    Scalar p = bmrdbpr * bmrdbpr * onembpr2 * onembmr2inv;
+    args[0] = invksq;
+    args[1] = kc;
+    args[2] = p;
+    args[3] = 1 + mu;
+    args[4] = 1.0;
+    args[5] = 1.0;
+    args[6] = p + mu;
+    args[7] = kcsq;
+    args[8] = 0.0;
+  }
+}
+
+/**
+Compute the three elliptic integrals needed in the general case
+of `computeS2_`, or read them from `ellip` if they were
+pre-computed (see `computeEllipticIntegrals`).
+
+*/
+template <class Scalar>
+inline void computeS2CEL_(const Scalar &b, const Scalar &r, const Scalar &ksq,
+                          const Scalar &kc, const Scalar &kcsq,
+                          const Scalar &invksq, const Scalar *ellip,
+                          Scalar &Piofk, Scalar &EllipticE,
+                          Scalar &EllipticEK) {
+  if (ellip) {
+    Piofk = ellip[0];
+    EllipticE = ellip[1];
+    EllipticEK = ellip[2];
+  } else {
+    Scalar args[9];
+    computeS2CELArgs_(b, r, ksq, kc, kcsq, invksq, args);
+    ellip::CEL(args[0], args[1], args[2], args[3], args[4], args[5], args[6],
+               args[7], args[8], Piofk, EllipticE, EllipticEK);
+  }
+}
+
 template <class Scalar, bool GRADIENT = false>
 inline void computeS2_(const Scalar &b, const Scalar &r, const Scalar &ksq,
                        const Scalar &kc, const Scalar &kcsq,
                        const Scalar &invksq, const Scalar &third, Scalar &s2,
                        Scalar &EllipticE, Scalar &EllipticEK, Scalar &ds2db,
                        Scalar &ds2dr, Scalar &dEllipticEdm,
-                       Scalar &dEllipticEKdm) {
+                       Scalar &dEllipticEKdm,
+                       const Scalar *ellip = nullptr) {
   // Initialize some useful quantities
   Scalar r2 = r * r;
   Scalar bmr = b - r;
   Scalar bpr = b + r;
   Scalar onembmr2 = (Scalar(1.0) + bmr) * (Scalar(1.0) - bmr);
-  Scalar onembmr2inv = Scalar(1.0) / onembmr2;
 
   // Compute s2 and its derivatives
   Scalar Lambda1 = 0;
@@ -407,10 +529,8 @@ inline void computeS2_(const Scalar &b, const Scalar &r, const Scalar &ksq,
         Scalar fourbr = 4 * b * r;
         Scalar sqbrinv = Scalar(1.0) / sqrt(b * r);
         Scalar Piofk;
-        ellip::CEL(ksq, kc, Scalar((b - r) * (b - r) * kcsq), Scalar(0.0),
-                   Scalar(1.0), Scalar(1.0),
-                   Scalar(3 * kcsq * (b - r) * (b + r)), kcsq, Scalar(0.0),
-                   Piofk, EllipticE, EllipticEK);
+        computeS2CEL_(b, r, ksq, kc, kcsq, invksq, ellip, Piofk, EllipticE,
+                      EllipticEK);
         Lambda1 = onembmr2 *
                   (Piofk + (-3 + 6 * r2 + 2 * b * r) * EllipticEK -
                    fourbr * EllipticE) *
@@ -428,13 +548,9 @@ inline void computeS2_(const Scalar &b, const Scalar &r, const Scalar &ksq,
         Scalar onembpr2 = (Scalar(1.0) + bpr) * (Scalar(1.0) - bpr);
         Scalar sqonembmr2 = sqrt(onembmr2);
         Scalar b2 = b * b;
-        Scalar bmrdbpr = (b - r) / (b + r);
-        Scalar mu = 3 * bmrdbpr * onembmr2inv;
-        Scalar p = bmrdbpr * bmrdbpr * onembpr2 * onembmr2inv;
         Scalar Piofk;
-        ellip::CEL(invksq, kc, p, Scalar(1 + mu), Scalar(1.0), Scalar(1.0),
-                   Scalar(p + mu), kcsq, Scalar(0.0), Piofk, EllipticE,
-                   EllipticEK);
+        computeS2CEL_(b, r, ksq, kc, kcsq, invksq, ellip, Piofk, EllipticE,
+                      EllipticEK);
         Lambda1 = 2 * sqonembmr2 *
                   (onembpr2 * Piofk - (4 - 7 * r2 - b2) * EllipticE) * third;
         if (GRADIENT) {
@@ -465,7 +581,7 @@ inline void computeS2_(const Scalar &b, const Scalar &r, const Scalar &ksq,
   s2 = ((1.0 - int(r > b)) * 2 * pi<Scalar>() - Lambda1) * third;
 }
 
-template <class T, bool AUTODIFF>
+template <class T>
 class Solver {
  public:
   // Indices
@@ -493,9 +609,20 @@ class Solver {
   T EllipticE;
   T EllipticEK;
 
+  // Derivatives of the variables. Note that `m` is the
+  // elliptic parameter, which is `k^2` if `k^2 < 1` and
+  // `1 / k^2` otherwise.
+  T dmdb;
+  T dmdr;
+  T ddeltadb;
+  T ddeltadr;
+  T dsinlamdb;
+  T dsinlamdr;
+  T dEllipticEdm;
+  T dEllipticEKdm;
+
   // Miscellaneous
   T third;
-  T dummy;
   bool qcond;
   Vector<T> pow_ksq;
   Vector<T> cjlow;
@@ -509,61 +636,41 @@ class Solver {
   Vector<T> IGamma;
   Vector<T> J;
 
-  // The solution vector
+  // Derivatives of the integrals with respect to `m`
+  Vector<T> dI;
+  Vector<T> dJ;
+
+  // The solution vector and its derivatives
   RowVector<T> sT;
+  RowVector<T> dsTdb;
+  RowVector<T> dsTdr;
 
   explicit Solver(int lmax) :
       lmax(lmax), N((lmax + 1) * (lmax + 1)), ivmax(lmax + 2),
       jvmax(lmax > 0 ? lmax - 1 : 0), pow_ksq(ivmax + 1),
       cjlow(Vector<T>::Zero(jvmax + 2)), cjhigh(Vector<T>::Zero(jvmax + 2)),
       A(lmax), H(lmax), I(ivmax + 1), IGamma(ivmax + 1), J(jvmax + 1),
-      sT(RowVector<T>::Zero(N)) {
+      dI(Vector<T>::Zero(ivmax + 1)), dJ(Vector<T>::Zero(jvmax + 1)),
+      sT(RowVector<T>::Zero(N)), dsTdb(RowVector<T>::Zero(N)),
+      dsTdr(RowVector<T>::Zero(N)) {
     third = T(1.0) / T(3.0);
-    dummy = 0.0;
     pow_ksq(0) = 1.0;
     precomputeIGamma();
     precomputeJCoeffs();
   }
 
-#ifdef STARRY_ENABLE_BOOST
-
   /**
   The helper primitive integral I_{v} when k^2 >= 1.
   This is pre-computed when the class is instantiated.
-  AutoDiff specialization.
 
   */
-  template <typename U = T, bool A = AUTODIFF>
-  inline typename std::enable_if<A, void>::type precomputeIGamma() {
-    for (int v = 0; v <= ivmax; v++) {
-      IGamma(v) =
-          root_pi<T>() *
-          boost::math::tgamma_delta_ratio<typename U::Scalar>(v + 0.5, 0.5);
-    }
-  }
-
-  /**
-  The helper primitive integral I_{v} when k^2 >= 1.
-  This is pre-computed when the class is instantiated.
-  Scalar specialization.
-
-  */
-  template <typename U = T, bool A = AUTODIFF>
-  inline typename std::enable_if<!A, void>::type precomputeIGamma() {
+  inline void precomputeIGamma() {
+#ifdef STARRY_ENABLE_BOOST
     for (int v = 0; v <= ivmax; v++) {
       IGamma(v) =
-          root_pi<T>() * boost::math::tgamma_delta_ratio<U>(v + 0.5, 0.5);
+          root_pi<T>() * boost::math::tgamma_delta_ratio<T>(v + 0.5, 0.5);
     }
-  }
-
 #else
-
-  /**
-  The helper primitive integral I_{v} when k^2 >= 1.
-  This is pre-computed when the class is instantiated.
-
-  */
-  inline void precomputeIGamma() {
     T term;
     for (int v = 0; v <= ivmax; v++) {
       term = pi<T>();
@@ -571,9 +678,8 @@ class Solver {
       for (int i = max(1, v); i < v + 1; ++i) term *= i - T(0.5);
       IGamma(v) = term;
     }
-  }
-
 #endif
+  }
 
   /**
   Pre-compute some useful coefficients in the series
@@ -658,12 +764,26 @@ class Solver {
     }
   }
 
+  /**
+  The derivative of the helper primitive integral I_{v} with
+  respect to k^2 when k^2 < 1. Since I_{v} is the integral of
+  `sin^{2v}(phi)` between `-kappa / 2` and `kappa / 2`, where
+  `sin(kappa / 2) = k`, this has the simple closed form
+  `k^{2v} / (k k_c)`.
+
+  */
+  inline void computeIDerivative() {
+    T invkkc = T(1.0) / kkc;
+    for (int v = 0; v < ivmax + 1; ++v) dI(v) = pow_ksq(v) * invkkc;
+  }
+
   /**
   The helper primitive integral J_{v}, computed
-  by downward recursion.
+  by downward recursion. If `GRADIENT` is set, also
+  computes the derivative with respect to `m`.
 
   */
-  template <bool KSQLESSTHANONE>
+  template <bool KSQLESSTHANONE, bool GRADIENT = false>
   inline void computeJDownward() {
     // Track the error
     T tol;
@@ -673,6 +793,8 @@ class Solver {
       tol = mach_eps<T>() * invksq;
     T coeff, res, error;
     T f1, f2, f3;
+    T m = KSQLESSTHANONE ? ksq : invksq;
+    T dcoeff, dres, df1, df2, df3;
     int vtop, vbot;
 
     // Compute our initial terms via the series expansion
@@ -686,24 +808,38 @@ class Solver {
         else
           coeff = cjhigh(v);
         res = coeff;
+        // `dcoeff` is the n^th coefficient divided by `m`,
+        // so we can sum `n * dcoeff` to get the derivative
+        dcoeff = coeff;
+        dres = 0;
         int n = 1;
         while ((n < STARRY_IJ_MAX_ITER) && (abs(error) > tol)) {
+          T fac;
           if (KSQLESSTHANONE)
-            coeff *= (2.0 * n - 1.0) * (2.0 * (n + v) - 1.0) * 0.25 /
-                     T(n * (n + v + 2.0)) * ksq;
+            fac = (2.0 * n - 1.0) * (2.0 * (n + v) - 1.0) * 0.25 /
+                  T(n * (n + v + 2.0));
           else
-            coeff *=
-                (T(1.0) - T(2.5 / n)) * (T(1.0) - T(0.5 / (n + v))) * invksq;
+            fac = (T(1.0) - T(2.5 / n)) * (T(1.0) - T(0.5 / (n + v)));
+          coeff *= fac * m;
+          if (GRADIENT) {
+            if (n > 1) dcoeff *= m;
+            dcoeff *= fac;
+            dres += n * dcoeff;
+          }
           error = coeff;
           res += coeff;
           ++n;
         }
         if (unlikely(n == STARRY_IJ_MAX_ITER))
           throw std::runtime_error("Primitive integral `J` did not converge.");
-        if (KSQLESSTHANONE)
+        if (KSQLESSTHANONE) {
           J(v) = pow_ksq(v) * k * res;
-        else
+          if (GRADIENT)
+            dJ(v) = pow_ksq(v) * k * ((v + 0.5) * res * invksq + dres);
+        } else {
           J(v) = res;
+          if (GRADIENT) dJ(v) = dres;
+        }
       }
       // Recurse downward
       if (i < jvseries.size() - 1)
@@ -716,11 +852,23 @@ class Solver {
           f1 = 2 * (T(3 + v) + ksq * (1 + v)) * f2;
           f3 = T(2 * v + 7) * f2;
           J(v) = f1 * J(v + 1) - f3 * J(v + 2);
+          if (GRADIENT) {
+            df1 = 2 * (1 + v) * f2 - f1 * invksq;
+            df3 = -f3 * invksq;
+            dJ(v) = df1 * J(v + 1) + f1 * dJ(v + 1) - df3 * J(v + 2) -
+                    f3 * dJ(v + 2);
+          }
         } else {
           f3 = T(1.0) / T(2 * v + 1);
           f2 = T(2 * v + 7) * f3 * invksq;
           f1 = 2.0 * f3 * ((3 + v) * invksq + T(1 + v));
           J(v) = f1 * J(v + 1) - f2 * J(v + 2);
+          if (GRADIENT) {
+            df2 = T(2 * v + 7) * f3;
+            df1 = 2.0 * f3 * (3 + v);
+            dJ(v) = df1 * J(v + 1) + f1 * dJ(v + 1) - df2 * J(v + 2) -
+                    f2 * dJ(v + 2);
+          }
         }
       }
     }
@@ -728,10 +876,11 @@ class Solver {
 
   /**
   The helper primitive integral J_{v}, computed
-  by upward recursion.
+  by upward recursion. If `GRADIENT` is set, also
+  computes the derivative with respect to `m`.
 
   */
-  template <bool KSQLESSTHANONE>
+  template <bool KSQLESSTHANONE, bool GRADIENT = false>
   inline void computeJUpward() {
     T f1, f2;
     if (KSQLESSTHANONE) {
@@ -740,17 +889,41 @@ class Solver {
       J(1) = 0.2 * fac *
              ((T(4.0) - 3.0 * ksq) * EllipticE +
               (9.0 * ksq - T(8.0)) * EllipticEK);
+      if (GRADIENT) {
+        dJ(0) = -0.5 * invksq * J(0) +
+                fac * (dEllipticEdm + 3.0 * EllipticEK +
+                       (3.0 * ksq - T(2.0)) * dEllipticEKdm);
+        dJ(1) = -0.5 * invksq * J(1) +
+                0.2 * fac *
+                    (-3.0 * EllipticE + (T(4.0) - 3.0 * ksq) * dEllipticEdm +
+                     9.0 * EllipticEK + (9.0 * ksq - T(8.0)) * dEllipticEKdm);
+      }
     } else {
       J(0) = 2.0 * third *
              ((T(3.0) - 2.0 * invksq) * EllipticE + invksq * EllipticEK);
       J(1) = 0.4 * third *
              ((T(9.0) - 8.0 * invksq) * EllipticE +
               (4.0 * invksq - T(3.0)) * EllipticEK);
+      if (GRADIENT) {
+        dJ(0) = 2.0 * third *
+                (-2.0 * EllipticE + (T(3.0) - 2.0 * invksq) * dEllipticEdm +
+                 EllipticEK + invksq * dEllipticEKdm);
+        dJ(1) = 0.4 * third *
+                (-8.0 * EllipticE + (T(9.0) - 8.0 * invksq) * dEllipticEdm +
+                 4.0 * EllipticEK + (4.0 * invksq - T(3.0)) * dEllipticEKdm);
+      }
     }
+    // The recursion is in terms of `k^2`, so we need
+    // the derivative of `k^2` with respect to `m`
+    T dksqdm = KSQLESSTHANONE ? T(1.0) : T(-ksq * ksq);
     for (int v = 2; v < jvmax + 1; ++v) {
       f1 = 2.0 * (T(v + 1) + (v - 1) * ksq);
       f2 = ksq * (2 * v - 3);
       J(v) = (f1 * J(v - 1) - f2 * J(v - 2)) / T(2 * v + 3);
+      if (GRADIENT)
+        dJ(v) = ((2.0 * (v - 1) * J(v - 1) - (2 * v - 3) * J(v - 2)) * dksqdm +
+                 f1 * dJ(v - 1) - f2 * dJ(v - 2)) /
+                T(2 * v + 3);
     }
   }
 
@@ -766,75 +939,83 @@ class Solver {
   }
 
   /**
-  The helper primitive integral L_{u,v}^(t).
+  The gradient of the helper primitive integral K_{u,v}.
 
   */
-  inline T L(int u, int v, int t) {
-    return A(u, v).dot(J.segment(u + t, u + v + 1));
-  }
-
-  /**
-  Compute s(0) for a Scalar type.
-
-  */
-  template <bool A = AUTODIFF>
-  inline typename std::enable_if<!A, void>::type computeS0() {
-    computeS0_<T, false>(b, r, ksq, kite_area2, kap0, kap1, invb, sT(0), dummy,
-                         dummy);
+  inline void dK(int u, int v, T &dKdb, T &dKdr) {
+    if (ksq >= 1) {
+      T dKddelta = A.deriv(u, v).dot(IGamma.segment(u, u + v + 1));
+      dKdb = dKddelta * ddeltadb;
+      dKdr = dKddelta * ddeltadr;
+    } else {
+      T dKddelta = A.deriv(u, v).dot(I.segment(u, u + v + 1));
+      T dKdm = A(u, v).dot(dI.segment(u, u + v + 1));
+      dKdb = dKddelta * ddeltadb + dKdm * dmdb;
+      dKdr = dKddelta * ddeltadr + dKdm * dmdr;
+    }
   }
 
   /**
-  Compute s(0) and its gradient for an AutoDiffScalar type.
-  We know how to compute the gradient analytically, so we need
-  to override AutoDiff.
+  The helper primitive integral L_{u,v}^(t).
 
   */
-  template <bool A = AUTODIFF>
-  inline typename std::enable_if<A, void>::type computeS0() {
-    computeS0_<typename T::Scalar, true>(
-        b.value(), r.value(), ksq.value(), kite_area2.value(), kap0.value(),
-        kap1.value(), invb.value(), sT(0).value(), sT(0).derivatives()(0),
-        sT(0).derivatives()(1));
+  inline T L(int u, int v, int t) {
+    return A(u, v).dot(J.segment(u + t, u + v + 1));
   }
 
   /**
-  Compute s(2) for a Scalar type.
+  The gradient of the helper primitive integral L_{u,v}^(t).
 
   */
-  template <bool A = AUTODIFF>
-  inline typename std::enable_if<!A, void>::type computeS2() {
-    computeS2_<T, false>(b, r, ksq, kc, kcsq, invksq, third, sT(2), EllipticE,
-                         EllipticEK, dummy, dummy, dummy, dummy);
+  inline void dL(int u, int v, int t, T &dLdb, T &dLdr) {
+    T dLddelta = A.deriv(u, v).dot(J.segment(u + t, u + v + 1));
+    T dLdm = A(u, v).dot(dJ.segment(u + t, u + v + 1));
+    dLdb = dLddelta * ddeltadb + dLdm * dmdb;
+    dLdr = dLddelta * ddeltadr + dLdm * dmdr;
   }
 
   /**
-  Compute s(2) and its gradient for an AutoDiffScalar type.
-  We know how to compute the gradient analytically, so we need
-  to override AutoDiff.
+  Compute the derivatives of the angular variables, `delta`
+  and the elliptic parameter `m` with respect to `b` and `r`.
 
   */
-  template <bool A = AUTODIFF>
-  inline typename std::enable_if<A, void>::type computeS2() {
-    typename T::Scalar dEdksq, dEKdksq;
-    computeS2_<typename T::Scalar, true>(
-        b.value(), r.value(), ksq.value(), kc.value(), kcsq.value(),
-        invksq.value(), third.value(), sT(2).value(), EllipticE.value(),
-        EllipticEK.value(), sT(2).derivatives()(0), sT(2).derivatives()(1),
-        dEdksq, dEKdksq);
+  inline void computeVariableDerivatives() {
+    T bmr = b - r;
+    ddeltadb = 0.5 * invr;
+    ddeltadr = -0.5 * b * invr * invr;
+    if (qcond) {
+      dsinlamdb = 0;
+      dsinlamdr = 0;
+    } else {
+      dsinlamdb = 0.5 * (b * b + r * r - T(1.0)) * invb * invb;
+      dsinlamdr = -r * invb;
+    }
     if (ksq < 1) {
-      EllipticE.derivatives() = dEdksq * ksq.derivatives();
-      EllipticEK.derivatives() = dEKdksq * ksq.derivatives();
+      dmdb = -(0.5 * bmr * invr + ksq) * invb;
+      dmdr = (0.5 * bmr * invb - ksq) * invr;
+    } else if (unlikely(abs(T(1.0) - abs(bmr)) < mach_eps<T>())) {
+      // Singular at `b = 0, r = 1`, where `k^2` is pinned at infinity
+      dmdb = 0;
+      dmdr = 0;
     } else {
-      EllipticE.derivatives() = dEdksq * invksq.derivatives();
-      EllipticEK.derivatives() = dEKdksq * invksq.derivatives();
+      // This is well-behaved even when `b = 0`
+      T onembmr2inv = T(1.0) / ((T(1.0) + bmr) * (T(1.0) - bmr));
+      dmdb = (4 * r + 2 * bmr * invksq) * onembmr2inv;
+      dmdr = (4 * b - 2 * bmr * invksq) * onembmr2inv;
     }
   }
 
   /**
-  Compute the `s^T` occultation solution vector.
+  Compute the `s^T` occultation solution vector. If
+  `GRADIENT` is set, also computes its derivatives with
+  respect to `b` and `r`. All derivatives are computed
+  analytically alongside the recursions. If `ellip` is
+  provided, it should point to the three pre-computed
+  elliptic integrals for this `b` and `r`.
 
   */
-  inline void compute(const T &b_, const T &r_) {
+  template <bool GRADIENT = false>
+  inline void compute(const T &b_, const T &r_, const T *ellip = nullptr) {
     // Initialize b and r
     b = b_;
     r = r_;
@@ -849,6 +1030,10 @@ class Solver {
     // Special case: complete occultation
     if (unlikely(b < r - 1)) {
       sT.setZero();
+      if (GRADIENT) {
+        dsTdb.setZero();
+        dsTdr.setZero();
+      }
       return;
     }
 
@@ -866,6 +1051,7 @@ class Solver {
     // Compute the k^2 terms and angular variables
     computeKVariables(b, r, ksq, k, kc, kcsq, kkc, invksq, kite_area2, kap0,
                       kap1, invb, invr, coslam, sinlam, qcond);
+    if (GRADIENT) computeVariableDerivatives();
 
     // Some useful quantities
     T twor = 2 * r;
@@ -874,30 +1060,55 @@ class Solver {
     T tworlp2 = twor * twor * twor;
 
     // Compute the constant term
-    computeS0();
+    computeS0_<T, GRADIENT>(b, r, ksq, kite_area2, kap0, kap1, invb, sT(0),
+                            dsTdb(0), dsTdr(0));
 
     // Break if lmax = 0
     if (unlikely(N == 1)) return;
 
     // The l = 1, m = -1 is zero by symmetry
     sT(1) = 0;
+    if (GRADIENT) {
+      dsTdb(1) = 0;
+      dsTdr(1) = 0;
+    }
 
     // Compute the linear limb darkening term
     // and the elliptic integrals
-    computeS2();
+    computeS2_<T, GRADIENT>(b, r, ksq, kc, kcsq, invksq, third, sT(2),
+                            EllipticE, EllipticEK, dsTdb(2), dsTdr(2),
+                            dEllipticEdm, dEllipticEKdm, ellip);
 
     // The l = 1, m = 1 term, written out explicitly for speed
-    T K11;
+    T K11, dK11db, dK11dr;
     if (ksq >= 1) {
       K11 = pi<T>() * (2 * delta + T(1.0)) / 16.;
+      if (GRADIENT) {
+        dK11db = pi<T>() * ddeltadb / 8.;
+        dK11dr = pi<T>() * ddeltadr / 8.;
+      }
     } else {
       T fac = T(3.0) + 6 * delta;
-      K11 =
-          0.0625 * third *
-          (2.0 * kkc * (2.0 * ksq * (6.0 * delta + 4.0 * ksq - T(1.0)) - fac) +
-           kap0 * fac);
+      T g = 2.0 * ksq * (6.0 * delta + 4.0 * ksq - T(1.0)) - fac;
+      K11 = 0.0625 * third * (2.0 * kkc * g + kap0 * fac);
+      if (GRADIENT) {
+        // Note that dkap0 / dk^2 = 1 / kkc
+        T dK11dksq = 0.0625 * third *
+                     ((T(1.0) - 2.0 * ksq) * g / kkc +
+                      2.0 * kkc * (12.0 * delta + 16.0 * ksq - T(2.0)) +
+                      fac / kkc);
+        T dK11ddelta =
+            0.0625 * third * (2.0 * kkc * (12.0 * ksq - T(6.0)) + 6.0 * kap0);
+        dK11db = dK11dksq * dmdb + dK11ddelta * ddeltadb;
+        dK11dr = dK11dksq * dmdr + dK11ddelta * ddeltadr;
+      }
     }
     sT(3) = -2.0 * third * coslam * coslam * coslam - 2 * tworlp2 * K11;
+    if (GRADIENT) {
+      T fac = 2.0 * coslam * sinlam;
+      dsTdb(3) = fac * dsinlamdb - 2 * tworlp2 * dK11db;
+      dsTdr(3) = fac * dsinlamdr - 2 * tworlp2 * (dK11dr + 3 * K11 * invr);
+    }
 
     // Break if lmax = 1
     if (N == 4) return;
@@ -906,31 +1117,38 @@ class Solver {
     for (int v = 1; v < ivmax + 1; ++v) pow_ksq(v) = pow_ksq(v - 1) * ksq;
 
     // Compute the helper integrals
-    A.reset(delta);
+    A.reset(delta, GRADIENT);
     H.reset(coslam, sinlam);
     if (ksq < 0.5)
       computeIDownward();
     else if (ksq < 1.0)
       computeIUpward();
     // else we use `IGamma`
+    if (GRADIENT && (ksq < 1.0)) computeIDerivative();
 
     if (ksq < 1.0) {
-      if (unlikely(ksq == 0))
+      if (unlikely(ksq == 0)) {
         J = IGamma;
-      else if (ksq < 0.5)
-        computeJDownward<true>();
+        if (GRADIENT) dJ.setZero();
+      } else if (ksq < 0.5)
+        computeJDownward<true, GRADIENT>();
       else
-        computeJUpward<true>();
+        computeJUpward<true, GRADIENT>();
     } else {
       if (ksq > 2.0)
-        computeJDownward<false>();
+        computeJDownward<false, GRADIENT>();
       else
-        computeJUpward<false>();
+        computeJUpward<false, GRADIENT>();
     }
 
     // Some more basic variables
     T Q, P;
     T lfac = pow(1 - bmr * bmr, 1.5);
+    T sqonembmr2 = GRADIENT ? sqrt(1 - bmr * bmr) : T(0.0);
+    T tworlm1 = 1.0;
+    T dlfacdb = 0, dlfacdr = 0, dtworlp2dr = 0;
+    T dQdb, dQdr, dPdb, dPdr;
+    T dL1db, dL1dr, dL2db, dL2dr;
 
     // Compute the other terms of the solution vector
     int n = 4;
@@ -938,6 +1156,12 @@ class Solver {
       // Update the pre-factors
       tworlp2 *= twor;
       lfac *= twor;
+      if (GRADIENT) {
+        tworlm1 *= twor;
+        dtworlp2dr = (l + 2) * tworlp2 * invr;
+        dlfacdb = -3 * bmr * sqonembmr2 * tworlm1;
+        dlfacdr = -dlfacdb + (l - 1) * lfac * invr;
+      }
 
       for (int m = -l; m < l + 1; ++m) {
         int mu = l - m;
@@ -947,35 +1171,87 @@ class Solver {
         // odd powers of x, so we don't need to compute them!
         if ((is_even(mu - 1)) && (!is_even((mu - 1) / 2))) {
           sT(n) = 0;
+          if (GRADIENT) {
+            dsTdb(n) = 0;
+            dsTdr(n) = 0;
+          }
 
           // These terms are also zero for the same reason
         } else if ((is_even(mu)) && (!is_even(mu / 2))) {
           sT(n) = 0;
+          if (GRADIENT) {
+            dsTdb(n) = 0;
+            dsTdr(n) = 0;
+          }
 
           // We need to compute the integral...
         } else {
           // The Q integral
-          if ((qcond) && (!is_even(mu, 2) || !is_even(nu, 2)))
-            Q = 0.0;
-          else if (!is_even(mu, 2))
+          if (((qcond) && (!is_even(mu, 2) || !is_even(nu, 2))) ||
+              (!is_even(mu, 2))) {
             Q = 0.0;
-          else
+            if (GRADIENT) {
+              dQdb = 0.0;
+              dQdr = 0.0;
+            }
+          } else {
             Q = H((mu + 4) / 2, nu / 2);
+            if (GRADIENT) {
+              T dQdsinlam = H.deriv((mu + 4) / 2, nu / 2);
+              dQdb = dQdsinlam * dsinlamdb;
+              dQdr = dQdsinlam * dsinlamdr;
+            }
+          }
 
           // The P integral
-          if (is_even(mu, 2))
-            P = 2 * tworlp2 * K((mu + 4) / 4, nu / 2);
-          else if ((mu == 1) && is_even(l))
-            P = lfac * (L((l - 2) / 2, 0, 0) - 2 * L((l - 2) / 2, 0, 1));
-          else if ((mu == 1) && !is_even(l))
-            P = lfac * (L((l - 3) / 2, 1, 0) - 2 * L((l - 3) / 2, 1, 1));
-          else if (is_even(mu - 1, 2))
-            P = 2 * lfac * L((mu - 1) / 4, (nu - 1) / 2, 0);
-          else
+          if (is_even(mu, 2)) {
+            T K_ = K((mu + 4) / 4, nu / 2);
+            P = 2 * tworlp2 * K_;
+            if (GRADIENT) {
+              dK((mu + 4) / 4, nu / 2, dPdb, dPdr);
+              dPdb *= 2 * tworlp2;
+              dPdr = 2 * (tworlp2 * dPdr + dtworlp2dr * K_);
+            }
+          } else if ((mu == 1) && is_even(l)) {
+            T L_ = L((l - 2) / 2, 0, 0) - 2 * L((l - 2) / 2, 0, 1);
+            P = lfac * L_;
+            if (GRADIENT) {
+              dL((l - 2) / 2, 0, 0, dL1db, dL1dr);
+              dL((l - 2) / 2, 0, 1, dL2db, dL2dr);
+              dPdb = dlfacdb * L_ + lfac * (dL1db - 2 * dL2db);
+              dPdr = dlfacdr * L_ + lfac * (dL1dr - 2 * dL2dr);
+            }
+          } else if ((mu == 1) && !is_even(l)) {
+            T L_ = L((l - 3) / 2, 1, 0) - 2 * L((l - 3) / 2, 1, 1);
+            P = lfac * L_;
+            if (GRADIENT) {
+              dL((l - 3) / 2, 1, 0, dL1db, dL1dr);
+              dL((l - 3) / 2, 1, 1, dL2db, dL2dr);
+              dPdb = dlfacdb * L_ + lfac * (dL1db - 2 * dL2db);
+              dPdr = dlfacdr * L_ + lfac * (dL1dr - 2 * dL2dr);
+            }
+          } else if (is_even(mu - 1, 2)) {
+            T L_ = L((mu - 1) / 4, (nu - 1) / 2, 0);
+            P = 2 * lfac * L_;
+            if (GRADIENT) {
+              dL((mu - 1) / 4, (nu - 1) / 2, 0, dL1db, dL1dr);
+              dPdb = 2 * (dlfacdb * L_ + lfac * dL1db);
+              dPdr = 2 * (dlfacdr * L_ + lfac * dL1dr);
+            }
+          } else {
             P = 0.0;
+            if (GRADIENT) {
+              dPdb = 0.0;
+              dPdr = 0.0;
+            }
+          }
 
           // The term of the solution vector
           sT(n) = Q - P;
+          if (GRADIENT) {
+            dsTdb(n) = dQdb - dPdb;
+            dsTdr(n) = dQdr - dPdr;
+          }
         }
 
         ++n;
@@ -989,35 +1265,30 @@ Greens integral solver wrapper class.
 Emitted light specialization.
 
 */
+template <class Scalar>
+class GreensEmittedTable;
+
 template <class Scalar>
 class GreensEmitted {
  protected:
-  using ADType = ADScalar<Scalar, 2>;
-
   // Indices
   int lmax;
   int N;
 
-  // Solvers
-  Solver<Scalar, false> ScalarSolver;
-  Solver<ADType, true> ADTypeSolver;
-
-  // AutoDiff
-  ADType b_ad;
-  ADType r_ad;
+  // The solver
+  Solver<Scalar> ScalarSolver;
 
  public:
   // Solutions
   RowVector<Scalar> &sT;
-  RowVector<Scalar> dsTdb;
-  RowVector<Scalar> dsTdr;
+  RowVector<Scalar> &dsTdb;
+  RowVector<Scalar> &dsTdr;
 
   // Constructor
   explicit GreensEmitted(int lmax) :
       lmax(lmax), N((lmax + 1) * (lmax + 1)), ScalarSolver(lmax),
-      ADTypeSolver(lmax), b_ad(ADType(0.0, Vector<Scalar>::Unit(2, 0))),
-      r_ad(ADType(0.0, Vector<Scalar>::Unit(2, 1))), sT(ScalarSolver.sT),
-      dsTdb(RowVector<Scalar>::Zero(N)), dsTdr(RowVector<Scalar>::Zero(N)) {}
+      sT(ScalarSolver.sT), dsTdb(ScalarSolver.dsTdb),
+      dsTdr(ScalarSolver.dsTdr) {}
 
   /**
   Compute the `s^T` occultation solution vector
@@ -1025,24 +1296,329 @@ class GreensEmitted {
 
   */
   template <bool GRADIENT = false>
-  inline void compute(const Scalar &b, const Scalar &r) {
-    if (!GRADIENT) {
-      ScalarSolver.compute(b, r);
+  inline void compute(const Scalar &b, const Scalar &r,
+                      const Scalar *ellip = nullptr) {
+    ScalarSolver.template compute<GRADIENT>(b, r, ellip);
+  }
+
+  /**
+  Compute the `s^T` occultation solution vector
+  with or without the gradient by evaluating a pre-computed
+  table. Falls back to the exact solution wherever the table
+  does not apply.
+
+  */
+  template <bool GRADIENT = false>
+  inline void compute(const Scalar &b, const Scalar &r,
+                      const GreensEmittedTable<Scalar> &table) {
+    if (!table.template evaluate<GRADIENT>(b, r, sT, dsTdb, dsTdr))
+      ScalarSolver.template compute<GRADIENT>(b, r);
+  }
+};
+
+/**
+Piecewise Chebyshev representation of the `s^T` occultation
+solution vector and its derivatives as a function of the impact
+parameter `b` at a fixed occultor radius `r`.
+
+The interval `[max(0, r - 1), 1 + r]` is split at the contact
+points and pieces are bisected until every component of `s^T`,
+`ds^T/db` and `ds^T/dr` agrees with the exact solution to within
+`tol` (relative to the magnitude of the component on the piece,
+or absolute if it is smaller than unity). The derivatives diverge
+at the contact points, so the few pieces that still fail after
+`STARRY_SOLVER_TABLE_MAX_DEPTH` bisections are flagged and
+evaluated exactly. The table is read-only once built, so a single
+instance may be shared by any number of solvers.
 
+*/
+template <class Scalar>
+class GreensEmittedTable {
+ protected:
+  static const int order = STARRY_SOLVER_TABLE_ORDER;
+  int N;
+  Scalar tol;
+  Scalar r;
+  bool built;
+
+  // The pieces
+  std::vector<Scalar> lo;
+  std::vector<Scalar> hi;
+  std::vector<bool> exact;
+  std::vector<Matrix<Scalar, RowMajor>> coeffs;
+
+  // Chebyshev nodes and transform
+  Vector<Scalar> nodes;
+  Vector<Scalar> checks;
+  Matrix<Scalar> transform;
+
+  /**
+  Fit a single piece on `[blo, bhi]`. Returns false
+  if the fit does not meet the tolerance.
+
+  */
+  inline bool fit(GreensEmitted<Scalar> &G, const Scalar &blo,
+                  const Scalar &bhi, Matrix<Scalar, RowMajor> &C) {
+    Scalar mid = 0.5 * (bhi + blo);
+    Scalar half = 0.5 * (bhi - blo);
+    Matrix<Scalar, RowMajor> F(order + 1, 3 * N);
+    RowVector<Scalar> f(3 * N), g(3 * N), scale(3 * N);
+    try {
+      for (int j = 0; j < order + 1; ++j) {
+        G.template compute<true>(mid + half * nodes(j), r);
+        F.row(j) << G.sT, G.dsTdb, G.dsTdr;
+      }
+      if (!F.allFinite()) return false;
+      C = transform * F;
+      scale = F.cwiseAbs().colwise().maxCoeff().cwiseMax(Scalar(1.0));
+      for (int j = 0; j < checks.size(); ++j) {
+        G.template compute<true>(mid + half * checks(j), r);
+        f << G.sT, G.dsTdb, G.dsTdr;
+        if (!f.allFinite()) return false;
+        evaluateSeries(C, checks(j), 0, g);
+        if (((f - g).cwiseAbs().array() > tol * scale.array()).any())
+          return false;
+      }
+    } catch (const std::exception &e) {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+  Recursively bisect `[blo, bhi]` until each piece is
+  well approximated by a Chebyshev series.
+
+  */
+  inline void subdivide(GreensEmitted<Scalar> &G, const Scalar &blo,
+                        const Scalar &bhi, int depth) {
+    Matrix<Scalar, RowMajor> C;
+    if (fit(G, blo, bhi, C)) {
+      lo.push_back(blo);
+      hi.push_back(bhi);
+      exact.push_back(false);
+      coeffs.push_back(C);
+    } else if (depth >= STARRY_SOLVER_TABLE_MAX_DEPTH) {
+      lo.push_back(blo);
+      hi.push_back(bhi);
+      exact.push_back(true);
+      coeffs.push_back(Matrix<Scalar, RowMajor>());
     } else {
-      b_ad.value() = b;
-      r_ad.value() = r;
-      ADTypeSolver.compute(b_ad, r_ad);
-      for (int n = 0; n < N; ++n) {
-        sT(n) = ADTypeSolver.sT(n).value();
-        dsTdb(n) = ADTypeSolver.sT(n).derivatives()(0);
-        dsTdr(n) = ADTypeSolver.sT(n).derivatives()(1);
+      Scalar mid = 0.5 * (bhi + blo);
+      subdivide(G, blo, mid, depth + 1);
+      subdivide(G, mid, bhi, depth + 1);
+    }
+  }
+
+  /**
+  Evaluate columns `[col, col + res.size())` of the Chebyshev
+  series with coefficients `C` at `t` in `[-1, 1]`.
+
+  */
+  inline void evaluateSeries(const Matrix<Scalar, RowMajor> &C,
+                             const Scalar &t, int col,
+                             RowVector<Scalar> &res) const {
+    Scalar Tk[order + 1];
+    Tk[0] = 1.0;
+    Tk[1] = t;
+    for (int k = 2; k < order + 1; ++k) Tk[k] = 2 * t * Tk[k - 1] - Tk[k - 2];
+    int n = res.size();
+    res = Tk[0] * C.row(0).segment(col, n);
+    for (int k = 1; k < order + 1; ++k)
+      res += Tk[k] * C.row(k).segment(col, n);
+  }
+
+ public:
+  explicit GreensEmittedTable(int lmax) :
+      N((lmax + 1) * (lmax + 1)), tol(0.0), r(0.0), built(false) {
+    // Chebyshev-Gauss nodes and the matrix taking
+    // the function values there to the coefficients
+    nodes.resize(order + 1);
+    transform.resize(order + 1, order + 1);
+    for (int j = 0; j < order + 1; ++j)
+      nodes(j) = cos(pi<Scalar>() * (j + 0.5) / (order + 1));
+    for (int k = 0; k < order + 1; ++k) {
+      for (int j = 0; j < order + 1; ++j) {
+        transform(k, j) = (k == 0 ? 1.0 : 2.0) *
+                          cos(pi<Scalar>() * k * (j + 0.5) / (order + 1)) /
+                          (order + 1);
       }
     }
+
+    // Points at which we check the fit: halfway (in angle)
+    // between the nodes and between the outermost nodes
+    // and the ends of the piece
+    checks.resize(order + 2);
+    checks(0) = cos(pi<Scalar>() * 0.25 / (order + 1));
+    for (int j = 1; j < order + 1; ++j)
+      checks(j) = cos(pi<Scalar>() * j / (order + 1));
+    checks(order + 1) = -checks(0);
+  }
+
+  /**
+  The tolerance of the table. A value of zero
+  disables the tabulation.
+
+  */
+  inline Scalar getTolerance() const { return tol; }
+
+  inline void setTolerance(const Scalar &tol_) {
+    if (tol_ < 0)
+      throw std::runtime_error("The table tolerance must be non-negative.");
+    if (tol_ != tol) built = false;
+    tol = tol_;
+  }
+
+  /**
+  Number of pieces in the table (zero if not built).
+
+  */
+  inline int size() const { return built ? int(lo.size()) : 0; }
+
+  /**
+  (Re)build the table for occultor radius `r_` using the solver
+  `G` to compute the exact solution. Does nothing if the table
+  is disabled or if it has already been built for this radius.
+
+  */
+  inline void update(GreensEmitted<Scalar> &G, const Scalar &r_) {
+    if ((tol == 0) || (built && (r_ == r))) return;
+    built = false;
+    lo.clear();
+    hi.clear();
+    exact.clear();
+    coeffs.clear();
+    if (r_ <= 0) return;
+    r = r_;
+
+    // Split at the points where the solution is not smooth
+    Scalar blo = max(Scalar(0.0), r - 1);
+    Scalar bhi = 1 + r;
+    Scalar contact = abs(1 - r);
+    std::vector<Scalar> breaks{blo, bhi};
+    if ((contact > blo) && (contact < bhi)) breaks.push_back(contact);
+    if ((r > blo) && (r < bhi)) breaks.push_back(r);
+    std::sort(breaks.begin(), breaks.end());
+    for (size_t i = 0; i < breaks.size() - 1; ++i) {
+      if (breaks[i + 1] > breaks[i])
+        subdivide(G, breaks[i], breaks[i + 1], 0);
+    }
+    built = true;
+  }
+
+  /**
+  Evaluate the table at impact parameter `b` and radius `r_`.
+  Returns false (and leaves the outputs untouched) if the table
+  does not apply, in which case the exact solution is needed.
+
+  */
+  template <bool GRADIENT = false>
+  inline bool evaluate(const Scalar &b, const Scalar &r_,
+                       RowVector<Scalar> &sT, RowVector<Scalar> &dsTdb,
+                       RowVector<Scalar> &dsTdr) const {
+    if (!built || (r_ != r) || (b < lo.front()) || (b > hi.back()))
+      return false;
+    size_t n = std::lower_bound(hi.begin(), hi.end(), b) - hi.begin();
+    if (exact[n]) return false;
+    const Matrix<Scalar, RowMajor> &C = coeffs[n];
+    Scalar t = (2 * b - lo[n] - hi[n]) / (hi[n] - lo[n]);
+    evaluateSeries(C, t, 0, sT);
+    if (GRADIENT) {
+      evaluateSeries(C, t, N, dsTdb);
+      evaluateSeries(C, t, 2 * N, dsTdr);
+    }
+    return true;
   }
 };
 
+/**
+Pre-compute the complete elliptic integrals needed by the
+solver for a batch of impact parameters `b` at radius `r` in
+a single call to the batched `CEL`. On return, column `n` of
+`ellip` holds `Piofk`, `E` and `E - K` for point `n` if
+`needed[n]` is true; otherwise the solver doesn't need them.
+
+*/
+template <class Scalar>
+inline void computeEllipticIntegrals(const Vector<Scalar> &b,
+                                     const Scalar &r, Matrix<Scalar> &ellip,
+                                     std::vector<bool> &needed) {
+  int npts = b.size();
+  ellip.resize(3, npts);
+  needed.assign(npts, false);
+  std::vector<int> idx;
+  std::vector<Scalar> args;
+  idx.reserve(npts);
+  args.reserve(9 * npts);
+  Scalar ksq, k, kc, kcsq, kkc, invksq, kite_area2, kap0, kap1, invb, invr,
+      coslam, sinlam;
+  bool qcond;
+  Scalar args_[9];
+  for (int n = 0; n < npts; ++n) {
+    Scalar b_ = b(n);
+    // Same hack as in `Solver::compute`
+    if (unlikely(abs(b_ - r) < 5 * mach_eps<Scalar>())) {
+      if (unlikely(abs(r - Scalar(0.5)) < 5 * mach_eps<Scalar>())) {
+        b_ += 5 * mach_eps<Scalar>();
+      }
+    }
+    if ((b_ < r - 1) || (r <= 0) || (b_ > r + 1)) continue;
+    computeKVariables(b_, r, ksq, k, kc, kcsq, kkc, invksq, kite_area2, kap0,
+                      kap1, invb, invr, coslam, sinlam, qcond);
+    if (!needsCEL_(b_, r, ksq)) continue;
+    computeS2CELArgs_(b_, r, ksq, kc, kcsq, invksq, args_);
+    idx.push_back(n);
+    args.insert(args.end(), args_, args_ + 9);
+  }
+  int nell = idx.size();
+  if (nell == 0) return;
+  Eigen::Map<Matrix<Scalar, RowMajor>> A(args.data(), nell, 9);
+  Vector<Scalar> Piofk, EllipticE, EllipticEK;
+  ellip::CEL(Vector<Scalar>(A.col(0)), Vector<Scalar>(A.col(1)),
+             Vector<Scalar>(A.col(2)), Vector<Scalar>(A.col(3)),
+             Vector<Scalar>(A.col(4)), Vector<Scalar>(A.col(5)),
+             Vector<Scalar>(A.col(6)), Vector<Scalar>(A.col(7)),
+             Vector<Scalar>(A.col(8)), Piofk, EllipticE, EllipticEK);
+  for (int i = 0; i < nell; ++i) {
+    ellip(0, idx[i]) = Piofk(i);
+    ellip(1, idx[i]) = EllipticE(i);
+    ellip(2, idx[i]) = EllipticEK(i);
+    needed[idx[i]] = true;
+  }
+}
+
+/**
+Compute the `s^T` occultation solution vector for each of the
+impact parameters `b` in turn at radius `r`, interpolating from
+`table` if it has been built and using the batched elliptic
+integrals otherwise. After each point `n`, `func(n)` is called
+so the caller can consume the solution held in `G`.
+
+*/
+template <bool GRADIENT, class Scalar, typename Function>
+inline void computeBatch(GreensEmitted<Scalar> &G,
+                         const GreensEmittedTable<Scalar> &table,
+                         const Vector<Scalar> &b, const Scalar &r,
+                         Function &&func) {
+  int npts = b.size();
+  if (table.size()) {
+    for (int n = 0; n < npts; ++n) {
+      G.template compute<GRADIENT>(b(n), r, table);
+      func(n);
+    }
+    return;
+  }
+  Matrix<Scalar> ellip;
+  std::vector<bool> needed;
+  computeEllipticIntegrals(b, r, ellip, needed);
+  for (int n = 0; n < npts; ++n) {
+    G.template compute<GRADIENT>(b(n), r,
+                                 needed[n] ? &ellip(0, n) : nullptr);
+    func(n);
+  }
+}
+
 }  // namespace solver
 }  // namespace starry
 
-#endif
\ No newline at end of file
+#endif
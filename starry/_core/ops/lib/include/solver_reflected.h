@@ -7,6 +7,7 @@
 #ifndef _STARRY_SOLVER_REFL_H_
 #define _STARRY_SOLVER_REFL_H_
 
+#include <vector>
 #include "ellip.h"
 #include "utils.h"
 
@@ -33,6 +34,16 @@ protected:
   Matrix<Scalar> K;
   Scalar tol;
 
+  // Index map for the parity split in `(mu, nu)`
+  std::vector<int> odd;
+  std::vector<int> jidx;
+  Vector<Scalar> alpha;
+  Vector<Scalar> beta;
+  Vector<Scalar> gamma;
+
+  // Number of points processed together in the batched calls
+  static const int BLOCK = 64;
+
   /**
   Computes the matrices
 
@@ -68,6 +79,45 @@ protected:
     }
   }
 
+  /**
+  Computes the index map for the parity split in `(mu, nu)`. Every
+  term of `rT` is of the form
+
+      alpha * fac * X(j + 1) - bterm * (beta * Y(j) + gamma * Y(j + 2))
+
+  where `fac = sqrt(1 - bterm^2)`, and `X = H`, `Y = I` if `nu` is even
+  and `X = I`, `Y = H` if it is odd.
+
+  */
+  inline void computeIndices() {
+    int n = 0;
+    int i, j;
+    int mu, nu;
+    for (int l = 0; l < lmax + 1; ++l) {
+      for (int m = -l; m < l + 1; ++m) {
+        mu = l - m;
+        nu = l + m;
+        if (is_even(nu)) {
+          i = mu / 2;
+          j = nu / 2;
+          odd[n] = 0;
+          alpha(n) = J(i, j + 1);
+          beta(n) = K(i, j);
+          gamma(n) = 0;
+        } else {
+          i = (mu - 1) / 2;
+          j = (nu - 1) / 2;
+          odd[n] = 1;
+          alpha(n) = K(i, j + 1);
+          beta(n) = J(i, j) - J(i + 2, j);
+          gamma(n) = -J(i, j + 2);
+        }
+        jidx[n] = j;
+        ++n;
+      }
+    }
+  }
+
   /*
   Computes the arrays
 
@@ -211,12 +261,610 @@ public:
     return bb;
   }
 
+  /**
+  Computes the complete reflectance integrals for a batch of
+  terminator values `bterm`, writing one row of `rT` per point.
+
+  The points are processed in blocks, and the `H` and `I` recurrences
+  are evaluated for all points in a block at once, so the inner loops
+  run over points and vectorize.
+
+  */
+  template <typename T1, typename T2>
+  inline void compute(const Eigen::MatrixBase<T1> &bterm,
+                      Eigen::MatrixBase<T2> const &rT_) const {
+    Eigen::MatrixBase<T2> &rT_out = const_cast<Eigen::MatrixBase<T2> &>(rT_);
+    using Array = Eigen::Array<Scalar, Eigen::Dynamic, 1>;
+    using Array2 = Eigen::Array<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    const int npts = bterm.size();
+    Array b, q, fac, fac1, fac2;
+    Array2 H, I, FX, BY;
+    Matrix<Scalar> out;
+    for (int p0 = 0; p0 < npts; p0 += BLOCK) {
+      int P = (npts - p0 < BLOCK) ? npts - p0 : BLOCK;
+      b = bterm.segment(p0, P).template cast<Scalar>().array();
+      q = Scalar(1.0) - b * b;
+      fac = q.unaryExpr([](const Scalar &x) { return sqrt(x); });
+
+      // The `H` and `I` recurrences
+      H.resize(P, lmax + 3);
+      I.resize(P, lmax + 3);
+      fac1 = q * fac;
+      I.col(0) = b.unaryExpr([](const Scalar &x) { return acos(x); });
+      I.col(0) = Scalar(0.5) * (I.col(0) - b * fac);
+      I.col(1) = fac1 / Scalar(3.0);
+      fac2 = b;
+      H.col(0) = Scalar(0.5) * (Scalar(1.0) - fac2);
+      fac2 *= b;
+      H.col(1) = Scalar(0.5) * (Scalar(1.0) - fac2);
+      fac1 *= b;
+      fac2 *= b;
+      for (int j = 0; j < lmax + 1; ++j) {
+        I.col(j + 2) = (fac1 + Scalar(j + 1.0) * I.col(j)) / Scalar(j + 4.0);
+        H.col(j + 2) = Scalar(0.5) * (Scalar(1.0) - fac2);
+        fac1 *= b;
+        fac2 *= b;
+      }
+
+      // Assemble `rT` from the index map
+      out.resize(P, N);
+      for (int parity = 0; parity < 2; ++parity) {
+        const Array2 &X = parity ? I : H;
+        const Array2 &Y = parity ? H : I;
+        FX = X.colwise() * fac;
+        BY = Y.colwise() * b;
+        for (int n = 0; n < N; ++n) {
+          if (odd[n] != parity)
+            continue;
+          int j = jidx[n];
+          if (parity)
+            out.col(n) = alpha(n) * FX.col(j + 1) - beta(n) * BY.col(j) -
+                         gamma(n) * BY.col(j + 2);
+          else
+            out.col(n) = alpha(n) * FX.col(j + 1) - beta(n) * BY.col(j);
+        }
+      }
+      rT_out.middleRows(p0, P) = out.template cast<typename T2::Scalar>();
+    }
+  }
+
+  /**
+  Computes the (backprop) gradient of the batched complete reflectance
+  integrals, given the gradient `brT` with respect to `rT` (one row
+  per point). The values and derivatives of the `H` and `I` terms are
+  computed in the same pass over each block of points.
+
+  */
+  template <typename T1, typename T2, typename T3>
+  inline void compute(const Eigen::MatrixBase<T1> &bterm,
+                      const Eigen::MatrixBase<T2> &brT,
+                      Eigen::MatrixBase<T3> const &bb_) const {
+    Eigen::MatrixBase<T3> &bb_out = const_cast<Eigen::MatrixBase<T3> &>(bb_);
+    using Array = Eigen::Array<Scalar, Eigen::Dynamic, 1>;
+    using Array2 = Eigen::Array<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    const int npts = bterm.size();
+    Array b, q, fac0, fac, DfacDb, fac1, Dfac1Db, fac2, Dfac2Db, bb;
+    Array2 H, I, DHDb, DIDb, DFX, DBY;
+    Matrix<Scalar> brTb;
+    for (int p0 = 0; p0 < npts; p0 += BLOCK) {
+      int P = (npts - p0 < BLOCK) ? npts - p0 : BLOCK;
+      b = bterm.segment(p0, P).template cast<Scalar>().array();
+      q = Scalar(1.0) - b * b;
+      fac0 = q.unaryExpr([](const Scalar &x) { return sqrt(x); });
+      // TODO: The gradient is infinite when bterm = +/- 1
+      fac = q.unaryExpr([this](const Scalar &x) { return sqrt(max(x, tol)); });
+      DfacDb = -b / fac;
+
+      // The `H` and `I` recurrences and their derivatives
+      H.resize(P, lmax + 3);
+      I.resize(P, lmax + 3);
+      DHDb.resize(P, lmax + 3);
+      DIDb.resize(P, lmax + 3);
+      fac1 = q * fac0;
+      Dfac1Db = Scalar(-3.0) * b * fac0;
+      I.col(0) = b.unaryExpr([](const Scalar &x) { return acos(x); });
+      I.col(0) = Scalar(0.5) * (I.col(0) - b * fac0);
+      DIDb.col(0) = -fac0;
+      I.col(1) = fac1 / Scalar(3.0);
+      DIDb.col(1) = Dfac1Db / Scalar(3.0);
+      fac2 = b;
+      Dfac2Db.setOnes(P);
+      H.col(0) = Scalar(0.5) * (Scalar(1.0) - fac2);
+      DHDb.col(0) = Scalar(-0.5) * Dfac2Db;
+      Dfac2Db = fac2 + Dfac2Db * b;
+      fac2 *= b;
+      H.col(1) = Scalar(0.5) * (Scalar(1.0) - fac2);
+      DHDb.col(1) = Scalar(-0.5) * Dfac2Db;
+      Dfac1Db = fac1 + Dfac1Db * b;
+      fac1 *= b;
+      Dfac2Db = fac2 + Dfac2Db * b;
+      fac2 *= b;
+      for (int j = 0; j < lmax + 1; ++j) {
+        I.col(j + 2) = (fac1 + Scalar(j + 1.0) * I.col(j)) / Scalar(j + 4.0);
+        DIDb.col(j + 2) =
+            (Dfac1Db + Scalar(j + 1.0) * DIDb.col(j)) / Scalar(j + 4.0);
+        H.col(j + 2) = Scalar(0.5) * (Scalar(1.0) - fac2);
+        DHDb.col(j + 2) = Scalar(-0.5) * Dfac2Db;
+        Dfac1Db = fac1 + Dfac1Db * b;
+        fac1 *= b;
+        Dfac2Db = fac2 + Dfac2Db * b;
+        fac2 *= b;
+      }
+
+      // Contract the derivative of `rT` with `brT`
+      brTb = brT.middleRows(p0, P).template cast<Scalar>();
+      bb.setZero(P);
+      for (int parity = 0; parity < 2; ++parity) {
+        const Array2 &X = parity ? I : H;
+        const Array2 &Y = parity ? H : I;
+        const Array2 &DXDb = parity ? DIDb : DHDb;
+        const Array2 &DYDb = parity ? DHDb : DIDb;
+        DFX = X.colwise() * DfacDb + DXDb.colwise() * fac;
+        DBY = Y + DYDb.colwise() * b;
+        for (int n = 0; n < N; ++n) {
+          if (odd[n] != parity)
+            continue;
+          int j = jidx[n];
+          if (parity)
+            bb += brTb.col(n).array() *
+                  (alpha(n) * DFX.col(j + 1) - beta(n) * DBY.col(j) -
+                   gamma(n) * DBY.col(j + 2));
+          else
+            bb += brTb.col(n).array() *
+                  (alpha(n) * DFX.col(j + 1) - beta(n) * DBY.col(j));
+        }
+      }
+      bb_out.segment(p0, P) = bb.template cast<typename T3::Scalar>();
+    }
+  }
+
   explicit GreensReflected(int lmax)
       : lmax(lmax), N((lmax + 1) * (lmax + 1)), H(lmax + 3), I(lmax + 3),
         DHDb(lmax + 3), DIDb(lmax + 3), J(lmax + 3, lmax + 3),
-        K(lmax + 3, lmax + 3), tol(sqrt(mach_eps<Scalar>())), rT(N) {
-    // Pre-compute the J and K matrices
+        K(lmax + 3, lmax + 3), tol(sqrt(mach_eps<Scalar>())), odd(N),
+        jidx(N), alpha(N), beta(N), gamma(N), rT(N) {
+    // Pre-compute the J and K matrices and the index map
     computeJK();
+    computeIndices();
+  }
+};
+
+/**
+Occultation solver in reflected light. Computes the integrals `oT`
+of the illuminated polynomial basis over the part of the day side
+that is covered by an occultor of radius `ro` centered at `(xo, yo)`,
+in the frame of `GreensReflected` (the source lies along `+y`, so the
+terminator is the half-ellipse `y = bterm * sqrt(1 - x^2)`). The
+visible flux is `rT - oT`.
+
+The occulted region is bounded by arcs of the limb, the terminator
+and the occultor. By Green's theorem, the integral of `f` over it is
+the line integral of
+
+    G(x, y) = (-y, x) int_0^1 f(t x, t y) t dt
+
+along these arcs, which we evaluate with Gauss-Legendre quadrature.
+The integrand has a square root singularity wherever an occultor arc
+meets the limb (and is nearly singular where it meets the terminator
+close to the limb), so along the occultor we change variables to one
+whose derivative vanishes at both endpoints.
+
+*/
+template <class Scalar> class OccultedReflected {
+
+protected:
+  // A piece of the boundary of the occulted region
+  struct Arc {
+    int curve;         // 0 = limb, 1 = terminator, 2 = occultor
+    Scalar phi0, phi1; // Angular limits (`phi0 < phi1`)
+    Scalar sign;       // Orientation along the boundary
+  };
+
+  const int lmax;
+  const int N;
+  const int L;
+  const int nquad;
+  Scalar tol;
+  Vector<Scalar> tq;      // Gauss-Legendre nodes on [0, 1]
+  Vector<Scalar> wq;      // Gauss-Legendre weights on [0, 1]
+  Vector<Scalar> series;  // Taylor coefficients of `sqrt(1 - x)`
+  Vector<Scalar> M;
+  Vector<Scalar> xp;
+  Vector<Scalar> yp;
+  Matrix<Scalar> m0;      // Integrals of `x^i y^j`
+  Matrix<Scalar> m1;      // Integrals of `x^i y^j z`
+  std::vector<Arc> arcs;
+  Scalar b, c, xo, yo, ro;
+
+  /**
+  Computes the Gauss-Legendre nodes and weights on [0, 1].
+
+  */
+  inline void computeQuadrature() {
+    for (int i = 0; i < nquad; ++i) {
+      Scalar x = cos(pi<Scalar>() * (i + 0.75) / (nquad + 0.5));
+      Scalar p0, p1, dp;
+      for (int iter = 0; iter < 100; ++iter) {
+        p0 = 1.0;
+        p1 = x;
+        for (int n = 2; n <= nquad; ++n) {
+          Scalar p2 = ((2 * n - 1) * x * p1 - (n - 1) * p0) / Scalar(n);
+          p0 = p1;
+          p1 = p2;
+        }
+        dp = nquad * (x * p1 - p0) / (x * x - 1);
+        Scalar dx = p1 / dp;
+        x -= dx;
+        if (abs(dx) < mach_eps<Scalar>())
+          break;
+      }
+      tq(i) = 0.5 * (1 - x);
+      wq(i) = 1.0 / ((1 - x * x) * dp * dp);
+    }
+  }
+
+  /*
+  Computes the radial primitives
+
+      M(m) = int_0^1 t^m (1 - s t^2)^(1/2) dt
+
+  for `m = 0 ... L`, where `s = x^2 + y^2` and `z0 = (1 - s)^(1/2)`.
+  Near the origin we start from the series at the two highest orders
+  and recurse downward; elsewhere the upward recursion is stable.
+
+  */
+  inline void computeM(const Scalar &s, const Scalar &z0) {
+    Scalar z3 = z0 * z0 * z0;
+    if (s < 0.5) {
+      for (int m = L; (m >= L - 1) && (m >= 0); --m) {
+        Scalar sk = 1.0, term, tot = 0.0;
+        for (int k = 0; k < series.size(); ++k) {
+          term = series(k) * sk / (m + 2 * k + 1);
+          tot += term;
+          if (abs(term) < mach_eps<Scalar>() * abs(tot))
+            break;
+          sk *= s;
+        }
+        M(m) = tot;
+      }
+      for (int m = L; m > 1; --m)
+        M(m - 2) = ((m + 2) * s * M(m) + z3) / (m - 1);
+    } else {
+      Scalar sqrts = sqrt(s);
+      M(0) = 0.5 * (z0 + atan2(sqrts, z0) / sqrts);
+      if (L > 0)
+        M(1) = (1 - z3) / (3 * s);
+      for (int m = 2; m < L + 1; ++m)
+        M(m) = ((m - 1) * M(m - 2) - z3) / ((m + 2) * s);
+    }
+  }
+
+  /**
+  Returns the angles `phi` in [0, pi] at which the terminator point
+  `(cos(phi), b sin(phi))` lies on the occultor boundary. Squaring the
+  condition gives a quartic in `x = cos(phi)`, whose roots we locate
+  with a companion matrix and polish on the original equation.
+
+  */
+  inline std::vector<Scalar> terminatorRoots() const {
+    std::vector<Scalar> roots;
+    Scalar A = 1 - b * b;
+    Scalar B = -2 * xo;
+    Scalar C = xo * xo + yo * yo - ro * ro + b * b;
+    Scalar D = 4 * b * b * yo * yo;
+    double coeffs[5] = {
+        static_cast<double>(C * C - D), static_cast<double>(2 * B * C),
+        static_cast<double>(B * B + 2 * A * C + D),
+        static_cast<double>(2 * A * B), static_cast<double>(A * A)};
+    double cmax = 0.0;
+    for (int k = 0; k < 5; ++k)
+      cmax = std::max(cmax, std::abs(coeffs[k]));
+    if (cmax == 0.0)
+      return roots;
+    int deg = 4;
+    while ((deg > 0) && (std::abs(coeffs[deg]) < 1e-15 * cmax))
+      --deg;
+    if (deg == 0)
+      return roots;
+    Eigen::MatrixXd companion = Eigen::MatrixXd::Zero(deg, deg);
+    for (int k = 0; k < deg; ++k)
+      companion(0, k) = -coeffs[deg - 1 - k] / coeffs[deg];
+    for (int k = 1; k < deg; ++k)
+      companion(k, k - 1) = 1.0;
+    Eigen::EigenSolver<Eigen::MatrixXd> solver(companion, false);
+    auto eigs = solver.eigenvalues();
+    for (int k = 0; k < deg; ++k) {
+      double x = eigs(k).real();
+      if ((std::abs(eigs(k).imag()) > 1e-4) || (x < -1.0 - 1e-4) ||
+          (x > 1.0 + 1e-4))
+        continue;
+      x = std::max(-1.0, std::min(1.0, x));
+
+      // Polish on `g(phi) = |terminator point - occultor center|^2 - ro^2`
+      Scalar phi = acos(Scalar(x)), g, dg, dphi;
+      for (int iter = 0; iter < 50; ++iter) {
+        Scalar cp = cos(phi), sp = sin(phi);
+        g = (cp - xo) * (cp - xo) + (b * sp - yo) * (b * sp - yo) - ro * ro;
+        dg = -2 * (cp - xo) * sp + 2 * (b * sp - yo) * b * cp;
+        if (dg == 0)
+          break;
+        dphi = g / dg;
+        phi -= dphi;
+        if (abs(dphi) < 10 * mach_eps<Scalar>())
+          break;
+      }
+      if ((phi < 0) || (phi > pi<Scalar>()))
+        continue;
+      Scalar cp = cos(phi), sp = sin(phi);
+      g = (cp - xo) * (cp - xo) + (b * sp - yo) * (b * sp - yo) - ro * ro;
+      if (abs(g) > tol)
+        continue;
+      bool duplicate = false;
+      for (auto &r : roots)
+        if (abs(r - phi) < tol)
+          duplicate = true;
+      if (!duplicate)
+        roots.push_back(phi);
+    }
+    return roots;
+  }
+
+  /**
+  Splits the curve `curve` at the angles `breaks` and keeps the
+  pieces that bound the occulted part of the day side.
+
+  */
+  inline void addArcs(int curve, std::vector<Scalar> &breaks, bool closed) {
+    std::sort(breaks.begin(), breaks.end());
+    if (closed) {
+      if (breaks.empty())
+        breaks.push_back(0.0);
+      breaks.push_back(breaks[0] + 2 * pi<Scalar>());
+    }
+    int nb = breaks.size();
+    for (int k = 0; k < nb - 1; ++k) {
+      Arc arc;
+      arc.curve = curve;
+      arc.phi0 = breaks[k];
+      arc.phi1 = breaks[k + 1];
+      if (arc.phi1 - arc.phi0 < 10 * mach_eps<Scalar>())
+        continue;
+
+      // Is the midpoint on the boundary of the occulted day side?
+      Scalar phi = 0.5 * (arc.phi0 + arc.phi1), x, y;
+      bool keep;
+      if (curve == 0) {
+        x = cos(phi);
+        y = sin(phi);
+        keep = inOccultor(x, y) && onDaySide(x, y);
+        arc.sign = 1.0;
+      } else if (curve == 1) {
+        x = cos(phi);
+        y = b * sin(phi);
+        keep = inOccultor(x, y);
+        arc.sign = -1.0;
+      } else {
+        x = xo + ro * cos(phi);
+        y = yo + ro * sin(phi);
+        keep = (x * x + y * y <= 1) && onDaySide(x, y);
+        arc.sign = 1.0;
+      }
+      if (keep)
+        arcs.push_back(arc);
+    }
+  }
+
+  inline bool inOccultor(const Scalar &x, const Scalar &y) const {
+    return (x - xo) * (x - xo) + (y - yo) * (y - yo) <= ro * ro;
+  }
+
+  inline bool onDaySide(const Scalar &x, const Scalar &y) const {
+    Scalar z2 = 1 - x * x - y * y;
+    Scalar z = z2 > 0 ? sqrt(z2) : Scalar(0.0);
+    return c * y - b * z >= 0;
+  }
+
+  /**
+  Computes the boundary of the occulted part of the day side.
+
+  */
+  inline void computeArcs() {
+    arcs.clear();
+    std::vector<Scalar> limb, term, occ;
+    Scalar bo = sqrt(xo * xo + yo * yo);
+
+    // Occultor-limb intersections
+    if ((bo > abs(1 - ro)) && (bo < 1 + ro)) {
+      Scalar theta = atan2(yo, xo);
+      Scalar arg = (1 + bo * bo - ro * ro) / (2 * bo);
+      Scalar dphi = acos(max(Scalar(-1.0), arg < 1 ? arg : Scalar(1.0)));
+      for (int sgn = -1; sgn < 2; sgn += 2) {
+        Scalar phi = theta + sgn * dphi;
+        Scalar x = cos(phi), y = sin(phi);
+        limb.push_back(wrap(phi));
+        occ.push_back(wrap(atan2(y - yo, x - xo)));
+      }
+    }
+
+    // Terminator intersections with the limb and the occultor
+    if (b > -1) {
+      limb.push_back(0.0);
+      limb.push_back(pi<Scalar>());
+      term.push_back(0.0);
+      term.push_back(pi<Scalar>());
+      for (auto &phi : terminatorRoots()) {
+        Scalar x = cos(phi), y = b * sin(phi);
+        term.push_back(phi);
+        occ.push_back(wrap(atan2(y - yo, x - xo)));
+      }
+      addArcs(1, term, false);
+    }
+    addArcs(0, limb, true);
+    addArcs(2, occ, true);
+  }
+
+  inline Scalar wrap(const Scalar &phi) const {
+    return phi < 0 ? phi + 2 * pi<Scalar>() : phi;
+  }
+
+  /**
+  Adds the contribution of a boundary point `(x, y)` with line
+  element `W = x dy - y dx` to the monomial integrals.
+
+  */
+  inline void accumulate(const Scalar &x, const Scalar &y, const Scalar &z0,
+                         const Scalar &W) {
+    computeM(x * x + y * y, z0);
+    xp(0) = 1.0;
+    yp(0) = 1.0;
+    for (int i = 1; i < L + 1; ++i) {
+      xp(i) = xp(i - 1) * x;
+      yp(i) = yp(i - 1) * y;
+    }
+    for (int d = 0; d < L + 1; ++d) {
+      Scalar W0 = W / (d + 2);
+      Scalar W1 = d < L ? W * M(d + 1) : Scalar(0.0);
+      for (int i = 0; i < d + 1; ++i) {
+        Scalar xy = xp(i) * yp(d - i);
+        m0(i, d - i) += W0 * xy;
+        if (d < L)
+          m1(i, d - i) += W1 * xy;
+      }
+    }
+  }
+
+public:
+  RowVector<Scalar> oT;
+  RowVector<Scalar> doTdb;
+  RowVector<Scalar> doTdxo;
+  RowVector<Scalar> doTdyo;
+  RowVector<Scalar> doTdro;
+
+  /**
+  Computes the integrals over the occulted part of the day side and,
+  if `GRADIENT`, their derivatives with respect to `bterm`, `xo`, `yo`
+  and `ro`.
+
+  Since the illumination vanishes on the terminator, only the motion
+  of the occultor boundary contributes to the derivatives with respect
+  to the occultor parameters, and the derivative with respect to
+  `bterm` is the integral of the derivative of the illumination.
+
+  */
+  template <bool GRADIENT = false>
+  inline void compute(const Scalar &bterm, const Scalar &xo_,
+                      const Scalar &yo_, const Scalar &ro_) {
+    oT.setZero();
+    if (GRADIENT) {
+      doTdb.setZero();
+      doTdxo.setZero();
+      doTdyo.setZero();
+      doTdro.setZero();
+    }
+    b = bterm < -1 ? Scalar(-1.0) : bterm;
+    xo = xo_;
+    yo = yo_;
+    ro = abs(ro_);
+    if ((b >= 1) || (ro == 0) || (xo * xo + yo * yo >= (1 + ro) * (1 + ro)))
+      return;
+    c = sqrt(1 - b * b);
+
+    // Integrate along the boundary of the occulted day side
+    computeArcs();
+    m0.setZero();
+    m1.setZero();
+    Vector<Scalar> P(GRADIENT ? N : 0);
+    for (auto &arc : arcs) {
+      Scalar D = arc.phi1 - arc.phi0;
+      for (int k = 0; k < nquad; ++k) {
+        Scalar tau = tq(k), g, dg;
+        if (arc.curve == 2) {
+          g = tau * tau * (3 - 2 * tau);
+          dg = 6 * tau * (1 - tau);
+        } else {
+          g = tau;
+          dg = 1.0;
+        }
+        Scalar phi = arc.phi0 + D * g;
+        Scalar wk = wq(k) * D * dg;
+        Scalar cp = cos(phi), sp = sin(phi);
+        Scalar x, y, z0, W;
+        if (arc.curve == 0) {
+          x = cp;
+          y = sp;
+          z0 = 0.0;
+          W = 1.0;
+        } else if (arc.curve == 1) {
+          x = cp;
+          y = b * sp;
+          z0 = c * sp;
+          W = b;
+        } else {
+          x = xo + ro * cp;
+          y = yo + ro * sp;
+          Scalar z2 = 1 - x * x - y * y;
+          z0 = z2 > 0 ? sqrt(z2) : Scalar(0.0);
+          W = ro * (ro + xo * cp + yo * sp);
+        }
+        accumulate(x, y, z0, arc.sign * wk * W);
+
+        // Motion of the occultor boundary
+        if (GRADIENT && (arc.curve == 2)) {
+          Scalar illum = c * y - b * z0;
+          int n = 0;
+          for (int l = 0; l < lmax + 1; ++l) {
+            for (int m = -l; m < l + 1; ++m) {
+              int mu = l - m, nu = l + m;
+              if (is_even(nu))
+                P(n) = xp(mu / 2) * yp(nu / 2);
+              else
+                P(n) = xp((mu - 1) / 2) * yp((nu - 1) / 2) * z0;
+              ++n;
+            }
+          }
+          P *= illum * wk * ro;
+          doTdxo += cp * P.transpose();
+          doTdyo += sp * P.transpose();
+          doTdro += P.transpose();
+        }
+      }
+    }
+
+    // Multiply by the illumination `c y - b z`
+    Scalar DcDb = -b / sqrt(max(1 - b * b, tol));
+    int n = 0;
+    for (int l = 0; l < lmax + 1; ++l) {
+      for (int m = -l; m < l + 1; ++m) {
+        int mu = l - m, nu = l + m;
+        Scalar Y, Z;
+        if (is_even(nu)) {
+          int i = mu / 2, j = nu / 2;
+          Y = m0(i, j + 1);
+          Z = m1(i, j);
+        } else {
+          int i = (mu - 1) / 2, j = (nu - 1) / 2;
+          Y = m1(i, j + 1);
+          Z = m0(i, j) - m0(i + 2, j) - m0(i, j + 2);
+        }
+        oT(n) = c * Y - b * Z;
+        if (GRADIENT)
+          doTdb(n) = DcDb * Y - Z;
+        ++n;
+      }
+    }
+  }
+
+  explicit OccultedReflected(int lmax)
+      : lmax(lmax), N((lmax + 1) * (lmax + 1)), L(lmax + 1),
+        nquad(STARRY_REFL_QUAD_POINTS), tol(sqrt(mach_eps<Scalar>())),
+        tq(nquad), wq(nquad), series(int(3.4 * STARRY_NDIGITS) + 8),
+        M(lmax + 2), xp(lmax + 2), yp(lmax + 2), m0(lmax + 3, lmax + 3),
+        m1(lmax + 3, lmax + 3), oT(N), doTdb(N), doTdxo(N), doTdyo(N),
+        doTdro(N) {
+    computeQuadrature();
+    series(0) = 1.0;
+    for (int k = 1; k < series.size(); ++k)
+      series(k) = series(k - 1) * (k - 1.5) / k;
   }
 };
 
@@ -18,7 +18,7 @@
 namespace starry {
 namespace sturm {
 
-#define POLYTOL 1e-10
+#define POLYTOL STARRY_STURM_TOL
 
 template <typename T>
 inline T polyval(const Eigen::Matrix<T, Eigen::Dynamic, 1>& p, const double x) {
@@ -162,6 +162,122 @@ inline int polycountroots(const Eigen::Matrix<T, Eigen::Dynamic, 1>& p,
   return count;
 }
 
+/**
+Evaluate the polynomial `p` of length `n + 1` (highest order first) at `x`.
+
+*/
+template <typename T>
+inline T polyval(const T* p, int n, const double x) {
+  T result = T(0.0);
+  for (int i = 0; i < n + 1; ++i) result = result * x + p[i];
+  return result;
+}
+
+/**
+Count the roots of a polynomial of degree `n <= N` over the domain `[a, b]`.
+
+This is the same algorithm (and the same arithmetic) as `polycountroots`
+above, but the entire Sturm sequence lives in three fixed-size buffers
+on the stack, so no memory is allocated. Each step overwrites the older
+of the two previous polynomials with (minus) the remainder of their
+division, trimmed of leading coefficients below `POLYTOL`.
+
+*/
+template <int N, typename T>
+inline int polycountrootsFixed(const T* p, int n, const T& a, const T& b) {
+  if (n < 1) return 0;
+  T buf0[N + 1], buf1[N + 1], buf2[N + 1];
+  T *p0 = buf0, *p1 = buf1, *r = buf2;
+  int n0 = n, n1 = n - 1, count = 0;
+  using std::abs;
+
+  // Copy & apply the stability hacks
+  for (int i = 0; i < n + 1; ++i) p0[i] = p[i];
+  if (p0[n] == 0) p0[n] = -utils::mach_eps<T>();
+  if ((n > 1) && (p0[n - 1] == 0)) p0[n - 1] = utils::mach_eps<T>();
+
+  // The derivative
+  for (int i = 0; i < n; ++i) p1[i] = p0[i] * (n - i);
+
+  // Initial signs
+  int s_0 = sgn(polyval(p1, n1, a));
+  int s_1 = sgn(polyval(p1, n1, b));
+  int s;
+  count += (sgn(polyval(p0, n0, a)) != s_0);
+  count -= (sgn(polyval(p0, n0, b)) != s_1);
+
+  // Loop over the Sturm sequence
+  for (int k = 0; k < n; ++k) {
+    // Remainder of p0 / p1
+    T d, scale = T(1.0) / p1[0];
+    for (int i = 0; i < n0 + 1; ++i) r[i] = p0[i];
+    for (int j = 0; j < n0 - n1 + 1; ++j) {
+      d = scale * r[j];
+      for (int i = 0; i < n1 + 1; ++i) r[j + i] -= d * p1[i];
+    }
+    int strt;
+    for (strt = 0; strt < n0; ++strt) {
+      if (abs(r[strt]) >= T(POLYTOL)) break;
+    }
+    int nr = n0 - strt;
+    for (int i = 0; i < nr + 1; ++i) r[i] = -r[strt + i];
+
+    // Shift the sequence
+    T* tmp = p0;
+    p0 = p1;
+    n0 = n1;
+    p1 = r;
+    n1 = nr;
+    r = tmp;
+
+    // Count the roots for this next polynomial
+    s = s_0;
+    s_0 = sgn(polyval(p1, n1, a));
+    count += (s != s_0);
+    s = s_1;
+    s_1 = sgn(polyval(p1, n1, b));
+    count -= (s != s_1);
+
+    if (n1 == 0) break;
+  }
+  return count;
+}
+
+/**
+Count the roots over the domain `[a, b]` of each of the polynomials in the
+rows of `P` (highest order first), writing the result to `count`. All rows
+are processed with `polycountrootsFixed` for the smallest supported storage
+size; degrees above `32` fall back to `polycountroots`.
+
+*/
+template <typename T>
+inline void polycountroots(
+    const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>& P,
+    const T& a, const T& b, Eigen::VectorXi& count,
+    int nthreads = STARRY_NTHREADS) {
+  size_t npts = P.rows();
+  int n = P.cols() - 1;
+  count.setZero(npts);
+  if (n < 1) return;
+  int nt = utils::getNumThreads(npts, nthreads);
+  utils::parallelFor(npts, nt, [&](int, size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      const T* p = P.data() + i * P.cols();
+      if (n <= 4)
+        count(i) = polycountrootsFixed<4>(p, n, a, b);
+      else if (n <= 8)
+        count(i) = polycountrootsFixed<8>(p, n, a, b);
+      else if (n <= 16)
+        count(i) = polycountrootsFixed<16>(p, n, a, b);
+      else if (n <= 32)
+        count(i) = polycountrootsFixed<32>(p, n, a, b);
+      else
+        count(i) = polycountroots(
+            Eigen::Matrix<T, Eigen::Dynamic, 1>(P.row(i).transpose()), a, b);
+    }
+  });
+}
+
 }  // namespace sturm
 }  // namespace starry
 
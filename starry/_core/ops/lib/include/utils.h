@@ -11,11 +11,16 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 #include <Eigen/SparseLU>
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <stdlib.h>
+#include <thread>
 #include <unsupported/Eigen/AutoDiff>
 #include <vector>
 
@@ -68,11 +73,36 @@ typedef void Multi;
 #define STARRY_BCUT 1.0e-3
 #endif
 
+//! Max iterations in the Kepler solver
+#ifndef STARRY_KEPLER_MAX_ITER
+#define STARRY_KEPLER_MAX_ITER 20
+#endif
+
+//! Remainders in the Sturm sequence are trimmed below this tolerance
+#ifndef STARRY_STURM_TOL
+#define STARRY_STURM_TOL 1e-10
+#endif
+
+//! Gauss-Legendre points per boundary arc in reflected light occultations
+#ifndef STARRY_REFL_QUAD_POINTS
+#define STARRY_REFL_QUAD_POINTS 32
+#endif
+
 //! Things currently go numerically unstable in our bases for high `l`
 #ifndef STARRY_MAX_LMAX
 #define STARRY_MAX_LMAX 50
 #endif
 
+//! Number of threads in batched computations (0 = one per core)
+#ifndef STARRY_NTHREADS
+#define STARRY_NTHREADS 0
+#endif
+
+//! Don't spawn a thread for fewer than this many points
+#ifndef STARRY_MIN_PTS_PER_THREAD
+#define STARRY_MIN_PTS_PER_THREAD 64
+#endif
+
 //! The value of `pi` in double precision
 #ifndef M_PI
 #define M_PI 3.14159265358979323846264338328
@@ -209,6 +239,69 @@ inline bool is_even(int n, int ntimes = 1) {
   return true;
 }
 
+// --------------------------
+// ------- Threading --------
+// --------------------------
+
+/**
+Return the number of threads we should use to process
+`npts` points, given a requested number of threads
+`nthreads` (zero or negative means one per core).
+
+*/
+inline int getNumThreads(size_t npts, int nthreads = STARRY_NTHREADS) {
+  if (nthreads <= 0) {
+    nthreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (nthreads <= 0)
+      nthreads = 1;
+  }
+  size_t nmax = npts / STARRY_MIN_PTS_PER_THREAD;
+  if (nmax < 1)
+    nmax = 1;
+  if (size_t(nthreads) > nmax)
+    nthreads = static_cast<int>(nmax);
+  return nthreads;
+}
+
+/**
+Split the range `[0, npts)` into `nthreads` contiguous chunks and
+call `func(thread, start, end)` on each chunk in its own thread.
+The calling thread handles the first chunk. Any exception thrown
+by a worker is re-thrown in the calling thread once all workers
+are done.
+
+*/
+template <typename Function>
+inline void parallelFor(size_t npts, int nthreads, Function &&func) {
+  if (nthreads <= 1 || npts < 2) {
+    func(0, size_t(0), npts);
+    return;
+  }
+  size_t chunk = (npts + nthreads - 1) / nthreads;
+  std::vector<std::exception_ptr> errors(nthreads);
+  std::vector<std::thread> threads;
+  threads.reserve(nthreads - 1);
+  auto work = [&](int t) {
+    size_t start = t * chunk;
+    size_t end = start + chunk < npts ? start + chunk : npts;
+    try {
+      if (start < end)
+        func(t, start, end);
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  for (int t = 1; t < nthreads; ++t)
+    threads.emplace_back(work, t);
+  work(0);
+  for (auto &thread : threads)
+    thread.join();
+  for (auto &error : errors) {
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
+
 // --------------------------
 // ------ Unit Vectors ------
 // --------------------------
@@ -157,6 +157,7 @@ inline void rotar(const int ydeg, const Scalar &c1, const Scalar &s1,
   // Compute the initial matrices D0, R0, D1 and R1
   D[0](0, 0) = 1.0;
   R[0](0, 0) = 1.0;
+  if (ydeg == 0) return;
   D[1](2, 2) = 0.5 * (Scalar(1.0) + c2);
   D[1](2, 1) = -s2 / root_two;
   D[1](2, 0) = 0.5 * (Scalar(1.0) - c2);
@@ -267,18 +268,34 @@ class Wigner {
   Scalar tol;                                        /**< */
 
   // Matrices
-  using ADType = ADScalar<Scalar, 4>; /**< AutoDiffScalar type for derivs w.r.t.
-                                         the rotation axis */
-  std::vector<Matrix<Scalar>> D;      /**< The complex Wigner matrix */
-  std::vector<Matrix<ADType>>
-      D_ad; /**< [AutoDiffScalar] The complex Wigner matrix */
-  std::vector<Matrix<Scalar>> R; /**< The real Wigner matrix */
-  std::vector<Matrix<ADType>>
-      R_ad; /**< [AutoDiffScalar] The real Wigner matrix */
-  std::vector<Matrix<Scalar>> DRDx;     /**< */
-  std::vector<Matrix<Scalar>> DRDy;     /**< */
-  std::vector<Matrix<Scalar>> DRDz;     /**< */
-  std::vector<Matrix<Scalar>> DRDtheta; /**< */
+  std::vector<Matrix<Scalar>> D;  /**< The complex Wigner matrix */
+  std::vector<Matrix<Scalar>> R;  /**< The real Wigner matrix */
+  std::vector<Matrix<Scalar>> Kx; /**< Generator of rotations about `x` */
+  std::vector<Matrix<Scalar>> Ky; /**< Generator of rotations about `y` */
+  std::vector<Matrix<Scalar>> Kz; /**< Generator of rotations about `z` */
+  Scalar ux, uy, uz, unorm; /**< The unit rotation axis and its norm */
+  std::vector<Matrix<Scalar>> Rsky;   /**< Rotation to the sky frame */
+  std::vector<Matrix<Scalar>> Rpolar; /**< Rotation to the polar frame */
+  Scalar inc_cache, obl_cache;        /**< */
+  Vector<Scalar> theta_proj;          /**< */
+
+  /**
+  Check the shapes of the arguments of `dotProjection` and
+  broadcast `theta` to the number of rows of the result.
+
+  */
+  inline size_t projectionShape(size_t nrows, const Vector<Scalar> &theta) {
+    size_t ntheta = theta.size();
+    size_t npts = (nrows == 1) ? ntheta : nrows;
+    if ((ntheta != npts) && (ntheta != 1))
+      throw std::runtime_error(
+          "Mismatch in the number of rows of `M` and `theta`.");
+    if (ntheta == npts)
+      theta_proj = theta;
+    else
+      theta_proj.setConstant(npts, theta(0));
+    return npts;
+  }
 
  public:
   // Tensor z rotation results
@@ -291,39 +308,67 @@ class Wigner {
   Scalar dotR_bx, dotR_by, dotR_bz, dotR_btheta; /**< */
   Matrix<Scalar> dotR_bM;                        /**< */
 
+  // Projection results
+  Matrix<Scalar> dotProjection_result;                /**< */
+  Scalar dotProjection_binc, dotProjection_bobl;      /**< */
+  Vector<Scalar> dotProjection_btheta;                /**< */
+  Matrix<Scalar> dotProjection_bM;                    /**< */
+
   Wigner(int ydeg, int udeg, int fdeg) :
       ydeg(ydeg), Ny((ydeg + 1) * (ydeg + 1)), udeg(udeg), Nu(udeg + 1),
       fdeg(fdeg), Nf((fdeg + 1) * (fdeg + 1)), deg(ydeg + udeg + fdeg),
       N((deg + 1) * (deg + 1)), theta_Rz_cache(0), x_cache(NAN), y_cache(NAN),
-      z_cache(NAN), theta_cache(NAN) {
+      z_cache(NAN), theta_cache(NAN), inc_cache(NAN), obl_cache(NAN) {
     // Allocate the Wigner matrices
     D.resize(ydeg + 1);
     R.resize(ydeg + 1);
-    D_ad.resize(ydeg + 1);
-    R_ad.resize(ydeg + 1);
-    DRDx.resize(ydeg + 1);
-    DRDy.resize(ydeg + 1);
-    DRDz.resize(ydeg + 1);
-    DRDtheta.resize(ydeg + 1);
+    Kx.resize(ydeg + 1);
+    Ky.resize(ydeg + 1);
+    Kz.resize(ydeg + 1);
     for (int l = 0; l < ydeg + 1; ++l) {
       int sz = 2 * l + 1;
       D[l].resize(sz, sz);
       R[l].resize(sz, sz);
-      D_ad[l].resize(sz, sz);
-      R_ad[l].resize(sz, sz);
-      DRDx[l].resize(sz, sz);
-      DRDy[l].resize(sz, sz);
-      DRDz[l].resize(sz, sz);
-      DRDtheta[l].resize(sz, sz);
     }
 
     // Misc
     tol = 10 * mach_eps<Scalar>();
+
+    // The generators of the rotations about the three axes. The one
+    // about `z` mixes `m` and `-m`; the other two are obtained from
+    // it by rotating `z` onto `x` and `y`, respectively.
+    for (int l = 0; l < ydeg + 1; ++l) {
+      Kz[l].setZero(2 * l + 1, 2 * l + 1);
+      for (int m = 1; m < l + 1; ++m) {
+        Kz[l](l - m, l + m) = m;
+        Kz[l](l + m, l - m) = -m;
+      }
+    }
+    computeR(0.0, 1.0, 0.0, 0.5 * pi<Scalar>());
+    for (int l = 0; l < ydeg + 1; ++l)
+      Kx[l] = R[l] * Kz[l] * R[l].transpose();
+    computeR(1.0, 0.0, 0.0, -0.5 * pi<Scalar>());
+    for (int l = 0; l < ydeg + 1; ++l)
+      Ky[l] = R[l] * Kz[l] * R[l].transpose();
+
+    // The rotation to the polar frame; the sky frame
+    // rotation depends on `inc` and `obl` (see below)
+    computeR(1.0, 0.0, 0.0, 0.5 * pi<Scalar>());
+    Rpolar = R;
+    Rsky.resize(ydeg + 1);
+    x_cache = NAN;
+    y_cache = NAN;
+    z_cache = NAN;
+    theta_cache = NAN;
   }
 
   /**
   Compute the full rotation matrix R.
 
+  The derivatives are not computed here: since `R = exp(theta K)`,
+  where `K` is the generator of rotations about the axis, they
+  follow in closed form from `K` and `R` (see `dotR`).
+
   */
   inline void computeR(const Scalar &x_, const Scalar &y_, const Scalar &z_,
                        const Scalar &theta_) {
@@ -337,38 +382,33 @@ class Wigner {
     z_cache = z_;
     theta_cache = theta_;
 
-    // Convert to ADType
-    ADType x = x_;
-    ADType y = y_;
-    ADType z = z_;
-    ADType theta = theta_;
-    x.derivatives() = Vector<Scalar>::Unit(4, 0);
-    y.derivatives() = Vector<Scalar>::Unit(4, 1);
-    z.derivatives() = Vector<Scalar>::Unit(4, 2);
-    theta.derivatives() = Vector<Scalar>::Unit(4, 3);
+    // Normalize the axis
+    unorm = sqrt(x_ * x_ + y_ * y_ + z_ * z_);
+    if (unorm == 0) unorm = 1.0;
+    ux = x_ / unorm;
+    uy = y_ / unorm;
+    uz = z_ / unorm;
 
     // Determine the Euler angles
-    ADType costheta = cos(theta);
-    ADType sintheta = sin(theta);
-    ADType RA01 = x * y * (1 - costheta) - z * sintheta;
-    ADType RA02 = x * z * (1 - costheta) + y * sintheta;
-    ADType RA11 = costheta + y * y * (1 - costheta);
-    ADType RA12 = y * z * (1 - costheta) - x * sintheta;
-    ADType RA20 = z * x * (1 - costheta) - y * sintheta;
-    ADType RA21 = z * y * (1 - costheta) + x * sintheta;
-    ADType RA22 = costheta + z * z * (1 - costheta);
-    ADType cosalpha, sinalpha, cosbeta, sinbeta, cosgamma, singamma;
-
-    if ((RA22.value() < Scalar(-1.0) + tol) &&
-        (RA22.value() > Scalar(-1.0) - tol)) {
+    Scalar costheta = cos(theta_);
+    Scalar sintheta = sin(theta_);
+    Scalar RA01 = ux * uy * (1 - costheta) - uz * sintheta;
+    Scalar RA02 = ux * uz * (1 - costheta) + uy * sintheta;
+    Scalar RA11 = costheta + uy * uy * (1 - costheta);
+    Scalar RA12 = uy * uz * (1 - costheta) - ux * sintheta;
+    Scalar RA20 = uz * ux * (1 - costheta) - uy * sintheta;
+    Scalar RA21 = uz * uy * (1 - costheta) + ux * sintheta;
+    Scalar RA22 = costheta + uz * uz * (1 - costheta);
+    Scalar cosalpha, sinalpha, cosbeta, sinbeta, cosgamma, singamma;
+
+    if ((RA22 < Scalar(-1.0) + tol) && (RA22 > Scalar(-1.0) - tol)) {
       cosbeta = RA22;                // = -1
       sinbeta = Scalar(1.0) + RA22;  // = 0
       cosgamma = RA11;
       singamma = RA01;
       cosalpha = -RA22;               // = 1
       sinalpha = Scalar(1.0) + RA22;  // = 0
-    } else if ((RA22.value() < Scalar(1.0) + tol) &&
-               (RA22.value() > Scalar(1.0) - tol)) {
+    } else if ((RA22 < Scalar(1.0) + tol) && (RA22 > Scalar(1.0) - tol)) {
       cosbeta = RA22;                // = 1
       sinbeta = Scalar(1.0) - RA22;  // = 0
       cosgamma = RA11;
@@ -376,7 +416,7 @@ class Wigner {
       cosalpha = RA22;                // = 1
       sinalpha = Scalar(1.0) - RA22;  // = 0
     } else {
-      ADType norm1, norm2;
+      Scalar norm1, norm2;
       cosbeta = RA22;
       sinbeta = sqrt(Scalar(1.0) - cosbeta * cosbeta);
       norm1 = sqrt(RA20 * RA20 + RA21 * RA21);
@@ -388,23 +428,46 @@ class Wigner {
     }
 
     // Call the Eulerian rotation function
-    ADType tol_ad = tol;
-    rotar(ydeg, cosalpha, sinalpha, cosbeta, sinbeta, cosgamma, singamma,
-          tol_ad, D_ad, R_ad);
+    rotar(ydeg, cosalpha, sinalpha, cosbeta, sinbeta, cosgamma, singamma, tol,
+          D, R);
+  }
 
-    // Extract the matrices and their derivatives
-    for (int l = 0; l < ydeg + 1; ++l) {
-      // TODO: This data copy is *very* slow; is there a better way?
-      for (int i = 0; i < 2 * l + 1; ++i) {
-        for (int j = 0; j < 2 * l + 1; ++j) {
-          R[l](i, j) = R_ad[l](i, j).value();
-          DRDx[l](i, j) = R_ad[l](i, j).derivatives()(0);
-          DRDy[l](i, j) = R_ad[l](i, j).derivatives()(1);
-          DRDz[l](i, j) = R_ad[l](i, j).derivatives()(2);
-          DRDtheta[l](i, j) = R_ad[l](i, j).derivatives()(3);
-        }
-      }
-    }
+  /**
+  Return the real Wigner matrices for a rotation by `theta` about the
+  axis `[x, y, z]`. The reference is only valid until the next call
+  to any of the rotation routines.
+
+  */
+  inline const std::vector<Matrix<Scalar>> &
+  getR(const Scalar &x, const Scalar &y, const Scalar &z,
+       const Scalar &theta) {
+    computeR(x, y, z, theta);
+    return R;
+  }
+
+  //! Generators of the rotations about `x`, `y` and `z`
+  inline const std::vector<Matrix<Scalar>> &getKx() const { return Kx; }
+  inline const std::vector<Matrix<Scalar>> &getKy() const { return Ky; }
+  inline const std::vector<Matrix<Scalar>> &getKz() const { return Kz; }
+
+  /**
+  Compute the compound rotation to the sky frame, i.e., the product
+  of the rotations by `inc - pi / 2` about `(-cos(obl), -sin(obl), 0)`,
+  by `obl` about `z` and by `-pi / 2` about `x`.
+
+  */
+  inline void computeProjection(const Scalar &inc, const Scalar &obl) {
+    // Check the cache
+    if ((inc == inc_cache) && (obl == obl_cache)) return;
+    inc_cache = inc;
+    obl_cache = obl;
+
+    // Compose the rotations
+    computeR(-cos(obl), -sin(obl), Scalar(0.0), inc - 0.5 * pi<Scalar>());
+    Rsky = R;
+    computeR(Scalar(0.0), Scalar(0.0), Scalar(1.0), obl);
+    for (int l = 0; l < ydeg + 1; ++l)
+      Rsky[l] = Rsky[l] * R[l] * Rpolar[l].transpose();
   }
 
   /**
@@ -487,10 +550,11 @@ class Wigner {
   Computes the gradient of the dot product M . R([x, y, z], theta).
 
   */
-  template <typename T1, bool M_IS_ROW_VECTOR = (T1::RowsAtCompileTime == 1)>
+  template <typename T1, typename T2,
+            bool M_IS_ROW_VECTOR = (T1::RowsAtCompileTime == 1)>
   inline void dotR(const MatrixBase<T1> &M, const Scalar &x, const Scalar &y,
                    const Scalar &z, const Scalar &theta,
-                   const Matrix<Scalar> &bMR) {
+                   const MatrixBase<T2> &bMR) {
     // Shape checks
     size_t npts = M.rows();
 
@@ -505,26 +569,197 @@ class Wigner {
     dotR_bM.setZero(npts, Ny);
     if (unlikely(npts == 0)) return;
 
-    // Dot them in
-    // TODO: There must be a more efficient way of doing this.
+    // Any derivative of R is of the form `K(w) R`, where `K(w)` is the
+    // generator of rotations about `w`, so all we need are the
+    // projections `g` of `M^T bMR R^T` onto the three generators
+    Scalar gx = 0.0, gy = 0.0, gz = 0.0;
+    Matrix<Scalar> MTbM;
     for (int l = 0; l < ydeg + 1; ++l) {
-      // d / dargs
-      dotR_bx += (M.block(0, l * l, npts, 2 * l + 1) * DRDx[l])
-                     .cwiseProduct(bMR.block(0, l * l, npts, 2 * l + 1))
-                     .sum();
-      dotR_by += (M.block(0, l * l, npts, 2 * l + 1) * DRDy[l])
-                     .cwiseProduct(bMR.block(0, l * l, npts, 2 * l + 1))
-                     .sum();
-      dotR_bz += (M.block(0, l * l, npts, 2 * l + 1) * DRDz[l])
-                     .cwiseProduct(bMR.block(0, l * l, npts, 2 * l + 1))
-                     .sum();
-      dotR_btheta += (M.block(0, l * l, npts, 2 * l + 1) * DRDtheta[l])
-                         .cwiseProduct(bMR.block(0, l * l, npts, 2 * l + 1))
-                         .sum();
-
       // d / dM
       dotR_bM.block(0, l * l, npts, 2 * l + 1) =
           bMR.block(0, l * l, npts, 2 * l + 1) * R[l].transpose();
+
+      // Projections onto the generators
+      if (l == 0) continue;
+      MTbM = M.block(0, l * l, npts, 2 * l + 1).transpose() *
+             dotR_bM.block(0, l * l, npts, 2 * l + 1);
+      gx += Kx[l].cwiseProduct(MTbM).sum();
+      gy += Ky[l].cwiseProduct(MTbM).sum();
+      gz += Kz[l].cwiseProduct(MTbM).sum();
+    }
+
+    // d / dtheta: `dR / dtheta = K(u) R`
+    dotR_btheta = ux * gx + uy * gy + uz * gz;
+
+    // d / daxis: a change `du` in the (unit) axis rotates
+    // the frame about `w = sin(theta) du + (1 - cos(theta)) u x du`.
+    // We also account for the normalization of the axis.
+    Scalar c = cos(theta), s = sin(theta);
+    Scalar hx = s * gx + (1 - c) * (gy * uz - gz * uy);
+    Scalar hy = s * gy + (1 - c) * (gz * ux - gx * uz);
+    Scalar hz = s * gz + (1 - c) * (gx * uy - gy * ux);
+    Scalar uh = ux * hx + uy * hy + uz * hz;
+    dotR_bx = (hx - ux * uh) / unorm;
+    dotR_by = (hy - uy * uh) / unorm;
+    dotR_bz = (hz - uz * uh) / unorm;
+  }
+
+  /*
+  Computes the projection M . Rsky(inc, obl) . Rz(theta) . Rpolar, or,
+  if `TRANSPOSE` is set, M . Rpolar^T . Rz(-theta) . Rsky(inc, obl)^T,
+  in a single pass over `M`. Either `M` or `theta` may have a single
+  row, in which case it is applied to every row of the result.
+
+  */
+  template <bool TRANSPOSE = false, typename T1>
+  inline void dotProjection(const MatrixBase<T1> &M, const Scalar &inc,
+                            const Scalar &obl, const Vector<Scalar> &theta) {
+    // Shape checks
+    size_t npts = projectionShape(M.rows(), theta);
+
+    // Compute the rotation matrices
+    computeProjection(inc, obl);
+    computeRz(theta_proj);
+
+    // Init result
+    dotProjection_result.resize(npts, Ny);
+    if (unlikely(npts == 0)) return;
+
+    // Dot them in
+    Scalar sgn = TRANSPOSE ? -1.0 : 1.0;
+    Matrix<Scalar> Y, Z(npts, 2 * ydeg + 1);
+    for (int l = 0; l < ydeg + 1; ++l) {
+      const Matrix<Scalar> &R1 = TRANSPOSE ? Rpolar[l] : Rsky[l];
+      const Matrix<Scalar> &R2 = TRANSPOSE ? Rsky[l] : Rpolar[l];
+      if (TRANSPOSE)
+        Y = M.block(0, l * l, M.rows(), 2 * l + 1) * R1.transpose();
+      else
+        Y = M.block(0, l * l, M.rows(), 2 * l + 1) * R1;
+      for (int j = 0; j < 2 * l + 1; ++j) {
+        if (Y.rows() == 1) {
+          Z.col(j) = Y(0, j) * cosmt.col(l * l + j) +
+                     sgn * Y(0, 2 * l - j) * sinmt.col(l * l + j);
+        } else {
+          Z.col(j) = Y.col(j).cwiseProduct(cosmt.col(l * l + j)) +
+                     sgn * Y.col(2 * l - j).cwiseProduct(sinmt.col(l * l + j));
+        }
+      }
+      if (TRANSPOSE)
+        dotProjection_result.block(0, l * l, npts, 2 * l + 1) =
+            Z.leftCols(2 * l + 1) * R2.transpose();
+      else
+        dotProjection_result.block(0, l * l, npts, 2 * l + 1) =
+            Z.leftCols(2 * l + 1) * R2;
+    }
+  }
+
+  /*
+  Computes the gradient of the projection M . Rsky(inc, obl) . Rz(theta) .
+  Rpolar (or its transpose; see above).
+
+  */
+  template <bool TRANSPOSE = false, typename T1, typename T2>
+  inline void dotProjection(const MatrixBase<T1> &M, const Scalar &inc,
+                            const Scalar &obl, const Vector<Scalar> &theta,
+                            const MatrixBase<T2> &bMR) {
+    // Shape checks
+    size_t npts = projectionShape(M.rows(), theta);
+
+    // Compute the rotation matrices
+    computeProjection(inc, obl);
+    computeRz(theta_proj);
+
+    // Init grads
+    dotProjection_binc = 0.0;
+    dotProjection_bobl = 0.0;
+    dotProjection_btheta.setZero(npts);
+    dotProjection_bM.setZero(M.rows(), Ny);
+    if (unlikely(npts == 0)) {
+      dotProjection_btheta.setZero(theta.size());
+      return;
+    }
+
+    // As in `dotR`, the derivatives of the sky frame rotation
+    // are of the form `K(w) Rsky`, so we need the projections `g`
+    // of `G = Rsky^T . bRsky` onto the three generators
+    Scalar sgn = TRANSPOSE ? -1.0 : 1.0;
+    Scalar gx = 0.0, gy = 0.0, gz = 0.0;
+    Matrix<Scalar> Y, bY, bZ, Z(npts, 2 * ydeg + 1), G;
+    for (int l = 0; l < ydeg + 1; ++l) {
+      const Matrix<Scalar> &R1 = TRANSPOSE ? Rpolar[l] : Rsky[l];
+      const Matrix<Scalar> &R2 = TRANSPOSE ? Rsky[l] : Rpolar[l];
+      if (TRANSPOSE) {
+        Y = M.block(0, l * l, M.rows(), 2 * l + 1) * R1.transpose();
+        bZ = bMR.block(0, l * l, npts, 2 * l + 1) * R2;
+      } else {
+        Y = M.block(0, l * l, M.rows(), 2 * l + 1) * R1;
+        bZ = bMR.block(0, l * l, npts, 2 * l + 1) * R2.transpose();
+      }
+      bY.setZero(npts, 2 * l + 1);
+      for (int j = 0; j < 2 * l + 1; ++j) {
+        tmp_c = bZ.col(j).cwiseProduct(cosmt.col(l * l + j));
+        tmp_s = bZ.col(j).cwiseProduct(sinmt.col(l * l + j));
+
+        // d / dtheta
+        if (Y.rows() == 1) {
+          dotProjection_btheta +=
+              (j - l) * (sgn * Y(0, 2 * l - j) * tmp_c - Y(0, j) * tmp_s);
+        } else {
+          dotProjection_btheta +=
+              (j - l) * (sgn * Y.col(2 * l - j).cwiseProduct(tmp_c) -
+                         Y.col(j).cwiseProduct(tmp_s));
+        }
+
+        // d / dY
+        bY.col(j) += tmp_c;
+        bY.col(2 * l - j) += sgn * tmp_s;
+
+        // We'll need the result itself in the transposed case
+        if (TRANSPOSE) {
+          if (Y.rows() == 1) {
+            Z.col(j) = Y(0, j) * cosmt.col(l * l + j) +
+                       sgn * Y(0, 2 * l - j) * sinmt.col(l * l + j);
+          } else {
+            Z.col(j) =
+                Y.col(j).cwiseProduct(cosmt.col(l * l + j)) +
+                sgn * Y.col(2 * l - j).cwiseProduct(sinmt.col(l * l + j));
+          }
+        }
+      }
+
+      // d / dM
+      if (M.rows() == 1) bY = bY.colwise().sum().eval();
+      if (TRANSPOSE)
+        dotProjection_bM.block(0, l * l, M.rows(), 2 * l + 1) = bY * R1;
+      else
+        dotProjection_bM.block(0, l * l, M.rows(), 2 * l + 1) =
+            bY * R1.transpose();
+
+      // Projections onto the generators
+      if (l == 0) continue;
+      if (TRANSPOSE)
+        G = bMR.block(0, l * l, npts, 2 * l + 1).transpose() *
+            (Z.leftCols(2 * l + 1) * R2.transpose());
+      else
+        G = M.block(0, l * l, M.rows(), 2 * l + 1).transpose() *
+            dotProjection_bM.block(0, l * l, M.rows(), 2 * l + 1);
+      gx += Kx[l].cwiseProduct(G).sum();
+      gy += Ky[l].cwiseProduct(G).sum();
+      gz += Kz[l].cwiseProduct(G).sum();
+    }
+
+    // d / dinc: the first rotation is about `u = (-cos(obl), -sin(obl), 0)`
+    dotProjection_binc = -cos(obl) * gx - sin(obl) * gy;
+
+    // d / dobl: since `u` is `(-1, 0, 0)` rotated by `obl` about `z`,
+    // the first two rotations are equal to `R(-x, inc - pi / 2)`
+    // followed by a rotation by `obl` about `z`
+    dotProjection_bobl = gz;
+
+    // Sum over theta if it was broadcast
+    if ((theta.size() == 1) && (npts > 1)) {
+      Scalar btheta = dotProjection_btheta.sum();
+      dotProjection_btheta.setConstant(1, btheta);
     }
   }
 
@@ -552,8 +787,8 @@ class Wigner {
       for (int j = 0; j < 2 * l + 1; ++j) {
         if (M_IS_ROW_VECTOR) {
           tensordotRz_result.col(l * l + j) =
-              M(l * l + j) * cosmt.col(l * l + j) +
-              M(l * l + 2 * l - j) * sinmt.col(l * l + j);
+              M(0, l * l + j) * cosmt.col(l * l + j) +
+              M(0, l * l + 2 * l - j) * sinmt.col(l * l + j);
         } else {
           tensordotRz_result.col(l * l + j) =
               M.col(l * l + j).cwiseProduct(cosmt.col(l * l + j)) +
@@ -567,9 +802,10 @@ class Wigner {
   Computes the gradient of the tensor dot product M . Rz(theta).
 
   */
-  template <typename T1, bool M_IS_ROW_VECTOR = (T1::RowsAtCompileTime == 1)>
+  template <typename T1, typename T2,
+            bool M_IS_ROW_VECTOR = (T1::RowsAtCompileTime == 1)>
   inline void tensordotRz(const MatrixBase<T1> &M, const Vector<Scalar> &theta,
-                          const Matrix<Scalar> &bMRz) {
+                          const MatrixBase<T2> &bMRz) {
     // Shape checks
     size_t npts = theta.size();
     size_t Nr = M.cols();
@@ -592,8 +828,8 @@ class Wigner {
 
         // d / dtheta
         if (M_IS_ROW_VECTOR) {
-          tensordotRz_btheta +=
-              (j - l) * (M(l * l + 2 * l - j) * tmp_c - M(l * l + j) * tmp_s);
+          tensordotRz_btheta += (j - l) * (M(0, l * l + 2 * l - j) * tmp_c -
+                                           M(0, l * l + j) * tmp_s);
         } else {
           tensordotRz_btheta +=
               (j - l) * (M.col(l * l + 2 * l - j).cwiseProduct(tmp_c) -
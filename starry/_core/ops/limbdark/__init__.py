@@ -1,3 +1,5 @@
 # -*- coding: utf-8 -*-
 from .limbdark import LimbDarkOp
+from .limbdark_flux import LimbDarkFluxOp
+from .limbdark_exposure import LimbDarkExposureOp
 from .get_cl import GetClOp
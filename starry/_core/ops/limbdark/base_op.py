@@ -43,6 +43,8 @@ class LimbDarkBaseOp(gof.COp):
 
     def c_compile_args(self, compiler):
         opts = ["-std=c++11", "-O2", "-DNDEBUG"]
+        if sys.platform != "win32":
+            opts += ["-pthread"]
         if sys.platform == "darwin":
             opts += ["-stdlib=libc++", "-mmacosx-version-min=10.7"]
         return opts
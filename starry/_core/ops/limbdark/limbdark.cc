@@ -1,6 +1,6 @@
 #section support_code_struct
 
-starry::limbdark::GreensLimbDark<DTYPE_OUTPUT_0>* APPLY_SPECIFIC(L);
+std::vector<starry::limbdark::GreensLimbDark<double>*>* APPLY_SPECIFIC(L);
 
 #section init_code_struct
 
@@ -9,20 +9,71 @@ starry::limbdark::GreensLimbDark<DTYPE_OUTPUT_0>* APPLY_SPECIFIC(L);
 #section cleanup_code_struct
 
 if (APPLY_SPECIFIC(L) != NULL) {
+  for (auto L : *APPLY_SPECIFIC(L)) delete L;
   delete APPLY_SPECIFIC(L);
 }
 
+#section support_code_apply
+
+/**
+Compute the flux (and, if `GRADIENT`, its derivatives) at the points
+`[start, end)` using the limb darkening solver `L`. The gradient of
+the flux with respect to `c` is an `Nc x Nb` row-major array.
+
+*/
+template <bool GRADIENT, class Solver, class Vector, typename T1, typename T2,
+          typename T3>
+inline void APPLY_SPECIFIC(kernel)(Solver& L, const Vector& cvec,
+                                   const DTYPE_INPUT_1* b,
+                                   const DTYPE_INPUT_2* r,
+                                   const DTYPE_INPUT_3* los, DTYPE_OUTPUT_0* f,
+                                   T1* dfdcl, T2* dfdb, T3* dfdr, size_t Nb,
+                                   size_t start, size_t end) {
+  using namespace starry;
+  int Nc = cvec.size();
+  for (size_t i = start; i < end; ++i) {
+    f[i] = 0;
+    if (GRADIENT) {
+      dfdb[i] = 0;
+      dfdr[i] = 0;
+      for (int n = 0; n < Nc; ++n) dfdcl[n * Nb + i] = 0;
+    }
+
+    if (los[i] > 0) {
+      auto b_ = std::abs(b[i]);
+      auto r_ = std::abs(r[i]);
+      if (b_ < 1 + r_) {
+        L.template compute<GRADIENT>(b_, r_);
+
+        // The value of the light curve
+        f[i] = L.sT.dot(cvec);
+
+        // The gradients
+        if (GRADIENT) {
+          for (int n = 0; n < Nc; ++n) dfdcl[n * Nb + i] = L.sT(n);
+          dfdb[i] = sgn(b[i]) * L.dsTdb.dot(cvec);
+          dfdr[i] = sgn(r[i]) * L.dsTdr.dot(cvec);
+        }
+      }
+    }
+  }
+}
+
 #section support_code_struct
 
 int APPLY_SPECIFIC(limbdark)(
-    PyArrayObject* input0,    // Array of "cl"
-    PyArrayObject* input1,    // Array of impact parameters "b"
-    PyArrayObject* input2,    // Array of radius ratios "r"
-    PyArrayObject* input3,    // Array of line-of-sight position "los"
+    PyArrayObject* input0,  // Array of "cl"
+    PyArrayObject* input1,  // Array of impact parameters "b"
+    PyArrayObject* input2,  // Array of radius ratios "r"
+    PyArrayObject* input3,  // Array of line-of-sight position "los"
+#if LIMBDARK_GRADIENT
     PyArrayObject** output0,  // Flux
     PyArrayObject** output1,  // dfdcl
     PyArrayObject** output2,  // dfdb
     PyArrayObject** output3   // dfdr
+#else
+    PyArrayObject** output0  // Flux
+#endif
 ) {
   using namespace starry;
 
@@ -55,46 +106,84 @@ int APPLY_SPECIFIC(limbdark)(
 
   auto f = allocate_output<DTYPE_OUTPUT_0>(ndim, shape, TYPENUM_OUTPUT_0,
                                            output0, &success);
+  if (success) return 1;
+#if LIMBDARK_GRADIENT
+  const bool gradient = true;
   auto dfdcl = allocate_output<DTYPE_OUTPUT_1>(
       ndim + ndim_c, &(new_shape[0]), TYPENUM_OUTPUT_1, output1, &success);
+  if (success) return 1;
   auto dfdb = allocate_output<DTYPE_OUTPUT_2>(ndim, shape, TYPENUM_OUTPUT_2,
                                               output2, &success);
+  if (success) return 1;
   auto dfdr = allocate_output<DTYPE_OUTPUT_3>(ndim, shape, TYPENUM_OUTPUT_3,
                                               output3, &success);
   if (success) return 1;
-
-  Eigen::Map<Eigen::Matrix<DTYPE_OUTPUT_1, Eigen::Dynamic, Eigen::Dynamic,
-                           Eigen::RowMajor>>
-      dfdcl_mat(dfdcl, Nc, Nb);
-  dfdcl_mat.setZero();
+#else
+  const bool gradient = false;
+  DTYPE_OUTPUT_0 *dfdcl = NULL, *dfdb = NULL, *dfdr = NULL;
+#endif
 
   Eigen::Map<Eigen::Matrix<DTYPE_INPUT_0, Eigen::Dynamic, 1>> cvec(c, Nc);
-  if (APPLY_SPECIFIC(L) == NULL || APPLY_SPECIFIC(L)->lmax != Nc - 1) {
-    if (APPLY_SPECIFIC(L) != NULL) delete APPLY_SPECIFIC(L);
-    APPLY_SPECIFIC(L) = new starry::limbdark::GreensLimbDark<double>(Nc - 1);
-  }
-
-  for (npy_intp i = 0; i < Nb; ++i) {
-    f[i] = 0;
-    dfdb[i] = 0;
-    dfdr[i] = 0;
-
-    if (los[i] > 0) {
-      auto b_ = std::abs(b[i]);
-      auto r_ = std::abs(r[i]);
-      if (b_ < 1 + r_) {
-        APPLY_SPECIFIC(L)->template compute<true>(b_, r_);
-        auto sT = APPLY_SPECIFIC(L)->sT;
 
-        // The value of the light curve
-        f[i] = sT.dot(cvec);
+  // Low degree solvers are specialized at compile time and
+  // live on the stack; for higher degrees we keep one solver
+  // workspace per thread around between calls
+  int nthreads = utils::getNumThreads(Nb);
+  if (APPLY_SPECIFIC(L) == NULL)
+    APPLY_SPECIFIC(L) =
+        new std::vector<starry::limbdark::GreensLimbDark<double>*>();
+  auto& workspaces = *APPLY_SPECIFIC(L);
+  if (Nc - 1 > 4) {
+    if (workspaces.size() && workspaces[0]->lmax != Nc - 1) {
+      for (auto L : workspaces) delete L;
+      workspaces.clear();
+    }
+    while (workspaces.size() < size_t(nthreads))
+      workspaces.push_back(
+          new starry::limbdark::GreensLimbDark<double>(Nc - 1));
+  }
 
-        // The gradients
-        dfdcl_mat.col(i) = sT;
-        dfdb[i] = sgn(b[i]) * APPLY_SPECIFIC(L)->dsTdb.dot(cvec);
-        dfdr[i] = sgn(r[i]) * APPLY_SPECIFIC(L)->dsTdr.dot(cvec);
+  // Each thread writes its own chunk of the outputs
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    utils::parallelFor(Nb, nthreads, [&](int t, size_t start, size_t end) {
+#define STARRY_LIMBDARK_KERNEL(L)                                          \
+  APPLY_SPECIFIC(kernel)<gradient>(L, cvec, b, r, los, f, dfdcl, dfdb, dfdr, \
+                                   Nb, start, end)
+      switch (Nc - 1) {
+        case 0: {
+          limbdark::GreensLimbDark<double, 0> L(0);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        case 1: {
+          limbdark::GreensLimbDark<double, 1> L(1);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        case 2: {
+          limbdark::GreensLimbDark<double, 2> L(2);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        case 3: {
+          limbdark::GreensLimbDark<double, 3> L(3);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        case 4: {
+          limbdark::GreensLimbDark<double, 4> L(4);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        default:
+          STARRY_LIMBDARK_KERNEL(*workspaces[t]);
       }
-    }
+#undef STARRY_LIMBDARK_KERNEL
+    });
+  } catch (std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_Format(PyExc_RuntimeError, "%s", error.c_str());
+    return 1;
   }
 
   return 0;
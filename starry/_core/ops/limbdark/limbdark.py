@@ -9,11 +9,25 @@ from .base_op import LimbDarkBaseOp
 
 
 class LimbDarkOp(LimbDarkBaseOp):
+    """Limb-darkened occultation light curve.
 
-    __props__ = ()
+    If ``gradient`` is False, the op only returns the flux. There's
+    usually no need to ask for this explicitly: graphs that never use the
+    gradient outputs are rewritten to the forward-only version when the
+    function is compiled.
+    """
+
+    __props__ = ("gradient",)
     func_file = "./limbdark.cc"
     func_name = "APPLY_SPECIFIC(limbdark)"
 
+    def __init__(self, gradient=True):
+        self.gradient = bool(gradient)
+        super(LimbDarkOp, self).__init__()
+
+    def get_op_params(self):
+        return [("LIMBDARK_GRADIENT", int(self.gradient))]
+
     def make_node(self, c, b, r, los):
         in_args = []
         dtype = theano.config.floatX
@@ -26,17 +40,20 @@ class LimbDarkOp(LimbDarkBaseOp):
                 dtype = theano.scalar.upcast(dtype, a.dtype)
             in_args.append(a)
 
-        out_args = [
-            in_args[1].type(),
-            tt.TensorType(
-                dtype=dtype, broadcastable=[False] * (in_args[1].ndim + 1)
-            )(),
-            in_args[1].type(),
-            in_args[2].type(),
-        ]
+        out_args = [in_args[1].type()]
+        if self.gradient:
+            out_args += [
+                tt.TensorType(
+                    dtype=dtype, broadcastable=[False] * (in_args[1].ndim + 1)
+                )(),
+                in_args[1].type(),
+                in_args[2].type(),
+            ]
         return gof.Apply(self, in_args, out_args)
 
     def infer_shape(self, node, shapes):
+        if not self.gradient:
+            return (shapes[1],)
         return (
             shapes[1],
             list(shapes[0]) + list(shapes[1]),
@@ -46,7 +63,7 @@ class LimbDarkOp(LimbDarkBaseOp):
 
     def grad(self, inputs, gradients):
         c, b, r, los = inputs
-        f, dfdcl, dfdb, dfdr = self(*inputs)
+        f, dfdcl, dfdb, dfdr = LimbDarkOp(gradient=True)(*inputs)
         bf = gradients[0]
         for i, g in enumerate(gradients[1:]):
             if not isinstance(g.type, theano.gradient.DisconnectedType):
@@ -66,3 +83,15 @@ class LimbDarkOp(LimbDarkBaseOp):
         if eval_points[0] is None:
             return eval_points
         return self.grad(inputs, eval_points)
+
+
+@tt.opt.register_specialize
+@gof.local_optimizer([LimbDarkOp])
+def local_limbdark_forward_only(node):
+    """Skip the gradient computation if nothing uses it."""
+    if not isinstance(node.op, LimbDarkOp) or not node.op.gradient:
+        return False
+    if any(len(out.clients) for out in node.outputs[1:]):
+        return False
+    f = LimbDarkOp(gradient=False)(*node.inputs)
+    return {node.outputs[0]: f}
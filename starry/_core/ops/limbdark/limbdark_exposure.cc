@@ -0,0 +1,91 @@
+#section support_code_apply
+
+int APPLY_SPECIFIC(limbdark_exposure)(
+    PyArrayObject* input0,   // Array of "u", shape (nw, udeg + 1)
+    PyArrayObject* input1,   // Array of occultor positions "xo"
+    PyArrayObject* input2,   // Array of occultor positions "yo"
+    PyArrayObject* input3,   // Array of occultor velocities "vx"
+    PyArrayObject* input4,   // Array of occultor velocities "vy"
+    PyArrayObject* input5,   // Array of occultor accelerations "ax"
+    PyArrayObject* input6,   // Array of occultor accelerations "ay"
+    PyArrayObject* input7,   // Array of radius ratios "r"
+    PyArrayObject* input8,   // Array of exposure times "texp"
+    PyArrayObject* input9,   // Array of line-of-sight position "los"
+    PyArrayObject** output0  // Flux, shape xo.shape + (nw,)
+) {
+  using namespace starry;
+  typedef DTYPE_OUTPUT_0 T;
+
+  int success = 0;
+  npy_intp nw, Nu;
+  auto u = get_matrix_input<DTYPE_INPUT_0>(&nw, &Nu, input0, &success);
+  if (success) return 1;
+  if (Nu < 1) {
+    PyErr_Format(PyExc_ValueError, "u must have at least one coefficient");
+    return 1;
+  }
+
+  int ndim = -1;
+  npy_intp* shape;
+  auto xo = get_input<DTYPE_INPUT_1>(&ndim, &shape, input1, &success);
+  auto yo = get_input<DTYPE_INPUT_2>(&ndim, &shape, input2, &success);
+  auto vx = get_input<DTYPE_INPUT_3>(&ndim, &shape, input3, &success);
+  auto vy = get_input<DTYPE_INPUT_4>(&ndim, &shape, input4, &success);
+  auto ax = get_input<DTYPE_INPUT_5>(&ndim, &shape, input5, &success);
+  auto ay = get_input<DTYPE_INPUT_6>(&ndim, &shape, input6, &success);
+  auto r = get_input<DTYPE_INPUT_7>(&ndim, &shape, input7, &success);
+  auto texp = get_input<DTYPE_INPUT_8>(&ndim, &shape, input8, &success);
+  auto los = get_input<DTYPE_INPUT_9>(&ndim, &shape, input9, &success);
+  if (success) return 1;
+
+  std::vector<npy_intp> new_shape(ndim + 1);
+  npy_intp N = 1;
+  for (int i = 0; i < ndim; ++i) {
+    new_shape[i] = shape[i];
+    N *= shape[i];
+  }
+  new_shape[ndim] = nw;
+
+  auto f = allocate_output<DTYPE_OUTPUT_0>(ndim + 1, &(new_shape[0]),
+                                           TYPENUM_OUTPUT_0, output0, &success);
+  if (success) return 1;
+
+  // The normalized Agol coefficients for each channel
+  Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> cn(nw, Nu);
+  Eigen::Matrix<T, Eigen::Dynamic, 1> c(Nu);
+  for (npy_intp w = 0; w < nw; ++w) {
+    limbdark::getCl(Nu, u + w * Nu, c.data());
+    T norm = utils::pi<T>() * ((Nu > 1) ? c(0) + 2 * c(1) / 3 : c(0));
+    cn.row(w) = c.transpose() / norm;
+  }
+
+  // Integrate each exposure; the quadrature is shared by all channels
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    utils::parallelFor(
+        N, utils::getNumThreads(N), [&](int, size_t start, size_t end) {
+          limbdark::LimbDarkExposure<T> E(Nu - 1, LIMBDARK_TOL,
+                                          LIMBDARK_MAXDEPTH);
+          for (size_t i = start; i < end; ++i) {
+            Eigen::Map<Eigen::Matrix<T, 1, Eigen::Dynamic>> fi(f + i * nw, nw);
+            if ((los[i] > 0) && (r[i] > 0)) {
+              E.compute(cn, xo[i], yo[i], vx[i], vy[i], ax[i], ay[i], r[i],
+                        texp[i]);
+              fi = E.flux;
+            } else {
+              fi.setOnes();
+            }
+          }
+        });
+  } catch (std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_Format(PyExc_RuntimeError, "%s", error.c_str());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,69 @@
+# -*- coding: utf-8 -*-
+
+__all__ = ["LimbDarkExposureOp"]
+
+import theano
+import theano.tensor as tt
+from theano import gof
+from .base_op import LimbDarkBaseOp
+from .limbdark_exposure_rev import LimbDarkExposureRevOp
+
+
+class LimbDarkExposureOp(LimbDarkBaseOp):
+    """Exposure-averaged limb-darkened occultation flux.
+
+    Takes the polynomial limb darkening coefficients ``u`` of shape
+    ``(nw, udeg + 1)`` and arrays ``xo``, ``yo``, ``vx``, ``vy``, ``ax``,
+    ``ay``, ``r``, ``texp``, ``los`` of the same shape, and returns the
+    flux averaged over exposures of length ``texp`` centered on the
+    positions ``(xo, yo)``, assuming the occultor moves with constant
+    velocity ``(vx, vy)`` and acceleration ``(ax, ay)`` during each
+    exposure. The output has shape
+    ``xo.shape + (nw,)``. The integral is computed adaptively to an
+    absolute tolerance ``tol``, so exposures that are out of transit or
+    fully in transit are cheap.
+    """
+
+    __props__ = ("tol", "maxdepth")
+    func_file = "./limbdark_exposure.cc"
+    func_name = "APPLY_SPECIFIC(limbdark_exposure)"
+
+    def __init__(self, tol=1e-8, maxdepth=16):
+        self.tol = float(tol)
+        self.maxdepth = int(maxdepth)
+        self.grad_op = LimbDarkExposureRevOp(tol=tol, maxdepth=maxdepth)
+        super(LimbDarkExposureOp, self).__init__()
+
+    def get_op_params(self):
+        return [
+            ("LIMBDARK_TOL", repr(self.tol)),
+            ("LIMBDARK_MAXDEPTH", self.maxdepth),
+        ]
+
+    def make_node(self, u, xo, yo, vx, vy, ax, ay, r, texp, los):
+        in_args = []
+        dtype = theano.config.floatX
+        for a in [u, xo, yo, vx, vy, ax, ay, r, texp, los]:
+            a = tt.as_tensor_variable(a)
+            dtype = theano.scalar.upcast(dtype, a.dtype)
+            in_args.append(a)
+        out_args = [
+            tt.TensorType(
+                dtype=dtype, broadcastable=[False] * (in_args[1].ndim + 1)
+            )()
+        ]
+        return gof.Apply(self, in_args, out_args)
+
+    def infer_shape(self, node, shapes):
+        return (list(shapes[1]) + [shapes[0][0]],)
+
+    def grad(self, inputs, gradients):
+        los = inputs[-1]
+        return list(self.grad_op(*(inputs + gradients))) + [
+            tt.zeros_like(los)
+        ]
+
+    def R_op(self, inputs, eval_points):
+        if eval_points[0] is None:
+            return eval_points
+        return self.grad(inputs, eval_points)
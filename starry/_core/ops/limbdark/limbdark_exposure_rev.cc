@@ -0,0 +1,149 @@
+#section support_code_apply
+
+int APPLY_SPECIFIC(limbdark_exposure_rev)(
+    PyArrayObject* input0,    // Array of "u", shape (nw, udeg + 1)
+    PyArrayObject* input1,    // Array of occultor positions "xo"
+    PyArrayObject* input2,    // Array of occultor positions "yo"
+    PyArrayObject* input3,    // Array of occultor velocities "vx"
+    PyArrayObject* input4,    // Array of occultor velocities "vy"
+    PyArrayObject* input5,    // Array of occultor accelerations "ax"
+    PyArrayObject* input6,    // Array of occultor accelerations "ay"
+    PyArrayObject* input7,    // Array of radius ratios "r"
+    PyArrayObject* input8,    // Array of exposure times "texp"
+    PyArrayObject* input9,    // Array of line-of-sight position "los"
+    PyArrayObject* input10,   // Gradient of the flux, shape xo.shape + (nw,)
+    PyArrayObject** output0,  // bu
+    PyArrayObject** output1,  // bxo
+    PyArrayObject** output2,  // byo
+    PyArrayObject** output3,  // bvx
+    PyArrayObject** output4,  // bvy
+    PyArrayObject** output5,  // bax
+    PyArrayObject** output6,  // bay
+    PyArrayObject** output7,  // br
+    PyArrayObject** output8   // btexp
+) {
+  using namespace starry;
+  typedef DTYPE_OUTPUT_0 T;
+
+  int success = 0;
+  npy_intp nw, Nu;
+  auto u = get_matrix_input<DTYPE_INPUT_0>(&nw, &Nu, input0, &success);
+  if (success) return 1;
+  if (Nu < 1) {
+    PyErr_Format(PyExc_ValueError, "u must have at least one coefficient");
+    return 1;
+  }
+
+  int ndim = -1;
+  npy_intp* shape;
+  auto xo = get_input<DTYPE_INPUT_1>(&ndim, &shape, input1, &success);
+  auto yo = get_input<DTYPE_INPUT_2>(&ndim, &shape, input2, &success);
+  auto vx = get_input<DTYPE_INPUT_3>(&ndim, &shape, input3, &success);
+  auto vy = get_input<DTYPE_INPUT_4>(&ndim, &shape, input4, &success);
+  auto ax = get_input<DTYPE_INPUT_5>(&ndim, &shape, input5, &success);
+  auto ay = get_input<DTYPE_INPUT_6>(&ndim, &shape, input6, &success);
+  auto r = get_input<DTYPE_INPUT_7>(&ndim, &shape, input7, &success);
+  auto texp = get_input<DTYPE_INPUT_8>(&ndim, &shape, input8, &success);
+  auto los = get_input<DTYPE_INPUT_9>(&ndim, &shape, input9, &success);
+  if (success) return 1;
+
+  std::vector<npy_intp> new_shape(ndim + 1);
+  npy_intp N = 1;
+  for (int i = 0; i < ndim; ++i) {
+    new_shape[i] = shape[i];
+    N *= shape[i];
+  }
+  new_shape[ndim] = nw;
+  auto bf = get_input<DTYPE_INPUT_10>(ndim + 1, &(new_shape[0]), input10,
+                                      &success);
+  if (success) return 1;
+
+  auto bu = allocate_output<DTYPE_OUTPUT_0>(
+      PyArray_NDIM(input0), PyArray_DIMS(input0), TYPENUM_OUTPUT_0, output0,
+      &success);
+  if (success) return 1;
+  auto bxo = allocate_output<DTYPE_OUTPUT_1>(ndim, shape, TYPENUM_OUTPUT_1,
+                                             output1, &success);
+  if (success) return 1;
+  auto byo = allocate_output<DTYPE_OUTPUT_2>(ndim, shape, TYPENUM_OUTPUT_2,
+                                             output2, &success);
+  if (success) return 1;
+  auto bvx = allocate_output<DTYPE_OUTPUT_3>(ndim, shape, TYPENUM_OUTPUT_3,
+                                             output3, &success);
+  if (success) return 1;
+  auto bvy = allocate_output<DTYPE_OUTPUT_4>(ndim, shape, TYPENUM_OUTPUT_4,
+                                             output4, &success);
+  if (success) return 1;
+  auto bax = allocate_output<DTYPE_OUTPUT_5>(ndim, shape, TYPENUM_OUTPUT_5,
+                                             output5, &success);
+  if (success) return 1;
+  auto bay = allocate_output<DTYPE_OUTPUT_6>(ndim, shape, TYPENUM_OUTPUT_6,
+                                             output6, &success);
+  if (success) return 1;
+  auto br = allocate_output<DTYPE_OUTPUT_7>(ndim, shape, TYPENUM_OUTPUT_7,
+                                            output7, &success);
+  if (success) return 1;
+  auto btexp = allocate_output<DTYPE_OUTPUT_8>(ndim, shape, TYPENUM_OUTPUT_8,
+                                               output8, &success);
+  if (success) return 1;
+
+  // The normalized Agol coefficients for each channel
+  Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> cn(nw, Nu);
+  Eigen::Matrix<T, Eigen::Dynamic, 1> norm(nw);
+  Eigen::Matrix<T, Eigen::Dynamic, 1> c(Nu);
+  for (npy_intp w = 0; w < nw; ++w) {
+    limbdark::getCl(Nu, u + w * Nu, c.data());
+    norm(w) = utils::pi<T>() * ((Nu > 1) ? c(0) + 2 * c(1) / 3 : c(0));
+    cn.row(w) = c.transpose() / norm(w);
+  }
+
+  // Backprop each exposure; each thread accumulates its own `bcn`
+  int nthreads = utils::getNumThreads(N);
+  std::vector<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> bcn(
+      nthreads, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(nw, Nu));
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    utils::parallelFor(N, nthreads, [&](int t, size_t start, size_t end) {
+      limbdark::LimbDarkExposure<T> E(Nu - 1, LIMBDARK_TOL, LIMBDARK_MAXDEPTH);
+      Eigen::Matrix<T, 1, Eigen::Dynamic> bfi(nw);
+      for (size_t i = start; i < end; ++i) {
+        bxo[i] = 0;
+        byo[i] = 0;
+        bvx[i] = 0;
+        bvy[i] = 0;
+        bax[i] = 0;
+        bay[i] = 0;
+        br[i] = 0;
+        btexp[i] = 0;
+        if ((los[i] > 0) && (r[i] > 0)) {
+          for (npy_intp w = 0; w < nw; ++w) bfi(w) = bf[i * nw + w];
+          E.computeRev(cn, xo[i], yo[i], vx[i], vy[i], ax[i], ay[i], r[i],
+                       texp[i], bfi, bcn[t], bxo[i], byo[i], bvx[i], bvy[i],
+                       bax[i], bay[i], br[i], btexp[i]);
+        }
+      }
+    });
+  } catch (std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_Format(PyExc_RuntimeError, "%s", error.c_str());
+    return 1;
+  }
+  for (int t = 1; t < nthreads; ++t) bcn[0] += bcn[t];
+
+  // Backprop through the normalization and onto `u`
+  Eigen::Matrix<T, Eigen::Dynamic, 1> bc(Nu), dnormdc(Nu);
+  dnormdc.setZero();
+  dnormdc(0) = utils::pi<T>();
+  if (Nu > 1) dnormdc(1) = 2 * utils::pi<T>() / 3;
+  for (npy_intp w = 0; w < nw; ++w) {
+    bc = (bcn[0].row(w).transpose() - bcn[0].row(w).dot(cn.row(w)) * dnormdc) /
+         norm(w);
+    limbdark::getClRev(Nu, bc.data(), bu + w * Nu);
+  }
+
+  return 0;
+}
@@ -0,0 +1,36 @@
+# -*- coding: utf-8 -*-
+
+__all__ = ["LimbDarkExposureRevOp"]
+
+import theano.tensor as tt
+from theano import gof
+from .base_op import LimbDarkBaseOp
+
+
+class LimbDarkExposureRevOp(LimbDarkBaseOp):
+
+    __props__ = ("tol", "maxdepth")
+    func_file = "./limbdark_exposure_rev.cc"
+    func_name = "APPLY_SPECIFIC(limbdark_exposure_rev)"
+
+    def __init__(self, tol=1e-8, maxdepth=16):
+        self.tol = float(tol)
+        self.maxdepth = int(maxdepth)
+        super(LimbDarkExposureRevOp, self).__init__()
+
+    def get_op_params(self):
+        return [
+            ("LIMBDARK_TOL", repr(self.tol)),
+            ("LIMBDARK_MAXDEPTH", self.maxdepth),
+        ]
+
+    def make_node(self, u, xo, yo, vx, vy, ax, ay, r, texp, los, bf):
+        in_args = [
+            tt.as_tensor_variable(a)
+            for a in [u, xo, yo, vx, vy, ax, ay, r, texp, los, bf]
+        ]
+        out_args = [a.type() for a in in_args[:9]]
+        return gof.Apply(self, in_args, out_args)
+
+    def infer_shape(self, node, shapes):
+        return shapes[:9]
@@ -0,0 +1,121 @@
+#section support_code_apply
+
+/**
+Compute the flux in all channels at the points `[start, end)` using
+the limb darkening solver `L`. The solution vector only depends on
+the geometry, so the channels cost a single matrix product.
+
+*/
+template <class Solver, class Matrix, typename T1, typename T2, typename T3,
+          typename T4>
+inline void APPLY_SPECIFIC(kernel)(Solver& L, const Matrix& cn, const T1* b,
+                                   const T2* r, const T3* los, T4* f,
+                                   npy_intp nw, size_t start, size_t end) {
+  for (size_t i = start; i < end; ++i) {
+    Eigen::Map<Eigen::Matrix<T4, 1, Eigen::Dynamic>> fi(f + i * nw, nw);
+    auto b_ = std::abs(b[i]);
+    auto r_ = std::abs(r[i]);
+    if ((los[i] > 0) && (b_ < 1 + r_)) {
+      L.template compute<false>(b_, r_);
+      fi.noalias() = L.sT * cn.transpose();
+    } else {
+      fi.setOnes();
+    }
+  }
+}
+
+int APPLY_SPECIFIC(limbdark_flux)(
+    PyArrayObject* input0,   // Array of "u", shape (nw, udeg + 1)
+    PyArrayObject* input1,   // Array of impact parameters "b"
+    PyArrayObject* input2,   // Array of radius ratios "r"
+    PyArrayObject* input3,   // Array of line-of-sight position "los"
+    PyArrayObject** output0  // Flux, shape b.shape + (nw,)
+) {
+  using namespace starry;
+  typedef DTYPE_OUTPUT_0 T;
+
+  int success = 0;
+  npy_intp nw, Nu;
+  auto u = get_matrix_input<DTYPE_INPUT_0>(&nw, &Nu, input0, &success);
+  if (success) return 1;
+  if (Nu < 1) {
+    PyErr_Format(PyExc_ValueError, "u must have at least one coefficient");
+    return 1;
+  }
+
+  int ndim = -1;
+  npy_intp* shape;
+  auto b = get_input<DTYPE_INPUT_1>(&ndim, &shape, input1, &success);
+  auto r = get_input<DTYPE_INPUT_2>(&ndim, &shape, input2, &success);
+  auto los = get_input<DTYPE_INPUT_3>(&ndim, &shape, input3, &success);
+  if (success) return 1;
+
+  std::vector<npy_intp> new_shape(ndim + 1);
+  npy_intp Nb = 1;
+  for (int i = 0; i < ndim; ++i) {
+    new_shape[i] = shape[i];
+    Nb *= shape[i];
+  }
+  new_shape[ndim] = nw;
+
+  auto f = allocate_output<DTYPE_OUTPUT_0>(ndim + 1, &(new_shape[0]),
+                                           TYPENUM_OUTPUT_0, output0, &success);
+  if (success) return 1;
+
+  // The normalized Agol coefficients for each channel
+  Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> cn(nw, Nu);
+  Eigen::Matrix<T, Eigen::Dynamic, 1> c(Nu);
+  for (npy_intp w = 0; w < nw; ++w) {
+    limbdark::getCl(Nu, u + w * Nu, c.data());
+    T norm = utils::pi<T>() * ((Nu > 1) ? c(0) + 2 * c(1) / 3 : c(0));
+    cn.row(w) = c.transpose() / norm;
+  }
+
+  // Compute the flux in all channels at once, with solvers
+  // specialized at compile time for low degrees
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    utils::parallelFor(
+        Nb, utils::getNumThreads(Nb), [&](int, size_t start, size_t end) {
+#define STARRY_LIMBDARK_KERNEL(L) \
+  APPLY_SPECIFIC(kernel)(L, cn, b, r, los, f, nw, start, end)
+          switch (Nu - 1) {
+            case 0: {
+              limbdark::GreensLimbDark<T, 0> L(0);
+              STARRY_LIMBDARK_KERNEL(L);
+            } break;
+            case 1: {
+              limbdark::GreensLimbDark<T, 1> L(1);
+              STARRY_LIMBDARK_KERNEL(L);
+            } break;
+            case 2: {
+              limbdark::GreensLimbDark<T, 2> L(2);
+              STARRY_LIMBDARK_KERNEL(L);
+            } break;
+            case 3: {
+              limbdark::GreensLimbDark<T, 3> L(3);
+              STARRY_LIMBDARK_KERNEL(L);
+            } break;
+            case 4: {
+              limbdark::GreensLimbDark<T, 4> L(4);
+              STARRY_LIMBDARK_KERNEL(L);
+            } break;
+            default: {
+              limbdark::GreensLimbDark<T> L(Nu - 1);
+              STARRY_LIMBDARK_KERNEL(L);
+            }
+          }
+#undef STARRY_LIMBDARK_KERNEL
+        });
+  } catch (std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_Format(PyExc_RuntimeError, "%s", error.c_str());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,55 @@
+# -*- coding: utf-8 -*-
+
+__all__ = ["LimbDarkFluxOp"]
+
+import theano
+import theano.tensor as tt
+from theano import gof
+from .base_op import LimbDarkBaseOp
+from .limbdark_flux_rev import LimbDarkFluxRevOp
+
+
+class LimbDarkFluxOp(LimbDarkBaseOp):
+    """Normalized limb-darkened occultation flux in many channels at once.
+
+    Takes the polynomial limb darkening coefficients ``u`` of shape
+    ``(nw, udeg + 1)`` and arrays ``b``, ``r``, ``los`` of the same shape,
+    and returns the flux with shape ``b.shape + (nw,)``. Unocculted points
+    have unit flux. The occultation solution is computed once per point
+    and shared by all channels.
+    """
+
+    __props__ = ()
+    func_file = "./limbdark_flux.cc"
+    func_name = "APPLY_SPECIFIC(limbdark_flux)"
+
+    def __init__(self):
+        self.grad_op = LimbDarkFluxRevOp()
+        super(LimbDarkFluxOp, self).__init__()
+
+    def make_node(self, u, b, r, los):
+        in_args = []
+        dtype = theano.config.floatX
+        for a in [u, b, r, los]:
+            a = tt.as_tensor_variable(a)
+            dtype = theano.scalar.upcast(dtype, a.dtype)
+            in_args.append(a)
+        out_args = [
+            tt.TensorType(
+                dtype=dtype, broadcastable=[False] * (in_args[1].ndim + 1)
+            )()
+        ]
+        return gof.Apply(self, in_args, out_args)
+
+    def infer_shape(self, node, shapes):
+        return (list(shapes[1]) + [shapes[0][0]],)
+
+    def grad(self, inputs, gradients):
+        u, b, r, los = inputs
+        bu, bb, br = self.grad_op(u, b, r, los, gradients[0])
+        return bu, bb, br, tt.zeros_like(los)
+
+    def R_op(self, inputs, eval_points):
+        if eval_points[0] is None:
+            return eval_points
+        return self.grad(inputs, eval_points)
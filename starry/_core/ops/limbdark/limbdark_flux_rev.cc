@@ -0,0 +1,157 @@
+#section support_code_apply
+
+/**
+Backprop the flux gradient `bf` at the points `[start, end)` onto `b`,
+`r` and the normalized coefficients `bcn` using the limb darkening
+solver `L`.
+
+*/
+template <class Solver, class Matrix, typename T1, typename T2, typename T3,
+          typename T4, typename T5, typename T6>
+inline void APPLY_SPECIFIC(kernel)(Solver& L, const Matrix& cn, const T1* b,
+                                   const T2* r, const T3* los, const T4* bf,
+                                   T5* bb, T6* br, Matrix& bcn, npy_intp nw,
+                                   size_t start, size_t end) {
+  using namespace starry;
+  typedef typename Matrix::Scalar T;
+  Eigen::Matrix<T, 1, Eigen::Dynamic> bfi(nw), g(cn.cols());
+  for (size_t i = start; i < end; ++i) {
+    bb[i] = 0;
+    br[i] = 0;
+    auto b_ = std::abs(b[i]);
+    auto r_ = std::abs(r[i]);
+    if ((los[i] > 0) && (b_ < 1 + r_)) {
+      L.template compute<true>(b_, r_);
+      for (npy_intp w = 0; w < nw; ++w) bfi(w) = bf[i * nw + w];
+      g.noalias() = bfi * cn;
+      bb[i] = sgn(b[i]) * L.dsTdb.dot(g);
+      br[i] = sgn(r[i]) * L.dsTdr.dot(g);
+      bcn.noalias() += bfi.transpose() * L.sT;
+    }
+  }
+}
+
+int APPLY_SPECIFIC(limbdark_flux_rev)(
+    PyArrayObject* input0,   // Array of "u", shape (nw, udeg + 1)
+    PyArrayObject* input1,   // Array of impact parameters "b"
+    PyArrayObject* input2,   // Array of radius ratios "r"
+    PyArrayObject* input3,   // Array of line-of-sight position "los"
+    PyArrayObject* input4,   // Gradient of the flux, shape b.shape + (nw,)
+    PyArrayObject** output0,  // bu
+    PyArrayObject** output1,  // bb
+    PyArrayObject** output2   // br
+) {
+  using namespace starry;
+  typedef DTYPE_OUTPUT_0 T;
+
+  int success = 0;
+  npy_intp nw, Nu;
+  auto u = get_matrix_input<DTYPE_INPUT_0>(&nw, &Nu, input0, &success);
+  if (success) return 1;
+  if (Nu < 1) {
+    PyErr_Format(PyExc_ValueError, "u must have at least one coefficient");
+    return 1;
+  }
+
+  int ndim = -1;
+  npy_intp* shape;
+  auto b = get_input<DTYPE_INPUT_1>(&ndim, &shape, input1, &success);
+  auto r = get_input<DTYPE_INPUT_2>(&ndim, &shape, input2, &success);
+  auto los = get_input<DTYPE_INPUT_3>(&ndim, &shape, input3, &success);
+  if (success) return 1;
+
+  std::vector<npy_intp> new_shape(ndim + 1);
+  npy_intp Nb = 1;
+  for (int i = 0; i < ndim; ++i) {
+    new_shape[i] = shape[i];
+    Nb *= shape[i];
+  }
+  new_shape[ndim] = nw;
+  auto bf = get_input<DTYPE_INPUT_4>(ndim + 1, &(new_shape[0]), input4,
+                                     &success);
+  if (success) return 1;
+
+  auto bu = allocate_output<DTYPE_OUTPUT_0>(
+      PyArray_NDIM(input0), PyArray_DIMS(input0), TYPENUM_OUTPUT_0, output0,
+      &success);
+  if (success) return 1;
+  auto bb = allocate_output<DTYPE_OUTPUT_1>(ndim, shape, TYPENUM_OUTPUT_1,
+                                            output1, &success);
+  if (success) return 1;
+  auto br = allocate_output<DTYPE_OUTPUT_2>(ndim, shape, TYPENUM_OUTPUT_2,
+                                            output2, &success);
+  if (success) return 1;
+
+  // The normalized Agol coefficients for each channel
+  Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> cn(nw, Nu);
+  Eigen::Matrix<T, Eigen::Dynamic, 1> norm(nw);
+  Eigen::Matrix<T, Eigen::Dynamic, 1> c(Nu);
+  for (npy_intp w = 0; w < nw; ++w) {
+    limbdark::getCl(Nu, u + w * Nu, c.data());
+    norm(w) = utils::pi<T>() * ((Nu > 1) ? c(0) + 2 * c(1) / 3 : c(0));
+    cn.row(w) = c.transpose() / norm(w);
+  }
+
+  // Backprop the flux onto `b`, `r` and the normalized
+  // coefficients; each thread accumulates its own `bcn`, with
+  // solvers specialized at compile time for low degrees
+  int nthreads = utils::getNumThreads(Nb);
+  std::vector<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> bcn(
+      nthreads, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(nw, Nu));
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    utils::parallelFor(Nb, nthreads, [&](int t, size_t start, size_t end) {
+#define STARRY_LIMBDARK_KERNEL(L) \
+  APPLY_SPECIFIC(kernel)(L, cn, b, r, los, bf, bb, br, bcn[t], nw, start, end)
+      switch (Nu - 1) {
+        case 0: {
+          limbdark::GreensLimbDark<T, 0> L(0);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        case 1: {
+          limbdark::GreensLimbDark<T, 1> L(1);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        case 2: {
+          limbdark::GreensLimbDark<T, 2> L(2);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        case 3: {
+          limbdark::GreensLimbDark<T, 3> L(3);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        case 4: {
+          limbdark::GreensLimbDark<T, 4> L(4);
+          STARRY_LIMBDARK_KERNEL(L);
+        } break;
+        default: {
+          limbdark::GreensLimbDark<T> L(Nu - 1);
+          STARRY_LIMBDARK_KERNEL(L);
+        }
+      }
+#undef STARRY_LIMBDARK_KERNEL
+    });
+  } catch (std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_Format(PyExc_RuntimeError, "%s", error.c_str());
+    return 1;
+  }
+  for (int t = 1; t < nthreads; ++t) bcn[0] += bcn[t];
+
+  // Backprop through the normalization and onto `u`
+  Eigen::Matrix<T, Eigen::Dynamic, 1> bc(Nu), dnormdc(Nu);
+  dnormdc.setZero();
+  dnormdc(0) = utils::pi<T>();
+  if (Nu > 1) dnormdc(1) = 2 * utils::pi<T>() / 3;
+  for (npy_intp w = 0; w < nw; ++w) {
+    bc = (bcn[0].row(w).transpose() - bcn[0].row(w).dot(cn.row(w)) * dnormdc) /
+         norm(w);
+    limbdark::getClRev(Nu, bc.data(), bu + w * Nu);
+  }
+
+  return 0;
+}
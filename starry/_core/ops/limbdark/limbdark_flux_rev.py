@@ -0,0 +1,22 @@
+# -*- coding: utf-8 -*-
+
+__all__ = ["LimbDarkFluxRevOp"]
+
+import theano.tensor as tt
+from theano import gof
+from .base_op import LimbDarkBaseOp
+
+
+class LimbDarkFluxRevOp(LimbDarkBaseOp):
+
+    __props__ = ()
+    func_file = "./limbdark_flux_rev.cc"
+    func_name = "APPLY_SPECIFIC(limbdark_flux_rev)"
+
+    def make_node(self, u, b, r, los, bf):
+        in_args = [tt.as_tensor_variable(a) for a in [u, b, r, los, bf]]
+        out_args = [in_args[0].type(), in_args[1].type(), in_args[2].type()]
+        return gof.Apply(self, in_args, out_args)
+
+    def infer_shape(self, node, shapes):
+        return shapes[0], shapes[1], shapes[2]
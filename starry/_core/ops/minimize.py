@@ -144,6 +144,9 @@ class LDPhysicalOp(tt.Op):
     """
     Check whether a limb darkening profile is physical using Sturm's theorem.
 
+    If `u` is a matrix, each of its rows is checked in a single batched
+    call and the result is a vector.
+
     """
 
     def __init__(self, nroots):
@@ -151,29 +154,33 @@ class LDPhysicalOp(tt.Op):
 
     def make_node(self, *inputs):
         inputs = [tt.as_tensor_variable(i) for i in inputs]
-        outputs = [tt.bscalar()]
+        if inputs[0].ndim > 1:
+            outputs = [tt.bvector()]
+        else:
+            outputs = [tt.bscalar()]
         return gof.Apply(self, inputs, outputs)
 
     def infer_shape(self, node, shapes):
-        return [()]
+        if node.inputs[0].ndim > 1:
+            return [shapes[0][:1]]
+        else:
+            return [()]
 
     def perform(self, node, inputs, outputs):
-        u = inputs[0]
-        outputs[0][0] = 1
+        u = np.atleast_2d(inputs[0])
 
         # Ensure the function is *decreasing* toward the limb
-        if u.sum() < -1:
-            outputs[0][0] = 0
-            return
+        physical = ~(u.sum(axis=1) < -1)
 
         # Sturm's theorem on the intensity to ensure positivity
-        p = u[::-1]
-        if self.nroots(p, 0, 1) > 0:
-            outputs[0][0] = 0
-            return
+        p = u[:, ::-1]
+        physical &= self.nroots(p, 0, 1) == 0
 
         # Sturm's theorem on the derivative to ensure monotonicity
-        p = (u[1:] * np.arange(1, len(u)))[::-1]
-        if self.nroots(p, 0, 1) > 0:
-            outputs[0][0] = 0
-            return
+        p = (u[:, 1:] * np.arange(1, u.shape[1]))[:, ::-1]
+        physical &= self.nroots(p, 0, 1) == 0
+
+        if inputs[0].ndim > 1:
+            outputs[0][0] = np.array(physical, dtype=np.int8)
+        else:
+            outputs[0][0] = np.array(physical[0], dtype=np.int8)
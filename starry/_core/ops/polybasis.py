@@ -3,6 +3,7 @@ import numpy as np
 import theano
 from theano import gof
 import theano.tensor as tt
+from ..utils import output_storage
 
 __all__ = ["pTOp"]
 
@@ -23,7 +24,9 @@ class pTOp(tt.Op):
         return [[shapes[0][0], self.N]]
 
     def perform(self, node, inputs, outputs):
-        outputs[0][0] = self.func(*inputs)
+        out = output_storage(outputs[0], (np.shape(inputs[0])[0], self.N))
+        self.func(*inputs, out=out)
+        outputs[0][0] = out
 
     def grad(self, inputs, gradients):
         return self._grad_op(*(inputs + gradients))
@@ -0,0 +1,69 @@
+# -*- coding: utf-8 -*-
+import numpy as np
+import theano
+from theano import gof
+import theano.tensor as tt
+from ..utils import output_storage
+
+__all__ = ["RenderOp"]
+
+
+class RenderOp(tt.Op):
+    """
+    Render polynomial maps on a ``res x res`` image. The inputs are the
+    resolution, the projection and the polynomial coefficients of each
+    frame (one per column); the output is the ``res^2 x nframes`` image.
+    The polynomial basis is evaluated one tile of pixels at a time, so it
+    is never formed in full.
+
+    """
+
+    def __init__(self, func):
+        self.func = func
+        self._grad_op = RenderGradientOp(self)
+
+    def make_node(self, *inputs):
+        inputs = [
+            tt.as_tensor_variable(inputs[0]).astype("int32"),
+            tt.as_tensor_variable(inputs[1]).astype("int32"),
+            tt.as_tensor_variable(inputs[2]),
+        ]
+        outputs = [inputs[2].type()]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        res = node.inputs[0]
+        return [(res * res, shapes[2][1])]
+
+    def connection_pattern(self, node):
+        return [[False], [False], [True]]
+
+    def perform(self, node, inputs, outputs):
+        res, projection, P = inputs
+        out = output_storage(outputs[0], (res * res, np.shape(P)[1]))
+        self.func(int(res), int(projection), P, out=out)
+        outputs[0][0] = out
+
+    def grad(self, inputs, gradients):
+        return [
+            theano.gradient.DisconnectedType()(),
+            theano.gradient.DisconnectedType()(),
+            self._grad_op(*(inputs + gradients)),
+        ]
+
+
+class RenderGradientOp(tt.Op):
+    def __init__(self, base_op):
+        self.base_op = base_op
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [inputs[2].type()]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return [shapes[2]]
+
+    def perform(self, node, inputs, outputs):
+        res, projection, P, bimage = inputs
+        outputs[0][0] = self.base_op.func(int(res), int(projection), P, bimage)
@@ -4,8 +4,9 @@ import numpy as np
 from theano import gof
 import theano.tensor as tt
 import theano.sparse as ts
+from ..utils import output_storage
 
-__all__ = ["dotROp", "tensordotRzOp"]
+__all__ = ["dotROp", "tensordotRzOp", "dotProjectionOp"]
 
 
 class dotROp(tt.Op):
@@ -27,7 +28,11 @@ class dotROp(tt.Op):
         return self.grad(inputs, eval_points)
 
     def perform(self, node, inputs, outputs):
-        outputs[0][0] = self.func(*inputs)
+        M = inputs[0]
+        npts = np.shape(M)[0] if np.ndim(M) == 2 else 1
+        out = output_storage(outputs[0], (npts, np.shape(M)[-1]))
+        self.func(*inputs, out=out)
+        outputs[0][0] = out
 
     def grad(self, inputs, gradients):
         return self._grad_op(*(inputs + gradients))
@@ -73,7 +78,10 @@ class tensordotRzOp(tt.Op):
         return self.grad(inputs, eval_points)
 
     def perform(self, node, inputs, outputs):
-        outputs[0][0] = self.func(*inputs)
+        M, theta = inputs
+        out = output_storage(outputs[0], (np.shape(theta)[0], np.shape(M)[-1]))
+        self.func(M, theta, out=out)
+        outputs[0][0] = out
 
     def grad(self, inputs, gradients):
         return self._grad_op(*(inputs + gradients))
@@ -95,3 +103,54 @@ class tensordotRzGradientOp(tt.Op):
         bM, btheta = self.base_op.func(*inputs)
         outputs[0][0] = np.reshape(bM, np.shape(inputs[0]))
         outputs[1][0] = np.reshape(btheta, np.shape(inputs[1]))
+
+
+class dotProjectionOp(tt.Op):
+    def __init__(self, func):
+        self.func = func
+        self._grad_op = dotProjectionGradientOp(self)
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [tt.TensorType(inputs[0].dtype, (False, False))()]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        nrows = shapes[0][0]
+        npts = tt.switch(tt.eq(nrows, 1), shapes[3][0], nrows)
+        return [[npts, shapes[0][-1]]]
+
+    def R_op(self, inputs, eval_points):
+        if eval_points[0] is None:
+            return eval_points
+        return self.grad(inputs, eval_points)
+
+    def perform(self, node, inputs, outputs):
+        M, inc, obl, theta = inputs
+        npts = np.shape(theta)[0] if np.shape(M)[0] == 1 else np.shape(M)[0]
+        out = output_storage(outputs[0], (npts, np.shape(M)[-1]))
+        self.func(M, inc, obl, theta, out=out)
+        outputs[0][0] = out
+
+    def grad(self, inputs, gradients):
+        return self._grad_op(*(inputs + gradients))
+
+
+class dotProjectionGradientOp(tt.Op):
+    def __init__(self, base_op):
+        self.base_op = base_op
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [i.type() for i in inputs[:-1]]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return shapes[:-1]
+
+    def perform(self, node, inputs, outputs):
+        bM, binc, bobl, btheta = self.base_op.func(*inputs)
+        outputs[0][0] = np.reshape(bM, np.shape(inputs[0]))
+        outputs[1][0] = np.reshape(binc, np.shape(inputs[1]))
+        outputs[2][0] = np.reshape(bobl, np.shape(inputs[2]))
+        outputs[3][0] = np.reshape(btheta, np.shape(inputs[3]))
@@ -0,0 +1,62 @@
+# -*- coding: utf-8 -*-
+import numpy as np
+import theano
+from theano import gof
+import theano.tensor as tt
+
+__all__ = ["SemiseparableOp"]
+
+
+class SemiseparableOp(tt.Op):
+    """
+    Solve the linear system `C Z = Y` for a semiseparable matrix `C`
+    and compute its log determinant. The inputs are the diagonal `A`
+    and the generators `U`, `V` and `P` of `C` (see `linalg.h`) and
+    the right hand side `Y`; the outputs are `Z` and `log |C|`.
+
+    """
+
+    def __init__(self, func):
+        self.func = func
+        self._grad_op = SemiseparableGradientOp(self)
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [inputs[-1].type(), tt.TensorType(inputs[-1].dtype, ())()]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return [shapes[-1], ()]
+
+    def perform(self, node, inputs, outputs):
+        Z, lndet = self.func(*inputs)
+        outputs[0][0] = Z
+        outputs[1][0] = np.array(lndet)
+
+    def grad(self, inputs, gradients):
+        results = self(*inputs)
+        gradients = [
+            tt.zeros_like(r)
+            if isinstance(g.type, theano.gradient.DisconnectedType)
+            else g
+            for r, g in zip(results, gradients)
+        ]
+        return self._grad_op(*(inputs + gradients))
+
+
+class SemiseparableGradientOp(tt.Op):
+    def __init__(self, base_op):
+        self.base_op = base_op
+
+    def make_node(self, *inputs):
+        inputs = [tt.as_tensor_variable(i) for i in inputs]
+        outputs = [i.type() for i in inputs[:-2]]
+        return gof.Apply(self, inputs, outputs)
+
+    def infer_shape(self, node, shapes):
+        return shapes[:-2]
+
+    def perform(self, node, inputs, outputs):
+        res = self.base_op.func(*inputs)
+        for i in range(len(outputs)):
+            outputs[i][0] = np.reshape(res[i], np.shape(inputs[i]))
@@ -10,7 +10,7 @@ import logging
 
 logger = logging.getLogger("starry.ops")
 
-__all__ = ["logger", "autocompile"]
+__all__ = ["logger", "autocompile", "output_storage"]
 
 
 integers = (int, np.int, np.int16, np.int32, np.int64)
@@ -44,6 +44,28 @@ class CompileLogMessage:
         logger.info("Done.")
 
 
+def output_storage(storage, shape):
+    """
+    Return an array the C++ ops can write their output into in place.
+
+    This is the array currently held in the Theano output ``storage``
+    cell if it is a writeable, C-contiguous float64 array of the
+    given ``shape``; otherwise, a new array is allocated.
+
+    """
+    out = storage[0]
+    shape = tuple(int(s) for s in shape)
+    if (
+        isinstance(out, np.ndarray)
+        and out.shape == shape
+        and out.dtype == np.float64
+        and out.flags.c_contiguous
+        and out.flags.writeable
+    ):
+        return out
+    return np.empty(shape)
+
+
 def _get_type(arg):
     """
     Get the theano tensor type corresponding to `arg`.
@@ -2,7 +2,7 @@
 from . import config
 from ._constants import *
 from .maps import MapBase, RVBase, ReflectedBase
-from ._core import OpsSystem, math, linalg
+from ._core import OpsSystem, SystemDesignMatrix, math, linalg
 import numpy as np
 from astropy import units
 from inspect import getmro
@@ -403,6 +403,13 @@ class System(object):
             be one of the following: ``0`` for a centered Riemann sum
             (equivalent to the "resampling" procedure suggested by Kipping 2010),
             ``1`` for the trapezoid rule, or ``2`` for Simpson’s rule.
+
+    .. note::
+        If all bodies are purely limb-darkened, the exposure time
+        integration is instead done adaptively (to an absolute tolerance
+        of ``1e-8``) in the occultation solver, using a second order
+        expansion of the orbits about the middle of each exposure. In this
+        case ``oversample`` and ``order`` are ignored.
     """
 
     def _no_spectral(self):
@@ -804,7 +811,7 @@ class System(object):
             for sec in self._secondaries:
                 sec.map._unset_RV_filter()
 
-    def design_matrix(self, t):
+    def design_matrix(self, t, structured=False):
         """Compute the system flux design matrix at times ``t``.
 
         .. note::
@@ -822,8 +829,23 @@ class System(object):
         Args:
             t (scalar or vector): An array of times at which to evaluate
                 the design matrix in units of :py:attr:`time_unit`.
+            structured (bool, optional): Return a
+                :py:class:`SystemDesignMatrix` instead of a dense matrix?
+                This stores the rotational phase curve of each body as
+                a low-rank product and only keeps the rows of the
+                occulted cadences in full, which saves memory and
+                speeds up :py:meth:`solve` and :py:meth:`lnlike`. It is
+                only available in greedy mode, for bodies in emitted
+                light with no differential rotation and zero exposure
+                time. Default is False.
         """
-        return self.ops.X(
+        if structured and config.lazy:
+            raise ValueError(
+                "Structured design matrices are only available "
+                "in greedy mode."
+            )
+        X = self.ops.X_structured if structured else self.ops.X
+        return X(
             math.reshape(math.to_array_or_tensor(t), [-1]) * self._time_factor,
             self._primary._r,
             self._primary._m,
@@ -996,6 +1018,38 @@ class System(object):
         )
         return (x / fac, y / fac, z / fac)
 
+    def _can_structure(self):
+        """Can we use a structured design matrix to solve the problem?"""
+        return (
+            not config.lazy
+            and not self._reflected
+            and self._texp == 0.0
+            and self._primary._map.nw is None
+            and self._C.kind in ["scalar", "vector"]
+            and all([np.all(body.map._alpha == 0.0) for body in self._bodies])
+        )
+
+    def _normal_equations(self, X):
+        """Return the normal equations for a structured design matrix."""
+        if self._C.kind not in ["scalar", "vector"]:
+            raise ValueError(
+                "Structured design matrices require a scalar or "
+                "vector data covariance."
+            )
+        return X.normal_equations(self._flux, self._C.inverse)
+
+    def _reduce_normal_equations(self, W, b, fCInvf, c, inds):
+        """
+        Subtract the contribution of the bodies with fixed coefficients
+        ``c`` from the normal equations and keep only the terms ``inds``
+        we'll solve for.
+        """
+        Wc = np.dot(W, c)
+        fCInvf = fCInvf + np.dot(c, Wc) - 2 * np.dot(c, b)
+        b = (b - Wc)[inds]
+        W = W[np.ix_(inds, inds)]
+        return W, b, fCInvf
+
     def _get_periods(self):
         periods = [None for sec in self._secondaries]
         for i, sec in enumerate(self._secondaries):
@@ -1023,7 +1077,12 @@ class System(object):
                 a scalar, in which case the noise is assumed to be
                 homoscedastic, a vector, in which case the covariance
                 is assumed to be diagonal, or a matrix specifying the full
-                covariance of the dataset. Default is None. Either `C` or
+                covariance of the dataset. It may also be an instance of
+                :py:class:`starry.linalg.Semiseparable` or
+                :py:class:`starry.linalg.Banded` describing correlated
+                noise, in which case the cost of :py:meth:`solve` and
+                :py:meth:`lnlike` scales linearly with the number of data
+                points. Default is None. Either `C` or
                 `cho_C` must be provided.
             cho_C (matrix): The lower Cholesky factorization of the data
                 covariance matrix. Defaults to None. Either `C` or
@@ -1046,9 +1105,13 @@ class System(object):
             design_matrix (matrix, optional): The flux design matrix, the
                 quantity returned by :py:meth:`design_matrix`. Default is
                 None, in which case this is computed based on ``kwargs``.
+                This may also be a structured design matrix, in which case
+                the data covariance must be a scalar or a vector.
             t (vector, optional): The vector of times at which to evaluate
                 :py:meth:`design_matrix`, if a design matrix is not provided.
-                Default is None.
+                Default is None. In greedy mode, with a scalar or vector
+                data covariance, the design matrix is computed in
+                structured form whenever possible.
 
         Returns:
             The posterior mean for the spherical harmonic \
@@ -1071,8 +1134,16 @@ class System(object):
         # Get the full design matrix
         if design_matrix is None:
             assert t is not None, "Please provide a time vector `t`."
-            design_matrix = self.design_matrix(t)
-        X = math.cast(design_matrix)
+            design_matrix = self.design_matrix(
+                t, structured=self._can_structure()
+            )
+        structured = isinstance(design_matrix, SystemDesignMatrix)
+        if structured:
+            X = design_matrix
+            W, b, fCInvf = self._normal_equations(X)
+            c = np.zeros(X.shape[1])
+        else:
+            X = math.cast(design_matrix)
 
         # Get the data vector
         f = math.cast(self._flux)
@@ -1087,7 +1158,12 @@ class System(object):
 
                 # Subtract out this term from the data vector,
                 # since it is fixed
-                f -= body.map.amp * math.dot(X[:, self._inds[k]], body.map.y)
+                if structured:
+                    c[self._inds[k]] = body.map.amp * body.map.y
+                else:
+                    f -= body.map.amp * math.dot(
+                        X[:, self._inds[k]], body.map.y
+                    )
 
             else:
 
@@ -1102,7 +1178,10 @@ class System(object):
             raise ValueError("Please provide a prior for at least one body.")
 
         # Keep only the terms we'll solve for
-        X = X[:, inds]
+        if structured:
+            W, b, fCInvf = self._reduce_normal_equations(W, b, fCInvf, c, inds)
+        else:
+            X = X[:, inds]
 
         # Stack our priors
         mu = math.concatenate([body.map._mu for body in self._solved_bodies])
@@ -1126,7 +1205,19 @@ class System(object):
             )
 
         # Compute the MAP solution
-        self._solution = linalg.solve(X, f, self._C.cholesky, mu, LInv)
+        if structured:
+            self._solution = linalg.solve_normal(W, b, mu, LInv)
+        elif self._C.kind == "semiseparable":
+            C = self._C.value
+            self._solution = linalg.solve_semiseparable(
+                X, f, C.t, C.diag, C.a, C.c, mu, LInv
+            )
+        elif self._C.kind == "banded":
+            self._solution = linalg.solve_banded(
+                X, f, self._C.value.bands, mu, LInv
+            )
+        else:
+            self._solution = linalg.solve(X, f, self._C.cholesky, mu, LInv)
 
         # Set all the map vectors
         x, _ = self._solution
@@ -1200,9 +1291,13 @@ class System(object):
             design_matrix (matrix, optional): The flux design matrix, the
                 quantity returned by :py:meth:`design_matrix`. Default is
                 None, in which case this is computed based on ``kwargs``.
+                This may also be a structured design matrix, in which case
+                the data covariance must be a scalar or a vector.
             t (vector, optional): The vector of times at which to evaluate
                 :py:meth:`design_matrix`, if a design matrix is not provided.
-                Default is None.
+                Default is None. In greedy mode, with a scalar or vector
+                data covariance, the design matrix is computed in
+                structured form whenever possible.
             woodbury (bool, optional): Solve the linear problem using the
                 Woodbury identity? Default is True. The
                 `Woodbury identity <https://en.wikipedia.org/wiki/Woodbury_matrix_identity>`_
@@ -1228,8 +1323,16 @@ class System(object):
         # Get the full design matrix
         if design_matrix is None:
             assert t is not None, "Please provide a time vector `t`."
-            design_matrix = self.design_matrix(t)
-        X = math.cast(design_matrix)
+            design_matrix = self.design_matrix(
+                t, structured=woodbury and self._can_structure()
+            )
+        structured = isinstance(design_matrix, SystemDesignMatrix)
+        if structured:
+            X = design_matrix
+            W, b, fCInvf = self._normal_equations(X)
+            c = np.zeros(X.shape[1])
+        else:
+            X = math.cast(design_matrix)
 
         # Get the data vector
         f = math.cast(self._flux)
@@ -1244,7 +1347,12 @@ class System(object):
 
                 # Subtract out this term from the data vector,
                 # since it is fixed
-                f -= body.map.amp * math.dot(X[:, self._inds[k]], body.map.y)
+                if structured:
+                    c[self._inds[k]] = body.map.amp * body.map.y
+                else:
+                    f -= body.map.amp * math.dot(
+                        X[:, self._inds[k]], body.map.y
+                    )
 
             else:
 
@@ -1259,13 +1367,20 @@ class System(object):
             raise ValueError("Please provide a prior for at least one body.")
 
         # Keep only the terms we'll solve for
-        X = X[:, inds]
+        if structured:
+            W, b, fCInvf = self._reduce_normal_equations(W, b, fCInvf, c, inds)
+        else:
+            X = X[:, inds]
 
         # Stack our priors
         mu = math.concatenate([body.map._mu for body in self._solved_bodies])
 
         # Compute the likelihood
-        if woodbury:
+        if (
+            woodbury
+            or structured
+            or self._C.kind in ["semiseparable", "banded"]
+        ):
             if not dense_L:
                 # We can just concatenate vectors
                 LInv = math.concatenate(
@@ -1284,6 +1399,19 @@ class System(object):
             lndetL = math.cast(
                 [body.map._L.lndet for body in self._solved_bodies]
             )
+            if structured:
+                return linalg.lnlike_normal(
+                    W, b, fCInvf, X.shape[0], mu, LInv, self._C.lndet, lndetL
+                )
+            elif self._C.kind == "semiseparable":
+                C = self._C.value
+                return linalg.lnlike_semiseparable(
+                    X, f, C.t, C.diag, C.a, C.c, mu, LInv, lndetL
+                )
+            elif self._C.kind == "banded":
+                return linalg.lnlike_banded(
+                    X, f, self._C.value.bands, mu, LInv, lndetL
+                )
             return linalg.lnlike_woodbury(
                 X, f, self._C.inverse, mu, LInv, self._C.lndet, lndetL
             )
@@ -1,6 +1,15 @@
 # -*- coding: utf-8 -*-
+from . import _c_ops
 from ._core import math, linalg
+from ._core.math import _to_matrix
 import numpy as np
+from scipy.linalg import cho_solve
+
+#: A semiseparable data covariance; see :py:class:`linalg.Semiseparable`
+Semiseparable = linalg.Semiseparable
+
+#: A banded data covariance; see :py:class:`linalg.Banded`
+Banded = linalg.Banded
 
 
 def solve(
@@ -25,7 +34,9 @@ def solve(
             a scalar, in which case the noise is assumed to be
             homoscedastic, a vector, in which case the covariance
             is assumed to be diagonal, or a matrix specifying the full
-            covariance of the dataset. Default is None. Either `C` or
+            covariance of the dataset. It may also be a
+            :py:class:`Semiseparable` or :py:class:`Banded` covariance
+            describing correlated noise. Default is None. Either `C` or
             `cho_C` must be provided.
         cho_C (matrix): The lower Cholesky factorization of the data
             covariance matrix. Defaults to None. Either `C` or
@@ -74,6 +85,21 @@ def solve(
     if mu.ndim == 0:
         mu = mu * math.ones(N)
     L = linalg.Covariance(L, cho_L, N=N)
+    if C.kind == "semiseparable":
+        return linalg.solve_semiseparable(
+            design_matrix,
+            data,
+            C.value.t,
+            C.value.diag,
+            C.value.a,
+            C.value.c,
+            mu,
+            L.inverse,
+        )
+    elif C.kind == "banded":
+        return linalg.solve_banded(
+            design_matrix, data, C.value.bands, mu, L.inverse
+        )
     return linalg.solve(design_matrix, data, C.cholesky, mu, L.inverse)
 
 
@@ -100,7 +126,9 @@ def lnlike(
             a scalar, in which case the noise is assumed to be
             homoscedastic, a vector, in which case the covariance
             is assumed to be diagonal, or a matrix specifying the full
-            covariance of the dataset. Default is None. Either `C` or
+            covariance of the dataset. It may also be a
+            :py:class:`Semiseparable` or :py:class:`Banded` covariance
+            describing correlated noise. Default is None. Either `C` or
             `cho_C` must be provided.
         cho_C (matrix): The lower Cholesky factorization of the data
             covariance matrix. Defaults to None. Either `C` or
@@ -158,9 +186,129 @@ def lnlike(
     if mu.ndim == 0:
         mu = mu * math.ones(N)
     L = linalg.Covariance(L, cho_L, N=N)
-    if woodbury:
+    if C.kind == "semiseparable":
+        return linalg.lnlike_semiseparable(
+            design_matrix,
+            data,
+            C.value.t,
+            C.value.diag,
+            C.value.a,
+            C.value.c,
+            mu,
+            L.inverse,
+            L.lndet,
+        )
+    elif C.kind == "banded":
+        return linalg.lnlike_banded(
+            design_matrix, data, C.value.bands, mu, L.inverse, L.lndet
+        )
+    elif woodbury:
         return linalg.lnlike_woodbury(
             design_matrix, data, C.inverse, mu, L.inverse, C.lndet, L.lndet
         )
     else:
         return linalg.lnlike(design_matrix, data, C.value, mu, L.value)
+
+
+class Posterior(object):
+    """
+    The posterior of a generalized least squares (GLS) problem, updated
+    incrementally as data points are added or removed.
+
+    At any point, :py:attr:`solution` is the same as what :py:func:`solve`
+    would return given all the data added so far. However, adding or
+    removing ``k`` data points only costs ``O(k N^2)`` for ``N`` regression
+    coefficients, rather than solving the whole problem from scratch.
+    The data covariance must be diagonal. This class works with
+    numerical values only.
+
+    Args:
+        mu (scalar or vector): The prior mean on the regression coefficients.
+            Default is zero.
+        L (scalar, vector, or matrix): The prior covariance. This may be
+            a scalar, in which case the covariance is assumed to be
+            homoscedastic, a vector, in which case the covariance
+            is assumed to be diagonal, or a matrix specifying the full
+            prior covariance. Default is None. Either `L` or
+            `cho_L` must be provided.
+        cho_L (matrix): The lower Cholesky factorization of the prior
+            covariance matrix. Defaults to None. Either `L` or
+            `cho_L` must be provided.
+        N (int, optional): The number of regression coefficients. This is
+            necessary only if both ``mu`` and ``L`` are provided as scalars.
+
+    """
+
+    def __init__(self, *, mu=0.0, L=None, cho_L=None, N=None):
+        if L is None and cho_L is None:
+            raise ValueError(
+                "Either the prior covariance or its "
+                "Cholesky factorization must be provided."
+            )
+        elif L is not None:
+            L = np.array(L, dtype="float64")
+            if L.ndim < 2:
+                LInv = 1.0 / L
+            else:
+                LInv = np.linalg.inv(L)
+        else:
+            cho_L = np.array(cho_L, dtype="float64")
+            LInv = cho_solve((cho_L, True), np.eye(cho_L.shape[0]))
+        mu = np.array(mu, dtype="float64")
+        if mu.ndim > 0:
+            N = mu.shape[0]
+        elif LInv.ndim > 0:
+            N = LInv.shape[0]
+        assert (
+            N is not None
+        ), "Please provide the number of coefficients ``N``."
+        mu = mu * np.ones(N)
+        self._posterior = _c_ops.Posterior(mu, _to_matrix(LInv, N))
+
+    def _update(self, design_matrix, data, C, sign):
+        design_matrix = np.ascontiguousarray(
+            np.atleast_2d(design_matrix), dtype="float64"
+        )
+        data = np.atleast_1d(np.array(data, dtype="float64"))
+        if C is None:
+            raise ValueError("Please provide the data covariance `C`.")
+        C = np.atleast_1d(np.array(C, dtype="float64"))
+        if C.ndim > 1:
+            raise ValueError(
+                "The data covariance must be a scalar or a vector."
+            )
+        self._posterior.update(design_matrix, data, 1.0 / C, sign)
+
+    def add(self, design_matrix, data, *, C=None):
+        """
+        Add data points to the problem.
+
+        Args:
+            design_matrix (matrix): The rows of the design matrix
+                corresponding to the new data points.
+            data (vector): The new data points.
+            C (scalar or vector): The variance of the new data points.
+        """
+        self._update(design_matrix, data, C, 1)
+
+    def remove(self, design_matrix, data, *, C=None):
+        """
+        Remove data points that were previously added to the problem.
+
+        Args:
+            design_matrix (matrix): The rows of the design matrix
+                corresponding to the data points to remove.
+            data (vector): The data points to remove.
+            C (scalar or vector): The variance of the data points to remove.
+        """
+        self._update(design_matrix, data, C, -1)
+
+    @property
+    def solution(self):
+        """
+        A tuple containing the posterior mean for the regression
+        coefficients (a vector) and the Cholesky factorization of the
+        posterior covariance (a lower triangular matrix).
+        """
+        return self._posterior.yhat, self._posterior.cho_ycov
+
@@ -658,7 +658,12 @@ class MapBase(object):
                 a scalar, in which case the noise is assumed to be
                 homoscedastic, a vector, in which case the covariance
                 is assumed to be diagonal, or a matrix specifying the full
-                covariance of the dataset. Default is None. Either `C` or
+                covariance of the dataset. It may also be an instance of
+                :py:class:`starry.linalg.Semiseparable` or
+                :py:class:`starry.linalg.Banded` describing correlated
+                noise, in which case the cost of :py:meth:`solve` and
+                :py:meth:`lnlike` scales linearly with the number of data
+                points. Default is None. Either `C` or
                 `cho_C` must be provided.
             cho_C (matrix): The lower Cholesky factorization of the data
                 covariance matrix. Defaults to None. Either `C` or
@@ -747,15 +752,64 @@ class MapBase(object):
         elif self._mu is None or self._L is None:
             raise ValueError("Please provide a prior with `set_prior()`.")
 
-        # Get the design matrix & remove any amplitude weighting
-        if design_matrix is None:
-            design_matrix = self.design_matrix(**kwargs)
-        X = math.cast(design_matrix)
+        # If we can, reduce the design matrix straight into the
+        # normal equations without ever storing it in memory
+        if (
+            design_matrix is None
+            and not config.lazy
+            and getattr(self.ops, "streaming", False)
+            and self._C.kind in ["scalar", "vector"]
+        ):
+            theta, xo, yo, zo, ro = self._get_flux_kwargs(kwargs)
+            self._check_kwargs("solve", kwargs)
+            self._solution = self.ops.solve(
+                theta,
+                xo,
+                yo,
+                zo,
+                ro,
+                self._inc,
+                self._obl,
+                self._u,
+                self._f,
+                self._flux,
+                self._C.inverse,
+                self._mu,
+                self._L.inverse,
+            )
 
-        # Compute the MAP solution
-        self._solution = linalg.solve(
-            X, self._flux, self._C.cholesky, self._mu, self._L.inverse
-        )
+        else:
+
+            # Get the design matrix & remove any amplitude weighting
+            if design_matrix is None:
+                design_matrix = self.design_matrix(**kwargs)
+            X = math.cast(design_matrix)
+
+            # Compute the MAP solution
+            if self._C.kind == "semiseparable":
+                C = self._C.value
+                self._solution = linalg.solve_semiseparable(
+                    X,
+                    self._flux,
+                    C.t,
+                    C.diag,
+                    C.a,
+                    C.c,
+                    self._mu,
+                    self._L.inverse,
+                )
+            elif self._C.kind == "banded":
+                self._solution = linalg.solve_banded(
+                    X,
+                    self._flux,
+                    self._C.value.bands,
+                    self._mu,
+                    self._L.inverse,
+                )
+            else:
+                self._solution = linalg.solve(
+                    X, self._flux, self._C.cholesky, self._mu, self._L.inverse
+                )
 
         # Set the amplitude and coefficients
         x, _ = self._solution
@@ -809,7 +863,29 @@ class MapBase(object):
         X = math.cast(design_matrix)
 
         # Compute the likelihood
-        if woodbury:
+        if self._C.kind == "semiseparable":
+            C = self._C.value
+            return linalg.lnlike_semiseparable(
+                X,
+                self._flux,
+                C.t,
+                C.diag,
+                C.a,
+                C.c,
+                self._mu,
+                self._L.inverse,
+                self._L.lndet,
+            )
+        elif self._C.kind == "banded":
+            return linalg.lnlike_banded(
+                X,
+                self._flux,
+                self._C.value.bands,
+                self._mu,
+                self._L.inverse,
+                self._L.lndet,
+            )
+        elif woodbury:
             return linalg.lnlike_woodbury(
                 X,
                 self._flux,
@@ -1713,9 +1789,10 @@ class ReflectedBase(object):
     unity, a uniform unit-amplitude map will emit a flux of unity when viewed
     at noon.
 
-    This class does not currently support occultations. If an occultation
-    does occur, a ``ValueError`` will be raised. Support for occultations in
-    reflected light will be added in an upcoming version, so stay tuned.
+    Occultations are computed by integrating the illuminated map over the
+    visible part of the day side, whose boundary consists of arcs of the
+    limb, the terminator, and the occultor. The line integrals along these
+    arcs are evaluated with Gauss-Legendre quadrature.
 
     .. note::
         Instantiate this class by calling
@@ -1767,10 +1844,6 @@ class ReflectedBase(object):
                 this body's radius.
             theta (scalar or vector, optional): Angular phase of the body
                 in units of :py:attr:`angle_unit`.
-
-        .. note::
-            ``starry`` does not yet support occultations in reflected light.
-
         """
         # Orbital kwargs
         theta, xs, ys, zs, xo, yo, zo, ro = self._get_flux_kwargs(kwargs)
@@ -1816,10 +1889,6 @@ class ReflectedBase(object):
                 this body's radius.
             theta (scalar or vector, optional): Angular phase of the body
                 in units of :py:attr:`angle_unit`.
-
-        .. note::
-            ``starry`` does not yet support occultations in reflected light.
-
         """
         # Orbital kwargs
         theta, xs, ys, zs, xo, yo, zo, ro = self._get_flux_kwargs(kwargs)
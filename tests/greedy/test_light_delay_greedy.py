@@ -10,4 +10,32 @@ def test_light_delay():
     sys = starry.System(pri, sec, light_delay=True)
     assert sys.light_delay is True
 
-    # TODO: Add tests here.
+
+def test_retarded_position():
+    """The apparent position at `t` is the true one at `t + z / c`."""
+    from starry._constants import G_grav, c_light
+
+    t = np.linspace(-0.5, 0.5, 100)
+    args = (1.0, [0.001], [0.0], [1.0], [0.2], [1.0], [0.3], [1.5], G_grav)
+    x, y, z, vx, vy, vz = starry._c_ops.kepler(t, *args, c_light)
+    tret = t + z[:, 0] / c_light
+    x0, y0, z0, vx0, vy0, vz0 = starry._c_ops.kepler(tret, *args, 0.0)
+    assert np.allclose(x, x0, rtol=1e-12, atol=1e-12)
+    assert np.allclose(y, y0, rtol=1e-12, atol=1e-12)
+    assert np.allclose(z, z0, rtol=1e-12, atol=1e-12)
+    assert np.allclose(vx, vx0, rtol=1e-12, atol=1e-12)
+    assert np.allclose(vy, vy0, rtol=1e-12, atol=1e-12)
+    assert np.allclose(vz, vz0, rtol=1e-12, atol=1e-12)
+
+
+def test_primary_position():
+    """The primary's reflex motion is not delayed."""
+    pri = starry.Primary(starry.Map(), m=1.0)
+    sec = starry.Secondary(starry.Map(), porb=1.0, m=0.1, ecc=0.2, w=30)
+    t = np.linspace(-0.5, 0.5, 100)
+    x, y, z = starry.System(pri, sec, light_delay=True).position(t)
+    x0, y0, z0 = starry.System(pri, sec).position(t)
+    assert np.allclose(x[0], x0[0], rtol=1e-12, atol=1e-12)
+    assert np.allclose(y[0], y0[0], rtol=1e-12, atol=1e-12)
+    assert np.allclose(z[0], z0[0], rtol=1e-12, atol=1e-12)
+    assert not np.allclose(x[1], x0[1], rtol=1e-12, atol=1e-12)
@@ -44,6 +44,18 @@ def test_sturm():
         assert nroots(p, 0, 1) == np_nroots
 
 
+def test_nroots_batch():
+    np.random.seed(0)
+    nroots = starry._c_ops.nroots
+    nroots_batch = starry._c_ops.nrootsBatch
+    for deg in [1, 2, 5, 10, 20]:
+        P = np.random.randn(200, deg + 1)
+        P[::7, -1] = 0
+        assert np.array_equal(
+            nroots_batch(P, 0, 1), [nroots(p, 0, 1) for p in P]
+        )
+
+
 def test_limbdark_physical():
     # Test our routine on quadratic LD, where
     # the constraints are analytic (Kipping 2013)
@@ -56,3 +68,9 @@ def test_limbdark_physical():
     for i in range(500):
         map[1:] = np.random.randn(2)
         assert map.limbdark_is_physical() == is_physical(map.u)
+
+    # Batched version
+    U = np.hstack((-np.ones((500, 1)), np.random.randn(500, 2)))
+    assert np.array_equal(
+        map.ops.limbdark_is_physical(U), [is_physical(u) for u in U]
+    )
@@ -7,6 +7,8 @@ import starry
 import io
 import logging
 import warnings
+import numpy as np
+import pytest
 
 
 def test_quiet():
@@ -87,3 +89,91 @@ def test_coefficient_numbers():
     assert map.Nu == 4
     assert map.Nf == 1
     assert map.drorder == 0
+
+
+def _sT(ops, b, bsT):
+    """The batched occultation solution and its gradient at `r = 0.3`."""
+    return (ops.sT(b, 0.3),) + tuple(ops.sT(b, 0.3, bsT))
+
+
+@pytest.mark.parametrize(
+    "setting,value", [("nthreads", 1), ("nthreads", 4), ("sT_tol", 1e-10)]
+)
+def test_sT_settings(setting, value):
+    """
+    Test that the batched occultation solver doesn't depend on the number
+    of threads or on the tabulation at fixed radius.
+
+    """
+    map = starry.Map(ydeg=3, udeg=2)
+    ops = map.ops._c_ops
+    b = np.linspace(0.0, 1.25, 5000)
+    bsT = np.random.randn(len(b), ops.N)
+    default = getattr(ops, setting)
+    expected = _sT(ops, b, bsT)
+    setattr(ops, setting, value)
+    try:
+        result = _sT(ops, b, bsT)
+    finally:
+        setattr(ops, setting, default)
+    for x, y in zip(result, expected):
+        assert np.allclose(x, y)
+
+
+def _sT_jac(ops, b, r):
+    """The occultation solution and its derivatives at each point."""
+    sT = ops.sT(b, r)
+    dsTdb = np.zeros_like(sT)
+    dsTdr = np.zeros_like(sT)
+    bsT = np.eye(ops.N)
+    for n in range(len(b)):
+        for j in range(ops.N):
+            bb, br = ops.sT(b[n : n + 1], r, bsT[j : j + 1])
+            dsTdb[n, j] = bb[0]
+            dsTdr[n, j] = br
+    return sT, dsTdb, dsTdr
+
+
+@pytest.mark.parametrize("r", [0.1, 0.9, 1.5])
+def test_sT_tol(r, tol=1e-8):
+    """
+    Test that the tabulated occultation solution and its derivatives
+    agree with the exact solution to within the tolerance, relative
+    to the magnitude of each component or absolute if it's below unity.
+
+    """
+    map = starry.Map(ydeg=3)
+    ops = map.ops._c_ops
+    assert ops.sT_tol == starry.config.sT_tol
+    with pytest.raises(ValueError):
+        starry.config.sT_tol = -1.0
+    bmin = max(0.0, r - 1)
+    b = bmin + (1 + r - bmin) * (np.arange(100) + 0.5) / 100
+    default = ops.sT_tol
+    ops.sT_tol = 0.0
+    expected = _sT_jac(ops, b, r)
+    ops.sT_tol = tol
+    try:
+        result = _sT_jac(ops, b, r)
+    finally:
+        ops.sT_tol = default
+    for x, y in zip(result, expected):
+        assert np.all(np.abs(x - y) <= tol * np.maximum(np.abs(y), 1.0))
+
+
+@pytest.mark.parametrize("name", ["dotR", "tensordotRz", "sT"])
+def test_c_ops_out(name):
+    """Test the C++ ops writing into preallocated output arrays."""
+    map = starry.Map(ydeg=3, udeg=2)
+    ops = map.ops._c_ops
+    M = np.random.randn(10, ops.Ny)
+    args = {
+        "dotR": (M, 0.1, 0.2, 0.3, 0.4),
+        "tensordotRz": (M, np.linspace(0, 1, 10)),
+        "sT": (np.linspace(0, 1, 10), 0.3),
+    }[name]
+    func = getattr(ops, name)
+    expected = func(*args)
+    out = np.empty_like(expected)
+    func(*args, out=out)
+    assert np.allclose(out, expected)
@@ -54,5 +54,29 @@ def test_flux_reflected(n_tests=10):
         )
 
 
+def test_flux_reflected_occultation(n_tests=10):
+    map = starry.Map(2, reflected=True)
+    np.random.seed(14)
+    for i in range(n_tests):
+        map[1:, :] = 0.1 * np.random.randn(len(map[1:, :]))
+        theta = np.random.random() * 360
+        source = np.random.randn(3)
+        xo = np.random.randn()
+        yo = np.random.randn()
+        ro = 0.25 + 0.5 * np.random.random()
+        kwargs = dict(
+            theta=theta,
+            xs=source[0],
+            ys=source[1],
+            zs=source[2],
+            xo=xo,
+            yo=yo,
+            ro=ro,
+        )
+        assert np.allclose(
+            map.flux(**kwargs), flux(map, **kwargs), rtol=1e-3, atol=1e-3
+        )
+
+
 if __name__ == "__main__":
     test_flux_reflected()
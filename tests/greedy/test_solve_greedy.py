@@ -108,3 +108,128 @@ def test_lnlike(L, C, woodbury):
     # Verify that we get the correct inclination
     assert incs[np.argmax(ll)] == 60
     assert np.allclose(ll[np.argmax(ll)], 972.5997)  # benchmarked
+
+
+@pytest.mark.parametrize("C", ["scalar", "vector"])
+def test_streaming_solve(C):
+    """Compare the streaming solver to the dense Theano solution."""
+    from starry._core import linalg
+
+    map = starry.Map(ydeg=3, udeg=2)
+    map[1:, :] = 0.1
+    map[1:] = [0.4, 0.2]
+    theta = np.linspace(0, 360, 1000)
+    xo = np.linspace(-1.5, 1.5, 1000)
+    kwargs = dict(theta=theta, xo=xo, yo=0.2, ro=0.1)
+    flux = map.flux(**kwargs)
+    map.set_prior(L=np.ones(map.Ny))
+    if C == "scalar":
+        map.set_data(flux, C=1e-6)
+    else:
+        map.set_data(flux, C=np.linspace(1, 2, len(flux)) * 1e-6)
+
+    # Streaming solution
+    mu, cho_cov = map.solve(**kwargs)
+
+    # Dense solution, which is what we get with a full covariance
+    X = map.design_matrix(**kwargs)
+    mu_dense, cho_cov_dense = linalg._solve(
+        X,
+        flux,
+        np.diag(np.sqrt(map._C.value * np.ones(len(flux)))),
+        map._mu,
+        map._L.inverse,
+    )
+    assert np.allclose(mu, mu_dense)
+    assert np.allclose(cho_cov, cho_cov_dense)
+
+    # Streaming solution given the design matrix
+    mu, cho_cov = map.solve(design_matrix=X)
+    assert np.allclose(mu, mu_dense)
+    assert np.allclose(cho_cov, cho_cov_dense)
+
+
+def _structured_cov(kind, t):
+    """A structured covariance and its dense equivalent."""
+    diag = 1e-4 * np.linspace(1, 2, len(t))
+    if kind == "semiseparable":
+        # A white noise + two exponential kernels covariance
+        a = np.array([1e-3, 5e-4])
+        c = np.array([0.5, 3.0])
+        dt = np.abs(t.reshape(-1, 1) - t.reshape(1, -1))
+        C = (
+            np.diag(diag)
+            + a[0] * np.exp(-c[0] * dt)
+            + a[1] * np.exp(-c[1] * dt)
+        )
+        return C, starry.linalg.Semiseparable(t, diag, a, c)
+    else:
+        # A white noise + compactly supported (triangular) kernel covariance
+        p = 4
+        dn = np.abs(np.arange(len(t)).reshape(-1, 1) - np.arange(len(t)))
+        C = np.diag(diag) + 1e-3 * np.maximum(0, 1 - dn / (p + 1))
+        bands = np.zeros((p + 1, len(t)))
+        for k in range(p + 1):
+            bands[k, : len(t) - k] = np.diag(C, -k)
+        return C, starry.linalg.Banded(bands)
+
+
+@pytest.mark.parametrize("kind", ["semiseparable", "banded"])
+def test_structured(kind):
+    """Compare the structured covariance solvers to the dense solution."""
+    map = starry.Map(ydeg=2)
+    map[1:, :] = 0.1
+    t = np.linspace(0, 10, 300)
+    theta = 36 * t
+    flux = map.flux(theta=theta)
+    C, Cs = _structured_cov(kind, t)
+
+    # Dense solution
+    map.set_prior(L=np.ones(map.Ny))
+    map.set_data(flux, C=C)
+    mu0, cho_cov0 = map.solve(theta=theta)
+    ll0 = map.lnlike(theta=theta, woodbury=False)
+
+    # Structured solution
+    map.set_data(flux, C=Cs)
+    mu, cho_cov = map.solve(theta=theta)
+    ll = map.lnlike(theta=theta)
+    assert np.allclose(mu, mu0)
+    assert np.allclose(cho_cov, cho_cov0)
+    assert np.allclose(ll, ll0)
+
+    # Same thing with the functional interface
+    X = map.design_matrix(theta=theta)
+    mu1, _ = starry.linalg.solve(X, flux, C=Cs, L=np.ones(map.Ny))
+    ll1 = starry.linalg.lnlike(X, flux, C=Cs, L=np.ones(map.Ny))
+    assert np.allclose(mu1, mu0)
+    assert np.allclose(ll1, ll0)
+
+
+def test_posterior():
+    """Compare the incrementally updated posterior to a full solve."""
+    np.random.seed(0)
+    N = 9
+    X = np.random.randn(300, N)
+    flux = X.dot(np.random.randn(N)) + 0.1 * np.random.randn(300)
+    C = np.linspace(1, 2, 300) * 1e-2
+    L = np.linspace(1, 2, N)
+    posterior = starry.linalg.Posterior(mu=0.1, L=L)
+
+    # Add the data in chunks of different sizes
+    for i, j in [(0, 5), (5, 6), (6, 250), (250, 300)]:
+        posterior.add(X[i:j], flux[i:j], C=C[i:j])
+    mu, cho_cov = posterior.solution
+    mu_full, cho_cov_full = starry.linalg.solve(X, flux, C=C, mu=0.1, L=L)
+    assert np.allclose(mu, mu_full)
+    assert np.allclose(cho_cov, cho_cov_full)
+
+    # Remove a few data points
+    posterior.remove(X[100:110], flux[100:110], C=C[100:110])
+    idx = np.delete(np.arange(300), np.arange(100, 110))
+    mu, cho_cov = posterior.solution
+    mu_full, cho_cov_full = starry.linalg.solve(
+        X[idx], flux[idx], C=C[idx], mu=0.1, L=L
+    )
+    assert np.allclose(mu, mu_full)
+    assert np.allclose(cho_cov, cho_cov_full)
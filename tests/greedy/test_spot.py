@@ -78,3 +78,21 @@ def test_two_spots():
 
     assert not same_intensity(amp=-0.01, relative=True)
     assert not same_intensity(intensity=-0.1, relative=True)
+
+
+def test_batched_spots():
+    """Test that the batched expansion is the sum of the individual ones."""
+    map = starry.Map(ydeg=10)
+    amp = np.array([-0.01, -0.02, 0.015, -0.005])
+    sigma = np.array([0.05, 0.1, 0.08, 0.05])
+    lat = np.array([30.0, 30.0, -20.0, 0.0]) * np.pi / 180
+    lon = np.array([0.0, 90.0, 90.0, 0.0]) * np.pi / 180
+    y = map.ops.expand_spots(amp, sigma, lat, lon)
+    y_sum = np.sum(
+        [
+            map.ops.expand_spot([a], s, la, lo)
+            for a, s, la, lo in zip(amp, sigma, lat, lon)
+        ],
+        axis=0,
+    )
+    assert np.allclose(y, y_sum)
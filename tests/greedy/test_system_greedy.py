@@ -77,6 +77,27 @@ def test_integration():
     assert np.allclose(flux, flux2)
 
 
+def test_integration_ld():
+    pri = starry.Primary(starry.Map(udeg=2), r=1.0)
+    pri.map[1:] = [0.5, 0.25]
+    sec = starry.Secondary(starry.Map(udeg=1, amp=0.1), porb=1.0, r=0.25)
+    sec.map[1] = 0.4
+
+    # Manual integration over the transit and the secondary eclipse
+    t = np.concatenate(
+        (np.linspace(-0.1, 0.1, 10000), np.linspace(0.4, 0.6, 10000))
+    )
+    sys = starry.System(pri, sec, texp=0)
+    flux = sys.flux(t)
+    t = t.reshape(-1, 1000).mean(axis=1)
+    flux = flux.reshape(-1, 1000).mean(axis=1)
+
+    # Adaptive integration in the limb darkening op
+    sys = starry.System(pri, sec, texp=0.02)
+    assert sys.ops._exposure_ld
+    assert np.allclose(flux, sys.flux(t))
+
+
 def test_reflected_light():
     pri = starry.Primary(starry.Map(amp=0), r=1)
     sec = starry.Secondary(starry.Map(reflected=True), porb=1.0, r=1)
@@ -85,3 +106,53 @@ def test_reflected_light():
     flux = sys.flux(t)
 
     # TODO: Add an analytic validation here
+
+
+def test_kepler():
+    """Compare the native Kepler solver to a simple numpy implementation."""
+    from starry._constants import G_grav
+
+    t = np.linspace(-2.0, 3.0, 5000)
+    pri_m = 1.1
+    m = np.array([0.01, 0.0])
+    t0 = np.array([0.1, -0.4])
+    porb = np.array([1.3, 3.7])
+    ecc = np.array([0.3, 0.6])
+    w = np.array([1.0, -2.0])
+    Omega = np.array([0.3, 2.0])
+    inc = np.array([1.5, 0.7])
+    x, y, z, vx, vy, vz = starry._c_ops.kepler(
+        t, pri_m, m, t0, porb, ecc, w, Omega, inc, G_grav, 0.0
+    )
+    for k in range(2):
+        # Mean anomaly, referenced to the time of transit
+        n = 2 * np.pi / porb[k]
+        a = (G_grav * (pri_m + m[k]) / n ** 2) ** (1.0 / 3)
+        f0 = 0.5 * np.pi - w[k]
+        E0 = 2 * np.arctan(
+            np.sqrt((1 - ecc[k]) / (1 + ecc[k])) * np.tan(0.5 * f0)
+        )
+        M = n * (t - t0[k]) + E0 - ecc[k] * np.sin(E0)
+
+        # Newton's method
+        E = M + 0.85 * ecc[k] * np.sign(np.sin(M))
+        for i in range(100):
+            E -= (E - ecc[k] * np.sin(E) - M) / (1 - ecc[k] * np.cos(E))
+        f = 2 * np.arctan2(
+            np.sqrt(1 + ecc[k]) * np.sin(0.5 * E),
+            np.sqrt(1 - ecc[k]) * np.cos(0.5 * E),
+        )
+        r = -a * (1 - ecc[k] ** 2) / (1 + ecc[k] * np.cos(f))
+
+        # Rotate to the sky
+        X = r * np.cos(w[k] + f)
+        Y = r * np.sin(w[k] + f) * np.cos(inc[k])
+        Z = -r * np.sin(w[k] + f) * np.sin(inc[k])
+        cO, sO = np.cos(Omega[k]), np.sin(Omega[k])
+        assert np.allclose(x[:, k], cO * X - sO * Y)
+        assert np.allclose(y[:, k], sO * X + cO * Y)
+        assert np.allclose(z[:, k], Z)
+
+        # The velocities are the time derivatives of the positions
+        dxdt = np.gradient(x[:, k], t)
+        assert np.allclose(vx[1:-1, k], dxdt[1:-1], rtol=1e-3)
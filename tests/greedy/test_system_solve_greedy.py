@@ -108,3 +108,37 @@ def test_lnlike(L, C, woodbury):
     # Verify that we get the correct radius
     assert rs[np.argmax(ll)] == 0.1
     assert np.allclose(ll[np.argmax(ll)], 981.9091)  # benchmarked
+
+
+def test_structured_design_matrix():
+    # A rotating star and a rotating planet on an eccentric orbit,
+    # so that we have both transits and secondary eclipses
+    A = starry.Primary(starry.Map(ydeg=2, udeg=2), prot=0.7)
+    A.map[1:, :] = 0.1
+    A.map[1:] = [0.4, 0.2]
+    b = starry.Secondary(
+        starry.Map(ydeg=1, amp=0.1), porb=1.0, r=0.1, ecc=0.1, prot=0.3
+    )
+    b.map[1, :] = [0.1, 0.2, 0.3]
+    sys = starry.System(A, b)
+    t = np.linspace(-1, 1, 2000)
+
+    # Compare to the dense design matrix
+    X = sys.design_matrix(t)
+    X_s = sys.design_matrix(t, structured=True)
+    assert 0 < len(X_s.occ) < len(t)
+    assert np.allclose(X_s.toarray(), X)
+    y = np.random.randn(X.shape[1])
+    assert np.allclose(X_s.dot(y), X.dot(y))
+
+    # Solve for the star, keeping the planet fixed
+    flux = sys.flux(t)
+    sys.set_data(flux, C=np.linspace(1, 2, len(t)) * 1e-6)
+    A.map.set_prior(L=1e-1)
+    ll = sys.lnlike(design_matrix=X)
+    ll_s = sys.lnlike(design_matrix=X_s)
+    assert np.allclose(ll, ll_s)
+    mu, cho_cov = sys.solve(design_matrix=X)
+    mu_s, cho_cov_s = sys.solve(design_matrix=X_s)
+    assert np.allclose(mu, mu_s)
+    assert np.allclose(cho_cov, cho_cov_s)
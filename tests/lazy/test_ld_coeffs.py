@@ -5,6 +5,9 @@ import theano.tensor as tt
 from theano.tests import unittest_tools as utt
 from starry._core.ops.limbdark.get_cl import GetClOp
 from starry._core.ops.limbdark.get_cl_rev import GetClRevOp
+from starry._core.ops.limbdark.limbdark import LimbDarkOp
+from starry._core.ops.limbdark.limbdark_flux import LimbDarkFluxOp
+from starry._core.ops.limbdark.limbdark_exposure import LimbDarkExposureOp
 
 
 class TestGetCl(utt.InferShapeTester):
@@ -52,3 +55,94 @@ class TestGetClRev(utt.InferShapeTester):
         self._compile_and_check(
             [x], [self.op(x)], [np.asarray(np.random.rand(5))], self.op_class
         )
+
+
+def test_limbdark_forward_only():
+    c = tt.dvector()
+    b = tt.dvector()
+    r = tt.dvector()
+    los = tt.dvector()
+    f, dfdcl, dfdb, dfdr = LimbDarkOp()(c, b, r, los)
+    func_full = theano.function([c, b, r, los], [f, dfdb])
+    func_fwd = theano.function([c, b, r, los], f)
+
+    # The forward-only graph should not compute the gradients
+    ops = [node.op for node in func_fwd.maker.fgraph.toposort()]
+    assert not any(isinstance(op, LimbDarkOp) and op.gradient for op in ops)
+
+    args = (
+        np.array([0.5, 0.3, 0.2]),
+        np.linspace(-1.2, 1.2, 1000),
+        0.1 * np.ones(1000),
+        np.ones(1000),
+    )
+    utt.assert_allclose(func_full(*args)[0], func_fwd(*args))
+
+
+def test_limbdark_flux_multichannel():
+    u = tt.dmatrix()
+    b = tt.dvector()
+    r = tt.dvector()
+    los = tt.dvector()
+    flux = theano.function([u, b, r, los], LimbDarkFluxOp()(u, b, r, los))
+
+    # Compare to the single-channel ops
+    c = GetClOp()(u[0])
+    c_norm = c / (np.pi * (c[0] + 2 * c[1] / 3))
+    flux1 = theano.function(
+        [u, b, r, los], LimbDarkOp()(c_norm, b, r, los)[0]
+    )
+
+    np.random.seed(0)
+    u_val = np.hstack((-np.ones((5, 1)), 0.3 * np.random.randn(5, 2)))
+    b_val = np.linspace(0.0, 1.2, 100)
+    r_val = 0.1 * np.ones(100)
+    los_val = np.ones(100)
+    f = flux(u_val, b_val, r_val, los_val)
+    assert f.shape == (100, 5)
+    for k in range(5):
+        f1 = flux1(u_val[k : k + 1], b_val, r_val, los_val)
+        f1[b_val >= 1 + r_val] = 1.0
+        utt.assert_allclose(f[:, k], f1)
+
+    # Check the gradients
+    utt.verify_grad(
+        lambda u, b, r: LimbDarkFluxOp()(u, b, r, los_val),
+        [u_val, b_val[1:-1:10], r_val[1:-1:10]],
+        n_tests=1,
+        eps=1e-7,
+    )
+
+
+def test_limbdark_exposure_grazing():
+    # Exposures dominated by the acceleration, where the occultor is
+    # out of transit at the midpoint but grazes the limb near one or
+    # both ends (or vice versa)
+    xo = np.array([0.0, 0.0, 1.15])
+    yo = np.array([1.12, 1.05, 0.0])
+    vx = np.array([0.0, 0.0, 0.01])
+    vy = np.zeros(3)
+    ax = np.array([0.0, 0.0, -30.0])
+    ay = np.array([-4.0, 8.0, 0.0])
+    r = 0.1 * np.ones(3)
+    texp = np.ones(3)
+    los = np.ones(3)
+    u = np.array([[-1.0, 0.4, 0.26]])
+    flux = LimbDarkExposureOp(tol=1e-10)(
+        u, xo, yo, vx, vy, ax, ay, r, texp, los
+    ).eval()[:, 0]
+
+    # Brute-force oversampling
+    s = np.linspace(-0.5, 0.5, 100001)[:, None]
+    x = xo + vx * s + 0.5 * ax * s ** 2
+    y = yo + vy * s + 0.5 * ay * s ** 2
+    b = np.sqrt(x ** 2 + y ** 2).reshape(-1)
+    ones = np.ones_like(b)
+    flux_brute = (
+        LimbDarkFluxOp()(u, b, 0.1 * ones, ones)
+        .eval()[:, 0]
+        .reshape(s.shape[0], 3)
+    )
+    flux_brute = np.trapz(flux_brute, dx=1.0 / (s.shape[0] - 1), axis=0)
+    assert np.all(flux_brute < 1)
+    utt.assert_allclose(flux, flux_brute, atol=1e-7)
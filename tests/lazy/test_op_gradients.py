@@ -25,6 +25,24 @@ def test_sT(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
         )
 
 
+def test_sT_b0_r1():
+    # The gradient is finite when the occultor is exactly the size of
+    # the occulted body and centered on it, and matches its limit
+    map = starry.Map(ydeg=2)
+    b = tt.dvector()
+    r = tt.dscalar()
+    sT = tt.sum(map.ops.sT(b, r), axis=0)
+    grad = theano.function(
+        [b, r],
+        [theano.gradient.jacobian(sT, b), theano.gradient.jacobian(sT, r)],
+    )
+    dsTdb, dsTdr = grad(np.array([0.0]), 1.0)
+    dsTdb_lim, dsTdr_lim = grad(np.array([0.0]), 1.0 - 1e-7)
+    assert np.all(np.isfinite(dsTdb)) and np.all(np.isfinite(dsTdr))
+    assert np.allclose(dsTdb, dsTdb_lim, atol=1e-2)
+    assert np.allclose(dsTdr, dsTdr_lim, atol=1e-2)
+
+
 def test_intensity(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
     with change_flags(compute_test_value="off"):
         map = starry.Map(ydeg=2, udeg=2)
@@ -111,6 +129,39 @@ def test_dotR(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
         )
 
 
+def test_dotProjection(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
+    with change_flags(compute_test_value="off"):
+        map = starry.Map(ydeg=2)
+        inc = 75.0 * np.pi / 180.0
+        obl = 30.0 * np.pi / 180.0
+        theta = (
+            np.array([0.0, 15.0, 30.0, 45.0, 60.0, 75.0, 90.0]) * np.pi / 180.0
+        )
+        for op in [map.ops._dotProjection, map.ops._dotProjectionT]:
+
+            # Matrix M
+            M = np.ones((7, 9))
+            verify_grad(
+                op,
+                (M, inc, obl, theta),
+                abs_tol=abs_tol,
+                rel_tol=rel_tol,
+                eps=eps,
+                n_tests=1,
+            )
+
+            # Vector M
+            M = np.ones((1, 9))
+            verify_grad(
+                op,
+                (M, inc, obl, theta),
+                abs_tol=abs_tol,
+                rel_tol=rel_tol,
+                eps=eps,
+                n_tests=1,
+            )
+
+
 def test_F(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
     with change_flags(compute_test_value="off"):
         map = starry.Map(ydeg=2, udeg=2, rv=True)
@@ -266,6 +317,55 @@ def test_flux_reflected(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
         )
 
 
+def test_sT_reflected(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
+    with change_flags(compute_test_value="off"):
+        map = starry.Map(ydeg=2, reflected=True)
+        bterm = np.linspace(-0.9, 0.9, 10)
+        xo = np.linspace(-1.2, 1.2, len(bterm))
+        yo = np.ones_like(xo) * 0.3
+        zo = np.ones_like(xo)
+        ro = 0.5
+        verify_grad(
+            map.ops.sTReflected,
+            (bterm, xo, yo, zo, ro),
+            abs_tol=abs_tol,
+            rel_tol=rel_tol,
+            eps=eps,
+            n_tests=1,
+        )
+
+
+def test_flux_reflected_occultation(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
+    with change_flags(compute_test_value="off"):
+        map = starry.Map(ydeg=2, reflected=True)
+        theta = np.linspace(0, 30, 10)
+        xs = np.linspace(-1.5, 1.5, len(theta))
+        ys = np.ones_like(xs) * 0.3
+        zs = np.ones_like(xs)
+        xo = np.linspace(-1.2, 1.2, len(theta))
+        yo = np.ones_like(xo) * -0.2
+        zo = np.ones_like(xo)
+        ro = 0.5
+        inc = 85.0 * np.pi / 180.0
+        obl = 30.0 * np.pi / 180.0
+        y = np.ones(9)
+        u = [-1.0]
+        f = [np.pi, 0.0, 0.0, 0.0]
+        alpha = 0.0
+
+        func = lambda *args: tt.dot(map.ops.X(*args), y)
+
+        # Rotation + occultation
+        verify_grad(
+            func,
+            (theta, xs, ys, zs, xo, yo, zo, ro, inc, obl, u, f, alpha),
+            abs_tol=abs_tol,
+            rel_tol=rel_tol,
+            eps=eps,
+            n_tests=1,
+        )
+
+
 def test_flux_ylm_ld(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
     with change_flags(compute_test_value="off"):
         map = starry.Map(ydeg=2, udeg=2)
@@ -431,3 +531,116 @@ def test_spot_spectral(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
             eps=eps,
             n_tests=1,
         )
+
+
+def test_spots(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
+    with change_flags(compute_test_value="off"):
+        map = starry.Map(ydeg=5, nw=2)
+        amp = [[-0.01, -0.02], [0.03, 0.01], [-0.02, 0.02]]
+        sigma = [0.1, 0.15, 0.1]
+        lat = np.array([30.0, 30.0, -10.0]) * np.pi / 180
+        lon = np.array([45.0, 0.0, 45.0]) * np.pi / 180
+        verify_grad(
+            map.ops.spotYlms,
+            (amp, sigma, lat, lon),
+            abs_tol=abs_tol,
+            rel_tol=rel_tol,
+            eps=eps,
+            n_tests=1,
+        )
+
+
+@pytest.mark.parametrize("clight", [0.0, 1000.0])
+def test_kepler(clight, abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
+    from starry._core.ops import KeplerOp
+    from starry._constants import G_grav
+
+    op = KeplerOp(starry._c_ops.kepler, G_grav, clight)
+    with change_flags(compute_test_value="off"):
+        verify_grad(
+            lambda *args: tt.stack(op(*args)),
+            (
+                np.linspace(-1.0, 1.0, 30),
+                1.1,
+                [0.01, 0.001],
+                [0.1, -0.4],
+                [1.3, 3.7],
+                [0.3, 0.1],
+                [1.0, 2.0],
+                [0.3, 0.0],
+                [1.5, 1.55],
+            ),
+            abs_tol=abs_tol,
+            rel_tol=rel_tol,
+            eps=eps,
+            n_tests=1,
+        )
+
+
+def test_semiseparable(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
+    from starry._core.ops import SemiseparableOp
+
+    op = SemiseparableOp(starry._c_ops.semiseparable)
+    np.random.seed(0)
+    N, J, M = 20, 2, 3
+    t = np.sort(np.random.uniform(0, 5, N))
+    a = np.array([1.0, 0.5])
+    c = np.array([0.7, 2.0])
+    A = 0.1 + np.random.uniform(0, 0.1, N) + np.sum(a)
+    U = a * (1 + 0.1 * np.random.uniform(0, 1, (N, J)))
+    V = 1 + 0.1 * np.random.uniform(0, 1, (N, J))
+    P = np.exp(-c * np.diff(t).reshape(-1, 1))
+    Y = np.random.randn(N, M)
+    with change_flags(compute_test_value="off"):
+        verify_grad(
+            lambda *args: tt.sum(op(*args)[0]) + op(*args)[1],
+            (A, U, V, P, Y),
+            abs_tol=abs_tol,
+            rel_tol=rel_tol,
+            eps=eps,
+            n_tests=1,
+        )
+
+
+def test_banded(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
+    from starry._core.ops import BandedOp
+
+    op = BandedOp(starry._c_ops.banded)
+    np.random.seed(0)
+    N, p, M = 20, 3, 3
+    B = 0.1 * np.random.uniform(0, 1, (p + 1, N))
+    B[0] += 1.0
+    Y = np.random.randn(N, M)
+    with change_flags(compute_test_value="off"):
+        verify_grad(
+            lambda *args: tt.sum(op(*args)[0]) + op(*args)[1],
+            (B, Y),
+            abs_tol=abs_tol,
+            rel_tol=rel_tol,
+            eps=eps,
+            n_tests=1,
+        )
+
+
+def test_render(abs_tol=1e-5, rel_tol=1e-5, eps=1e-7):
+    map = starry.Map(ydeg=2, udeg=1)
+    np.random.seed(0)
+    P = np.random.randn((map.ops.deg + 1) ** 2, 3)
+    with change_flags(compute_test_value="off"):
+        # Compare to the dense polynomial basis
+        xyz = map.ops.compute_ortho_grid(10)
+        pT = map.ops.pT(xyz[0], xyz[1], xyz[2])
+        image = map.ops._render(10, 0, P).eval()
+        assert np.allclose(image, pT.dot(P), equal_nan=True)
+        xyz = map.ops.compute_rect_grid(10)
+        pT = map.ops.pT(xyz[0], xyz[1], xyz[2])
+        image = map.ops._render(10, 1, P).eval()
+        assert np.allclose(image, pT.dot(P))
+        verify_grad(
+            lambda P: map.ops._render(8, 1, P),
+            (P,),
+            abs_tol=abs_tol,
+            rel_tol=rel_tol,
+            eps=eps,
+            n_tests=1,
+        )